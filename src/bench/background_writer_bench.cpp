@@ -0,0 +1,132 @@
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "storage/heap_file.hpp"
+
+// Point-read latency while writer threads delete and re-insert records at
+// random across a file several times larger than the buffer pool, so most
+// evictions hit dirty pages. Three configurations:
+//   none        no background write-back and no checkpoints
+//   sync        a thread runs the blocking sync() checkpoint every interval
+//   background  background page writer plus fuzzy checkpoints
+//
+// Usage: background_writer_bench [num_records] [writer_threads] [seconds] [path]
+
+namespace {
+
+constexpr uint16_t RECORD_SIZE = 100;
+constexpr uint32_t CHECKPOINT_INTERVAL_MS = 1000;
+
+enum class Mode { NONE, SYNC, BACKGROUND };
+
+double percentile(std::vector<double>& values, double fraction) {
+    if (values.empty()) {
+        return 0;
+    }
+    size_t idx = std::min(values.size() - 1, static_cast<size_t>(fraction * values.size()));
+    std::nth_element(values.begin(), values.begin() + idx, values.end());
+    return values[idx];
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t num_records = argc > 1 ? std::stoul(argv[1]) : 2000000;
+    unsigned writer_threads = argc > 2 ? std::stoul(argv[2]) : 2;
+    double seconds = argc > 3 ? std::stod(argv[3]) : 5;
+    std::string path = argc > 4 ? argv[4] : "background_writer_bench.db";
+
+    const std::pair<const char*, Mode> modes[] = {
+        {"none", Mode::NONE},
+        {"sync", Mode::SYNC},
+        {"background", Mode::BACKGROUND},
+    };
+
+    std::cout << "mode,read_p50_us,read_p99_us,read_p999_us,reads,writes,"
+                 "eviction_writes,writer_writes,writer_pages_per_sec,dirty_pages\n";
+    for (const auto& [name, mode] : modes) {
+        unlink(path.c_str());
+        unlink((path + ".wal").c_str());
+        unlink((path + ".fsm").c_str());
+
+        HeapFileOptions options;
+        options.writer_interval_ms = mode == Mode::BACKGROUND ? 20 : 0;
+        options.checkpoint_interval_ms = mode == Mode::BACKGROUND ? CHECKPOINT_INTERVAL_MS : 0;
+        HeapFile heap_file(path, options);
+
+        std::vector<uint8_t> rows(num_records * RECORD_SIZE);
+        std::vector<HeapFile::RecordId> rids = heap_file.insertRecords(rows.data(), RECORD_SIZE, num_records);
+
+        std::atomic<bool> done(false);
+        std::atomic<uint64_t> writes(0);
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < writer_threads; t++) {
+            threads.emplace_back([&, t] {
+                std::mt19937_64 rng(t + 1);
+                std::uniform_int_distribution<size_t> pick(0, num_records - 1);
+                uint8_t record[RECORD_SIZE] = {};
+                uint64_t local = 0;
+                while (!done) {
+                    const auto& rid = rids[pick(rng)];
+                    heap_file.deleteRecord(rid.page_id, rid.slot_id);
+                    heap_file.insertRecord(record, RECORD_SIZE);
+                    if (++local % 64 == 0) {
+                        heap_file.commit();
+                    }
+                }
+                writes += local;
+            });
+        }
+        if (mode == Mode::SYNC) {
+            threads.emplace_back([&] {
+                auto next = std::chrono::steady_clock::now();
+                while (!done) {
+                    next += std::chrono::milliseconds(CHECKPOINT_INTERVAL_MS);
+                    while (!done && std::chrono::steady_clock::now() < next) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    }
+                    if (!done) {
+                        heap_file.sync();
+                    }
+                }
+            });
+        }
+
+        std::vector<double> latencies;
+        std::mt19937_64 rng(42);
+        std::uniform_int_distribution<size_t> pick(0, num_records - 1);
+        uint8_t buffer[RECORD_SIZE];
+        auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+        while (std::chrono::steady_clock::now() < end) {
+            const auto& rid = rids[pick(rng)];
+            auto start = std::chrono::steady_clock::now();
+            heap_file.readRecord(rid.page_id, rid.slot_id, buffer, sizeof(buffer));
+            latencies.push_back(std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - start).count());
+        }
+        BufferPool::Stats stats = heap_file.getBufferPoolStats();
+        done = true;
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        size_t reads = latencies.size();
+        std::cout << name << "," << percentile(latencies, 0.5) << "," << percentile(latencies, 0.99) << ","
+                  << percentile(latencies, 0.999) << "," << reads << "," << writes << ","
+                  << stats.eviction_writes << "," << stats.writer_writes << ","
+                  << stats.writer_pages_per_sec << "," << stats.dirty_pages << "\n";
+        heap_file.close();
+    }
+
+    unlink(path.c_str());
+    unlink((path + ".wal").c_str());
+    unlink((path + ".fsm").c_str());
+    return 0;
+}
@@ -0,0 +1,134 @@
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "storage/b_plus_tree.hpp"
+
+// YCSB-style mixes over a preloaded B+-tree with uniformly chosen keys:
+//   read_heavy   95% point lookups,  5% updates      (YCSB B)
+//   update_heavy 50% point lookups, 50% updates      (YCSB A)
+//   scan         95% short scans,    5% inserts      (YCSB E)
+// An update removes a key's entry and inserts it again. Throughput is
+// reported for 1, 2, 4, ... threads up to the given maximum, and every
+// run checks afterwards that no preloaded key was lost.
+//
+// Usage: btree_ycsb_bench [num_keys] [max_threads] [ops_per_thread] [path]
+
+namespace {
+
+struct Workload {
+    const char* name;
+    int read_percent;  // Remaining operations are the workload's write kind
+    bool scans;
+};
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Record ids are derived from the key so updates can find the old entry
+HeapFile::RecordId ridFor(uint64_t key) {
+    return {static_cast<uint32_t>(key / 64), static_cast<uint16_t>(key % 64)};
+}
+
+void runWorker(BPlusTree& tree, const Workload& workload, size_t num_keys, size_t ops,
+               unsigned thread_id, std::atomic<uint64_t>& next_key, uint64_t& found) {
+    std::mt19937_64 rng(thread_id * 7919 + 1);
+    std::uniform_int_distribution<uint64_t> pick(0, num_keys - 1);
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::uniform_int_distribution<int> scan_length(1, 100);
+    uint64_t local_found = 0;
+
+    for (size_t op = 0; op < ops; op++) {
+        uint64_t key = pick(rng);
+        if (percent(rng) < workload.read_percent) {
+            if (workload.scans) {
+                int remaining = scan_length(rng);
+                tree.scan(key, UINT64_MAX, [&](BPlusTree::Key, BPlusTree::RecordId) {
+                    local_found++;
+                    return --remaining > 0;
+                });
+            } else {
+                local_found += tree.find(key).size();
+            }
+        } else if (workload.scans) {
+            tree.insert(next_key++, ridFor(key));
+        } else {
+            // Concurrent updates of the same key may miss the old entry;
+            // the insert keeps the key present either way
+            tree.remove(key, ridFor(key));
+            tree.insert(key, ridFor(key));
+        }
+    }
+    found = local_found;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t num_keys = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    unsigned max_threads = argc > 2 ? std::stoul(argv[2]) : std::thread::hardware_concurrency();
+    size_t ops_per_thread = argc > 3 ? std::stoul(argv[3]) : 500000;
+    std::string path = argc > 4 ? argv[4] : "btree_ycsb_bench.idx";
+
+    const Workload workloads[] = {
+        {"read_heavy", 95, false},
+        {"update_heavy", 50, false},
+        {"scan", 95, true},
+    };
+
+    std::cout << "workload,threads,mops_per_sec,height\n";
+    for (const auto& workload : workloads) {
+        for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+            unlink(path.c_str());
+            BPlusTree tree(path, [](const void* record, uint16_t) {
+                return *static_cast<const uint64_t*>(record);
+            }, 1024);
+
+            std::vector<uint64_t> keys(num_keys);
+            for (size_t i = 0; i < num_keys; i++) {
+                keys[i] = i;
+            }
+            std::shuffle(keys.begin(), keys.end(), std::mt19937_64(42));
+            for (uint64_t key : keys) {
+                tree.insert(key, ridFor(key));
+            }
+
+            std::atomic<uint64_t> next_key(num_keys);
+            std::vector<uint64_t> found(threads);
+            std::vector<std::thread> workers;
+            auto start = std::chrono::steady_clock::now();
+            for (unsigned t = 0; t < threads; t++) {
+                workers.emplace_back(runWorker, std::ref(tree), std::cref(workload), num_keys,
+                                     ops_per_thread, t, std::ref(next_key), std::ref(found[t]));
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+            double secs = secondsSince(start);
+
+            std::cout << workload.name << "," << threads << ","
+                      << threads * ops_per_thread / secs / 1e6 << "," << tree.getHeight() << "\n";
+
+            // Every preloaded key must still be present exactly once
+            size_t present = 0;
+            tree.scan(0, num_keys - 1, [&present](BPlusTree::Key, BPlusTree::RecordId) {
+                present++;
+                return true;
+            });
+            if (present != num_keys) {
+                std::cerr << "expected " << num_keys << " keys, found " << present << "\n";
+                return 1;
+            }
+            tree.close();
+        }
+    }
+
+    unlink(path.c_str());
+    return 0;
+}
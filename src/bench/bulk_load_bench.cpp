@@ -0,0 +1,86 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "storage/heap_file.hpp"
+
+// Load throughput of HeapFile::insertRecords() compared with an
+// insertRecord() loop and with raw sequential writes of the same volume.
+//
+// Usage: bulk_load_bench [num_records] [record_size] [path]
+
+namespace {
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void removeHeapFile(const std::string& path) {
+    unlink(path.c_str());
+    unlink((path + ".wal").c_str());
+    unlink((path + ".fsm").c_str());
+}
+
+void report(const std::string& name, size_t bytes, size_t rows, double secs) {
+    std::cout << name << "," << rows / secs << "," << bytes / secs / (1024 * 1024) << "\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t num_records = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    uint16_t record_size = argc > 2 ? static_cast<uint16_t>(std::stoul(argv[2])) : 112;
+    std::string path = argc > 3 ? argv[3] : "bulk_load_bench.db";
+
+    std::vector<uint8_t> rows(num_records * record_size);
+    for (size_t i = 0; i < num_records; i++) {
+        std::memset(rows.data() + i * record_size, static_cast<int>(i), record_size);
+        std::memcpy(rows.data() + i * record_size, &i, std::min<size_t>(sizeof(i), record_size));
+    }
+
+    std::cout << "method,rows_per_sec,mb_per_sec\n";
+
+    removeHeapFile(path);
+    {
+        HeapFile heap_file(path);
+        auto start = std::chrono::steady_clock::now();
+        heap_file.insertRecords(rows.data(), record_size, num_records);
+        double secs = secondsSince(start);
+        size_t bytes = heap_file.getNumPages() * SlottedPage::PAGE_SIZE;
+        report("insertRecords", bytes, num_records, secs);
+        heap_file.close();
+
+        // Raw sequential write of the same number of bytes the heap file ended up with
+        std::vector<uint8_t> chunk(HeapFile::BULK_LOAD_BATCH_PAGES * SlottedPage::PAGE_SIZE, 0xAB);
+        int fd = open((path + ".raw").c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        start = std::chrono::steady_clock::now();
+        for (size_t written = 0; written < bytes; written += chunk.size()) {
+            if (write(fd, chunk.data(), chunk.size()) != static_cast<ssize_t>(chunk.size())) {
+                break;
+            }
+        }
+        fdatasync(fd);
+        report("raw_sequential_write", bytes, num_records, secondsSince(start));
+        close(fd);
+        unlink((path + ".raw").c_str());
+    }
+
+    removeHeapFile(path);
+    {
+        HeapFile heap_file(path);
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < num_records; i++) {
+            heap_file.insertRecord(rows.data() + i * record_size, record_size);
+        }
+        heap_file.sync();
+        double secs = secondsSince(start);
+        report("insertRecord_loop", heap_file.getNumPages() * SlottedPage::PAGE_SIZE, num_records, secs);
+        heap_file.close();
+    }
+
+    removeHeapFile(path);
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "storage/heap_file.hpp"
+#include "storage/heap_scanner.hpp"
+
+// Cold archive table stored plain and LZ-compressed: bulk load, bytes on
+// disk (data file plus page table), a full scan and random point lookups
+// through a small buffer pool. Before every read pass the file is dropped
+// from the OS page cache, so passes start cold.
+//
+// Usage: compression_bench [num_records] [num_lookups] [path]
+
+namespace {
+
+struct Movie {
+    uint32_t id;
+    char title[100];
+    float rating;
+    uint32_t release;
+};
+
+const char* const WORDS[] = {"the", "last", "night", "of", "a", "star", "return", "king", "lost", "city",
+                             "shadow", "river", "war", "love", "story", "dark", "empire", "little", "ghost"};
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void removeHeapFile(const std::string& path) {
+    for (const char* suffix : {"", ".wal", ".fsm", ".ptt"}) {
+        unlink((path + suffix).c_str());
+    }
+}
+
+uint64_t fileBytes(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+}
+
+void dropCache(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd != -1) {
+        fdatasync(fd);
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        close(fd);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t num_records = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    size_t num_lookups = argc > 2 ? std::stoul(argv[2]) : 200000;
+    std::string path = argc > 3 ? argv[3] : "compression_bench.db";
+
+    std::mt19937 rng(7);
+    std::vector<Movie> movies(num_records);
+    for (size_t i = 0; i < num_records; i++) {
+        Movie& movie = movies[i];
+        std::memset(&movie, 0, sizeof(movie));
+        movie.id = static_cast<uint32_t>(i);
+        std::string title;
+        for (size_t words = 2 + rng() % 5; words > 0; words--) {
+            title += WORDS[rng() % (sizeof(WORDS) / sizeof(WORDS[0]))];
+            title += words > 1 ? " " : "";
+        }
+        std::strncpy(movie.title, title.c_str(), sizeof(movie.title) - 1);
+        movie.rating = static_cast<float>(rng() % 1000) / 1000;
+        movie.release = 1950 + rng() % 75;
+    }
+
+    std::cout << "storage,disk_mb,ratio,load_ms,scan_ms,lookups_per_sec\n";
+    uint64_t plain_bytes = 0;
+    for (auto compression : {HeapFileOptions::Compression::NONE, HeapFileOptions::Compression::LZ}) {
+        bool lz = compression == HeapFileOptions::Compression::LZ;
+        removeHeapFile(path);
+        HeapFileOptions options;
+        options.compression = compression;
+
+        std::vector<HeapFile::RecordId> record_ids;
+        auto start = std::chrono::steady_clock::now();
+        {
+            HeapFile heap_file(path, options);
+            record_ids = heap_file.insertRecords(movies.data(), sizeof(Movie), num_records);
+            heap_file.close();
+        }
+        double load_time = secondsSince(start);
+        uint64_t bytes = fileBytes(path) + fileBytes(path + ".ptt");
+        if (!lz) {
+            plain_bytes = bytes;
+        }
+
+        HeapFileOptions read_options;
+        read_options.buffer_pool_mb = 4;
+        HeapFile heap_file(path, read_options);
+
+        dropCache(path);
+        start = std::chrono::steady_clock::now();
+        double sum = 0;
+        HeapScanner scanner(heap_file);
+        while (scanner.next()) {
+            sum += static_cast<const Movie*>(scanner.getRecord())->rating;
+        }
+        double scan_time = secondsSince(start);
+
+        dropCache(path);
+        std::uniform_int_distribution<size_t> pick(0, record_ids.size() - 1);
+        std::mt19937 lookup_rng(42);
+        uint64_t checksum = 0;
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < num_lookups; i++) {
+            const HeapFile::RecordId& rid = record_ids[pick(lookup_rng)];
+            Movie movie;
+            heap_file.readRecord(rid.page_id, rid.slot_id, &movie, sizeof(movie));
+            checksum += movie.id;
+        }
+        double lookup_time = secondsSince(start);
+        if (sum < 0 || checksum == 0) {
+            std::cerr << "unexpected result\n";
+        }
+
+        std::cout << (lz ? "lz" : "plain") << "," << bytes / 1e6 << ","
+                  << static_cast<double>(plain_bytes) / bytes << "," << load_time * 1000 << ","
+                  << scan_time * 1000 << "," << num_lookups / lookup_time << "\n";
+        heap_file.close();
+    }
+
+    removeHeapFile(path);
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include <unistd.h>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "storage/batch_scanner.hpp"
+#include "storage/filter_kernels.hpp"
+#include "storage/heap_file.hpp"
+
+// A bulk-loaded PAX table stored plain and in sealed, encoded pages:
+// pages needed, then SELECT COUNT(*), SUM(votes) WHERE release < 2000 AND
+// genre = 3 AND rating > 0.9 through BatchScanner (best of several warm
+// passes), then random point lookups through a buffer pool that holds a
+// quarter of the plain table.
+//
+// Usage: encoding_bench [num_records] [num_lookups] [path]
+
+namespace {
+
+struct Title {
+    uint32_t id;      // Load order, so sorted
+    uint32_t release; // 1950..2024
+    uint32_t genre;   // One of 20
+    float rating;
+    uint32_t votes;
+    char language[12]; // One of a few codes
+};
+
+const std::vector<uint16_t> TITLE_COLUMNS = {4, 4, 4, 4, 4, 12};
+const char* const LANGUAGES[] = {"en", "fr", "de", "ja", "hi", "es"};
+constexpr int PASSES = 5;
+
+using CompareOp = FilterKernels::CompareOp;
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void removeHeapFile(const std::string& path) {
+    for (const char* suffix : {"", ".wal", ".fsm"}) {
+        unlink((path + suffix).c_str());
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t num_records = argc > 1 ? std::stoul(argv[1]) : 2000000;
+    size_t num_lookups = argc > 2 ? std::stoul(argv[2]) : 1000000;
+    std::string path = argc > 3 ? argv[3] : "encoding_bench.db";
+
+    std::mt19937 rng(11);
+    std::vector<Title> titles(num_records);
+    for (size_t i = 0; i < num_records; i++) {
+        Title& title = titles[i];
+        std::memset(&title, 0, sizeof(title));
+        title.id = static_cast<uint32_t>(i);
+        title.release = 1950 + rng() % 75;
+        title.genre = rng() % 20;
+        title.rating = static_cast<float>(rng() % 100) / 100;
+        title.votes = rng() % 100000;
+        std::strcpy(title.language, LANGUAGES[rng() % 6]);
+    }
+
+    const FilterKernels& kernels = FilterKernels::get();
+    std::cout << "layout,pages,rows_per_page,load_ms,scan_ms,lookups_per_sec,pool_hit_rate\n";
+    size_t plain_pages = 0;
+    for (bool encoded : {false, true}) {
+        removeHeapFile(path);
+        HeapFileOptions options;
+        options.pax_column_widths = TITLE_COLUMNS;
+        options.encode_bulk_loads = encoded;
+
+        std::vector<HeapFile::RecordId> record_ids;
+        auto start = std::chrono::steady_clock::now();
+        size_t pages;
+        {
+            HeapFile heap_file(path, options);
+            record_ids = heap_file.insertRecords(titles.data(), sizeof(Title), num_records);
+            pages = heap_file.getNumPages();
+            heap_file.close();
+        }
+        double load_time = secondsSince(start);
+        if (!encoded) {
+            plain_pages = pages;
+        }
+
+        HeapFileOptions read_options;
+        read_options.buffer_pool_mb = std::max<size_t>(1, plain_pages * SlottedPage::PAGE_SIZE / 4 >> 20);
+        HeapFile heap_file(path, read_options);
+
+        double best_scan = 1e9;
+        uint64_t count = 0;
+        std::vector<uint64_t> selection;
+        std::vector<uint64_t> matches;
+        for (int pass = 0; pass < PASSES; pass++) {
+            start = std::chrono::steady_clock::now();
+            BatchScanner scanner(heap_file, {{offsetof(Title, release), FilterKernels::ColumnType::UINT32},
+                                             {offsetof(Title, genre), FilterKernels::ColumnType::UINT32},
+                                             {offsetof(Title, rating), FilterKernels::ColumnType::FLOAT},
+                                             {offsetof(Title, votes), FilterKernels::ColumnType::UINT32}});
+            FilterKernels::Aggregate votes;
+            while (scanner.next()) {
+                size_t rows = scanner.getNumRows();
+                selection.resize(FilterKernels::selectionWords(rows));
+                matches.resize(selection.size());
+                scanner.compare(0, kernels, CompareOp::LT, 2000u, selection.data());
+                scanner.compare(1, kernels, CompareOp::EQ, 3u, matches.data());
+                FilterKernels::intersect(selection.data(), matches.data(), rows);
+                scanner.compare(2, kernels, CompareOp::GT, 0.9f, matches.data());
+                FilterKernels::intersect(selection.data(), matches.data(), rows);
+                FilterKernels::intersect(selection.data(), scanner.getSelection(), rows);
+                kernels.aggregate(scanner.getColumn<uint32_t>(3), rows, selection.data(), votes);
+            }
+            best_scan = std::min(best_scan, secondsSince(start));
+            count = votes.count;
+        }
+
+        std::uniform_int_distribution<size_t> pick(0, record_ids.size() - 1);
+        std::mt19937 lookup_rng(42);
+        uint64_t checksum = 0;
+        BufferPool::Stats before = heap_file.getBufferPoolStats();
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < num_lookups; i++) {
+            const HeapFile::RecordId& rid = record_ids[pick(lookup_rng)];
+            Title title;
+            heap_file.readRecord(rid.page_id, rid.slot_id, &title, sizeof(title));
+            checksum += title.votes;
+        }
+        double lookup_time = secondsSince(start);
+        BufferPool::Stats after = heap_file.getBufferPoolStats();
+        double hits = static_cast<double>(after.hits - before.hits);
+        double misses = static_cast<double>(after.misses - before.misses);
+        if (count == 0 || checksum == 0) {
+            std::cerr << "unexpected result\n";
+        }
+
+        std::cout << (encoded ? "encoded" : "plain") << "," << pages << ","
+                  << static_cast<double>(num_records) / pages << "," << load_time * 1000 << ","
+                  << best_scan * 1000 << "," << num_lookups / lookup_time << "," << hits / (hits + misses) << "\n";
+        heap_file.close();
+    }
+
+    removeHeapFile(path);
+    return 0;
+}
@@ -0,0 +1,224 @@
+#include <unistd.h>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "storage/batch_scanner.hpp"
+#include "storage/filter_kernels.hpp"
+#include "storage/heap_file.hpp"
+
+// SELECT COUNT(*), SUM(rating), MIN(release), MAX(release)
+// WHERE rating > 0.9 AND release < 2000
+//
+// First over in-memory columns, to time the kernels alone, then over a heap
+// file: the scalar loop calling HeapFile::getRecord per record id, against
+// BatchScanner with each kernel set over slotted pages (fields gathered
+// per page) and over PAX pages read through the mapping (no copies).
+// Reports the best of several warm passes.
+//
+// Usage: filter_bench [num_records] [path]
+
+namespace {
+
+struct Movie {
+    uint32_t id;
+    char title[100];
+    float rating;
+    uint32_t release;
+};
+
+using Kind = FilterKernels::Kind;
+using CompareOp = FilterKernels::CompareOp;
+
+const std::vector<uint16_t> MOVIE_COLUMNS = {4, 100, 4, 4};
+constexpr float MIN_RATING = 0.9f;
+constexpr uint32_t BEFORE_RELEASE = 2000;
+constexpr std::size_t BATCH_ROWS = 1024; // Batch size for in-memory columns
+constexpr int PASSES = 5;
+
+struct Result {
+    uint64_t count = 0;
+    double sum_rating = 0;
+    int64_t min_release = 0;
+    int64_t max_release = 0;
+};
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void removeHeapFile(const std::string& path) {
+    unlink(path.c_str());
+    unlink((path + ".wal").c_str());
+    unlink((path + ".fsm").c_str());
+}
+
+// The query over one batch of columns, with live rows already selected
+struct Query {
+    const FilterKernels& kernels;
+    std::vector<uint64_t> selection;
+    std::vector<uint64_t> matches;
+    FilterKernels::Aggregate rating;
+    FilterKernels::Aggregate release;
+
+    explicit Query(const FilterKernels& kernels)
+        : kernels(kernels),
+          selection(FilterKernels::selectionWords(BATCH_ROWS * 4)),
+          matches(selection.size()) {}
+
+    void run(const float* ratings, const uint32_t* releases, std::size_t rows, const uint64_t* live) {
+        if (selection.size() < FilterKernels::selectionWords(rows)) {
+            selection.resize(FilterKernels::selectionWords(rows));
+            matches.resize(selection.size());
+        }
+        kernels.compare(ratings, rows, CompareOp::GT, MIN_RATING, selection.data());
+        kernels.compare(releases, rows, CompareOp::LT, BEFORE_RELEASE, matches.data());
+        FilterKernels::intersect(selection.data(), matches.data(), rows);
+        if (live != nullptr) {
+            FilterKernels::intersect(selection.data(), live, rows);
+        }
+        kernels.aggregate(ratings, rows, selection.data(), rating);
+        kernels.aggregate(releases, rows, selection.data(), release);
+    }
+
+    Result result() const {
+        return {rating.count, rating.fp_sum, release.int_min, release.int_max};
+    }
+};
+
+void addMatch(Result& result, const Movie& movie) {
+    if (movie.rating > MIN_RATING && movie.release < BEFORE_RELEASE) {
+        result.min_release = result.count == 0 ? movie.release : std::min<int64_t>(result.min_release, movie.release);
+        result.max_release = result.count == 0 ? movie.release : std::max<int64_t>(result.max_release, movie.release);
+        result.count++;
+        result.sum_rating += movie.rating;
+    }
+}
+
+void print(const std::string& name, double best, std::size_t rows, const Result& result) {
+    std::cout << name << "," << best * 1000 << "," << rows / best / 1e6 << "," << result.count << ","
+              << result.sum_rating << "," << result.min_release << "," << result.max_release << "\n";
+}
+
+template <typename Scan>
+void time(const std::string& name, std::size_t rows, Scan scan) {
+    double best = 1e30;
+    Result result;
+    for (int pass = 0; pass < PASSES; pass++) {
+        auto start = std::chrono::steady_clock::now();
+        result = scan();
+        best = std::min(best, secondsSince(start));
+    }
+    print(name, best, rows, result);
+}
+
+std::vector<Kind> supportedKinds() {
+    std::vector<Kind> kinds;
+    for (Kind kind : {Kind::SCALAR, Kind::SSE42, Kind::AVX2}) {
+        if (FilterKernels::isSupported(kind)) {
+            kinds.push_back(kind);
+        }
+    }
+    return kinds;
+}
+
+Result batchScan(HeapFile& heap_file, const FilterKernels& kernels) {
+    BatchScanner scanner(heap_file, {{offsetof(Movie, rating), FilterKernels::ColumnType::FLOAT},
+                                     {offsetof(Movie, release), FilterKernels::ColumnType::UINT32}});
+    Query query(kernels);
+    while (scanner.next()) {
+        query.run(scanner.getColumn<float>(0), scanner.getColumn<uint32_t>(1), scanner.getNumRows(),
+                  scanner.getSelection());
+    }
+    return query.result();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t num_records = argc > 1 ? std::stoul(argv[1]) : 2000000;
+    std::string path = argc > 2 ? argv[2] : "filter_bench.db";
+
+    std::vector<Movie> movies(num_records);
+    std::vector<float> ratings(num_records);
+    std::vector<uint32_t> releases(num_records);
+    for (size_t i = 0; i < num_records; i++) {
+        Movie& movie = movies[i];
+        std::memset(&movie, 0, sizeof(movie));
+        movie.id = static_cast<uint32_t>(i);
+        std::snprintf(movie.title, sizeof(movie.title), "Movie %zu", i);
+        movie.rating = static_cast<float>((i * 7919) % 1000) / 1000;
+        movie.release = static_cast<uint32_t>(1950 + (i * 31) % 75);
+        ratings[i] = movie.rating;
+        releases[i] = movie.release;
+    }
+
+    std::cout << "variant,best_ms,mrows_per_sec,count,sum_rating,min_release,max_release\n";
+    time("memory_scalar_loop", num_records, [&] {
+        Result result;
+        for (const Movie& movie : movies) {
+            addMatch(result, movie);
+        }
+        return result;
+    });
+    for (Kind kind : supportedKinds()) {
+        const FilterKernels& kernels = FilterKernels::get(kind);
+        time(std::string("memory_") + kernels.getName(), num_records, [&] {
+            Query query(kernels);
+            for (size_t first = 0; first < num_records; first += BATCH_ROWS) {
+                size_t rows = std::min(BATCH_ROWS, num_records - first);
+                query.run(ratings.data() + first, releases.data() + first, rows, nullptr);
+            }
+            return query.result();
+        });
+    }
+
+    for (bool pax : {false, true}) {
+        HeapFileOptions load_options;
+        if (pax) {
+            load_options.pax_column_widths = MOVIE_COLUMNS;
+        }
+        removeHeapFile(path);
+        std::vector<HeapFile::RecordId> record_ids;
+        {
+            HeapFile heap_file(path, load_options);
+            record_ids = heap_file.insertRecords(movies.data(), sizeof(Movie), num_records);
+            heap_file.close();
+        }
+
+        if (pax) {
+            HeapFileOptions mapped;
+            mapped.access_mode = HeapFileOptions::AccessMode::MMAP_READ_ONLY;
+            HeapFile heap_file(path, mapped);
+            for (Kind kind : supportedKinds()) {
+                const FilterKernels& kernels = FilterKernels::get(kind);
+                time(std::string("pax_mmap_") + kernels.getName(), num_records,
+                     [&] { return batchScan(heap_file, kernels); });
+            }
+            heap_file.close();
+            continue;
+        }
+
+        HeapFileOptions buffered;
+        buffered.buffer_pool_mb = 2 * num_records * sizeof(Movie) / (1024 * 1024) + 16;
+        HeapFile heap_file(path, buffered);
+        time("row_getrecord_loop", num_records, [&] {
+            Result result;
+            for (const HeapFile::RecordId& rid : record_ids) {
+                addMatch(result, *static_cast<const Movie*>(heap_file.getRecord(rid.page_id, rid.slot_id)));
+            }
+            return result;
+        });
+        for (Kind kind : supportedKinds()) {
+            const FilterKernels& kernels = FilterKernels::get(kind);
+            time(std::string("row_batch_") + kernels.getName(), num_records,
+                 [&] { return batchScan(heap_file, kernels); });
+        }
+        heap_file.close();
+    }
+
+    removeHeapFile(path);
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "storage/b_plus_tree.hpp"
+#include "storage/hash_index.hpp"
+#include "storage/metrics.hpp"
+
+// Point lookups by key through the extendible hash index and, for
+// comparison, the B+-tree: insert throughput of num_keys keys in random
+// order, then the latency of lookups of random present keys (timed one by
+// one), their throughput and the pages each touches, and the pool misses
+// per lookup once the index outgrows a small buffer pool.
+//
+// Usage: hash_index_bench [num_keys] [num_lookups] [path]
+
+namespace {
+
+constexpr std::size_t WARM_POOL_MB = 1024;
+constexpr std::size_t COLD_POOL_MB = 16;
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+HeapFile::RecordId ridFor(uint64_t key) {
+    return {static_cast<uint32_t>(key / 64), static_cast<uint16_t>(key % 64)};
+}
+
+uint64_t keyOf(const void* record, uint16_t) {
+    return *static_cast<const uint64_t*>(record);
+}
+
+template <typename Index>
+void run(const char* name, const std::string& path, const std::vector<uint64_t>& keys,
+         const std::vector<uint64_t>& lookups) {
+    unlink(path.c_str());
+    double insert_time;
+    std::size_t pages;
+    {
+        Index index(path, keyOf, WARM_POOL_MB);
+        auto start = std::chrono::steady_clock::now();
+        for (uint64_t key : keys) {
+            index.insert(key, ridFor(key));
+        }
+        insert_time = secondsSince(start);
+        pages = index.getNumPages();
+        index.close();
+    }
+
+    // Warm: the whole index is resident after the first pass
+    Index index(path, keyOf, WARM_POOL_MB);
+    for (uint64_t key : lookups) {
+        index.find(key);
+    }
+    Histogram latency;
+    std::size_t found = 0;
+    BufferPool::Stats warm_before = index.getBufferPoolStats();
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t key : lookups) {
+        auto begin = std::chrono::steady_clock::now();
+        found += index.find(key).size();
+        latency.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin).count()));
+    }
+    double lookup_time = secondsSince(start);
+    BufferPool::Stats warm_after = index.getBufferPoolStats();
+    double pages_per_lookup = static_cast<double>(warm_after.hits + warm_after.misses - warm_before.hits -
+                                                  warm_before.misses) / lookups.size();
+    index.close();
+    if (found != lookups.size()) {
+        std::cerr << name << ": expected " << lookups.size() << " hits, found " << found << "\n";
+    }
+
+    // Cold: a pool far smaller than the index, so misses show the page
+    // reads each lookup needs
+    Index cold(path, keyOf, COLD_POOL_MB);
+    for (uint64_t key : lookups) {
+        cold.find(key);
+    }
+    BufferPool::Stats before = cold.getBufferPoolStats();
+    for (uint64_t key : lookups) {
+        cold.find(key);
+    }
+    BufferPool::Stats after = cold.getBufferPoolStats();
+    cold.close();
+
+    std::cout << name << "," << keys.size() << "," << keys.size() / insert_time / 1e3 << ","
+              << latency.getPercentile(0.5) << "," << latency.getPercentile(0.99) << ","
+              << lookups.size() / lookup_time / 1e6 << "," << pages_per_lookup << ","
+              << static_cast<double>(after.misses - before.misses) / lookups.size() << "," << pages << "\n";
+    unlink(path.c_str());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t num_keys = argc > 1 ? std::stoul(argv[1]) : 10000000;
+    size_t num_lookups = argc > 2 ? std::stoul(argv[2]) : 1000000;
+    std::string path = argc > 3 ? argv[3] : "hash_index_bench.idx";
+
+    std::vector<uint64_t> keys(num_keys);
+    for (size_t i = 0; i < num_keys; i++) {
+        keys[i] = i;
+    }
+    std::shuffle(keys.begin(), keys.end(), std::mt19937_64(42));
+    std::vector<uint64_t> lookups(num_lookups);
+    std::mt19937_64 rng(7);
+    std::uniform_int_distribution<uint64_t> pick(0, num_keys - 1);
+    for (auto& key : lookups) {
+        key = pick(rng);
+    }
+
+    std::cout << "index,keys,insert_kops_per_sec,lookup_p50_ns,lookup_p99_ns,lookup_mops_per_sec,"
+                 "pages_per_lookup,cold_misses_per_lookup,pages\n";
+    run<HashIndex>("hash", path, keys, lookups);
+    run<BPlusTree>("btree", path, keys, lookups);
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "storage/heap_file.hpp"
+
+// Multi-threaded HeapFile throughput: each configuration runs an insert phase
+// (with a group commit after every insert) followed by a random-read phase on
+// a fresh file, and reports operations per second for each thread count.
+//
+// Usage: heap_file_concurrency_bench [ops_per_thread] [max_threads] [path]
+
+namespace {
+
+constexpr uint16_t RECORD_SIZE = 112;
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <typename Fn>
+double runThreads(size_t num_threads, Fn&& fn) {
+    std::atomic<bool> go{false};
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < num_threads; t++) {
+        workers.emplace_back([&, t] {
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            fn(t);
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return secondsSince(start);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t ops_per_thread = argc > 1 ? std::stoul(argv[1]) : 20000;
+    size_t max_threads = argc > 2 ? std::stoul(argv[2]) : 16;
+    std::string path = argc > 3 ? argv[3] : "concurrency_bench.db";
+
+    std::cout << "threads,insert_commit_ops_per_sec,read_ops_per_sec,log_fsyncs,commits_per_fsync\n";
+
+    for (size_t num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+        unlink(path.c_str());
+        unlink((path + ".wal").c_str());
+        unlink((path + ".fsm").c_str());
+
+        HeapFileOptions options;
+        options.buffer_pool_mb = 64;
+        HeapFile heap_file(path, options);
+
+        double insert_secs = runThreads(num_threads, [&](size_t t) {
+            uint8_t record[RECORD_SIZE];
+            std::memset(record, static_cast<int>(t), sizeof(record));
+            for (size_t i = 0; i < ops_per_thread; i++) {
+                std::memcpy(record, &i, sizeof(i));
+                heap_file.insertRecord(record, sizeof(record));
+                heap_file.commit();
+            }
+        });
+        auto log_stats = heap_file.getLogStats();
+
+        size_t num_pages = heap_file.getNumPages();
+        double read_secs = runThreads(num_threads, [&](size_t t) {
+            std::mt19937 rng(static_cast<uint32_t>(t));
+            std::uniform_int_distribution<uint32_t> page_dist(0, static_cast<uint32_t>(num_pages - 1));
+            std::uniform_int_distribution<uint16_t> slot_dist(0, SlottedPage::PAGE_SIZE / RECORD_SIZE);
+            uint8_t buffer[RECORD_SIZE];
+            for (size_t i = 0; i < ops_per_thread; i++) {
+                heap_file.readRecord(page_dist(rng), slot_dist(rng), buffer, sizeof(buffer));
+            }
+        });
+
+        double total_ops = static_cast<double>(num_threads * ops_per_thread);
+        std::cout << num_threads << ","
+                  << static_cast<uint64_t>(total_ops / insert_secs) << ","
+                  << static_cast<uint64_t>(total_ops / read_secs) << ","
+                  << log_stats.fsyncs << ","
+                  << (log_stats.fsyncs ? total_ops / log_stats.fsyncs : 0.0) << "\n";
+
+        heap_file.close();
+    }
+
+    unlink(path.c_str());
+    unlink((path + ".wal").c_str());
+    unlink((path + ".fsm").c_str());
+    return 0;
+}
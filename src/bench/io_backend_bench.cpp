@@ -0,0 +1,88 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "storage/io_backend.hpp"
+#include "storage/slotted_page.hpp"
+
+// Page write and random page read throughput of each I/O backend, issuing
+// requests in batches, with and without O_DIRECT.
+//
+// Usage: io_backend_bench [num_pages] [batch_pages] [path]
+
+namespace {
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t num_pages = argc > 1 ? std::stoul(argv[1]) : 65536;
+    size_t batch_pages = argc > 2 ? std::stoul(argv[2]) : 64;
+    std::string path = argc > 3 ? argv[3] : "io_backend_bench.db";
+    const size_t page_size = SlottedPage::PAGE_SIZE;
+
+    AlignedBuffer buffer = allocateAligned(batch_pages * page_size);
+    std::vector<IoBackend::Request> requests(batch_pages);
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<size_t> pick(0, num_pages - 1);
+
+    std::cout << "backend,direct_io,write_mb_per_sec,random_read_kiops\n";
+    for (auto kind : {IoBackend::Kind::SYNC, IoBackend::Kind::IO_URING}) {
+        std::unique_ptr<IoBackend> backend;
+        try {
+            backend = IoBackend::create(kind);
+        } catch (const std::exception& e) {
+            std::cerr << "skipping io_uring: " << e.what() << "\n";
+            continue;
+        }
+
+        for (bool direct_io : {false, true}) {
+            unlink(path.c_str());
+            int fd = open(path.c_str(), O_RDWR | O_CREAT | (direct_io ? O_DIRECT : 0), 0644);
+            if (fd == -1) {
+                std::cerr << "skipping direct_io=" << direct_io << ": open failed\n";
+                continue;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+            for (size_t first = 0; first < num_pages; first += batch_pages) {
+                size_t count = std::min(batch_pages, num_pages - first);
+                for (size_t i = 0; i < count; i++) {
+                    requests[i] = {IoBackend::Request::Op::WRITE, fd, buffer.get() + i * page_size, page_size,
+                                   static_cast<off_t>((first + i) * page_size), 0};
+                }
+                backend->submit(requests.data(), count);
+            }
+            fdatasync(fd);
+            double write_secs = secondsSince(start);
+
+            size_t reads = 0;
+            start = std::chrono::steady_clock::now();
+            for (size_t first = 0; first < num_pages; first += batch_pages) {
+                size_t count = std::min(batch_pages, num_pages - first);
+                for (size_t i = 0; i < count; i++) {
+                    requests[i] = {IoBackend::Request::Op::READ, fd, buffer.get() + i * page_size, page_size,
+                                   static_cast<off_t>(pick(rng) * page_size), 0};
+                }
+                backend->submit(requests.data(), count);
+                reads += count;
+            }
+            double read_secs = secondsSince(start);
+
+            std::cout << backend->getName() << "," << direct_io << ","
+                      << num_pages * page_size / write_secs / (1024.0 * 1024) << ","
+                      << reads / read_secs / 1000 << "\n";
+            ::close(fd);
+        }
+    }
+
+    unlink(path.c_str());
+    return 0;
+}
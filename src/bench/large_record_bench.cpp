@@ -0,0 +1,84 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "storage/heap_file.hpp"
+#include "storage/large_record.hpp"
+
+// Streaming throughput of large records: each value is written through
+// LargeRecordWriter and read back through LargeRecordReader in pieces of
+// the given size, so neither side ever holds the whole value. Also reports
+// the overflow pages used per value.
+//
+// Usage: large_record_bench [value_mb] [num_values] [piece_kb] [path]
+
+namespace {
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void removeHeapFile(const std::string& path) {
+    unlink(path.c_str());
+    unlink((path + ".wal").c_str());
+    unlink((path + ".fsm").c_str());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t value_mb = argc > 1 ? std::stoul(argv[1]) : 64;
+    size_t num_values = argc > 2 ? std::stoul(argv[2]) : 8;
+    size_t piece_kb = argc > 3 ? std::stoul(argv[3]) : 256;
+    std::string path = argc > 4 ? argv[4] : "large_record_bench.db";
+
+    const size_t value_bytes = value_mb * 1024 * 1024;
+    std::vector<uint8_t> piece(piece_kb * 1024);
+
+    removeHeapFile(path);
+    HeapFile heap_file(path);
+    std::vector<HeapFile::RecordId> rids;
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t v = 0; v < num_values; v++) {
+        LargeRecordWriter writer(heap_file);
+        for (size_t written = 0; written < value_bytes; written += piece.size()) {
+            std::memset(piece.data(), static_cast<int>(v + written / piece.size()), piece.size());
+            writer.write(piece.data(), std::min(piece.size(), value_bytes - written));
+        }
+        rids.push_back(writer.finish());
+    }
+    double write_secs = secondsSince(start);
+    size_t pages_per_value = heap_file.getNumPages() / num_values;
+
+    // Drop the file from the page cache so reads come from the device
+    heap_file.sync();
+    posix_fadvise(heap_file.getFileDescriptor(), 0, 0, POSIX_FADV_DONTNEED);
+
+    size_t errors = 0;
+    start = std::chrono::steady_clock::now();
+    for (size_t v = 0; v < num_values; v++) {
+        LargeRecordReader reader(heap_file, rids[v]);
+        size_t offset = 0;
+        while (size_t n = reader.read(piece.data(), piece.size())) {
+            if (piece[0] != static_cast<uint8_t>(v + offset / piece.size()) || piece[n - 1] != piece[0]) {
+                errors++;
+            }
+            offset += n;
+        }
+        errors += offset != value_bytes;
+    }
+    double read_secs = secondsSince(start);
+
+    double total_mb = static_cast<double>(value_bytes) * num_values / (1024 * 1024);
+    std::cout << "value_mb,values,piece_kb,pages_per_value,write_mb_per_sec,read_mb_per_sec,errors\n"
+              << value_mb << "," << num_values << "," << piece_kb << "," << pages_per_value << ","
+              << total_mb / write_secs << "," << total_mb / read_secs << "," << errors << "\n";
+
+    heap_file.close();
+    removeHeapFile(path);
+    return errors == 0 ? 0 : 1;
+}
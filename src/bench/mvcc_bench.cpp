@@ -0,0 +1,130 @@
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "storage/mvcc_heap.hpp"
+
+// Updates against an MVCC heap with and without full-table snapshot scans
+// running alongside: update throughput of the writers alone, then with a
+// scanner looping over fresh snapshots, the scans completed and their row
+// rate, and whether every scan saw each row exactly once. Ends with the
+// versions a final vacuum reclaims.
+//
+// Usage: mvcc_bench [num_rows] [num_writers] [seconds] [path]
+
+namespace {
+
+constexpr uint16_t ROW_SIZE = 100;
+
+struct Row {
+    uint64_t id;
+    uint64_t value;
+    uint8_t payload[ROW_SIZE - 2 * sizeof(uint64_t)];
+};
+
+void removeHeapFile(const std::string& path) {
+    for (const char* suffix : {"", ".wal", ".fsm", ".mvcc"}) {
+        unlink((path + suffix).c_str());
+    }
+}
+
+// Writers update the rows of their own stripe for the given time; returns updates per second
+double runWriters(MvccHeap& heap, std::vector<MvccHeap::RecordId>& rids, size_t num_writers, double seconds) {
+    std::atomic<uint64_t> updates{0};
+    std::vector<std::thread> writers;
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::duration<double>(seconds);
+    for (size_t w = 0; w < num_writers; w++) {
+        writers.emplace_back([&, w] {
+            std::mt19937_64 rng(w + 1);
+            Row row = {};
+            uint64_t done = 0;
+            while (std::chrono::steady_clock::now() < deadline) {
+                for (int i = 0; i < 64; i++) {
+                    size_t idx = (rng() % (rids.size() / num_writers)) * num_writers + w;
+                    row.id = idx;
+                    row.value = rng();
+                    if (heap.update(rids[idx], &row, sizeof(row))) {
+                        done++;
+                    }
+                }
+            }
+            updates += done;
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    return updates / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t num_rows = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    size_t num_writers = argc > 2 ? std::stoul(argv[2]) : 4;
+    double seconds = argc > 3 ? std::stod(argv[3]) : 5;
+    std::string path = argc > 4 ? argv[4] : "mvcc_bench.db";
+    num_rows = std::max(num_rows, num_writers);
+
+    removeHeapFile(path);
+    MvccHeap heap(path);
+    std::vector<MvccHeap::RecordId> rids(num_rows);
+    Row row = {};
+    for (size_t i = 0; i < num_rows; i++) {
+        row.id = i;
+        rids[i] = heap.insert(&row, sizeof(row));
+    }
+    heap.commit();
+
+    double alone = runWriters(heap, rids, num_writers, seconds);
+
+    // One scanner loops over fresh snapshots while the writers run
+    std::atomic<bool> stop{false};
+    uint64_t scans = 0;
+    uint64_t rows_scanned = 0;
+    uint64_t inconsistent = 0;
+    double scan_time = 0;
+    std::thread scanner_thread([&] {
+        std::vector<uint8_t> seen(num_rows);
+        auto start = std::chrono::steady_clock::now();
+        while (!stop) {
+            std::fill(seen.begin(), seen.end(), 0);
+            MvccHeap::Snapshot snapshot = heap.beginSnapshot();
+            size_t count = 0;
+            bool torn = false;
+            for (MvccHeap::Scanner scanner(heap, snapshot); scanner.next();) {
+                uint64_t id;
+                std::memcpy(&id, scanner.getRecord(), sizeof(id));
+                torn |= id >= num_rows || seen[id]++ != 0;
+                count++;
+            }
+            rows_scanned += count;
+            inconsistent += torn || count != num_rows;
+            scans++;
+        }
+        scan_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    });
+    double with_scans = runWriters(heap, rids, num_writers, seconds);
+    stop = true;
+    scanner_thread.join();
+
+    size_t pages = heap.getHeapFile().getNumPages();
+    auto start = std::chrono::steady_clock::now();
+    size_t reclaimed = heap.vacuum();
+    double vacuum_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cout << "rows,writers,updates_per_sec,updates_per_sec_with_scans,scans,scan_mrows_per_sec,"
+                 "inconsistent_scans,pages,vacuumed_versions,vacuum_sec\n";
+    std::cout << num_rows << "," << num_writers << "," << alone << "," << with_scans << "," << scans << ","
+              << rows_scanned / scan_time / 1e6 << "," << inconsistent << "," << pages << "," << reclaimed << ","
+              << vacuum_time << "\n";
+    heap.close();
+    removeHeapFile(path);
+    return 0;
+}
@@ -0,0 +1,113 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "storage/slotted_page.hpp"
+
+// Page size trade-off on the same data: fill factor, a sequential scan that
+// reads one page per system call, and random point reads that must read a
+// whole page for one record. Bigger pages cut per-page overhead and
+// syscalls for scans but read more bytes per point lookup.
+//
+// Usage: page_size_bench [data_mb] [record_size] [num_lookups] [path]
+
+namespace {
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+template <std::size_t PageSize>
+void run(std::size_t data_mb, uint16_t record_size, std::size_t num_lookups, const std::string& path) {
+    using Page = BasicSlottedPage<PageSize>;
+    const std::size_t num_records = data_mb * 1024 * 1024 / record_size;
+
+    unlink(path.c_str());
+    int fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd == -1) {
+        std::cerr << "failed to open " << path << "\n";
+        return;
+    }
+
+    // Load: fill each page before writing it
+    std::vector<uint8_t> record(record_size, 0x5a);
+    Page page(Page::PageType::LEAF, 0);
+    uint32_t num_pages = 0;
+    std::size_t records_per_page = 0;
+    for (std::size_t i = 0; i < num_records; i++) {
+        if (page.getHeader().total_free < record_size + sizeof(typename Page::CellPointer)) {
+            page.savePage(fd);
+            page.reset(Page::PageType::LEAF, ++num_pages);
+        }
+        page.addCell(record.data(), record_size);
+        if (num_pages == 0) {
+            records_per_page++;
+        }
+    }
+    page.savePage(fd);
+    num_pages++;
+    fdatasync(fd);
+
+    // Sequential scan, one pread per page
+    uint64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t page_id = 0; page_id < num_pages; page_id++) {
+        if (pread(fd, page.getData(), PageSize, static_cast<off_t>(page_id) * PageSize) !=
+            static_cast<ssize_t>(PageSize)) {
+            std::cerr << "short read\n";
+            break;
+        }
+        auto pointers = page.getPointerList();
+        for (std::size_t slot = 0; slot < pointers.size; slot++) {
+            checksum += *static_cast<const uint8_t*>(page.getCell(slot));
+        }
+    }
+    double scan_secs = secondsSince(start);
+
+    // Random point reads
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<std::size_t> pick(0, num_records - 1);
+    start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < num_lookups; i++) {
+        std::size_t idx = pick(rng);
+        uint32_t page_id = idx / records_per_page;
+        pread(fd, page.getData(), PageSize, static_cast<off_t>(page_id) * PageSize);
+        checksum += *static_cast<const uint8_t*>(page.getCell(idx % records_per_page));
+    }
+    double lookup_secs = secondsSince(start);
+
+    if (checksum == 0) {
+        std::cerr << "unexpected checksum\n";
+    }
+    double file_bytes = static_cast<double>(num_pages) * PageSize;
+    std::cout << PageSize << "," << records_per_page << ","
+              << num_records * record_size / file_bytes << ","
+              << file_bytes / scan_secs / 1e9 << "," << num_pages << ","
+              << lookup_secs / num_lookups * 1e6 << ","
+              << static_cast<double>(PageSize) / record_size << "\n";
+
+    ::close(fd);
+    unlink(path.c_str());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::size_t data_mb = argc > 1 ? std::stoul(argv[1]) : 256;
+    uint16_t record_size = argc > 2 ? std::stoul(argv[2]) : 200;
+    std::size_t num_lookups = argc > 3 ? std::stoul(argv[3]) : 500000;
+    std::string path = argc > 4 ? argv[4] : "page_size_bench.db";
+
+    std::cout << "page_size,records_per_page,fill_factor,scan_gb_per_sec,scan_syscalls,"
+                 "point_read_us,read_amplification\n";
+    run<4096>(data_mb, record_size, num_lookups, path);
+    run<8192>(data_mb, record_size, num_lookups, path);
+    run<16384>(data_mb, record_size, num_lookups, path);
+    run<32768>(data_mb, record_size, num_lookups, path);
+    run<65536>(data_mb, record_size, num_lookups, path);
+    return 0;
+}
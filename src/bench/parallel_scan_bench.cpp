@@ -0,0 +1,84 @@
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "storage/heap_file.hpp"
+#include "storage/parallel_scan.hpp"
+
+// Bulk load and full-table scan throughput by thread count: a parallel
+// insertRecords() into a fresh file, then SUM over one field through
+// ParallelScan (best of several warm passes). Speedups are bounded by the
+// cores of the machine, which goes to stderr.
+//
+// Usage: parallel_scan_bench [num_records] [record_size] [path]
+
+namespace {
+
+constexpr int PASSES = 3;
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void removeHeapFile(const std::string& path) {
+    for (const char* suffix : {"", ".wal", ".fsm"}) {
+        unlink((path + suffix).c_str());
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t num_records = argc > 1 ? std::stoul(argv[1]) : 4000000;
+    uint16_t record_size = argc > 2 ? static_cast<uint16_t>(std::stoul(argv[2])) : 112;
+    std::string path = argc > 3 ? argv[3] : "parallel_scan_bench.db";
+    record_size = std::max<uint16_t>(record_size, sizeof(uint64_t));
+
+    std::vector<uint8_t> rows(num_records * record_size);
+    uint64_t expected = 0;
+    for (size_t i = 0; i < num_records; i++) {
+        std::memcpy(rows.data() + i * record_size, &i, sizeof(i));
+        expected += i;
+    }
+
+    std::cerr << "hardware threads: " << std::thread::hardware_concurrency() << "\n";
+    std::cout << "threads,load_mb_per_sec,scan_gb_per_sec,morsels\n";
+    for (size_t threads : {1, 2, 4, 8, 16, 32}) {
+        removeHeapFile(path);
+        HeapFile heap_file(path);
+
+        auto start = std::chrono::steady_clock::now();
+        heap_file.insertRecords(rows.data(), record_size, num_records, threads);
+        double load_time = secondsSince(start);
+        double file_bytes = static_cast<double>(heap_file.getNumPages()) * SlottedPage::PAGE_SIZE;
+
+        ParallelScan scan(heap_file, threads);
+        double best_scan = 1e9;
+        for (int pass = 0; pass < PASSES; pass++) {
+            start = std::chrono::steady_clock::now();
+            uint64_t sum = scan.aggregate<uint64_t>(
+                0,
+                [](uint64_t& partial, const HeapScanner& scanner) {
+                    uint64_t key;
+                    std::memcpy(&key, scanner.getRecord(), sizeof(key));
+                    partial += key;
+                },
+                [](uint64_t& result, const uint64_t& partial) { result += partial; });
+            best_scan = std::min(best_scan, secondsSince(start));
+            if (sum != expected) {
+                std::cerr << "unexpected sum\n";
+            }
+        }
+
+        std::cout << threads << "," << static_cast<double>(num_records) * record_size / load_time / (1024.0 * 1024)
+                  << "," << file_bytes / best_scan / (1024.0 * 1024 * 1024) << "," << scan.getNumMorsels() << "\n";
+        heap_file.close();
+    }
+
+    removeHeapFile(path);
+    return 0;
+}
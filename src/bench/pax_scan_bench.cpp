@@ -0,0 +1,164 @@
+#include <unistd.h>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "storage/column_scanner.hpp"
+#include "storage/heap_file.hpp"
+#include "storage/heap_scanner.hpp"
+
+// One- and two-column aggregates over Movie-style records stored row-wise
+// in slotted pages and column-wise in PAX pages, each read through the
+// buffered chunk scanners and through the read-only mapping. Reports the
+// best of several warm passes.
+//
+//   sum_rating     SELECT SUM(rating)
+//   recent_rating  SELECT SUM(rating) WHERE year >= 2000
+//
+// Usage: pax_scan_bench [num_records] [path]
+
+namespace {
+
+#pragma pack(push, 1)
+struct Movie {
+    uint32_t id;
+    char title[96];
+    float rating;
+    uint16_t year;
+    uint16_t runtime;
+    uint32_t votes;
+};
+#pragma pack(pop)
+
+const std::vector<uint16_t> MOVIE_COLUMNS = {4, 96, 4, 2, 2, 4};
+constexpr uint16_t RATING = 2;
+constexpr uint16_t YEAR = 3;
+constexpr int PASSES = 5;
+
+struct Result {
+    double sum_rating = 0;
+    double recent_rating = 0;
+};
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void removeHeapFile(const std::string& path) {
+    unlink(path.c_str());
+    unlink((path + ".wal").c_str());
+    unlink((path + ".fsm").c_str());
+}
+
+Result scanRows(HeapFile& heap_file) {
+    Result result;
+    HeapScanner scanner(heap_file);
+    while (scanner.next()) {
+        const auto* movie = static_cast<const Movie*>(scanner.getRecord());
+        result.sum_rating += movie->rating;
+        if (movie->year >= 2000) {
+            result.recent_rating += movie->rating;
+        }
+    }
+    return result;
+}
+
+Result scanMappedRows(HeapFile& heap_file) {
+    Result result;
+    for (uint32_t page_id = 0; page_id < heap_file.getNumPages(); page_id++) {
+        for (uint16_t slot = 0;; slot++) {
+            const auto* movie = static_cast<const Movie*>(heap_file.getRecord(page_id, slot));
+            if (movie == nullptr) {
+                break;
+            }
+            result.sum_rating += movie->rating;
+            if (movie->year >= 2000) {
+                result.recent_rating += movie->rating;
+            }
+        }
+    }
+    return result;
+}
+
+Result scanColumns(HeapFile& heap_file) {
+    Result result;
+    ColumnScanner scanner(heap_file, {RATING, YEAR});
+    while (scanner.next()) {
+        const auto* ratings = reinterpret_cast<const float*>(scanner.getColumn(0));
+        const auto* years = reinterpret_cast<const uint16_t*>(scanner.getColumn(1));
+        for (size_t row = 0; row < scanner.getNumRows(); row++) {
+            if (scanner.isLive(row)) {
+                result.sum_rating += ratings[row];
+                if (years[row] >= 2000) {
+                    result.recent_rating += ratings[row];
+                }
+            }
+        }
+    }
+    return result;
+}
+
+template <typename Scan>
+void run(const char* name, const std::string& path, const HeapFileOptions& options, Scan scan, size_t num_records) {
+    HeapFile heap_file(path, options);
+    double best = 1e30;
+    Result result;
+    for (int pass = 0; pass < PASSES; pass++) {
+        auto start = std::chrono::steady_clock::now();
+        result = scan(heap_file);
+        best = std::min(best, secondsSince(start));
+    }
+    double file_mb = static_cast<double>(heap_file.getNumPages()) * SlottedPage::PAGE_SIZE / (1024 * 1024);
+    std::cout << name << "," << heap_file.getNumPages() << "," << file_mb << "," << best * 1000 << ","
+              << num_records / best / 1e6 << "," << result.sum_rating << "," << result.recent_rating << "\n";
+    heap_file.close();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t num_records = argc > 1 ? std::stoul(argv[1]) : 2000000;
+    std::string path = argc > 2 ? argv[2] : "pax_scan_bench.db";
+
+    std::vector<Movie> movies(num_records);
+    for (size_t i = 0; i < num_records; i++) {
+        Movie& movie = movies[i];
+        std::memset(&movie, 0, sizeof(movie));
+        movie.id = static_cast<uint32_t>(i);
+        std::snprintf(movie.title, sizeof(movie.title), "Movie %zu", i);
+        movie.rating = static_cast<float>(i % 100) / 10;
+        movie.year = static_cast<uint16_t>(1950 + i % 75);
+        movie.runtime = static_cast<uint16_t>(80 + i % 100);
+        movie.votes = static_cast<uint32_t>(i * 7);
+    }
+
+    std::cout << "layout,pages,file_mb,best_ms,mrows_per_sec,sum_rating,recent_rating\n";
+    for (bool pax : {false, true}) {
+        HeapFileOptions load_options;
+        if (pax) {
+            load_options.pax_column_widths = MOVIE_COLUMNS;
+        }
+        removeHeapFile(path);
+        {
+            HeapFile heap_file(path, load_options);
+            heap_file.insertRecords(movies.data(), sizeof(Movie), num_records);
+            heap_file.close();
+        }
+
+        HeapFileOptions buffered;
+        HeapFileOptions mapped;
+        mapped.access_mode = HeapFileOptions::AccessMode::MMAP_READ_ONLY;
+        if (pax) {
+            run("pax_chunked", path, buffered, scanColumns, num_records);
+            run("pax_mmap", path, mapped, scanColumns, num_records);
+        } else {
+            run("row_chunked", path, buffered, scanRows, num_records);
+            run("row_mmap", path, mapped, scanMappedRows, num_records);
+        }
+    }
+
+    removeHeapFile(path);
+    return 0;
+}
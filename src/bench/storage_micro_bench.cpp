@@ -0,0 +1,355 @@
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "storage/heap_file.hpp"
+#include "storage/slotted_page.hpp"
+
+// Google Benchmark suite for the SlottedPage and HeapFile hot paths, meant
+// to be diffed between releases: cell operations on one in-memory page,
+// then record operations on a heap file across record sizes, working sets
+// that fit the buffer pool (hit path) or are four times its size (miss
+// path, served from the OS page cache), sequential or random record order,
+// and the cost of sync() for a given number of dirty pages.
+//
+// Usage: storage_micro_bench [benchmark flags] [path]
+//
+// Results are machine-readable with the library's own flags, e.g.
+//   storage_micro_bench --benchmark_out=micro.json --benchmark_out_format=json
+// and compare.py from Google Benchmark diffs two such files. HeapFile
+// benchmarks also report allocs_per_op, the operator new calls per
+// iteration, which should be zero for reads, deletes and compactions once
+// the buffer pool is built.
+
+namespace {
+
+std::string bench_path = "micro_bench.db";
+
+// Counted by the replacement operator new below
+std::atomic<uint64_t> num_allocations{0};
+
+constexpr std::size_t POOL_MB = 16;
+const std::vector<int64_t> RECORD_SIZES = {16, 100, 1000};
+
+using Page = SlottedPage;
+
+void removeHeapFile(const std::string& path) {
+    for (const char* suffix : {"", ".wal", ".fsm"}) {
+        unlink((path + suffix).c_str());
+    }
+}
+
+// Fill an empty page with record_size cells; returns the cells added
+uint16_t fillPage(Page& page, const std::vector<uint8_t>& record) {
+    page.reset(Page::PageType::LEAF, 0);
+    uint16_t cells = 0;
+    while (page.getHeader().total_free >= record.size() + sizeof(Page::CellPointer)) {
+        page.addCell(record.data(), static_cast<uint16_t>(record.size()));
+        cells++;
+    }
+    return cells;
+}
+
+// Slot or record order: 0..count-1, shuffled when random
+std::vector<uint32_t> accessOrder(std::size_t count, bool random) {
+    std::vector<uint32_t> order(count);
+    std::iota(order.begin(), order.end(), 0);
+    if (random) {
+        std::shuffle(order.begin(), order.end(), std::mt19937(7));
+    }
+    return order;
+}
+
+// Heap file bulk-loaded with num_records copies of one record, removed
+// when destroyed. The background checkpointer is off so that a checkpoint
+// never lands inside a timed region.
+class LoadedHeapFile {
+public:
+    LoadedHeapFile(uint16_t record_size, std::size_t num_records, std::size_t pool_mb = POOL_MB)
+        : record(record_size, 0x5a) {
+        removeHeapFile(bench_path);
+        HeapFileOptions options;
+        options.buffer_pool_mb = pool_mb;
+        options.checkpoint_interval_ms = 0;
+        heap_file = std::make_unique<HeapFile>(bench_path, options);
+        if (num_records > 0) {
+            std::vector<uint8_t> records(num_records * record_size, 0x5a);
+            record_ids = heap_file->insertRecords(records.data(), record_size, num_records);
+        }
+    }
+
+    ~LoadedHeapFile() {
+        heap_file->close();
+        heap_file.reset();
+        removeHeapFile(bench_path);
+    }
+
+    HeapFile& get() { return *heap_file; }
+
+    std::unique_ptr<HeapFile> heap_file;
+    std::vector<HeapFile::RecordId> record_ids;
+    std::vector<uint8_t> record;
+};
+
+void reportAllocations(benchmark::State& state, uint64_t before) {
+    state.counters["allocs_per_op"] =
+        static_cast<double>(num_allocations.load(std::memory_order_relaxed) - before) / state.iterations();
+}
+
+void reportHitRate(benchmark::State& state, const BufferPool::Stats& before, const BufferPool::Stats& after) {
+    double hits = static_cast<double>(after.hits - before.hits);
+    double misses = static_cast<double>(after.misses - before.misses);
+    state.counters["hit_rate"] = hits + misses > 0 ? hits / (hits + misses) : 0;
+}
+
+// SlottedPage
+
+// One iteration fills an empty page
+void BM_SlottedPage_AddCell(benchmark::State& state) {
+    Page page(Page::PageType::LEAF, 0);
+    std::vector<uint8_t> record(state.range(0), 0x5a);
+    uint16_t cells = 0;
+    for (auto _ : state) {
+        cells = fillPage(page, record);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * cells);
+    state.counters["cells_per_page"] = cells;
+}
+BENCHMARK(BM_SlottedPage_AddCell)->ArgName("record_size")->ArgsProduct({RECORD_SIZES});
+
+// One iteration refills a full page after every cell but the last was
+// removed and compacted away, so each add searches the pointer array for a
+// tombstone
+void BM_SlottedPage_AddCellReusingSlots(benchmark::State& state) {
+    Page page(Page::PageType::LEAF, 0);
+    std::vector<uint8_t> record(state.range(0), 0x5a);
+    uint16_t cells = fillPage(page, record) - 1;
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (uint16_t slot = 0; slot < cells; slot++) {
+            page.removeCell(slot);
+        }
+        page.compact();
+        state.ResumeTiming();
+        for (uint16_t slot = 0; slot < cells; slot++) {
+            page.addCell(record.data(), static_cast<uint16_t>(record.size()));
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * cells);
+}
+BENCHMARK(BM_SlottedPage_AddCellReusingSlots)->ArgName("record_size")->ArgsProduct({RECORD_SIZES});
+
+void BM_SlottedPage_GetCell(benchmark::State& state) {
+    Page page(Page::PageType::LEAF, 0);
+    std::vector<uint8_t> record(state.range(0), 0x5a);
+    std::vector<uint32_t> order = accessOrder(fillPage(page, record), state.range(1) != 0);
+    std::size_t next = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(page.getCell(static_cast<uint16_t>(order[next])));
+        if (++next == order.size()) {
+            next = 0;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SlottedPage_GetCell)->ArgNames({"record_size", "random"})->ArgsProduct({RECORD_SIZES, {0, 1}});
+
+// One iteration removes every cell of a full page
+void BM_SlottedPage_RemoveCell(benchmark::State& state) {
+    Page page(Page::PageType::LEAF, 0);
+    std::vector<uint8_t> record(state.range(0), 0x5a);
+    std::vector<uint32_t> order = accessOrder(fillPage(page, record), state.range(1) != 0);
+    for (auto _ : state) {
+        state.PauseTiming();
+        fillPage(page, record);
+        state.ResumeTiming();
+        for (uint32_t slot : order) {
+            page.removeCell(static_cast<uint16_t>(slot));
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * order.size());
+}
+BENCHMARK(BM_SlottedPage_RemoveCell)->ArgNames({"record_size", "random"})->ArgsProduct({RECORD_SIZES, {0, 1}});
+
+// One iteration compacts a full page with every other cell removed
+void BM_SlottedPage_Compact(benchmark::State& state) {
+    Page page(Page::PageType::LEAF, 0);
+    std::vector<uint8_t> record(state.range(0), 0x5a);
+    uint16_t cells = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        cells = fillPage(page, record);
+        for (uint16_t slot = 0; slot < cells; slot += 2) {
+            page.removeCell(slot);
+        }
+        state.ResumeTiming();
+        page.compact();
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * (cells / 2) * record.size());
+}
+BENCHMARK(BM_SlottedPage_Compact)->ArgName("record_size")->ArgsProduct({RECORD_SIZES});
+
+// HeapFile
+
+// Appends to one file for the whole run; the log is never committed
+void BM_HeapFile_InsertRecord(benchmark::State& state) {
+    LoadedHeapFile file(static_cast<uint16_t>(state.range(0)), 0);
+    uint64_t allocations = num_allocations;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(file.get().insertRecord(file.record.data(), static_cast<uint16_t>(file.record.size())));
+    }
+    reportAllocations(state, allocations);
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+    state.counters["pages"] = static_cast<double>(file.get().getNumPages());
+}
+BENCHMARK(BM_HeapFile_InsertRecord)->ArgName("record_size")->ArgsProduct({RECORD_SIZES})->UseRealTime();
+
+// Working set in MB against the POOL_MB buffer pool: 4 stays resident,
+// 64 misses on most pages
+void BM_HeapFile_GetRecord(benchmark::State& state) {
+    std::size_t num_records = (state.range(1) << 20) / (state.range(0) + sizeof(SlottedPage::CellPointer));
+    LoadedHeapFile file(static_cast<uint16_t>(state.range(0)), num_records);
+    std::vector<uint32_t> order = accessOrder(file.record_ids.size(), state.range(2) != 0);
+    HeapFile& heap_file = file.get();
+
+    // One untimed pass so that both cases start from a warm pool
+    for (const HeapFile::RecordId& rid : file.record_ids) {
+        benchmark::DoNotOptimize(heap_file.getRecord(rid.page_id, rid.slot_id));
+    }
+    BufferPool::Stats before = heap_file.getBufferPoolStats();
+    uint64_t allocations = num_allocations;
+    std::size_t next = 0;
+    for (auto _ : state) {
+        const HeapFile::RecordId& rid = file.record_ids[order[next]];
+        benchmark::DoNotOptimize(heap_file.getRecord(rid.page_id, rid.slot_id));
+        if (++next == order.size()) {
+            next = 0;
+        }
+    }
+    reportAllocations(state, allocations);
+    reportHitRate(state, before, heap_file.getBufferPoolStats());
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HeapFile_GetRecord)
+    ->ArgNames({"record_size", "working_set_mb", "random"})
+    ->ArgsProduct({RECORD_SIZES, {4, 64}, {0, 1}})
+    ->UseRealTime();
+
+// Deletes the records of a bulk-loaded file in load or random order,
+// loading a fresh file (untimed) whenever they run out
+void BM_HeapFile_DeleteRecord(benchmark::State& state) {
+    constexpr std::size_t NUM_RECORDS = 1 << 16;
+    std::unique_ptr<LoadedHeapFile> file;
+    std::vector<uint32_t> order = accessOrder(NUM_RECORDS, state.range(1) != 0);
+    std::size_t next = order.size();
+    uint64_t allocations = num_allocations;
+    for (auto _ : state) {
+        if (next == order.size()) {
+            state.PauseTiming();
+            uint64_t reload_start = num_allocations;
+            file.reset();
+            file = std::make_unique<LoadedHeapFile>(static_cast<uint16_t>(state.range(0)), NUM_RECORDS);
+            next = 0;
+            allocations += num_allocations - reload_start;
+            state.ResumeTiming();
+        }
+        const HeapFile::RecordId& rid = file->record_ids[order[next++]];
+        benchmark::DoNotOptimize(file->get().deleteRecord(rid.page_id, rid.slot_id));
+    }
+    reportAllocations(state, allocations);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HeapFile_DeleteRecord)
+    ->ArgNames({"record_size", "random"})
+    ->ArgsProduct({RECORD_SIZES, {0, 1}})
+    ->UseRealTime();
+
+// One iteration dirties that many pages (one delete each) untimed, then
+// syncs: write-back, fsync of the data file and log truncation
+void BM_HeapFile_Sync(benchmark::State& state) {
+    constexpr uint16_t RECORD_SIZE = 100;
+    const std::size_t dirty_pages = static_cast<std::size_t>(state.range(0));
+    const std::size_t records_per_page =
+        (SlottedPage::PAGE_SIZE - 1 - sizeof(SlottedPage::PageHeader)) / (RECORD_SIZE + sizeof(SlottedPage::CellPointer));
+    std::unique_ptr<LoadedHeapFile> file;
+    std::size_t next = records_per_page;
+    for (auto _ : state) {
+        state.PauseTiming();
+        if (next == records_per_page) {
+            // Every record deleted: start over on a fresh file
+            file.reset();
+            file = std::make_unique<LoadedHeapFile>(RECORD_SIZE, std::max<std::size_t>(dirty_pages, 1) * records_per_page);
+            file->get().sync();
+            next = 0;
+        }
+        for (std::size_t page = 0; page < dirty_pages; page++) {
+            const HeapFile::RecordId& rid = file->record_ids[page * records_per_page + next];
+            file->get().deleteRecord(rid.page_id, rid.slot_id);
+        }
+        next++;
+        state.ResumeTiming();
+        file->get().sync();
+    }
+    state.counters["dirty_pages"] = static_cast<double>(dirty_pages);
+}
+BENCHMARK(BM_HeapFile_Sync)->ArgName("dirty_pages")->Arg(0)->Arg(1)->Arg(64)->Arg(1024)->UseRealTime();
+
+// The counting operators forward to malloc and free through these. Kept
+// out of line so that GCC, once it inlines new and delete into a caller,
+// does not pair free with new and report a mismatched deallocation.
+[[gnu::noinline]] void* allocate(std::size_t size, std::size_t alignment) {
+    num_allocations.fetch_add(1, std::memory_order_relaxed);
+    void* ptr = nullptr;
+    if (alignment <= alignof(std::max_align_t)) {
+        ptr = std::malloc(size > 0 ? size : 1);
+    } else if (posix_memalign(&ptr, alignment, size > 0 ? size : 1) != 0) {
+        ptr = nullptr;
+    }
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+[[gnu::noinline]] void release(void* ptr) noexcept { std::free(ptr); }
+
+} // namespace
+
+void* operator new(std::size_t size) { return allocate(size, alignof(std::max_align_t)); }
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    return allocate(size, std::max(static_cast<std::size_t>(alignment), sizeof(void*)));
+}
+
+void operator delete(void* ptr) noexcept { release(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { release(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { release(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { release(ptr); }
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (argc > 2) {
+        benchmark::ReportUnrecognizedArguments(argc, argv);
+        return 1;
+    }
+    if (argc == 2) {
+        bench_path = argv[1];
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,147 @@
+#ifndef B_PLUS_TREE_H
+#define B_PLUS_TREE_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+#include "slotted_page.hpp"
+#include "buffer_pool.hpp"
+#include "heap_file.hpp"
+
+// Disk-resident B+-tree index mapping a 64-bit key, extracted from each
+// record by a caller-supplied function, to the record's RID. Every node is a
+// SlottedPage: cell 0 holds a NodeHeader and the remaining cells are entries
+// kept sorted through the cell pointer array, so searches binary-search the
+// pointers. Leaves are chained left to right for range scans. The root stays
+// on page 0 (type ROOT) for the life of the tree; a root split moves its
+// contents down to new children. Duplicate keys are allowed since entries
+// are ordered by (key, RID). Deletes do not merge underfull nodes.
+//
+// Concurrency uses optimistic lock coupling on the page version word:
+// readers take no latches, they remember each node's version and restart
+// from the root if it changed by the time they are done with the node.
+// Writers descend the same way and only lock the nodes they modify,
+// splitting full internal nodes on the way down so a split never needs
+// more than the parent and the node itself.
+//
+// The index is not covered by the heap file's log: sync() makes it durable,
+// and after a crash it should be rebuilt from the heap file with build().
+class BPlusTree {
+public:
+    using Key = uint64_t;
+    using KeyExtractor = std::function<Key(const void* record, uint16_t record_size)>;
+    using RecordId = HeapFile::RecordId;
+
+    static constexpr uint32_t ROOT_PAGE_ID = 0;
+    static constexpr uint32_t NO_PAGE = UINT32_MAX;
+
+    BPlusTree(const std::string& filename, KeyExtractor key_extractor,
+              std::size_t buffer_pool_mb = BufferPool::DEFAULT_POOL_SIZE_MB);
+
+    BPlusTree(const BPlusTree&) = delete;
+    BPlusTree& operator=(const BPlusTree&) = delete;
+
+    // Core operations
+    void insert(Key key, RecordId rid);
+    bool remove(Key key, RecordId rid);
+    void insertRecord(const void* record, uint16_t record_size, RecordId rid) {
+        insert(key_extractor(record, record_size), rid);
+    }
+    bool removeRecord(const void* record, uint16_t record_size, RecordId rid) {
+        return remove(key_extractor(record, record_size), rid);
+    }
+
+    // Every RID stored under key, in RID order
+    std::vector<RecordId> find(Key key);
+    // Visit entries with low <= key <= high in order until visitor returns
+    // false. Each leaf is validated before its entries are visited, so the
+    // visitor never sees an entry twice even if the scan restarts.
+    void scan(Key low, Key high, const std::function<bool(Key, RecordId)>& visitor);
+
+    // Index every live record of heap_file
+    void build(HeapFile& heap_file);
+
+    // File operations; sync() waits for in-flight writers, not readers
+    void sync();
+    void close();
+
+    // Statistics
+    std::size_t getHeight();
+    std::size_t getNumPages() const { return num_pages; }
+    BufferPool::Stats getBufferPoolStats() const { return buffer_pool->getStats(); }
+
+private:
+    // Cell 0 of every node; link is the right sibling of a leaf or the
+    // leftmost child of an internal node
+    struct NodeHeader {
+        uint32_t link;
+        uint8_t level; // 0 for leaves
+        uint8_t reserved[3];
+    };
+
+    struct Entry {
+        Key key;
+        uint32_t page_id;
+        uint16_t slot_id;
+        uint16_t reserved;
+    };
+
+    // Separator and the child holding entries >= it
+    struct InternalEntry {
+        Entry separator;
+        uint32_t child;
+        uint32_t reserved;
+    };
+
+    struct Split {
+        Entry separator;
+        uint32_t right_page;
+    };
+
+    std::string filename;
+    int file_descriptor;
+    KeyExtractor key_extractor;
+    std::atomic<std::size_t> num_pages;
+    std::unique_ptr<BufferPool> buffer_pool;
+    // The root is on every path, so it stays pinned
+    BufferPool::PageGuard root;
+
+    // Held shared by writers and exclusively by sync(); readers never take it
+    std::shared_mutex checkpoint_latch;
+
+    // Optimistic latching on the page version word
+    static bool readLock(SlottedPage& page, uint32_t& version);
+    static bool validate(SlottedPage& page, uint32_t version);
+    static bool upgradeLock(SlottedPage& page, uint32_t version);
+    static void writeUnlock(SlottedPage& page);
+
+    // Node accessors; safe on a page that is being modified concurrently,
+    // in which case the result is garbage and fails validation
+    static Entry makeEntry(Key key, RecordId rid);
+    static bool less(const Entry& a, const Entry& b);
+    static bool successor(Entry& entry);
+    static const uint8_t* cellData(SlottedPage& page, uint16_t idx, std::size_t size);
+    static NodeHeader readNodeHeader(SlottedPage& page);
+    static uint16_t numEntries(SlottedPage& page);
+    static Entry entryAt(SlottedPage& page, uint16_t idx);
+    static uint16_t lowerBound(SlottedPage& page, const Entry& target);
+    static uint32_t findChild(SlottedPage& page, const Entry& target);
+    static uint16_t cellSize(uint8_t level);
+    static bool isFull(SlottedPage& page, uint8_t level);
+
+    // Each returns false when the operation has to restart
+    bool descend(const Entry& target, BufferPool::PageGuard& leaf, uint32_t& version);
+    bool tryInsert(const Entry& entry);
+
+    // Structure modifications (callers hold the write locks)
+    uint32_t allocatePage(SlottedPage::PageType type, NodeHeader node);
+    bool insertCell(SlottedPage& page, uint16_t idx, const void* cell, uint16_t cell_size);
+    Split splitNode(SlottedPage& page);
+    void splitRoot(SlottedPage& root_page);
+};
+
+#endif // B_PLUS_TREE_H
@@ -0,0 +1,99 @@
+#ifndef BATCH_SCANNER_H
+#define BATCH_SCANNER_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "filter_kernels.hpp"
+#include "heap_file.hpp"
+#include "heap_scanner.hpp"
+
+// Scan that feeds fixed-offset fields of every record to the filter kernels
+// a page at a time. Fields are named by their byte offset in the record and
+// their type; for each page the scanner hands out one contiguous vector per
+// field plus a selection bitmap of the rows that hold a live record.
+//
+//     BatchScanner scanner(heap_file, {{offsetof(Movie, rating), FilterKernels::ColumnType::FLOAT},
+//                                      {offsetof(Movie, release), FilterKernels::ColumnType::UINT32}});
+//     while (scanner.next()) {
+//         scanner.compare(0, kernels, GT, 0.9f, selection);
+//         FilterKernels::intersect(selection, scanner.getSelection(), scanner.getNumRows());
+//         ...
+//     }
+//
+// Slotted pages are gathered: each field of each live cell is copied into
+// its vector. Large records are skipped. PAX pages need no copy, since a
+// field is a column there; in MMAP_READ_ONLY mode the vectors point into
+// the mapping, as with ColumnScanner. Encoded pages are decoded a field at
+// a time, only when getColumn() asks for it; compare() evaluates
+// predicates on their encoded values instead.
+class BatchScanner {
+public:
+    struct Field {
+        std::size_t offset; // Byte offset within the record
+        FilterKernels::ColumnType type;
+    };
+
+    // Throws std::invalid_argument if a PAX file has no column at a field's
+    // offset with the width of its type
+    BatchScanner(HeapFile& heap_file, std::vector<Field> fields,
+                 std::size_t readahead_pages = HeapScanner::DEFAULT_READAHEAD_PAGES);
+
+    BatchScanner(const BatchScanner&) = delete;
+    BatchScanner& operator=(const BatchScanner&) = delete;
+
+    // Advance to the next page holding records; false once the scan is
+    // exhausted. Throws std::runtime_error for a record too short for the
+    // fields.
+    bool next();
+
+    // Rows of the current batch; vectors and bitmap are valid until next()
+    std::size_t getNumRows() const { return num_rows; }
+    const void* getColumn(std::size_t i) const;
+    template <typename T>
+    const T* getColumn(std::size_t i) const { return static_cast<const T*>(getColumn(i)); }
+    // Set selection to field i op constant for every row of the batch, as
+    // FilterKernels::compare() on getColumn(i) would
+    void compare(std::size_t i, const FilterKernels& kernels, FilterKernels::CompareOp op, const void* constant,
+                 uint64_t* selection) const;
+    template <typename T>
+    void compare(std::size_t i, const FilterKernels& kernels, FilterKernels::CompareOp op, T constant,
+                 uint64_t* selection) const {
+        compare(i, kernels, op, static_cast<const void*>(&constant), selection);
+    }
+    // Live rows; FilterKernels::selectionWords(getNumRows()) words
+    const uint64_t* getSelection() const { return live.data(); }
+    HeapFile::RecordId getRecordId(std::size_t row) const {
+        return {page_id, slots.empty() ? static_cast<uint16_t>(row) : slots[row]};
+    }
+
+private:
+    HeapFile& heap_file;
+    std::vector<Field> fields;
+    std::size_t record_size = 0; // Bytes a record needs to hold every field
+    std::vector<uint16_t> pax_columns; // Column of each field in PAX files
+    std::unique_ptr<HeapScanner> scanner; // Unless the file is mapped
+    std::size_t end_page;
+    uint32_t next_mapped_page = 0;
+
+    // Gathered fields of a slotted page, one vector per field
+    std::vector<std::unique_ptr<uint64_t[]>> gathered;
+    // Slot of each gathered row; empty for PAX pages, where row == slot
+    std::vector<uint16_t> slots;
+
+    // Current batch
+    uint32_t page_id = 0;
+    std::size_t num_rows = 0;
+    // Fields of an encoded page stay null until decoded on demand
+    mutable std::vector<const void*> column_data;
+    std::vector<uint64_t> live;
+    const uint8_t* encoded_page = nullptr;
+    mutable std::vector<std::vector<uint64_t>> decoded;
+
+    const uint8_t* nextPage();
+    std::size_t gatherSlotted(const uint8_t* page);
+    std::size_t loadPax(const uint8_t* page);
+    std::size_t loadEncoded(const uint8_t* page);
+};
+
+#endif // BATCH_SCANNER_H
@@ -0,0 +1,252 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+#include "slotted_page.hpp"
+#include "log_manager.hpp"
+#include "io_backend.hpp"
+#include "page_arena.hpp"
+
+class CompressedPageFile;
+
+// Fixed-size cache of page frames for a single file. Frames are split into
+// shards by page id, each with its own hash table, CLOCK hand and mutex, so
+// lookups are O(1) and unrelated pages do not contend. A page is pinned while
+// a caller holds it and a pinned page is never chosen as an eviction victim.
+// When a log manager is attached, a dirty page is only written once the log
+// is durable up to the page's LSN (write-ahead rule).
+//
+// Page I/O goes through an IoBackend; flushAllPages() writes dirty pages in
+// batches so an asynchronous backend can keep many writes in flight. With a
+// CompressedPageFile, pages are compressed on write-back and decompressed
+// on load instead of being transferred as is.
+//
+// An optional background writer cleans dirty pages the CLOCK hand is about
+// to reach. While it runs, eviction passes over dirty victims in favour of
+// clean ones and only writes a page itself when no clean victim is left.
+// Such a write, and the log flush before it, happen with the shard mutex
+// released and the victim pinned.
+//
+// Frames are views into one PageArena allocated up front, and each shard's
+// page table is sized for its frames, so once the pool is built fetching,
+// evicting and writing back pages allocate nothing. A page read from disk
+// is not zeroed first; a new page is.
+//
+// Each frame also carries a reader-writer latch protecting the page contents.
+// Lock order is page latch before shard mutex; the shard mutex is never held
+// while waiting for a page latch.
+class BufferPool {
+public:
+    static constexpr std::size_t DEFAULT_POOL_SIZE_MB = 16;
+    static constexpr std::size_t MAX_SHARDS = 16;
+    // Small pools (or large pages) get fewer shards rather than shards a
+    // few long-lived pins could exhaust
+    static constexpr std::size_t MIN_FRAMES_PER_SHARD = 8;
+    // Dirty pages written per batch by flushAllPages()
+    static constexpr std::size_t FLUSH_BATCH_PAGES = 64;
+    // Most dirty pages the background writer cleans per round
+    static constexpr std::size_t WRITER_ROUND_PAGES = 4 * FLUSH_BATCH_PAGES;
+
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        uint64_t dirty_writes;    // Pages written back on eviction or flush
+        uint64_t eviction_writes; // Of those, written by an evicting caller
+        uint64_t writer_writes;   // Of those, written by the background writer
+        uint64_t dirty_pages;     // Resident pages currently dirty
+        double writer_pages_per_sec; // Background writer throughput over its last second
+    };
+
+    enum class LatchMode : uint8_t {
+        NONE,      // Pin only; caller is responsible for synchronisation
+        SHARED,
+        EXCLUSIVE
+    };
+
+    // RAII pin (and optionally latch) on a page: unlatches and unpins,
+    // propagating the dirty bit, on destruction
+    class PageGuard {
+    public:
+        PageGuard() = default;
+        PageGuard(BufferPool& pool, uint32_t page_id, LatchMode mode = LatchMode::NONE);
+        ~PageGuard() { release(); }
+
+        PageGuard(const PageGuard&) = delete;
+        PageGuard& operator=(const PageGuard&) = delete;
+        PageGuard(PageGuard&& other) noexcept;
+        PageGuard& operator=(PageGuard&& other) noexcept;
+
+        SlottedPage* get() const { return page; }
+        SlottedPage* operator->() const { return page; }
+        SlottedPage& operator*() const { return *page; }
+        uint32_t getPageId() const { return page_id; }
+
+        void markDirty() { is_dirty = true; }
+        void release();
+
+    private:
+        BufferPool* pool = nullptr;
+        std::shared_mutex* latch = nullptr;
+        SlottedPage* page = nullptr;
+        uint32_t page_id = 0;
+        LatchMode mode = LatchMode::NONE;
+        bool is_dirty = false;
+    };
+
+    // Size the pool in megabytes of page frames (at least one frame per
+    // shard); without an I/O backend the pool uses synchronous I/O
+    BufferPool(int fd, std::size_t pool_size_mb = DEFAULT_POOL_SIZE_MB,
+               LogManager* log_manager = nullptr, IoBackend* io_backend = nullptr,
+               CompressedPageFile* compressed_file = nullptr);
+
+    ~BufferPool();
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // Pin a page, reading it from disk on a miss
+    SlottedPage* fetchPage(uint32_t page_id);
+    // Pin a freshly initialised page that does not need to be read from disk
+    SlottedPage* newPage(uint32_t page_id, SlottedPage::PageType type);
+    void unpinPage(uint32_t page_id, bool is_dirty);
+
+    void flushPage(uint32_t page_id);
+    void flushAllPages();
+    // Write back those of the given pages that are still resident and dirty
+    void flushPages(const uint32_t* page_ids, std::size_t count);
+    // Pages dirty right now; every page not listed has been written back
+    std::vector<uint32_t> getDirtyPages();
+
+    // Run the background writer every interval, and sooner when eviction
+    // runs into dirty victims
+    void startBackgroundWriter(std::chrono::milliseconds interval);
+    void stopBackgroundWriter();
+
+    // Copy a page out if it is resident, without counting a hit or touching
+    // its reference bit, so sequential scans do not disturb the working set
+    bool copyPageIfResident(uint32_t page_id, uint8_t* dest);
+
+    Stats getStats() const;
+    std::size_t getNumFrames() const { return num_frames; }
+
+private:
+    struct Frame {
+        SlottedPage page{nullptr}; // View of this frame's slot in the arena
+        std::shared_mutex latch;
+        uint32_t page_id = 0;
+        uint32_t pin_count = 0;
+        bool is_dirty = false;
+        bool referenced = false; // CLOCK second-chance bit
+        bool in_use = false;
+    };
+
+    // Page id to frame index, open addressing with linear probing in a table
+    // at most half full. Sized once; erasing shifts later entries back
+    // rather than leaving tombstones.
+    class PageTable {
+    public:
+        static constexpr std::size_t NOT_FOUND = SIZE_MAX;
+
+        void init(std::size_t max_entries);
+        std::size_t find(uint32_t page_id) const;
+        void insert(uint32_t page_id, std::size_t frame_idx);
+        void erase(uint32_t page_id);
+        std::size_t size() const { return num_entries; }
+
+    private:
+        static constexpr uint32_t EMPTY = SlottedPage::NO_PAGE;
+
+        std::vector<uint32_t> page_ids;
+        std::vector<uint32_t> frame_ids;
+        std::size_t mask = 0;
+        std::size_t num_entries = 0;
+
+        std::size_t home(uint32_t page_id) const { return (page_id * UINT32_C(0x9E3779B1)) & mask; }
+    };
+
+    struct Shard {
+        std::mutex latch;
+        std::unique_ptr<Frame[]> frames;
+        std::size_t num_frames = 0;
+        PageTable page_table;
+        std::size_t clock_hand = 0;
+        std::size_t num_dirty = 0;
+        Stats stats = {};
+    };
+
+    // A pinned dirty frame queued for write-back
+    struct DirtyFrame {
+        Shard* shard;
+        Frame* frame;
+        uint32_t page_id;
+        IoBackend::Request* request;
+    };
+
+    int file_descriptor;
+    LogManager* log_manager;
+    std::unique_ptr<IoBackend> owned_io_backend;
+    IoBackend* io_backend;
+    CompressedPageFile* compressed_file;
+    std::size_t num_frames;
+    // Page frames, then FLUSH_BATCH_PAGES of write-back staging
+    PageArena arena;
+    std::vector<std::unique_ptr<Shard>> shards;
+
+    // Serialises batched write-back, so a page found clean is on disk, and
+    // guards the staging pages and requests
+    std::mutex flush_latch;
+    std::vector<IoBackend::Request> flush_requests;
+
+    // Background writer
+    std::thread writer_thread;
+    mutable std::mutex writer_latch;
+    std::condition_variable writer_cv;
+    std::atomic<bool> writer_running{false};
+    bool writer_stopping = false;
+    bool writer_wanted = false;
+    double writer_pages_per_sec = 0;
+    std::vector<DirtyFrame> writer_frames; // Picked each round, capacity kept
+
+    Shard& shardFor(uint32_t page_id) { return *shards[page_id % shards.size()]; }
+    static std::size_t numShards(std::size_t num_frames) {
+        return std::min(MAX_SHARDS, std::max<std::size_t>(num_frames / MIN_FRAMES_PER_SHARD, 1));
+    }
+    // Frames in a pool of that size, at least one per shard
+    static std::size_t numFrames(std::size_t pool_size_mb) {
+        std::size_t frames = pool_size_mb * 1024 * 1024 / SlottedPage::PAGE_SIZE;
+        return std::max(frames, numShards(frames));
+    }
+
+    // Pin a page and return its frame
+    Frame* fetchFrame(uint32_t page_id);
+
+    // Write back pinned dirty frames in batches and unpin them; returns the
+    // pages written
+    std::size_t writeDirtyFrames(std::vector<DirtyFrame>& dirty, bool background);
+    std::size_t cleanAheadOfHand();
+    void runBackgroundWriter(std::chrono::milliseconds interval);
+
+    // Helper methods (callers hold the shard latch)
+    // Free a frame, evicting a victim; a dirty victim is written back with
+    // the shard latch released, so the shard may have changed on return
+    std::size_t acquireFrame(Shard& shard, std::unique_lock<std::mutex>& lock);
+    void evictFrame(Shard& shard, Frame& frame);
+    void setDirty(Shard& shard, Frame& frame, bool is_dirty);
+    // Write back an unpinned dirty frame, pinned and with the shard latch
+    // released meanwhile
+    void writeFrame(Shard& shard, Frame& frame, std::unique_lock<std::mutex>& lock);
+    void readFrame(Frame& frame, uint32_t page_id);
+    void writePage(const SlottedPage& page);
+};
+
+#endif // BUFFER_POOL_H
@@ -0,0 +1,65 @@
+#ifndef COLUMN_SCANNER_H
+#define COLUMN_SCANNER_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "heap_file.hpp"
+#include "heap_scanner.hpp"
+
+// Scan over a PAX heap file that returns column vectors, one page at a
+// time: for each requested column, a contiguous array of getNumRows()
+// values of that column's width, plus a bitmap of the live rows.
+//
+//     ColumnScanner scanner(heap_file, {RATING_COLUMN});
+//     while (scanner.next()) {
+//         const auto* ratings = reinterpret_cast<const float*>(scanner.getColumn(0));
+//         for (size_t row = 0; row < scanner.getNumRows(); row++) {
+//             if (scanner.isLive(row)) sum += ratings[row];
+//         }
+//     }
+//
+// In MMAP_READ_ONLY mode the vectors point straight into the mapping, so
+// only the requested columns are ever touched. Otherwise pages are read in
+// chunks as by HeapScanner. Columns of encoded pages are decoded into
+// buffers owned by the scanner, unless they are stored plain.
+class ColumnScanner {
+public:
+    // Throws std::invalid_argument unless the file has the PAX layout and
+    // every column index is in its schema
+    ColumnScanner(HeapFile& heap_file, std::vector<uint16_t> columns,
+                  std::size_t readahead_pages = HeapScanner::DEFAULT_READAHEAD_PAGES);
+
+    ColumnScanner(const ColumnScanner&) = delete;
+    ColumnScanner& operator=(const ColumnScanner&) = delete;
+
+    // Advance to the next page holding rows; false once the scan is exhausted
+    bool next();
+
+    // Rows of the current page, live or not; vectors are valid until next()
+    std::size_t getNumRows() const { return num_rows; }
+    const uint8_t* getColumn(std::size_t i) const { return column_data[i]; }
+    uint16_t getColumnWidth(std::size_t i) const { return heap_file.getColumnWidths()[columns[i]]; }
+    const uint8_t* getPresence() const { return presence; }
+    bool isLive(std::size_t row) const { return presence[row / 8] >> (row % 8) & 1; }
+    uint32_t getPageId() const { return page_id; }
+
+private:
+    HeapFile& heap_file;
+    std::vector<uint16_t> columns;
+    std::unique_ptr<HeapScanner> scanner; // Unless the file is mapped
+    std::size_t end_page;
+    uint32_t next_mapped_page = 0;
+
+    // Current page
+    uint32_t page_id = 0;
+    std::size_t num_rows = 0;
+    const uint8_t* presence = nullptr;
+    std::vector<const uint8_t*> column_data;
+    std::vector<std::vector<uint8_t>> decoded;
+
+    const uint8_t* nextPage();
+    bool loadEncoded(const uint8_t* page);
+};
+
+#endif // COLUMN_SCANNER_H
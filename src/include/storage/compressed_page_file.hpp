@@ -0,0 +1,122 @@
+#ifndef COMPRESSED_PAGE_FILE_H
+#define COMPRESSED_PAGE_FILE_H
+
+#include <sys/types.h>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "io_backend.hpp"
+#include "slotted_page.hpp"
+
+// Data file whose pages are stored LZ-compressed (see LzCodec) in extents
+// of variable size. A page translation table, persisted in the
+// "<filename>.ptt" fork, maps each page id to its extent; callers address
+// pages exactly as in a plain file, by offset page_id * PAGE_SIZE.
+//
+// Pages are compressed when written and decompressed when read. A write
+// never overwrites an extent the persisted table refers to: each version
+// goes to a free extent and the table is updated in memory, so after a
+// crash the persisted table still describes intact, older pages that the
+// write-ahead log brings forward. sync() persists the table; only then are
+// the superseded extents reused, or cut off if they end the file.
+//
+// The first block is a superblock laid out as a page header whose id is
+// MAGIC, so readPageSize() checks compressed files unchanged while page 0
+// of a plain file (id 0) never matches.
+class CompressedPageFile {
+public:
+    static constexpr uint32_t MAGIC = 0x5A424454; // "TDBZ"
+    // Extents start and end on this boundary, bounding both the free-list
+    // size classes and the space a page can save
+    static constexpr std::size_t EXTENT_ALIGNMENT = 256;
+
+    struct Stats {
+        std::size_t pages;        // Pages with an extent
+        uint64_t stored_bytes;    // Their extents, after compression
+        uint64_t file_bytes;      // Data file size, free extents included
+        uint64_t pages_written;
+        uint64_t pages_read;
+    };
+
+    // True if the file at fd holds compressed pages
+    static bool isCompressed(int fd);
+
+    // Writes the superblock into an empty file. Throws std::runtime_error if
+    // the table fork is missing or does not match the data file.
+    CompressedPageFile(int fd, const std::string& filename, IoBackend* io_backend);
+
+    CompressedPageFile(const CompressedPageFile&) = delete;
+    CompressedPageFile& operator=(const CompressedPageFile&) = delete;
+
+    std::size_t getNumPages();
+
+    // Same contract as IoBackend::submit() for page-aligned requests; the
+    // requests' descriptor is ignored. Reads of pages never written return
+    // zeroes, and stop short at the last page.
+    void submit(IoBackend::Request* requests, std::size_t count);
+    ssize_t read(void* buffer, std::size_t length, off_t offset);
+    ssize_t write(const void* buffer, std::size_t length, off_t offset);
+
+    // Make the pages written so far durable and persist the table
+    void sync();
+
+    Stats getStats();
+
+private:
+    struct Extent {
+        uint64_t offset = 0;
+        uint32_t size = 0; // Stored bytes, 0 for a page never written
+        uint32_t flags = 0;
+    };
+    static constexpr uint32_t RAW = 0x1; // Stored uncompressed
+
+    int file_descriptor;
+    std::string table_filename;
+    IoBackend* io_backend;
+
+    // Table, free extents and counters
+    std::mutex latch;
+    std::vector<Extent> table;
+    // Free extents, coalesced, indexed by size for best fit and by offset
+    // for merging neighbours
+    std::multimap<uint64_t, uint64_t> free_by_size;
+    std::map<uint64_t, uint64_t> free_by_offset;
+    // Extents replaced since the table was last persisted; the persisted
+    // table may still refer to them
+    std::vector<Extent> pending_free;
+    // Reads in flight by the epoch they began in, and extents no longer in
+    // either table by the epoch they left; those are freed once every read
+    // that may have looked one up has finished
+    uint64_t read_epoch = 0;
+    std::map<uint64_t, std::size_t> active_reads;
+    std::vector<std::pair<uint64_t, Extent>> retired;
+    uint64_t file_end;
+    Stats stats = {};
+
+    // Serialises sync()
+    std::mutex sync_latch;
+
+    static uint64_t alignedSize(uint64_t size) {
+        return (size + EXTENT_ALIGNMENT - 1) / EXTENT_ALIGNMENT * EXTENT_ALIGNMENT;
+    }
+
+    void loadTable();
+    // Caller holds latch
+    uint64_t allocateExtent(uint64_t size);
+    void releaseExtent(uint64_t offset, uint64_t size);
+    void removeFreeExtent(std::map<uint64_t, uint64_t>::iterator it);
+    // Free the retired extents no read in flight can still be using
+    void releaseRetired();
+    void endRead(uint64_t epoch);
+    // Give a free extent at the end of the file back to the file system
+    void trimFile();
+
+    void persistTable(const std::vector<Extent>& snapshot);
+    void readPages(IoBackend::Request& request);
+    void readExtents(IoBackend::Request& request, uint32_t first_page, const std::vector<Extent>& extents);
+    void writePages(const std::vector<IoBackend::Request*>& requests);
+};
+
+#endif // COMPRESSED_PAGE_FILE_H
@@ -0,0 +1,148 @@
+#ifndef ENCODED_PAGE_H
+#define ENCODED_PAGE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "filter_kernels.hpp"
+#include "slotted_page.hpp"
+
+// Sealed PAX page whose columns are stored in lightweight encodings, each
+// column picking whichever is smallest for the rows on the page:
+//
+//   PLAIN               values back to back, as in a PaxPage
+//   RLE                 run end rows, then one value per run
+//   DICTIONARY          up to MAX_DICTIONARY distinct values, then one
+//                       bit-packed code per row
+//   FRAME_OF_REFERENCE  integer columns: the page minimum, then one
+//                       bit-packed offset from it per row
+//
+//   PageHeader | EncodedHeader | ColumnInfo[num_columns] | presence | segment 0 | segment 1 | ...
+//
+// A page is built once by a Builder, holding as many rows as fit encoded,
+// and never takes another row; removing a row only clears its presence
+// bit. Rows read back as the records they were built from. compare()
+// evaluates predicates on the encoded values: once per dictionary entry or
+// run, or as a range of offsets, rather than once per decoded value.
+//
+// EncodedPage is a view over the bytes of a page of type ENCODED and owns
+// nothing.
+class EncodedPage {
+public:
+    enum class Encoding : uint8_t { PLAIN, RLE, DICTIONARY, FRAME_OF_REFERENCE };
+
+    static constexpr std::size_t MAX_DICTIONARY = 256;
+    // Bounded by 16-bit row numbers and by the presence bitmap
+    static constexpr std::size_t MAX_ROWS = std::min<std::size_t>(UINT16_MAX, SlottedPage::PAGE_SIZE * 2);
+    static constexpr std::size_t SEGMENT_ALIGNMENT = 8;
+
+    struct EncodedHeader {
+        uint16_t num_columns;
+        uint16_t num_rows;
+        uint16_t live_rows;
+        uint16_t reserved;
+    };
+
+    struct ColumnInfo {
+        uint16_t offset; // Start of the segment within the page
+        uint16_t size;   // Segment bytes
+        uint16_t width;
+        uint16_t count;  // Runs or dictionary entries
+        Encoding encoding;
+        uint8_t bits;    // Width of packed codes or offsets
+        uint8_t domain;  // Frame of reference: see Domain
+        uint8_t reserved;
+    };
+
+    // Accumulates rows for one page and tracks, per column, the size of
+    // every encoding, so add() knows when the page is full
+    class Builder {
+    public:
+        // Throws std::invalid_argument if not even one row fits a page
+        explicit Builder(const std::vector<uint16_t>& column_widths);
+
+        // Take the record if the page still fits with it; false otherwise,
+        // leaving the builder unchanged
+        bool add(const void* record);
+        std::size_t getNumRows() const { return num_rows; }
+        // Lay out the page after its PageHeader, which the caller set up
+        // with type ENCODED; the builder is then empty again
+        void build(uint8_t* data);
+
+    private:
+        struct ColumnStats {
+            uint16_t width;
+            std::size_t runs = 0;
+            // Distinct values while there are at most MAX_DICTIONARY
+            bool dictionary = true;
+            std::vector<uint8_t> entries;
+            std::size_t num_entries = 0;
+            std::vector<uint16_t> slots; // Open-addressed hash of entries, index + 1
+            // Integer columns (widths 1, 2, 4 and 8) also track their range
+            bool integer;
+            uint64_t unsigned_min, unsigned_max;
+            int64_t signed_min, signed_max;
+        };
+
+        std::vector<uint16_t> column_widths;
+        std::size_t row_size = 0;
+        std::size_t num_rows = 0;
+        std::vector<uint8_t> rows;
+        std::vector<ColumnStats> stats;
+
+        void reset();
+    };
+
+    explicit EncodedPage(uint8_t* data) : data(data) {}
+
+    static std::vector<uint16_t> readColumnWidths(const uint8_t* data);
+
+    void removeRow(uint16_t row);
+    // Copy up to size bytes of the record; returns the bytes copied
+    uint16_t readRow(uint16_t row, void* buffer, uint16_t size) const;
+
+    bool isLive(uint16_t row) const {
+        return row < header()->num_rows && (getPresence()[row / 8] >> (row % 8) & 1);
+    }
+    const uint8_t* getPresence() const { return data + presenceOffset(header()->num_columns); }
+
+    // Values of every row of a column, num_rows * width bytes, in out
+    void decodeColumn(uint16_t column, void* out) const;
+    // The column's values in place if it is stored PLAIN, else nullptr
+    const uint8_t* getPlainColumn(uint16_t column) const;
+    // Set bit i of selection to value i op *constant for every row, live or
+    // not, as FilterKernels::compare() would on the decoded column. Throws
+    // std::invalid_argument if the type is not as wide as the column.
+    void compare(uint16_t column, const FilterKernels& kernels, FilterKernels::ColumnType type,
+                 FilterKernels::CompareOp op, const void* constant, uint64_t* selection) const;
+
+    uint16_t getNumColumns() const { return header()->num_columns; }
+    uint16_t getNumRows() const { return header()->num_rows; }
+    uint16_t getLiveRows() const { return header()->live_rows; }
+    uint16_t getColumnWidth(uint16_t column) const { return columns()[column].width; }
+    Encoding getEncoding(uint16_t column) const { return columns()[column].encoding; }
+    uint16_t getRowSize() const;
+
+    // Which order frame-of-reference offsets follow: both agree unless the
+    // column mixes values with and without the top bit set
+    enum Domain : uint8_t { ANY, UNSIGNED, SIGNED };
+
+private:
+    uint8_t* data;
+
+    EncodedHeader* header() { return reinterpret_cast<EncodedHeader*>(data + sizeof(SlottedPage::PageHeader)); }
+    const EncodedHeader* header() const {
+        return reinterpret_cast<const EncodedHeader*>(data + sizeof(SlottedPage::PageHeader));
+    }
+    const ColumnInfo* columns() const { return reinterpret_cast<const ColumnInfo*>(header() + 1); }
+    uint8_t* presence() { return data + presenceOffset(header()->num_columns); }
+
+    static std::size_t presenceOffset(std::size_t num_columns);
+    // Copy the first length bytes of a row's value
+    void readValue(const ColumnInfo& column, uint16_t row, uint8_t* out, std::size_t length) const;
+    void compareFrameOfReference(const ColumnInfo& column, const FilterKernels& kernels,
+                                 FilterKernels::ColumnType type, FilterKernels::CompareOp op,
+                                 const void* constant, uint64_t* selection) const;
+};
+
+#endif // ENCODED_PAGE_H
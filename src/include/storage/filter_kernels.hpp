@@ -0,0 +1,92 @@
+#ifndef FILTER_KERNELS_H
+#define FILTER_KERNELS_H
+
+#include <cstdint>
+#include <limits>
+
+// Vectorized predicates and aggregates over column vectors, as handed out
+// by BatchScanner and ColumnScanner. A comparison turns count values into a
+// selection bitmap; aggregates fold the selected values. Bitmaps hold row i
+// in bit i % 64 of word i / 64, and bits past the last row are always zero.
+//
+//     const FilterKernels& kernels = FilterKernels::get();
+//     kernels.compare(ratings, n, FilterKernels::CompareOp::GT, 0.9f, selection);
+//     kernels.compare(releases, n, FilterKernels::CompareOp::LT, 2000u, matches);
+//     FilterKernels::intersect(selection, matches, n);
+//     kernels.aggregate(ratings, n, selection, rating_stats);
+//
+// Implementations for AVX2, SSE4.2 and plain scalar code are built into
+// every binary; get() picks the widest one the CPU supports at run time.
+class FilterKernels {
+public:
+    enum class Kind : uint8_t {
+        SCALAR,
+        SSE42,  // 128-bit vectors; throws if unsupported
+        AVX2,   // 256-bit vectors; throws if unsupported
+        AUTO    // The widest the CPU supports
+    };
+
+    enum class ColumnType : uint8_t { INT32, UINT32, INT64, FLOAT, DOUBLE };
+
+    // Floating-point comparisons follow C++: only NE holds for a NaN
+    enum class CompareOp : uint8_t { EQ, NE, LT, LE, GT, GE };
+
+    // Running COUNT, SUM, MIN and MAX of the selected values. Integer
+    // columns fill the int64_t fields, floating-point columns the doubles.
+    // Results accumulate across calls, so one Aggregate covers a whole scan.
+    struct Aggregate {
+        uint64_t count = 0;
+        int64_t int_sum = 0;
+        int64_t int_min = std::numeric_limits<int64_t>::max();
+        int64_t int_max = std::numeric_limits<int64_t>::min();
+        double fp_sum = 0;
+        double fp_min = std::numeric_limits<double>::infinity();
+        double fp_max = -std::numeric_limits<double>::infinity();
+    };
+
+    virtual ~FilterKernels() = default;
+
+    static const FilterKernels& get(Kind kind = Kind::AUTO);
+    static bool isSupported(Kind kind);
+
+    // Set bit i of selection to values[i] op *constant for i < count; the
+    // constant has the column's type
+    virtual void compare(ColumnType type, const void* values, std::size_t count, CompareOp op,
+                         const void* constant, uint64_t* selection) const = 0;
+    // Fold the values whose bit is set into result
+    virtual void aggregate(ColumnType type, const void* values, std::size_t count, const uint64_t* selection,
+                           Aggregate& result) const = 0;
+    virtual const char* getName() const = 0;
+
+    template <typename T>
+    void compare(const T* values, std::size_t count, CompareOp op, T constant, uint64_t* selection) const {
+        compare(columnTypeOf<T>(), values, count, op, &constant, selection);
+    }
+    template <typename T>
+    void aggregate(const T* values, std::size_t count, const uint64_t* selection, Aggregate& result) const {
+        aggregate(columnTypeOf<T>(), values, count, selection, result);
+    }
+
+    // Bitmap helpers; the word loops are left to the compiler to vectorize
+    static std::size_t selectionWords(std::size_t count) { return (count + 63) / 64; }
+    static void intersect(uint64_t* selection, const uint64_t* other, std::size_t count);
+    static void unite(uint64_t* selection, const uint64_t* other, std::size_t count);
+    static std::size_t countSelected(const uint64_t* selection, std::size_t count);
+
+    static std::size_t typeWidth(ColumnType type);
+    template <typename T>
+    static constexpr ColumnType columnTypeOf();
+};
+
+template <>
+constexpr FilterKernels::ColumnType FilterKernels::columnTypeOf<int32_t>() { return ColumnType::INT32; }
+template <>
+constexpr FilterKernels::ColumnType FilterKernels::columnTypeOf<uint32_t>() { return ColumnType::UINT32; }
+template <>
+constexpr FilterKernels::ColumnType FilterKernels::columnTypeOf<int64_t>() { return ColumnType::INT64; }
+template <>
+constexpr FilterKernels::ColumnType FilterKernels::columnTypeOf<float>() { return ColumnType::FLOAT; }
+template <>
+constexpr FilterKernels::ColumnType FilterKernels::columnTypeOf<double>() { return ColumnType::DOUBLE; }
+
+#endif // FILTER_KERNELS_H
@@ -0,0 +1,65 @@
+#ifndef FREE_SPACE_MAP_H
+#define FREE_SPACE_MAP_H
+
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "slotted_page.hpp"
+
+// Free-space tree over the pages of a heap file. Each leaf holds one byte
+// per heap page (free space in units of BYTES_PER_CATEGORY) and each
+// internal node holds the maximum of its children, so a page with enough
+// room is found by a single root-to-leaf descent. Leaves are persisted in
+// dedicated FSM pages in a separate "<heap file>.fsm" fork; internal
+// levels are rebuilt on load. Like the rest of the map this is only a
+// hint: callers must re-check the page itself before using it.
+class FreeSpaceMap {
+public:
+    static constexpr std::size_t DEFAULT_FANOUT = 64;
+    static constexpr std::size_t BYTES_PER_CATEGORY = SlottedPage::PAGE_SIZE / 256;
+    static constexpr uint32_t NO_PAGE = UINT32_MAX;
+
+    FreeSpaceMap(const std::string& filename, std::size_t fanout = DEFAULT_FANOUT);
+    ~FreeSpaceMap();
+
+    FreeSpaceMap(const FreeSpaceMap&) = delete;
+    FreeSpaceMap& operator=(const FreeSpaceMap&) = delete;
+
+    // Read persisted leaves; false if the fork does not cover num_pages
+    bool load(std::size_t num_pages);
+    // Write dirty FSM pages and fsync the fork
+    void sync();
+
+    void addPage(uint32_t page_id, uint16_t free_bytes);
+    void update(uint32_t page_id, uint16_t free_bytes);
+    // Find a page with at least required_bytes free, trying the page
+    // returned last first; NO_PAGE if none
+    uint32_t findPage(uint16_t required_bytes);
+
+    uint16_t getFreeSpace(uint32_t page_id) const;
+    std::size_t getNumPages() const;
+    void print(std::ostream& os) const;
+
+private:
+    std::string filename;
+    int file_descriptor;
+    std::size_t fanout;
+
+    mutable std::mutex latch;
+    // levels[0] are the leaves, levels.back() is the single root
+    std::vector<std::vector<uint8_t>> levels;
+    std::vector<bool> dirty_fsm_pages;
+    uint32_t last_page_hint = NO_PAGE;
+
+    // Helper methods (callers hold the latch)
+    static uint8_t toCategory(uint16_t free_bytes);
+    static uint32_t requiredCategory(uint16_t required_bytes);
+    void setLeaf(uint32_t page_id, uint8_t category);
+    void growLevels();
+    uint8_t maxOfChildren(std::size_t level, std::size_t idx) const;
+    void propagate(std::size_t leaf_idx);
+};
+
+#endif // FREE_SPACE_MAP_H
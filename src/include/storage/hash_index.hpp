@@ -0,0 +1,158 @@
+#ifndef HASH_INDEX_H
+#define HASH_INDEX_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+#include "slotted_page.hpp"
+#include "buffer_pool.hpp"
+#include "heap_file.hpp"
+
+// Disk-resident extendible hash index mapping a 64-bit key, extracted from
+// each record by a caller-supplied function, to the record's RID, for
+// equality lookups that need no ordering. The directory maps the low
+// global-depth bits of a key's hash to a bucket page and is held in memory,
+// so a lookup reads one bucket page. Each bucket is a SlottedPage: cell 0
+// holds a BucketHeader and the remaining cells are entries sorted by
+// (key, RID) through the cell pointer array. Duplicate keys are allowed.
+//
+// A full bucket splits in two on the next hash bit. Only when its local
+// depth already equals the global depth does the directory double, one
+// level at a time: the lower half is copied into the new upper half and
+// nothing else moves. When the next bit would barely separate anything, as
+// with many duplicates of one key, the bucket gets an overflow page chained
+// through next_page instead.
+// Deletes do not merge buckets.
+//
+// Page 0 holds a MetaHeader; the directory is stored in the chain of raw
+// pages that starts at page 0's next_page.
+//
+// Lookups and inserts hold the directory latch shared and latch the first
+// page of their bucket, which covers its whole chain; a split takes the
+// directory latch exclusively.
+//
+// The index is not covered by the heap file's log: sync() makes it durable,
+// and after a crash it should be rebuilt from the heap file with build().
+class HashIndex {
+public:
+    using Key = uint64_t;
+    using KeyExtractor = std::function<Key(const void* record, uint16_t record_size)>;
+    using RecordId = HeapFile::RecordId;
+
+    static constexpr uint32_t META_PAGE_ID = 0;
+    static constexpr uint32_t NO_PAGE = UINT32_MAX;
+    static constexpr uint32_t MAGIC = 0x48494458; // "HIDX"
+    // Buckets are chained rather than split beyond this depth, or when the
+    // smaller half of the split would get under 1/MIN_SPLIT_DIVISOR of
+    // the entries. The directory holds 2^global_depth four-byte page ids,
+    // so this bounds it at 4 MiB, in memory and on disk; skewed keys fill
+    // overflow chains rather than doubling it past that.
+    static constexpr uint8_t MAX_GLOBAL_DEPTH = 20;
+    static constexpr std::size_t MIN_SPLIT_DIVISOR = 8;
+    static constexpr std::size_t DIRECTORY_ENTRIES_PER_PAGE =
+        (SlottedPage::PAGE_SIZE - sizeof(SlottedPage::PageHeader)) / sizeof(uint32_t);
+
+    HashIndex(const std::string& filename, KeyExtractor key_extractor,
+              std::size_t buffer_pool_mb = BufferPool::DEFAULT_POOL_SIZE_MB);
+
+    HashIndex(const HashIndex&) = delete;
+    HashIndex& operator=(const HashIndex&) = delete;
+
+    // Core operations
+    void insert(Key key, RecordId rid);
+    bool remove(Key key, RecordId rid);
+    void insertRecord(const void* record, uint16_t record_size, RecordId rid) {
+        insert(key_extractor(record, record_size), rid);
+    }
+    bool removeRecord(const void* record, uint16_t record_size, RecordId rid) {
+        return remove(key_extractor(record, record_size), rid);
+    }
+
+    // Every RID stored under key, in RID order
+    std::vector<RecordId> find(Key key);
+
+    // Index every live record of heap_file
+    void build(HeapFile& heap_file);
+
+    // File operations; sync() waits for in-flight operations
+    void sync();
+    void close();
+
+    // Statistics
+    uint8_t getGlobalDepth();
+    std::size_t getNumBuckets();
+    std::size_t getNumPages() const { return num_pages; }
+    BufferPool::Stats getBufferPoolStats() const { return buffer_pool->getStats(); }
+
+    // 64-bit mix of the key; its low bits pick the directory slot
+    static uint64_t hashKey(Key key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        key *= 0xc4ceb9fe1a85ec53ULL;
+        key ^= key >> 33;
+        return key;
+    }
+
+private:
+    // Cell 0 of page 0
+    struct MetaHeader {
+        uint32_t magic;
+        uint8_t global_depth;
+        uint8_t reserved[3];
+        uint64_t num_buckets;
+    };
+
+    // Cell 0 of the first page of each bucket; overflow pages have one too
+    struct BucketHeader {
+        uint8_t local_depth;
+        uint8_t reserved[7];
+    };
+
+    struct Entry {
+        Key key;
+        uint32_t page_id;
+        uint16_t slot_id;
+        uint16_t reserved;
+    };
+
+    std::string filename;
+    int file_descriptor;
+    KeyExtractor key_extractor;
+    std::atomic<std::size_t> num_pages;
+    std::unique_ptr<BufferPool> buffer_pool;
+
+    // Held shared by every operation and exclusively by splits and sync()
+    std::shared_mutex directory_latch;
+    std::vector<uint32_t> directory;
+    uint8_t global_depth = 0;
+    std::size_t num_buckets = 0;
+
+    uint32_t bucketFor(uint64_t hash) const { return directory[hash & ((uint64_t(1) << global_depth) - 1)]; }
+
+    // Bucket page accessors
+    static Entry makeEntry(Key key, RecordId rid);
+    static bool less(const Entry& a, const Entry& b);
+    static uint16_t numEntries(SlottedPage& page);
+    static Entry entryAt(SlottedPage& page, uint16_t idx);
+    static uint16_t lowerBound(SlottedPage& page, const Entry& target);
+    static bool makeRoom(SlottedPage& page);
+
+    // Insert unless the bucket's chain is full; true if the entry is now present
+    bool tryInsert(uint32_t bucket_page, const Entry& entry);
+    // Split the bucket, or chain an overflow page to it; holds the
+    // directory latch exclusively
+    void growBucket(uint32_t bucket_page, uint64_t hash);
+    void doubleDirectory();
+    // Rewrite a chain with entries, reusing its pages and adding more as needed
+    void writeChain(BufferPool::PageGuard& first, uint8_t local_depth, const std::vector<Entry>& entries);
+    uint32_t allocatePage(SlottedPage::PageType type);
+    void loadDirectory();
+    void saveDirectory();
+};
+
+#endif // HASH_INDEX_H
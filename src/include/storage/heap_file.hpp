@@ -4,26 +4,110 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <thread>
 #include <cstdint>
+#include <algorithm>
+#include <functional>
 #include "slotted_page.hpp"
+#include "buffer_pool.hpp"
+#include "log_manager.hpp"
+#include "free_space_map.hpp"
+#include "io_backend.hpp"
+#include "compressed_page_file.hpp"
+#include "pax_page.hpp"
+#include "encoded_page.hpp"
+#include "schema.hpp"
+#include "metrics.hpp"
 
+struct HeapFileOptions {
+    enum class AccessMode : uint8_t {
+        READ_WRITE,
+        // Map the whole file read-only; getRecord returns pointers into the
+        // mapping with no copies and no buffer pool bookkeeping
+        MMAP_READ_ONLY
+    };
+
+    enum class Compression : uint8_t {
+        NONE,
+        // Pages are stored LZ-compressed behind a page translation table
+        // (see CompressedPageFile); suits cold data read a page at a time.
+        // Not with direct I/O or MMAP_READ_ONLY.
+        LZ
+    };
+
+    AccessMode access_mode = AccessMode::READ_WRITE;
+    // Storage of a new file; an existing one keeps the format it was
+    // created with, and asking for LZ on a plain file throws
+    Compression compression = Compression::NONE;
+    // Backend for batched page I/O (checkpoint flush, scan read-ahead,
+    // bulk load)
+    IoBackend::Kind io_backend = IoBackend::Kind::AUTO;
+    // Open the data file with O_DIRECT, bypassing the OS page cache
+    bool direct_io = false;
+    std::size_t buffer_pool_mb = BufferPool::DEFAULT_POOL_SIZE_MB;
+    std::size_t fsm_fanout = FreeSpaceMap::DEFAULT_FANOUT;
+    // Background write-back (READ_WRITE mode, 0 disables): the buffer
+    // pool's writer cleans pages ahead of eviction every writer interval,
+    // and a fuzzy checkpoint starts every checkpoint interval, spreading its
+    // writes over half of it
+    uint32_t writer_interval_ms = 20;
+    uint32_t checkpoint_interval_ms = 5000;
+    // Compact a page on delete once removed cells hold this fraction of it
+    // (0 disables). Compaction keeps record ids valid.
+    float compaction_threshold = 0.25f;
+    // Field widths of a fixed-size record schema. When set, new files store
+    // records column-wise in PAX pages (see PaxPage and ColumnScanner).
+    // Existing files keep the layout they were created with; opening one
+    // with a different schema throws.
+    std::vector<uint16_t> pax_column_widths;
+    // Bulk loads into a PAX file write sealed pages instead, each holding as
+    // many rows as fit once its columns are dictionary, run-length or
+    // frame-of-reference encoded (see EncodedPage). Sealed pages take no
+    // further inserts; deleting a row only clears its presence bit.
+    bool encode_bulk_loads = false;
+    // Column types of typed tuples (see TupleBuilder). A new file records
+    // the schema in a catalog page, page 0, and inserts must then be valid
+    // tuples of it. An empty schema opens an existing file with whichever
+    // schema it has; opening it with a different one throws. Row layout only.
+    Schema schema;
+};
+
+// Heap of unordered records in slotted pages. All operations may be called
+// concurrently: pages are protected by buffer pool latches, the free-space
+// map by its own latch, and sync() waits for in-flight writers.
 class HeapFile {
 public:
-    // Constants for free-space map
-    static constexpr size_t ENTRIES_PER_SECOND_LEVEL = 4; // For demonstration, use 4 as in example
-    static constexpr uint8_t MAX_FREE_FRACTION = 8; // 3-bit representation as in example
-    
-    struct FreeSpaceEntry {
-        uint8_t free_fraction; // Value should be divided by MAX_FREE_FRACTION
-        
-        // Helper method to get actual fraction
-        float getFraction() const { 
-            return static_cast<float>(free_fraction) / MAX_FREE_FRACTION; 
-        }
+    // Pages written per vectored write by insertRecords()
+    static constexpr size_t BULK_LOAD_BATCH_PAGES = 64;
+
+    // Minimum address space reserved by the read-only mapping
+    static constexpr size_t MMAP_MIN_RESERVATION = size_t(1) << 30;
+
+    // Largest record that fits in an empty page; larger ones are written
+    // to overflow pages with LargeRecordWriter
+    static constexpr uint16_t MAX_RECORD_SIZE = std::min<std::size_t>(SlottedPage::MAX_CELL_SIZE,
+        SlottedPage::PAGE_SIZE - 1 - sizeof(SlottedPage::PageHeader) - sizeof(SlottedPage::CellPointer));
+
+    struct RecordId {
+        uint32_t page_id;
+        uint16_t slot_id;
+    };
+
+    // Cell left in a heap page for a record stored in a chain of overflow
+    // pages. getRecord() and the scanners return these bytes for it.
+    struct OverflowStub {
+        uint64_t length;
+        uint32_t first_page; // NO_PAGE for an empty record
+        uint32_t num_pages;
     };
 
     // Constructor
-    explicit HeapFile(const std::string& filename);
+    explicit HeapFile(const std::string& filename, const HeapFileOptions& options = HeapFileOptions());
 
     // Delete copy operations
     HeapFile(const HeapFile&) = delete;
@@ -33,54 +117,181 @@ public:
     HeapFile(HeapFile&& other) noexcept = delete;
     HeapFile& operator=(HeapFile&& other) noexcept = delete;
 
-    // Default destructor
-    ~HeapFile() = default;
+    // Stops the background checkpointer; pages not yet synced are recovered
+    // from the log on the next open
+    ~HeapFile();
     
     // Core operations
-    uint32_t insertRecord(const void* record, uint16_t record_size);
+    // With a schema, throws std::invalid_argument unless the record is a
+    // valid tuple of it
+    RecordId insertRecord(const void* record, uint16_t record_size);
+    // Bulk load count fixed-size records laid out back to back into fresh
+    // pages; the records are durable when the call returns. With several
+    // threads the records are cut into that many slices, each filled into
+    // its own pages by one thread; record ids still follow input order.
+    // Concurrent calls fill disjoint pages in parallel too.
+    std::vector<RecordId> insertRecords(const void* records, uint16_t record_size, size_t count,
+                                        size_t num_threads = 1);
+    // Deleting a large record also turns its overflow pages into empty heap pages
     bool deleteRecord(uint32_t page_id, uint16_t slot_id);
+    // In MMAP_READ_ONLY mode the pointer stays valid until close();
+    // otherwise until the page is evicted or changed.
+    // PAX records have no contiguous bytes: use readRecord() for those.
     void* getRecord(uint32_t page_id, uint16_t slot_id);
+    // Copy a record out under the page latch; returns bytes copied (0 if absent)
+    uint16_t readRecord(uint32_t page_id, uint16_t slot_id, void* buffer, uint16_t buffer_size);
+    // Change a record in place under the page latch: update edits its bytes
+    // and returns false to leave the record as it was. Only the changed
+    // byte range is logged. The callback must not call back into the file.
+    // Slotted rows only; false if the record is absent, a large record, or
+    // update declined.
+    bool updateRecord(uint32_t page_id, uint16_t slot_id,
+                      const std::function<bool(void* record, uint16_t record_size)>& update);
+    // Reclaim the space of deleted records; record ids stay valid
+    void compactPage(uint32_t page_id);
+    // True if the slot holds the stub of a record in overflow pages
+    bool isLargeRecord(uint32_t page_id, uint16_t slot_id);
+
+    // Make every change so far durable through the write-ahead log
+    void commit();
     
     // Free space management
     void updateFreeSpaceMap(uint32_t page_id);
-    uint32_t findPageWithSpace(uint16_t required_space);
+    uint32_t findPageWithSpace(uint16_t required_space); // num_pages if none
+    
     void recomputeFreeSpaceMap();
     
     // File operations
-    void sync();
+    void sync(); // Checkpoint: write back all pages and truncate the log
+    // Fuzzy checkpoint: write back the pages dirty when it starts, spreading
+    // the writes over spread_ms, then drop the log records they cover.
+    // Writers only pause while the dirty pages are listed.
+    void checkpoint(uint32_t spread_ms = 0);
     void close();
+    // Pick up pages appended by another writer (MMAP_READ_ONLY mode)
+    void refreshMapping();
 
     // Debugging/Statistics
     void printFreeSpaceMap() const;
+    int getFileDescriptor() const { return file_descriptor; }
+    BufferPool& getBufferPool() { return *buffer_pool; }
+    IoBackend& getIoBackend() { return *io_backend; }
+    bool isCompressed() const { return compressed_file != nullptr; }
+    CompressedPageFile::Stats getCompressionStats() const {
+        return compressed_file ? compressed_file->getStats() : CompressedPageFile::Stats{};
+    }
+    // Page-aligned transfers on the data file for scanners that bypass the
+    // buffer pool; goes through the page translation table when compressed.
+    // A thread with its own backend passes it to keep its batches off the
+    // file's one (uncompressed files only; ignored otherwise).
+    void submitPageIo(IoBackend::Request* requests, std::size_t count, IoBackend* backend = nullptr);
+    // A new backend of the kind the file uses, for a thread batching I/O
+    // of its own
+    std::unique_ptr<IoBackend> createIoBackend() const { return IoBackend::create(io_backend_kind); }
+    // Pages allocated so far. Pages of a bulk load or large record still
+    // being written read back empty until the call that allocated them
+    // returns.
     size_t getNumPages() const { return num_pages; }
+    bool isPax() const { return !pax_column_widths.empty(); }
+    const std::vector<uint16_t>& getColumnWidths() const { return pax_column_widths; }
+    bool hasSchema() const { return !schema.empty(); }
+    const Schema& getSchema() const { return schema; }
+    BufferPool::Stats getBufferPoolStats() const { return buffer_pool->getStats(); }
+    LogManager::Stats getLogStats() const { return log_manager ? log_manager->getStats() : LogManager::Stats{}; }
 
 private:
+    friend class LargeRecordWriter;
+    friend class LargeRecordReader;
+    friend class ColumnScanner;
+    friend class BatchScanner;
+
     std::string filename;
+    HeapFileOptions::AccessMode access_mode;
     int file_descriptor;
-    size_t num_pages;
+    // Page allocator: new pages and page ranges are claimed with one
+    // fetch_add, so concurrent loaders never wait on each other
+    std::atomic<size_t> num_pages;
+    IoBackend::Kind io_backend_kind = IoBackend::Kind::SYNC;
+    uint16_t compaction_threshold_bytes = 0;
+
+    // Record layout: empty for slotted rows, else the PAX field widths
+    std::vector<uint16_t> pax_column_widths;
+    uint16_t pax_record_size = 0;
+    bool encode_bulk_loads = false;
+    // Schema from the catalog page; empty for untyped files
+    Schema schema;
     
-    // Free space maps
-    std::vector<FreeSpaceEntry> free_space_map;
-    std::vector<FreeSpaceEntry> second_level_map;
+    // Free space tree, persisted in the "<filename>.fsm" fork
+    std::unique_ptr<FreeSpaceMap> free_space_map;
     
-    // Cache of recently used pages
-    static constexpr size_t PAGE_CACHE_SIZE = 10;
-    struct CachedPage {
-        uint32_t page_id;
-        std::shared_ptr<SlottedPage> page;
-        bool is_dirty;
-    };
-    std::vector<CachedPage> page_cache;
+    // Redo log, I/O backend and page frames shared by all operations on this file
+    std::unique_ptr<LogManager> log_manager;
+    std::unique_ptr<IoBackend> io_backend;
+    std::unique_ptr<CompressedPageFile> compressed_file; // Compression::LZ only
+    std::unique_ptr<BufferPool> buffer_pool;
+
+    // Held shared by mutations and exclusively by sync() and while a
+    // checkpoint lists the dirty pages
+    std::shared_mutex checkpoint_latch;
+
+    // Background checkpointer
+    std::thread checkpoint_thread;
+    std::mutex checkpointer_latch;
+    std::condition_variable checkpointer_cv;
+    bool checkpointer_stopping = false;
+
+    // Pages written outside the buffer pool, and pages of both kinds
+    // covered by the last sync (metrics only)
+    std::atomic<uint64_t> direct_page_writes{0};
+    std::atomic<uint64_t> synced_page_writes{0};
+
+    // Read-only mapping of the whole file (MMAP_READ_ONLY mode). Readers
+    // load it without the latch, so a mapping the file outgrows is kept,
+    // with the pointers into it, until close()
+    std::mutex mapping_latch;
+    std::atomic<const uint8_t*> mapping{nullptr};
+    size_t mapping_size = 0;
+    std::vector<std::pair<const uint8_t*, size_t>> old_mappings;
 
     // Helper methods
-    std::shared_ptr<SlottedPage> getPage(uint32_t page_id);
-    void flushPage(uint32_t page_id);
+    BufferPool::PageGuard getPage(uint32_t page_id, BufferPool::LatchMode mode);
+    void unmapFile();
+    void setFreeSpace(uint32_t page_id, const SlottedPage& page);
     uint32_t allocateNewPage();
-    void updateSecondLevelMap(size_t start_idx);
-    float calculatePageFreeSpace(const SlottedPage& page);
-    void writeFreeSpaceMapToDisk();
-    void readFreeSpaceMapFromDisk();
-    void initializeMaps();
+    RecordId insertCell(const void* cell, uint16_t cell_size, bool is_overflow);
+    // One thread's share of insertRecords(): fill, log and write pages for
+    // count records, appending their ids and the pages' free space. Call
+    // under checkpoint_latch.
+    void loadRecords(const uint8_t* input, uint16_t record_size, size_t count, std::vector<RecordId>& record_ids,
+                     std::vector<std::pair<uint32_t, uint16_t>>& loaded_pages);
+    // Log the allocation of count overflow pages at the end of the file and
+    // return the first; the caller writes them. Call under checkpoint_latch.
+    uint32_t allocateOverflowPages(uint32_t count, uint64_t& lsn);
+    // Reset an overflow page to an empty heap page; returns its next link,
+    // or NO_PAGE without changing it if it is not an overflow page
+    uint32_t freeOverflowPage(uint32_t page_id);
+    static uint16_t usableSpace(const SlottedPage& page);
+    // Make pages written outside the buffer pool durable (and, when
+    // compressed, reachable through the persisted table)
+    void syncPages();
+    void requireWritable() const;
+    void openMapped(const HeapFileOptions& options);
+    const uint8_t* getMappedPage(uint32_t page_id);
+    const SlottedPage::CellPointer* getMappedCell(uint32_t page_id, uint16_t slot_id);
+    void recover();
+    void runCheckpointer(std::chrono::milliseconds interval);
+    void stopBackgroundWork();
+    void redoNewPage(uint32_t page_id, SlottedPage::PageType type, uint64_t lsn,
+                     const std::vector<uint16_t>& column_widths);
+    void resolveLayout(const HeapFileOptions& options);
+    // Adopt the schema in the catalog page, or write the requested one to
+    // a new file
+    void resolveSchema(const Schema& requested);
+    void writeCatalog(const Schema& requested, bool new_page);
+    void checkTuple(const void* record, uint16_t record_size) const;
+    SlottedPage::PageType heapPageType() const;
+    // Lay out a freshly reset heap page for the file's record layout
+    void formatHeapPage(SlottedPage& page) const;
 };
 
 #endif // HEAP_FILE_H
\ No newline at end of file
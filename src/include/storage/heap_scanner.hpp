@@ -0,0 +1,80 @@
+#ifndef HEAP_SCANNER_H
+#define HEAP_SCANNER_H
+
+#include <cstdint>
+#include <vector>
+#include "heap_file.hpp"
+
+// Forward scan over every live record of a HeapFile in page order. Pages are
+// read in large chunks into a private buffer that bypasses the buffer pool,
+// with the next chunk prefetched via posix_fadvise, so a full-table scan
+// does not evict the hot working set. The runs of a chunk are read as one
+// batch through the file's I/O backend. Pages that are resident in the pool
+// are copied from there, so unflushed changes are visible. Rows of PAX
+// and encoded pages are gathered into a buffer owned by the scanner.
+//
+//     HeapScanner scanner(heap_file);
+//     while (scanner.next()) {
+//         use(scanner.getRecord(), scanner.getRecordSize());
+//     }
+class HeapScanner {
+public:
+    static constexpr std::size_t DEFAULT_READAHEAD_PAGES = 64;
+
+    explicit HeapScanner(HeapFile& heap_file, std::size_t readahead_pages = DEFAULT_READAHEAD_PAGES);
+    // Scan only pages [first_page, end_page), reading through io_backend
+    // when given instead of the file's (see ParallelScan)
+    HeapScanner(HeapFile& heap_file, uint32_t first_page, std::size_t end_page,
+                std::size_t readahead_pages = DEFAULT_READAHEAD_PAGES, IoBackend* io_backend = nullptr);
+
+    HeapScanner(const HeapScanner&) = delete;
+    HeapScanner& operator=(const HeapScanner&) = delete;
+
+    // Restart over pages [first_page, end_page), keeping the read-ahead
+    // buffer
+    void setRange(uint32_t first_page, std::size_t end_page);
+
+    // Advance to the next live record; false once the scan is exhausted
+    bool next();
+
+    // Page-at-a-time iteration for readers of other layouts: the next page
+    // of the file, valid until the following call, or nullptr at the end.
+    // Do not mix with next().
+    const uint8_t* nextPage();
+    uint32_t getPageId() const { return static_cast<uint32_t>(chunk_first_page + page_in_chunk); }
+
+    // Accessors for the current record; the pointer is valid until next()
+    HeapFile::RecordId getRecordId() const {
+        return {getPageId(), slot_id};
+    }
+    const void* getRecord() const { return record; }
+    uint16_t getRecordSize() const { return record_size; }
+    // The record is a HeapFile::OverflowStub; read it with LargeRecordReader
+    bool isLargeRecord() const { return large_record; }
+
+private:
+    HeapFile& heap_file;
+    IoBackend* io_backend;
+    std::size_t readahead_pages;
+    std::size_t end_page = 0;
+    AlignedBuffer chunk;
+    std::vector<IoBackend::Request> requests;
+
+    // Position of the current record
+    uint32_t chunk_first_page = 0;
+    std::size_t chunk_pages = 0;
+    std::size_t page_in_chunk = 0;
+    uint16_t slot_id = 0;
+    bool slot_started = false;
+    const void* record = nullptr;
+    uint16_t record_size = 0;
+    bool large_record = false;
+    std::vector<uint8_t> row_buffer;
+    bool page_started = false;
+
+    // Helper methods
+    bool loadChunk(uint32_t first_page);
+    bool advanceInPage();
+};
+
+#endif // HEAP_SCANNER_H
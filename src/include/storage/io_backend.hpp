@@ -0,0 +1,118 @@
+#ifndef IO_BACKEND_H
+#define IO_BACKEND_H
+
+#include <sys/types.h>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
+
+// Alignment of buffers handed to the kernel; O_DIRECT needs at least the
+// logical block size, and a page covers every common device
+constexpr std::size_t IO_ALIGNMENT = 4096;
+
+struct AlignedDeleter {
+    void operator()(uint8_t* ptr) const { ::operator delete[](ptr, std::align_val_t(IO_ALIGNMENT)); }
+};
+using AlignedBuffer = std::unique_ptr<uint8_t[], AlignedDeleter>;
+
+// Zero-filled buffer aligned to IO_ALIGNMENT
+inline AlignedBuffer allocateAligned(std::size_t size) {
+    auto* ptr = static_cast<uint8_t*>(::operator new[](size, std::align_val_t(IO_ALIGNMENT)));
+    std::memset(ptr, 0, size);
+    return AlignedBuffer(ptr);
+}
+
+// Positional page I/O. Single reads and writes are plain blocking calls;
+// submit() takes a batch of independent requests and returns once all of
+// them have completed, letting backends that support it keep the whole
+// batch in flight at once.
+class IoBackend {
+public:
+    enum class Kind : uint8_t {
+        SYNC,      // pread/pwrite, one request at a time
+        IO_URING,  // Batches go through an io_uring; throws if unsupported
+        AUTO       // io_uring when the kernel allows it, otherwise SYNC
+    };
+
+    struct Request {
+        enum class Op : uint8_t { READ, WRITE };
+
+        Op op;
+        int fd;
+        void* buffer;
+        std::size_t length;
+        off_t offset;
+        ssize_t result; // Bytes transferred (short only at end of file) or -errno
+    };
+
+    virtual ~IoBackend() = default;
+
+    static std::unique_ptr<IoBackend> create(Kind kind);
+
+    // Transfer the whole range, retrying short transfers; returns the bytes
+    // transferred (less than length only when a read hits end of file) or -1
+    static ssize_t read(int fd, void* buffer, std::size_t length, off_t offset);
+    static ssize_t write(int fd, const void* buffer, std::size_t length, off_t offset);
+    // Sync the directory holding path, so a file renamed or created there
+    // is found after a crash; false on failure
+    static bool syncDirectory(const std::string& path);
+
+    virtual void submit(Request* requests, std::size_t count) = 0;
+    virtual const char* getName() const = 0;
+};
+
+class SyncIoBackend : public IoBackend {
+public:
+    void submit(Request* requests, std::size_t count) override;
+    const char* getName() const override { return "sync"; }
+};
+
+// io_uring driven through the raw system calls, so no liburing is needed.
+// One ring is shared by all threads; concurrent batches are serialised.
+class IoUringBackend : public IoBackend {
+public:
+    static constexpr unsigned DEFAULT_QUEUE_DEPTH = 128;
+
+    explicit IoUringBackend(unsigned queue_depth = DEFAULT_QUEUE_DEPTH);
+    ~IoUringBackend() override;
+
+    IoUringBackend(const IoUringBackend&) = delete;
+    IoUringBackend& operator=(const IoUringBackend&) = delete;
+
+    void submit(Request* requests, std::size_t count) override;
+    const char* getName() const override { return "io_uring"; }
+
+private:
+    int ring_fd;
+    std::mutex latch;
+    // Per-batch bookkeeping, reused under the latch
+    std::vector<std::size_t> pending;
+    std::vector<std::size_t> transferred;
+
+    // Ring mappings
+    void* sq_ring = nullptr;
+    void* cq_ring = nullptr;
+    std::size_t sq_ring_size = 0;
+    std::size_t cq_ring_size = 0;
+    struct io_uring_sqe* sqes = nullptr;
+    std::size_t sqes_size = 0;
+
+    // Pointers into the mapped rings
+    unsigned* sq_head;
+    unsigned* sq_tail;
+    unsigned* sq_mask;
+    unsigned* sq_array;
+    unsigned sq_entries;
+    unsigned* cq_head;
+    unsigned* cq_tail;
+    unsigned* cq_mask;
+    struct io_uring_cqe* cqes;
+
+    void unmapRings();
+};
+
+#endif // IO_BACKEND_H
@@ -0,0 +1,102 @@
+#ifndef LARGE_RECORD_H
+#define LARGE_RECORD_H
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "heap_file.hpp"
+
+// Streams a record of any length into a chain of overflow pages and leaves
+// a HeapFile::OverflowStub in a heap page, so a multi-megabyte value is never
+// held in one buffer. Data is staged a batch of pages at a time; each batch
+// is allocated at the end of the file with one logged range, like a bulk
+// load, and written with a single request. The record is durable and
+// visible once finish() returns.
+//
+//     LargeRecordWriter writer(heap_file);
+//     while (size_t n = source.read(buffer, sizeof(buffer))) {
+//         writer.write(buffer, n);
+//     }
+//     HeapFile::RecordId rid = writer.finish();
+class LargeRecordWriter {
+public:
+    static constexpr std::size_t DATA_PER_PAGE =
+        SlottedPage::PAGE_SIZE - 1 - sizeof(SlottedPage::PageHeader);
+
+    explicit LargeRecordWriter(HeapFile& heap_file,
+                               std::size_t batch_pages = HeapFile::BULK_LOAD_BATCH_PAGES);
+
+    LargeRecordWriter(const LargeRecordWriter&) = delete;
+    LargeRecordWriter& operator=(const LargeRecordWriter&) = delete;
+
+    // An unfinished record gives its pages back to the heap
+    ~LargeRecordWriter();
+
+    void write(const void* data, std::size_t size);
+    HeapFile::RecordId finish();
+
+    uint64_t getLength() const { return length; }
+
+private:
+    HeapFile& heap_file;
+    std::size_t batch_pages;
+    AlignedBuffer batch; // Staged pages, data after each page's header
+    std::size_t batch_bytes = 0;
+
+    // Last page of the previous batch, written once the next page id is known
+    AlignedBuffer held;
+    uint32_t held_page = SlottedPage::NO_PAGE;
+
+    uint64_t length = 0;
+    uint32_t first_page = SlottedPage::NO_PAGE;
+    uint32_t num_pages = 0;
+    std::vector<std::pair<uint32_t, uint32_t>> allocated; // (first page, count)
+    bool finished = false;
+
+    void flushBatch(bool last);
+};
+
+// Reads a large record back in pieces of the caller's choosing. Runs of
+// consecutive overflow pages are read ahead in chunks straight from the
+// file, bypassing the buffer pool.
+class LargeRecordReader {
+public:
+    static constexpr std::size_t DEFAULT_READAHEAD_PAGES = 64;
+
+    // Throws std::invalid_argument if the slot does not hold a large record
+    LargeRecordReader(HeapFile& heap_file, HeapFile::RecordId rid,
+                      std::size_t readahead_pages = DEFAULT_READAHEAD_PAGES);
+    LargeRecordReader(HeapFile& heap_file, const HeapFile::OverflowStub& stub,
+                      std::size_t readahead_pages = DEFAULT_READAHEAD_PAGES);
+
+    LargeRecordReader(const LargeRecordReader&) = delete;
+    LargeRecordReader& operator=(const LargeRecordReader&) = delete;
+
+    // Copy up to size bytes; returns the number copied, 0 at the end
+    std::size_t read(void* buffer, std::size_t size);
+
+    uint64_t size() const { return stub.length; }
+    uint64_t tell() const { return position; }
+
+private:
+    HeapFile& heap_file;
+    HeapFile::OverflowStub stub;
+    std::size_t readahead_pages;
+    AlignedBuffer chunk;
+
+    uint32_t chunk_first_page = 0;
+    std::size_t chunk_pages = 0;
+    uint32_t next_page;
+    uint32_t pages_left;
+    uint64_t position = 0;
+
+    // Data of the current page
+    const uint8_t* data = nullptr;
+    std::size_t data_size = 0;
+    std::size_t data_offset = 0;
+
+    static HeapFile::OverflowStub readStub(HeapFile& heap_file, HeapFile::RecordId rid);
+    void loadNextPage();
+};
+
+#endif // LARGE_RECORD_H
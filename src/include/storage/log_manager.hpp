@@ -0,0 +1,112 @@
+#ifndef LOG_MANAGER_H
+#define LOG_MANAGER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Append-only redo log. Records are buffered in memory and made durable by
+// flush(); concurrent committers waiting on the same fsync are batched into
+// a single write (group commit). LSNs increase monotonically across
+// truncations, so page LSNs on disk stay comparable with new records.
+class LogManager {
+public:
+    // Capacity each half of the append buffer starts with, enough for the
+    // groups of a busy writer so that steady-state appends never grow it
+    static constexpr std::size_t INITIAL_BUFFER_SIZE = 256 * 1024;
+
+    enum class RecordType : uint8_t {
+        NEW_PAGE = 1,   // payload: one byte of SlottedPage::PageType
+        ADD_CELL = 2,   // payload: cell bytes, slot_id: expected slot
+        REMOVE_CELL = 3,
+        COMPACT = 4,
+        NEW_PAGE_RANGE = 5, // payload: PageType byte + uint32_t page count
+        ADD_OVERFLOW_CELL = 6, // As ADD_CELL, for the stub of a large record
+        UPDATE_CELL = 7 // payload: uint16_t offset into the cell + the bytes written there
+    };
+
+    struct RecordHeader {
+        uint32_t size;      // Header plus payload
+        uint32_t checksum;  // FNV-1a over the record with this field zeroed
+        uint64_t lsn;
+        uint32_t page_id;
+        uint16_t slot_id;
+        RecordType type;
+        uint8_t reserved;
+    };
+
+    struct LogRecord {
+        const RecordHeader* header;
+        const uint8_t* payload;
+        uint16_t payload_size;
+    };
+
+    struct Stats {
+        uint64_t records_appended;
+        uint64_t bytes_written;
+        uint64_t flush_requests;
+        uint64_t fsyncs;
+    };
+
+    explicit LogManager(const std::string& filename);
+    ~LogManager();
+
+    LogManager(const LogManager&) = delete;
+    LogManager& operator=(const LogManager&) = delete;
+
+    // Buffer a record and return its LSN
+    uint64_t append(RecordType type, uint32_t page_id, uint16_t slot_id,
+                    const void* payload = nullptr, uint16_t payload_size = 0);
+
+    // Block until every record up to and including lsn is on stable storage
+    void flush(uint64_t lsn);
+    void flushAll() { flush(getLastLsn()); }
+
+    // Visit every intact record on disk in LSN order, stopping at a torn tail
+    void forEachRecord(const std::function<void(const LogRecord&)>& visitor);
+
+    // Discard the log once all pages it covers are durable (checkpoint)
+    void truncate();
+    // Discard the durable records older than lsn once the pages they cover
+    // are durable (fuzzy checkpoint). The newer records are copied into a
+    // fresh log, so this is skipped until the discarded prefix outweighs them.
+    void truncateBefore(uint64_t lsn);
+
+    uint64_t getLastLsn();
+    uint64_t getDurableLsn();
+    Stats getStats();
+
+private:
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t reserved;
+        uint64_t base_lsn;
+    };
+
+    static constexpr uint32_t LOG_MAGIC = 0x4C415754; // "TWAL"
+
+    std::string filename;
+    int file_descriptor;
+
+    std::mutex latch;
+    std::condition_variable flushed_cv;
+    std::vector<uint8_t> log_buffer;
+    // The other half of a double buffer: empty, holding the capacity of the
+    // last group written, which appends take over during the next flush
+    std::vector<uint8_t> spare_buffer;
+    uint64_t base_lsn;
+    uint64_t next_lsn;
+    uint64_t durable_lsn;
+    off_t write_offset;
+    bool flush_in_progress = false;
+    Stats stats = {};
+
+    // Helper methods
+    void writeFileHeader(uint64_t first_lsn);
+    static uint32_t checksum(const uint8_t* data, std::size_t size);
+};
+
+#endif // LOG_MANAGER_H
@@ -0,0 +1,26 @@
+#ifndef LZ_CODEC_H
+#define LZ_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Byte-oriented LZ77 compression laid out like an LZ4 block: a sequence is a
+// token (literal count, match length), the literals, and a 16-bit offset
+// back to the match. Single pass with a small hash table of 4-byte prefixes,
+// so it is fast on both sides and needs no state beyond the call; pages are
+// compressed one at a time.
+class LzCodec {
+public:
+    // Worst-case output size for incompressible input
+    static std::size_t maxCompressedSize(std::size_t size) { return size + size / 255 + 16; }
+
+    // Returns the compressed size, or 0 if it would exceed capacity (pass
+    // less than the input size to give up on data that does not shrink)
+    static std::size_t compress(const uint8_t* src, std::size_t size, uint8_t* dst, std::size_t capacity);
+
+    // Returns the decompressed size. Throws std::runtime_error for
+    // malformed input or output that would exceed capacity.
+    static std::size_t decompress(const uint8_t* src, std::size_t size, uint8_t* dst, std::size_t capacity);
+};
+
+#endif // LZ_CODEC_H
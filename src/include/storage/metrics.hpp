@@ -0,0 +1,193 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Build-time switch, set with the TINYDB_METRICS CMake option. At 0 the
+// recording macros below expand to nothing; snapshot() still works and
+// returns zeroes.
+#ifndef TINYDB_METRICS
+#define TINYDB_METRICS 1
+#endif
+
+// Latency distribution in nanoseconds, bucketed HDR-style: exact below 16,
+// then 16 buckets per power of two, so any value is reported within 6.25%.
+// Values from 2^40 ns (about 18 minutes) on share the last bucket.
+class Histogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 4;
+    static constexpr unsigned MAX_VALUE_BITS = 40;
+    static constexpr std::size_t NUM_BUCKETS = std::size_t(MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;
+
+    static std::size_t bucketFor(uint64_t value) {
+        constexpr uint64_t sub_buckets = uint64_t(1) << SUB_BUCKET_BITS;
+        if (value < sub_buckets) {
+            return static_cast<std::size_t>(value);
+        }
+        if (value >> MAX_VALUE_BITS) {
+            return NUM_BUCKETS - 1;
+        }
+        unsigned shift = 63 - __builtin_clzll(value) - SUB_BUCKET_BITS;
+        return static_cast<std::size_t>(((shift + 1) << SUB_BUCKET_BITS) + (value >> shift) - sub_buckets);
+    }
+    // Largest value that lands in the bucket
+    static uint64_t bucketLimit(std::size_t bucket);
+
+    void record(uint64_t value) { add(bucketFor(value), 1, value, value); }
+    void merge(const Histogram& other);
+    // Fold in count values known only by bucket, with their sum and maximum
+    void add(std::size_t bucket, uint64_t count, uint64_t sum, uint64_t max);
+
+    uint64_t getCount() const { return count; }
+    uint64_t getSum() const { return sum; }
+    uint64_t getMax() const { return max; }
+    double getMean() const { return count > 0 ? static_cast<double>(sum) / count : 0; }
+    // Smallest recorded bucket limit at or above the quantile (0..1), capped
+    // at the maximum; 0 when empty
+    uint64_t getPercentile(double quantile) const;
+
+private:
+    std::array<uint64_t, NUM_BUCKETS> buckets{};
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t max = 0;
+};
+
+// Process-wide counters and latency histograms on the storage hot paths.
+// Each thread records into its own slots with plain relaxed stores, so the
+// hot path takes no lock and shares no cache line; snapshot() sums every
+// live thread plus the totals left by threads that have exited.
+//
+//     Metrics::Snapshot snapshot = Metrics::snapshot();
+//     double hit_rate = snapshot.getHitRate();
+//     std::cout << snapshot.toPrometheus();
+//
+// Record with the TINYDB_COUNT and TINYDB_TIME macros so that a build with
+// TINYDB_METRICS=0 pays nothing.
+class Metrics {
+public:
+    static constexpr bool ENABLED = TINYDB_METRICS != 0;
+
+    enum class Counter : uint8_t {
+        PAGE_HITS,      // Buffer pool fetches served from a resident frame
+        PAGE_MISSES,    // Buffer pool fetches that had to read the page
+        PAGES_READ,     // Pages read from data files, pool and direct
+        PAGES_WRITTEN,  // Pages written to data files, pool and direct
+        EVICTION_WRITES, // Of those, dirty victims an evicting fetch wrote itself
+        FSM_PROBES,     // Candidate pages tried by inserts
+        COMPACTIONS,    // Heap pages compacted
+        VERSIONS_VACUUMED, // Dead MVCC versions reclaimed
+        FSYNCS,         // Data and log file syncs
+        BYTES_FSYNCED,  // Bytes written since the previous sync of each file
+        NUM_COUNTERS
+    };
+
+    enum class Latency : uint8_t {
+        PAGE_READ,   // Buffer pool miss read
+        PAGE_WRITE,  // Single page write-back
+        BATCH_WRITE, // Batched page writes (flushes, checkpoints, background writer, bulk loads), per batch
+        LOG_FLUSH,   // Log group write and fsync
+        DATA_SYNC,   // Data file fsync
+        CHECKPOINT,  // HeapFile::sync() and checkpoint(), end to end
+        NUM_LATENCIES
+    };
+
+    static constexpr std::size_t NUM_COUNTERS = static_cast<std::size_t>(Counter::NUM_COUNTERS);
+    static constexpr std::size_t NUM_LATENCIES = static_cast<std::size_t>(Latency::NUM_LATENCIES);
+
+    struct Snapshot {
+        std::array<uint64_t, NUM_COUNTERS> counters{};
+        std::array<Histogram, NUM_LATENCIES> latencies;
+
+        uint64_t get(Counter counter) const { return counters[static_cast<std::size_t>(counter)]; }
+        const Histogram& get(Latency latency) const { return latencies[static_cast<std::size_t>(latency)]; }
+        double getHitRate() const;
+
+        std::string toJson() const;
+        // Text exposition format: counters as tinydb_<name>_total,
+        // latencies as summaries in seconds
+        std::string toPrometheus() const;
+    };
+
+    static const char* getName(Counter counter);
+    static const char* getName(Latency latency);
+
+    static Snapshot snapshot();
+
+    static void add(Counter counter, uint64_t amount = 1) {
+        std::atomic<uint64_t>& value = local().counters[static_cast<std::size_t>(counter)];
+        value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    static void record(Latency latency, uint64_t nanos) {
+        ThreadHistogram& histogram = local().latencies[static_cast<std::size_t>(latency)];
+        std::atomic<uint64_t>& bucket = histogram.buckets[Histogram::bucketFor(nanos)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        histogram.sum.store(histogram.sum.load(std::memory_order_relaxed) + nanos, std::memory_order_relaxed);
+        if (nanos > histogram.max.load(std::memory_order_relaxed)) {
+            histogram.max.store(nanos, std::memory_order_relaxed);
+        }
+    }
+
+    // Records the lifetime of the enclosing scope
+    class Timer {
+    public:
+        explicit Timer(Latency latency) : latency(latency), start(std::chrono::steady_clock::now()) {}
+        ~Timer() {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            record(latency, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        }
+
+        Timer(const Timer&) = delete;
+        Timer& operator=(const Timer&) = delete;
+
+    private:
+        Latency latency;
+        std::chrono::steady_clock::time_point start;
+    };
+
+private:
+    // Written only by the owning thread, read by snapshot()
+    struct ThreadHistogram {
+        std::array<std::atomic<uint64_t>, Histogram::NUM_BUCKETS> buckets;
+        std::atomic<uint64_t> sum;
+        std::atomic<uint64_t> max;
+    };
+
+    struct ThreadMetrics {
+        std::array<std::atomic<uint64_t>, NUM_COUNTERS> counters;
+        std::array<ThreadHistogram, NUM_LATENCIES> latencies;
+    };
+
+    // Registers the thread's slots on first use; folds them into the
+    // retired totals when the thread exits
+    class Registration {
+    public:
+        Registration();
+        ~Registration();
+
+        std::unique_ptr<ThreadMetrics> metrics;
+    };
+
+    static ThreadMetrics& local() {
+        thread_local Registration registration;
+        return *registration.metrics;
+    }
+
+    static void collect(const ThreadMetrics& metrics, Snapshot& snapshot);
+};
+
+#if TINYDB_METRICS
+#define TINYDB_COUNT(counter, amount) Metrics::add(Metrics::Counter::counter, (amount))
+#define TINYDB_TIME(latency) Metrics::Timer metrics_timer_##latency(Metrics::Latency::latency)
+#else
+#define TINYDB_COUNT(counter, amount) ((void)0)
+#define TINYDB_TIME(latency) ((void)0)
+#endif
+
+#endif // METRICS_H
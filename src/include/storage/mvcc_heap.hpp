@@ -0,0 +1,211 @@
+#ifndef MVCC_HEAP_H
+#define MVCC_HEAP_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "heap_file.hpp"
+#include "heap_scanner.hpp"
+
+// Multi-version records over a HeapFile, so that long scans see a
+// consistent state while ingestion continues. Each record is stored as a
+// version: a VersionHeader with the timestamp of the write that created it
+// and of the one that replaced or deleted it, followed by the caller's
+// bytes. Writes never change a version's bytes, only stamp its end: an
+// update adds a new version linked both ways to the one it replaces, and a
+// delete ends the current version.
+//
+// Each insert, update and remove is a transaction of its own, taking its
+// timestamp from a single counter, and is visible once it returns;
+// commit() makes it durable as HeapFile::commit() does. A Snapshot sees
+// exactly the versions with begin_ts <= its timestamp < end_ts. Its
+// timestamp is the newest one below every write still in flight, so no
+// write ever appears under it later. Readers hold a page latch only while
+// copying a version (the scanner copies whole pages), so readers and
+// writers never wait on each other beyond that.
+//
+//     MvccHeap heap("table.db");
+//     MvccHeap::RecordId rid = heap.insert(&row, sizeof(row));
+//     heap.update(rid, &new_row, sizeof(new_row)); // rid now names the new version
+//     MvccHeap::Snapshot snapshot = heap.beginSnapshot();
+//     for (MvccHeap::Scanner scanner(heap, snapshot); scanner.next();) {
+//         use(scanner.getRecord(), scanner.getRecordSize());
+//     }
+//
+// Vacuum, run in the background every vacuum interval or by vacuum(),
+// deletes the versions that ended at or before the oldest live snapshot,
+// compacts their pages and hands the space back to the free-space map. It
+// only revisits pages where a version has ended since its last pass.
+// Reclaimed record ids are reused, so keep the id update() returns rather
+// than the one a record was inserted under.
+//
+// An update first claims the old version (end_ts stamped, UPDATE_PENDING
+// set), then inserts and links the new one. The "<filename>.mvcc" fork
+// holds the next timestamp while the heap is closed; after a crash a scan
+// rebuilds it, completes updates whose new version reached the log and
+// rolls back the others.
+class MvccHeap {
+public:
+    using Timestamp = uint64_t;
+    using RecordId = HeapFile::RecordId;
+
+    static constexpr Timestamp INFINITE_TS = UINT64_MAX;
+    static constexpr uint16_t UPDATE_PENDING = 0x1;
+    static constexpr uint32_t DEFAULT_VACUUM_INTERVAL_MS = 1000;
+
+    // Prefix of every stored version
+    struct VersionHeader {
+        Timestamp begin_ts;
+        Timestamp end_ts; // INFINITE_TS while current
+        uint32_t prev_page; // Version this one replaced, NO_PAGE if none
+        uint32_t next_page; // Version that replaced this one, NO_PAGE if none
+        uint16_t prev_slot;
+        uint16_t next_slot;
+        uint16_t flags;
+        uint16_t reserved;
+    };
+
+    static constexpr uint16_t MAX_RECORD_SIZE = HeapFile::MAX_RECORD_SIZE - sizeof(VersionHeader);
+
+    // Read timestamp registered with the heap until destroyed; vacuum keeps
+    // every version it can see
+    class Snapshot {
+    public:
+        Snapshot(Snapshot&& other) noexcept;
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator=(const Snapshot&) = delete;
+        Snapshot& operator=(Snapshot&&) = delete;
+        ~Snapshot();
+
+        Timestamp getTimestamp() const { return timestamp; }
+        bool isVisible(const VersionHeader& version) const {
+            return version.begin_ts <= timestamp && timestamp < version.end_ts;
+        }
+
+    private:
+        friend class MvccHeap;
+        Snapshot(MvccHeap* heap, std::multiset<Timestamp>::iterator registration);
+
+        MvccHeap* heap;
+        std::multiset<Timestamp>::iterator registration;
+        Timestamp timestamp;
+    };
+
+    // Forward scan over the versions a snapshot sees, in page order; see
+    // HeapScanner. The snapshot must outlive the scanner.
+    class Scanner {
+    public:
+        Scanner(MvccHeap& heap, const Snapshot& snapshot,
+                std::size_t readahead_pages = HeapScanner::DEFAULT_READAHEAD_PAGES);
+
+        bool next();
+
+        // Accessors for the current record; the pointer is valid until next()
+        RecordId getRecordId() const { return scanner.getRecordId(); }
+        const void* getRecord() const { return static_cast<const uint8_t*>(scanner.getRecord()) + sizeof(VersionHeader); }
+        uint16_t getRecordSize() const { return scanner.getRecordSize() - sizeof(VersionHeader); }
+        const VersionHeader& getVersion() const { return version; }
+
+    private:
+        const Snapshot& snapshot;
+        HeapScanner scanner;
+        VersionHeader version;
+    };
+
+    // A vacuum interval of 0 leaves vacuum() to the caller.
+    // Throws std::invalid_argument for PAX, typed or read-only heap files,
+    // and std::runtime_error for a heap file that holds unversioned records
+    explicit MvccHeap(const std::string& filename, const HeapFileOptions& options = HeapFileOptions(),
+                      uint32_t vacuum_interval_ms = DEFAULT_VACUUM_INTERVAL_MS);
+
+    MvccHeap(const MvccHeap&) = delete;
+    MvccHeap& operator=(const MvccHeap&) = delete;
+
+    // Stops the background vacuum; without close() the next open rebuilds
+    // the fork with a scan
+    ~MvccHeap();
+
+    // Core operations
+    RecordId insert(const void* record, uint16_t record_size);
+    // Replace the current version rid names; on success rid names the new
+    // one. False if rid no longer names a current version (it was updated
+    // or removed since).
+    bool update(RecordId& rid, const void* record, uint16_t record_size);
+    bool remove(RecordId rid);
+    // Copy out the version of rid's record that snapshot sees, following
+    // the version chain either way; returns bytes copied (0 if none)
+    uint16_t read(const Snapshot& snapshot, RecordId rid, void* buffer, uint16_t buffer_size);
+
+    Snapshot beginSnapshot();
+
+    // Reclaim the versions no snapshot can see; returns how many
+    std::size_t vacuum();
+
+    // File operations
+    void commit() { heap_file->commit(); }
+    void sync() { heap_file->sync(); }
+    void close();
+
+    // Statistics
+    HeapFile& getHeapFile() { return *heap_file; }
+    // Versions ended at or before this are dead
+    Timestamp getVacuumHorizon();
+
+private:
+    // Fork contents
+    struct State {
+        uint32_t magic;
+        uint32_t clean; // Closed cleanly, so next_timestamp is exact
+        Timestamp next_timestamp;
+    };
+
+    static constexpr uint32_t STATE_MAGIC = 0x4D564343; // "MVCC"
+
+    std::unique_ptr<HeapFile> heap_file;
+    std::string state_filename;
+    int state_descriptor = -1;
+
+    // Timestamps of writes in flight, live snapshots, and pages where a
+    // version ended since vacuum last looked
+    std::mutex timestamp_latch;
+    Timestamp next_timestamp = 1;
+    std::set<Timestamp> in_flight;
+    std::multiset<Timestamp> snapshots;
+    std::set<uint32_t> ended_pages;
+    bool vacuum_everything = true;
+
+    // One vacuum pass at a time
+    std::mutex vacuum_latch;
+
+    // Background vacuum
+    std::thread vacuum_thread;
+    std::mutex vacuumer_latch;
+    std::condition_variable vacuumer_cv;
+    bool vacuumer_stopping = false;
+
+    // Helper methods
+    Timestamp beginWrite();
+    // Publish the write; ended_page is the page of a version it ended
+    void endWrite(Timestamp timestamp, uint32_t ended_page = SlottedPage::NO_PAGE);
+    // Newest timestamp every write at or below has finished
+    Timestamp stableTimestamp() const;
+    RecordId insertVersion(const VersionHeader& header, const void* record, uint16_t record_size);
+    // Copy a version into buffer; false if rid holds none
+    bool readVersion(RecordId rid, std::vector<uint8_t>& buffer, VersionHeader& header);
+    // Reclaim the versions of pages [first_page, end_page) that ended at
+    // or before horizon, reading them with scanner
+    std::size_t vacuumPages(HeapScanner& scanner, uint32_t first_page, std::size_t end_page, Timestamp horizon);
+    void writeState(bool clean);
+    // Rebuild the next timestamp and settle interrupted updates
+    void recoverVersions();
+    void runVacuum(std::chrono::milliseconds interval);
+    void stopVacuum();
+};
+
+#endif // MVCC_HEAP_H
@@ -0,0 +1,38 @@
+#ifndef PAGE_ARENA_H
+#define PAGE_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+
+// One anonymous mapping carved into page frames, so a cache allocates its
+// memory once instead of per page. The mapping starts on a huge page
+// boundary and is backed by huge pages when the system has them reserved
+// (MAP_HUGETLB), otherwise marked for transparent huge pages; either way
+// frames are aligned for O_DIRECT. Memory is zero until first written and
+// never initialised by the arena.
+class PageArena {
+public:
+    static constexpr std::size_t HUGE_PAGE_SIZE = std::size_t(2) << 20;
+
+    PageArena(std::size_t num_frames, std::size_t frame_size);
+    ~PageArena();
+
+    PageArena(const PageArena&) = delete;
+    PageArena& operator=(const PageArena&) = delete;
+
+    uint8_t* getFrame(std::size_t idx) const { return base + idx * frame_size; }
+    std::size_t getNumFrames() const { return num_frames; }
+    std::size_t getSize() const { return size; }
+    // True when the mapping came from the reserved huge page pool; with
+    // transparent huge pages the kernel decides page by page
+    bool usesReservedHugePages() const { return reserved_huge_pages; }
+
+private:
+    uint8_t* base = nullptr;
+    std::size_t size = 0;
+    std::size_t num_frames;
+    std::size_t frame_size;
+    bool reserved_huge_pages = false;
+};
+
+#endif // PAGE_ARENA_H
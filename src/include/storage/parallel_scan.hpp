@@ -0,0 +1,89 @@
+#ifndef PARALLEL_SCAN_H
+#define PARALLEL_SCAN_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "heap_file.hpp"
+#include "heap_scanner.hpp"
+
+// Full-table scan of a HeapFile split across worker threads. The pages are
+// cut into morsels of consecutive pages and dealt out as one contiguous run
+// per worker; a worker that finishes its run steals morsels from the front
+// of the others' runs, so one slow range does not hold up the scan. Each
+// worker reads through its own HeapScanner and I/O backend, so read-ahead
+// and io_uring batches of different workers proceed in parallel, and keeps
+// its own partial result, merged once every worker is done.
+//
+//     ParallelScan scan(heap_file, 8);
+//     uint64_t bytes = scan.aggregate<uint64_t>(0,
+//         [](uint64_t& sum, const HeapScanner& scanner) { sum += scanner.getRecordSize(); },
+//         [](uint64_t& sum, const uint64_t& partial) { sum += partial; });
+//
+// The calling thread is worker 0; the others are started per run.
+class ParallelScan {
+public:
+    static constexpr std::size_t DEFAULT_MORSEL_PAGES = 512;
+
+    ParallelScan(HeapFile& heap_file, std::size_t num_threads, std::size_t morsel_pages = DEFAULT_MORSEL_PAGES,
+                 std::size_t readahead_pages = HeapScanner::DEFAULT_READAHEAD_PAGES);
+
+    ParallelScan(const ParallelScan&) = delete;
+    ParallelScan& operator=(const ParallelScan&) = delete;
+
+    // Call scan_morsel(worker, scanner) once per morsel, with the worker's
+    // scanner set to the morsel's pages; read them with next() or
+    // nextPage(). Returns once all morsels are done, rethrowing the first
+    // exception a worker raised (the other workers stop early).
+    void run(const std::function<void(std::size_t worker, HeapScanner& scanner)>& scan_morsel);
+
+    // Fold every live record into per-worker partials starting from
+    // identity with visit(partial, scanner), then merge(result, partial)
+    // them into a result that also starts from identity
+    template <typename Partial, typename Visit, typename Merge>
+    Partial aggregate(const Partial& identity, Visit visit, Merge merge) {
+        std::vector<PaddedPartial<Partial>> partials(num_threads, PaddedPartial<Partial>{identity});
+        run([&](std::size_t worker, HeapScanner& scanner) {
+            Partial& partial = partials[worker].value;
+            while (scanner.next()) {
+                visit(partial, static_cast<const HeapScanner&>(scanner));
+            }
+        });
+        Partial result = identity;
+        for (const auto& partial : partials) {
+            merge(result, partial.value);
+        }
+        return result;
+    }
+
+    std::size_t getNumThreads() const { return num_threads; }
+    std::size_t getNumMorsels() const { return num_morsels; }
+
+private:
+    // Kept on separate cache lines: each worker updates its own
+    template <typename Partial>
+    struct alignas(64) PaddedPartial {
+        Partial value;
+    };
+
+    // Morsels [next, end) left in a worker's run; the owner and thieves
+    // alike claim the next one with fetch_add
+    struct alignas(64) Run {
+        std::atomic<std::size_t> next{0};
+        std::size_t end = 0;
+    };
+
+    HeapFile& heap_file;
+    std::size_t num_threads;
+    std::size_t morsel_pages;
+    std::size_t readahead_pages;
+    std::size_t end_page = 0;
+    std::size_t num_morsels = 0;
+    std::vector<Run> runs;
+
+    void runWorker(std::size_t worker, const std::function<void(std::size_t, HeapScanner&)>& scan_morsel,
+                   std::atomic<bool>& failed);
+};
+
+#endif // PARALLEL_SCAN_H
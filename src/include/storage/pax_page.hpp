@@ -0,0 +1,81 @@
+#ifndef PAX_PAGE_H
+#define PAX_PAGE_H
+
+#include <cstdint>
+#include <vector>
+#include "slotted_page.hpp"
+
+// Column-wise (PAX) layout of a heap page holding records of one fixed-width
+// schema. Each field gets a minipage of its own, so a scan reads only the
+// columns it needs. Rows keep their slot for life; a presence bitmap marks
+// the live ones and freed rows are reused first.
+//
+//   PageHeader | PaxHeader | ColumnInfo[num_columns] | presence | minipage 0 | minipage 1 | ...
+//
+// Records passed in and out hold their fields back to back in column order.
+// PaxPage is a view over the bytes of a page of type PAX and owns nothing.
+class PaxPage {
+public:
+    static constexpr std::size_t MAX_COLUMNS = 64;
+    // Minipage starts are aligned for vector loads
+    static constexpr std::size_t MINIPAGE_ALIGNMENT = 8;
+
+    struct PaxHeader {
+        uint16_t num_columns;
+        uint16_t capacity;  // Rows that fit the page
+        uint16_t num_rows;  // Rows ever used; slots past it are free
+        uint16_t live_rows;
+    };
+
+    struct ColumnInfo {
+        uint16_t offset; // Start of the minipage within the page
+        uint16_t width;
+    };
+
+    explicit PaxPage(uint8_t* data) : data(data) {}
+
+    // Lay out an empty page after its PageHeader; throws
+    // std::invalid_argument for a schema that does not fit a page
+    static void format(uint8_t* data, const std::vector<uint16_t>& column_widths);
+    static uint16_t capacityFor(const std::vector<uint16_t>& column_widths);
+    static std::vector<uint16_t> readColumnWidths(const uint8_t* data);
+
+    // Schema as carried in log records: a uint16_t count, then the widths
+    static void encodeSchema(const std::vector<uint16_t>& column_widths, std::vector<uint8_t>& out);
+    static std::vector<uint16_t> decodeSchema(const uint8_t* payload, std::size_t size);
+
+    uint16_t addRow(const void* record);
+    void removeRow(uint16_t row);
+    // Copy up to size bytes of the record; returns the bytes copied
+    uint16_t readRow(uint16_t row, void* buffer, uint16_t size) const;
+
+    bool isLive(uint16_t row) const {
+        return row < header()->num_rows && (getPresence()[row / 8] >> (row % 8) & 1);
+    }
+    const uint8_t* getPresence() const { return data + presenceOffset(header()->num_columns); }
+    const uint8_t* getColumn(uint16_t column) const { return data + columns()[column].offset; }
+    uint16_t getColumnWidth(uint16_t column) const { return columns()[column].width; }
+
+    uint16_t getNumColumns() const { return header()->num_columns; }
+    uint16_t getCapacity() const { return header()->capacity; }
+    uint16_t getNumRows() const { return header()->num_rows; }
+    uint16_t getLiveRows() const { return header()->live_rows; }
+    uint16_t getFreeRows() const { return header()->capacity - header()->live_rows; }
+    uint16_t getRowSize() const;
+
+private:
+    uint8_t* data;
+
+    PaxHeader* header() { return reinterpret_cast<PaxHeader*>(data + sizeof(SlottedPage::PageHeader)); }
+    const PaxHeader* header() const {
+        return reinterpret_cast<const PaxHeader*>(data + sizeof(SlottedPage::PageHeader));
+    }
+    const ColumnInfo* columns() const { return reinterpret_cast<const ColumnInfo*>(header() + 1); }
+    uint8_t* presence() { return data + presenceOffset(header()->num_columns); }
+
+    static std::size_t presenceOffset(std::size_t num_columns);
+    // Bytes the layout needs for capacity rows, or 0 past the end of a page
+    static std::size_t layoutSize(const std::vector<uint16_t>& column_widths, std::size_t capacity);
+};
+
+#endif // PAX_PAGE_H
@@ -0,0 +1,70 @@
+#ifndef SCHEMA_H
+#define SCHEMA_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Column layout of a table's typed tuples (see TupleBuilder and TupleView).
+// A heap file created with a schema records it in its catalog page, so the
+// file describes its own records. Every column has a slot at a constant
+// offset in the tuple: fixed-width values are stored there, and a VARCHAR
+// slot holds the end offset of its bytes in the variable-length section.
+//
+//   null bitmap | slot 0 | slot 1 | ... | variable-length bytes
+class Schema {
+public:
+    // The numeric types match FilterKernels::ColumnType, so fixed columns
+    // can be handed to BatchScanner by offset
+    enum class Type : uint8_t { INT32, UINT32, INT64, FLOAT, DOUBLE, VARCHAR };
+
+    struct Column {
+        std::string name;
+        Type type;
+        bool nullable = false;
+
+        bool operator==(const Column& other) const {
+            return name == other.name && type == other.type && nullable == other.nullable;
+        }
+    };
+
+    static constexpr std::size_t MAX_COLUMNS = 256;
+    static constexpr std::size_t MAX_NAME_LENGTH = 255;
+
+    // An empty schema stands for untyped records
+    Schema() = default;
+    // Throws std::invalid_argument for unnamed, duplicate or too many columns
+    explicit Schema(std::vector<Column> columns);
+
+    bool empty() const { return columns.empty(); }
+    std::size_t getNumColumns() const { return columns.size(); }
+    const Column& getColumn(std::size_t column) const { return columns[column]; }
+    // Throws std::invalid_argument for an unknown name
+    std::size_t getColumnIndex(const std::string& name) const;
+
+    // Offset of the column's slot within every tuple
+    uint16_t getOffset(std::size_t column) const { return offsets[column]; }
+    uint16_t getNullBitmapSize() const { return static_cast<uint16_t>((columns.size() + 7) / 8); }
+    // Bytes before the variable-length section, the size of a tuple
+    // without strings
+    uint16_t getFixedSize() const { return fixed_size; }
+
+    // Slot width of a type; a VARCHAR slot is its uint16_t end offset
+    static uint16_t slotWidth(Type type);
+
+    // Catalog encoding: a format version, the column count, then per column
+    // the type, flags, name length and name
+    void encode(std::vector<uint8_t>& out) const;
+    // Throws std::runtime_error for malformed bytes
+    static Schema decode(const uint8_t* data, std::size_t size);
+
+    bool operator==(const Schema& other) const { return columns == other.columns; }
+    bool operator!=(const Schema& other) const { return !(*this == other); }
+
+private:
+    std::vector<Column> columns;
+    std::vector<uint16_t> offsets;
+    uint16_t fixed_size = 0;
+};
+
+#endif // SCHEMA_H
@@ -1,32 +1,61 @@
 #ifndef SLOTTED_PAGE_H
 #define SLOTTED_PAGE_H
 
+#include <atomic>
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <iostream>
+#include "io_backend.hpp"
 
-class SlottedPage {
+// Page size of this build, a power of two from 4 KiB to 64 KiB. Set it with
+// the TINYDB_PAGE_SIZE CMake option; files record the size they were
+// created with in every page header and refuse to open under another.
+#ifndef TINYDB_PAGE_SIZE
+#define TINYDB_PAGE_SIZE 4096
+#endif
+
+// Layout shared by every page size
+class SlottedPageBase {
 public:
-    static constexpr std::size_t PAGE_SIZE = 4096;
-    
+    static constexpr std::size_t MIN_PAGE_SIZE = 4096;
+    static constexpr std::size_t MAX_PAGE_SIZE = 65536;
+    static constexpr uint32_t NO_PAGE = UINT32_MAX;
+
     enum class PageType : uint8_t {
         ROOT,
         INTERNAL,
-        LEAF
+        LEAF,
+        OVERFLOW, // Raw bytes of a large record after the header; no cells
+        PAX, // Fixed-width rows stored column-wise, see PaxPage
+        CATALOG, // Page 0 of a typed heap file; cell 0 holds its Schema
+        ENCODED // Sealed PAX rows with encoded columns, see EncodedPage
     };
 
     struct PageHeader {
         uint32_t id;
         PageType type;
+        uint8_t flags;
         uint16_t free_start;
         uint16_t free_end;
         uint16_t total_free;
-        uint8_t flags;
+        uint32_t version; // Optimistic latch word, see getVersion()
+        uint64_t lsn; // LSN of the last logged change applied to this page
+        uint32_t page_size; // Size the file was created with
+        uint32_t next_page; // Next page of an overflow chain, NO_PAGE at its end
     };
 
+    // Cell sizes are 15 bits; the top bit marks the cell as the stub of a
+    // record stored out of line in overflow pages
+    static constexpr uint16_t OVERFLOW_CELL = 0x8000;
+    static constexpr uint16_t MAX_CELL_SIZE = OVERFLOW_CELL - 1;
+
     struct CellPointer {
         uint16_t cell_location;
-        uint16_t cell_size;
+        uint16_t cell_size; // Including the OVERFLOW_CELL bit
+
+        uint16_t size() const { return cell_size & MAX_CELL_SIZE; }
+        bool isOverflow() const { return (cell_size & OVERFLOW_CELL) != 0; }
     };
 
     struct PointerList {
@@ -35,58 +64,117 @@ public:
     };
 
     static constexpr uint8_t CAN_COMPACT = 0x1;
+    static constexpr uint8_t HAS_FREE_SLOT = 0x2; // Some pointer is a tombstone
+
+    // Page size recorded in the first page of a file, 0 for an empty file
+    static std::size_t readPageSize(int fd);
+};
+
+// Slotted page of PageSize bytes. Offsets stay 16-bit: the last byte of a
+// page is never used, so every offset fits even in a 64 KiB page.
+//
+// A page either owns its buffer or is a view over memory owned elsewhere,
+// such as a buffer pool frame; the view does not initialise the bytes.
+template <std::size_t PageSize>
+class BasicSlottedPage : public SlottedPageBase {
+public:
+    static_assert(PageSize >= MIN_PAGE_SIZE && PageSize <= MAX_PAGE_SIZE && (PageSize & (PageSize - 1)) == 0,
+                  "page size must be a power of two between 4 KiB and 64 KiB");
+
+    static constexpr std::size_t PAGE_SIZE = PageSize;
+
+    // Owning page, initialised empty
+    BasicSlottedPage(PageType type, uint32_t id);
+    // View over PAGE_SIZE bytes at data (nullptr for an unbound view); the
+    // memory must outlive it
+    explicit BasicSlottedPage(uint8_t* data) : page_data(data) {}
 
-    // Constructor
-    SlottedPage(PageType type, uint32_t id);
-    
-    
     // Delete copy operations
-    SlottedPage(const SlottedPage&) = delete;
-    SlottedPage& operator=(const SlottedPage&) = delete;
+    BasicSlottedPage(const BasicSlottedPage&) = delete;
+    BasicSlottedPage& operator=(const BasicSlottedPage&) = delete;
     
     // Allow move operations
-    SlottedPage(SlottedPage&& other) noexcept = default;
-    SlottedPage& operator=(SlottedPage&& other) noexcept = default;
+    BasicSlottedPage(BasicSlottedPage&& other) noexcept = default;
+    BasicSlottedPage& operator=(BasicSlottedPage&& other) noexcept = default;
+
+    // Reinitialise as an empty page without reallocating
+    void reset(PageType type, uint32_t id);
 
-    // Core operations
-    uint16_t addCell(const void* cell, uint16_t cell_size);
+    // Core operations. addCell reuses the slot of a removed cell when there
+    // is one, so it only needs room for a new pointer otherwise.
+    uint16_t addCell(const void* cell, uint16_t cell_size, bool is_overflow = false);
     void removeCell(uint16_t idx);
     void* getCell(uint16_t idx);
+    // Slide live cells together at the end of the page. Slot numbers are
+    // kept, except that tombstones at the end of the pointer array are dropped.
     void compact();
+    // Bytes held by removed cells that only compact() can reclaim
+    uint16_t getFragmentedBytes();
+
+    // Ordered variants for pages whose pointer array is kept sorted: insert
+    // shifts later pointers up one slot, erase shifts them down
+    void insertCell(uint16_t idx, const void* cell, uint16_t cell_size);
+    void eraseCell(uint16_t idx);
     
     // I/O operations
     void savePage(int fd) const;
-    static std::unique_ptr<SlottedPage> loadPage(int fd, uint32_t page_id);
+    static std::unique_ptr<BasicSlottedPage> loadPage(int fd, uint32_t page_id);
+    // Throw if a non-empty file was created with a different page size
+    static void checkPageSize(int fd, const std::string& filename);
     
     // Utility methods
     PointerList getPointerList();
     const PageHeader& getHeader() const { return *header(); }
-    uint8_t* getData() { return page_data.get(); }
-    const uint8_t* getData() const { return page_data.get();
-}
+    void setLsn(uint64_t lsn) { header()->lsn = lsn; }
+    void setId(uint32_t id) { header()->id = id; }
+    void setNextPage(uint32_t page_id) { header()->next_page = page_id; }
+    // Version counter for optimistic lock coupling: odd while a writer holds
+    // the page, advanced on every unlock. reset() leaves it untouched.
+    std::atomic<uint32_t>& getVersion() {
+        static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "version must overlay the header");
+        return *reinterpret_cast<std::atomic<uint32_t>*>(&header()->version);
+    }
+    uint8_t* getData() { return page_data; }
+    const uint8_t* getData() const { return page_data; }
 
 private:
-    std::unique_ptr<uint8_t[]> page_data;
+    AlignedBuffer owned_data; // Empty for a view; aligned for O_DIRECT
+    uint8_t* page_data;
 
     // Helper methods
-    PageHeader* header() { return reinterpret_cast<PageHeader*>(page_data.get()); }
-    const PageHeader* header() const { return reinterpret_cast<const PageHeader*>(page_data.get()); }
+    PageHeader* header() { return reinterpret_cast<PageHeader*>(page_data); }
+    const PageHeader* header() const { return reinterpret_cast<const PageHeader*>(page_data); }
     
-    static uint16_t cellPointerOffsetToIdx(uint16_t offset) {
+    static constexpr uint16_t cellPointerOffsetToIdx(uint16_t offset) {
         return (offset - sizeof(PageHeader)) / sizeof(CellPointer);
     }
     
-    static uint16_t cellPointerIdxToOffset(uint16_t idx) {
+    static constexpr uint16_t cellPointerIdxToOffset(uint16_t idx) {
         return idx * sizeof(CellPointer) + sizeof(PageHeader);
     }
+
+    uint16_t appendCell(const void* cell, uint16_t cell_size, uint16_t cell_flags);
 };
 
+// Explicitly instantiated in slotted_page.cpp for each supported size
+extern template class BasicSlottedPage<4096>;
+extern template class BasicSlottedPage<8192>;
+extern template class BasicSlottedPage<16384>;
+extern template class BasicSlottedPage<32768>;
+extern template class BasicSlottedPage<65536>;
+
+using SlottedPage = BasicSlottedPage<TINYDB_PAGE_SIZE>;
+
 // Output operator for PageType
 inline std::ostream& operator<<(std::ostream& os, const SlottedPage::PageType& type) {
     switch (type) {
         case SlottedPage::PageType::LEAF: os << "LEAF"; break;
         case SlottedPage::PageType::INTERNAL: os << "INTERNAL"; break;
         case SlottedPage::PageType::ROOT: os << "ROOT"; break;
+        case SlottedPage::PageType::OVERFLOW: os << "OVERFLOW"; break;
+        case SlottedPage::PageType::PAX: os << "PAX"; break;
+        case SlottedPage::PageType::CATALOG: os << "CATALOG"; break;
+        case SlottedPage::PageType::ENCODED: os << "ENCODED"; break;
         default: os << "UNKNOWN"; break;
     }
     return os;
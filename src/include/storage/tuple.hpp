@@ -0,0 +1,83 @@
+#ifndef TUPLE_H
+#define TUPLE_H
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "schema.hpp"
+
+// Encodes one tuple of a schema. Columns start unset; build() throws unless
+// every column not nullable has been given a value, and unset nullable
+// columns are NULL. The builder can be reused: clear() keeps its buffers.
+//
+//     TupleBuilder builder(schema);
+//     builder.setUInt32(0, 1).setString(1, "Toy Story").setFloat(2, 0.92f);
+//     const auto& tuple = builder.build();
+//     heap_file.insertRecord(tuple.data(), tuple.size());
+class TupleBuilder {
+public:
+    explicit TupleBuilder(const Schema& schema);
+
+    // Setters throw std::invalid_argument if the column has another type
+    TupleBuilder& setInt32(std::size_t column, int32_t value);
+    TupleBuilder& setUInt32(std::size_t column, uint32_t value);
+    TupleBuilder& setInt64(std::size_t column, int64_t value);
+    TupleBuilder& setFloat(std::size_t column, float value);
+    TupleBuilder& setDouble(std::size_t column, double value);
+    TupleBuilder& setString(std::size_t column, std::string_view value);
+    // Throws std::invalid_argument unless the column is nullable
+    TupleBuilder& setNull(std::size_t column);
+
+    // The encoded tuple, valid until the builder is next changed. Throws
+    // std::invalid_argument for an unset column that is not nullable, and
+    // std::length_error past 64 KiB, the reach of the uint16_t offsets.
+    // Larger tuples are stored as large records like any other.
+    const std::vector<uint8_t>& build();
+    void clear();
+
+private:
+    const Schema& schema;
+    std::vector<uint8_t> fixed;        // Null bitmap and slots
+    std::vector<std::string> strings;  // Value of each VARCHAR column
+    std::vector<bool> assigned;
+    std::vector<uint8_t> tuple;
+
+    void setFixed(std::size_t column, Schema::Type type, const void* value);
+    void markNull(std::size_t column, bool is_null);
+};
+
+// Read access to an encoded tuple; a view over bytes it does not own. The
+// tuple's size follows from its own offsets, so only the start is needed.
+class TupleView {
+public:
+    TupleView(const Schema& schema, const void* data)
+        : schema(schema), data(static_cast<const uint8_t*>(data)) {}
+
+    bool isNull(std::size_t column) const { return data[column / 8] >> (column % 8) & 1; }
+
+    // Getters throw std::invalid_argument if the column has another type;
+    // a NULL reads as zero or as an empty string
+    int32_t getInt32(std::size_t column) const;
+    uint32_t getUInt32(std::size_t column) const;
+    int64_t getInt64(std::size_t column) const;
+    float getFloat(std::size_t column) const;
+    double getDouble(std::size_t column) const;
+    std::string_view getString(std::size_t column) const;
+
+    uint16_t size() const;
+
+    // True if size bytes hold exactly one well-formed tuple of the schema
+    static bool isValid(const Schema& schema, const void* data, std::size_t size);
+
+private:
+    const Schema& schema;
+    const uint8_t* data;
+
+    template <typename T>
+    T getFixed(std::size_t column, Schema::Type type) const;
+    uint16_t varEnd(std::size_t column) const;
+    uint16_t varStart(std::size_t column) const;
+};
+
+#endif // TUPLE_H
@@ -1,16 +1,25 @@
 #include <iostream>
 #include "storage/heap_file.hpp"
+#include "storage/b_plus_tree.hpp"
+#include "storage/tuple.hpp"
 
 struct Movie {
     uint32_t id;
-    char title[100];
+    const char* title;
     float rating;
     uint32_t release;
 };
 
 int main() {
     try {
-        HeapFile heap_file("movies.db");
+        // Movies are typed tuples; the file keeps the schema in its catalog
+        HeapFileOptions options;
+        options.schema = Schema({{"id", Schema::Type::UINT32},
+                                 {"title", Schema::Type::VARCHAR},
+                                 {"rating", Schema::Type::FLOAT},
+                                 {"release", Schema::Type::UINT32}});
+        HeapFile heap_file("movies.db", options);
+        const Schema& schema = heap_file.getSchema();
 
         // Insert some movies
         Movie movies[] = {
@@ -25,12 +34,29 @@ int main() {
         std::vector<std::pair<uint32_t, uint16_t>> locations;
 
         // Insert movies
+        TupleBuilder builder(schema);
         for (const auto& movie : movies) {
-            uint32_t page_id = heap_file.insertRecord(&movie, sizeof(Movie));
+            builder.setUInt32(0, movie.id).setString(1, movie.title).setFloat(2, movie.rating)
+                .setUInt32(3, movie.release);
+            const auto& tuple = builder.build();
+            auto rid = heap_file.insertRecord(tuple.data(), static_cast<uint16_t>(tuple.size()));
+            locations.emplace_back(rid.page_id, rid.slot_id);
             std::cout << "Inserted movie " << movie.title 
-                     << " on page " << page_id << "\n";
+                     << " on page " << rid.page_id << " slot " << rid.slot_id << "\n";
         }
 
+        // Index the movies by id and look one up
+        BPlusTree id_index("movies_id.idx", [&schema](const void* record, uint16_t) -> BPlusTree::Key {
+            return TupleView(schema, record).getUInt32(0);
+        });
+        id_index.build(heap_file);
+        for (const auto& rid : id_index.find(3)) {
+            uint8_t tuple[HeapFile::MAX_RECORD_SIZE];
+            heap_file.readRecord(rid.page_id, rid.slot_id, tuple, sizeof(tuple));
+            std::cout << "Index lookup id=3: " << TupleView(schema, tuple).getString(1) << "\n";
+        }
+        id_index.close();
+
         // Print free space map state
         std::cout << "\nFree Space Map after insertions:\n";
         heap_file.printFreeSpaceMap();
@@ -41,6 +67,8 @@ int main() {
         // Close the file
         heap_file.close();
 
+        std::cout << "\nStorage metrics:\n" << Metrics::snapshot().toJson() << "\n";
+
     } catch (const std::exception& e) {
         std::cerr << "Error: " << e.what() << std::endl;
         return 1;
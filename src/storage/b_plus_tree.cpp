@@ -0,0 +1,492 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include "storage/b_plus_tree.hpp"
+#include "storage/heap_scanner.hpp"
+
+BPlusTree::BPlusTree(const std::string& fname, KeyExtractor extractor, std::size_t buffer_pool_mb)
+    : filename(fname), key_extractor(std::move(extractor)) {
+    file_descriptor = open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+    if (file_descriptor == -1) {
+        throw std::runtime_error("Failed to open index file: " + filename);
+    }
+    try {
+        SlottedPage::checkPageSize(file_descriptor, filename);
+    } catch (...) {
+        ::close(file_descriptor);
+        throw;
+    }
+
+    buffer_pool = std::make_unique<BufferPool>(file_descriptor, buffer_pool_mb);
+    off_t file_size = lseek(file_descriptor, 0, SEEK_END);
+    num_pages = file_size / SlottedPage::PAGE_SIZE;
+
+    if (num_pages == 0) {
+        // An empty tree is a root that is also a leaf
+        allocatePage(SlottedPage::PageType::ROOT, {NO_PAGE, 0, {}});
+    }
+    root = BufferPool::PageGuard(*buffer_pool, ROOT_PAGE_ID);
+}
+
+void BPlusTree::insert(Key key, RecordId rid) {
+    std::shared_lock<std::shared_mutex> lock(checkpoint_latch);
+
+    Entry entry = makeEntry(key, rid);
+    while (!tryInsert(entry)) {
+        std::this_thread::yield();
+    }
+}
+
+bool BPlusTree::remove(Key key, RecordId rid) {
+    std::shared_lock<std::shared_mutex> lock(checkpoint_latch);
+
+    Entry target = makeEntry(key, rid);
+    while (true) {
+        BufferPool::PageGuard leaf;
+        uint32_t version;
+        if (descend(target, leaf, version)) {
+            uint16_t idx = lowerBound(*leaf, target);
+            bool found = idx <= numEntries(*leaf) && !less(target, entryAt(*leaf, idx));
+            if (!found && validate(*leaf, version)) {
+                return false;
+            }
+            if (found && upgradeLock(*leaf, version)) {
+                leaf->eraseCell(idx);
+                leaf.markDirty();
+                writeUnlock(*leaf);
+                return true;
+            }
+        }
+        std::this_thread::yield();
+    }
+}
+
+std::vector<BPlusTree::RecordId> BPlusTree::find(Key key) {
+    std::vector<RecordId> rids;
+    scan(key, key, [&rids](Key, RecordId rid) {
+        rids.push_back(rid);
+        return true;
+    });
+    return rids;
+}
+
+void BPlusTree::scan(Key low, Key high, const std::function<bool(Key, RecordId)>& visitor) {
+    Entry target = makeEntry(low, {0, 0});
+    std::vector<Entry> batch;
+
+    while (true) {
+        BufferPool::PageGuard leaf;
+        uint32_t version;
+        if (!descend(target, leaf, version)) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Walk the leaf chain, coupling each leaf to the next by validating
+        // it after the sibling is locked; on failure re-descend to target
+        while (true) {
+            batch.clear();
+            bool done = false;
+            uint16_t count = numEntries(*leaf);
+            for (uint16_t idx = lowerBound(*leaf, target); idx <= count; idx++) {
+                Entry entry = entryAt(*leaf, idx);
+                if (entry.key > high) {
+                    done = true;
+                    break;
+                }
+                batch.push_back(entry);
+            }
+            uint32_t next = readNodeHeader(*leaf).link;
+            if (!validate(*leaf, version)) {
+                break;
+            }
+
+            for (const auto& entry : batch) {
+                if (!visitor(entry.key, {entry.page_id, entry.slot_id})) {
+                    return;
+                }
+            }
+            if (!batch.empty()) {
+                target = batch.back();
+                done = done || !successor(target);
+            }
+            if (done || next == NO_PAGE) {
+                return;
+            }
+
+            BufferPool::PageGuard next_leaf(*buffer_pool, next);
+            uint32_t next_version;
+            if (!readLock(*next_leaf, next_version) || !validate(*leaf, version)) {
+                break;
+            }
+            leaf = std::move(next_leaf);
+            version = next_version;
+        }
+    }
+}
+
+void BPlusTree::build(HeapFile& heap_file) {
+    HeapScanner scanner(heap_file);
+    while (scanner.next()) {
+        insertRecord(scanner.getRecord(), scanner.getRecordSize(), scanner.getRecordId());
+    }
+}
+
+void BPlusTree::sync() {
+    std::unique_lock<std::shared_mutex> lock(checkpoint_latch);
+    buffer_pool->flushAllPages();
+    if (fdatasync(file_descriptor) == -1) {
+        throw std::runtime_error("Failed to sync index file: " + filename);
+    }
+}
+
+void BPlusTree::close() {
+    sync();
+    root.release();
+    ::close(file_descriptor);
+}
+
+std::size_t BPlusTree::getHeight() {
+    while (true) {
+        uint32_t version;
+        if (readLock(*root, version)) {
+            std::size_t height = readNodeHeader(*root).level + 1;
+            if (validate(*root, version)) {
+                return height;
+            }
+        }
+        std::this_thread::yield();
+    }
+}
+
+bool BPlusTree::readLock(SlottedPage& page, uint32_t& version) {
+    version = page.getVersion().load(std::memory_order_acquire);
+    return (version & 1) == 0;
+}
+
+bool BPlusTree::validate(SlottedPage& page, uint32_t version) {
+    // Order the preceding plain reads of the page before the re-check
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return page.getVersion().load(std::memory_order_relaxed) == version;
+}
+
+bool BPlusTree::upgradeLock(SlottedPage& page, uint32_t version) {
+    return page.getVersion().compare_exchange_strong(version, version + 1, std::memory_order_acquire);
+}
+
+void BPlusTree::writeUnlock(SlottedPage& page) {
+    page.getVersion().fetch_add(1, std::memory_order_release);
+}
+
+BPlusTree::Entry BPlusTree::makeEntry(Key key, RecordId rid) {
+    return {key, rid.page_id, rid.slot_id, 0};
+}
+
+bool BPlusTree::less(const Entry& a, const Entry& b) {
+    if (a.key != b.key) {
+        return a.key < b.key;
+    }
+    if (a.page_id != b.page_id) {
+        return a.page_id < b.page_id;
+    }
+    return a.slot_id < b.slot_id;
+}
+
+bool BPlusTree::successor(Entry& entry) {
+    // Smallest entry greater than entry; false if it is the largest possible
+    if (entry.slot_id != UINT16_MAX) {
+        entry.slot_id++;
+    } else if (entry.page_id != UINT32_MAX) {
+        entry.page_id++;
+        entry.slot_id = 0;
+    } else if (entry.key != UINT64_MAX) {
+        entry.key++;
+        entry.page_id = 0;
+        entry.slot_id = 0;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const uint8_t* BPlusTree::cellData(SlottedPage& page, uint16_t idx, std::size_t size) {
+    // A torn cell pointer is clamped so the read stays inside the page
+    const auto* pointers = reinterpret_cast<const SlottedPage::CellPointer*>(
+        page.getData() + sizeof(SlottedPage::PageHeader));
+    std::size_t location = std::min<std::size_t>(pointers[idx].cell_location, SlottedPage::PAGE_SIZE - size);
+    return page.getData() + location;
+}
+
+BPlusTree::NodeHeader BPlusTree::readNodeHeader(SlottedPage& page) {
+    NodeHeader header;
+    std::memcpy(&header, cellData(page, 0, sizeof(NodeHeader)), sizeof(NodeHeader));
+    return header;
+}
+
+uint16_t BPlusTree::numEntries(SlottedPage& page) {
+    constexpr std::size_t max_cells = (SlottedPage::PAGE_SIZE - sizeof(SlottedPage::PageHeader)) /
+                                      sizeof(SlottedPage::CellPointer);
+    std::size_t cells = page.getPointerList().size;
+    return static_cast<uint16_t>(cells == 0 || cells > max_cells ? 0 : cells - 1);
+}
+
+BPlusTree::Entry BPlusTree::entryAt(SlottedPage& page, uint16_t idx) {
+    // Cells are not aligned, so copy rather than cast
+    Entry entry;
+    std::memcpy(&entry, cellData(page, idx, sizeof(Entry)), sizeof(Entry));
+    return entry;
+}
+
+uint16_t BPlusTree::lowerBound(SlottedPage& page, const Entry& target) {
+    // First entry >= target; entries occupy cells 1..numEntries
+    uint16_t low = 1;
+    uint16_t high = numEntries(page) + 1;
+    while (low < high) {
+        uint16_t mid = low + (high - low) / 2;
+        if (less(entryAt(page, mid), target)) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+uint32_t BPlusTree::findChild(SlottedPage& page, const Entry& target) {
+    // Last separator <= target, or the leftmost child if there is none
+    uint16_t low = 1;
+    uint16_t high = numEntries(page) + 1;
+    while (low < high) {
+        uint16_t mid = low + (high - low) / 2;
+        if (less(target, entryAt(page, mid))) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+
+    if (low == 1) {
+        return readNodeHeader(page).link;
+    }
+    uint32_t child;
+    std::memcpy(&child, cellData(page, low - 1, sizeof(InternalEntry)) + offsetof(InternalEntry, child),
+                sizeof(child));
+    return child;
+}
+
+uint16_t BPlusTree::cellSize(uint8_t level) {
+    return level == 0 ? sizeof(Entry) : sizeof(InternalEntry);
+}
+
+bool BPlusTree::isFull(SlottedPage& page, uint8_t level) {
+    // A leaf with deleted entries can still make room by compacting
+    const auto& header = page.getHeader();
+    return header.total_free < cellSize(level) + sizeof(SlottedPage::CellPointer) &&
+           (level > 0 || !(header.flags & SlottedPage::CAN_COMPACT));
+}
+
+bool BPlusTree::descend(const Entry& target, BufferPool::PageGuard& leaf, uint32_t& version) {
+    SlottedPage* node = root.get();
+    if (!readLock(*node, version)) {
+        return false;
+    }
+
+    while (readNodeHeader(*node).level != 0) {
+        // The child pointer is only trusted once the parent is validated,
+        // and the parent is validated again once the child's version is
+        // known so a concurrent split of the child cannot be missed
+        uint32_t child = findChild(*node, target);
+        if (!validate(*node, version)) {
+            return false;
+        }
+        BufferPool::PageGuard child_guard(*buffer_pool, child);
+        uint32_t child_version;
+        if (!readLock(*child_guard, child_version) || !validate(*node, version)) {
+            return false;
+        }
+        leaf = std::move(child_guard);
+        node = leaf.get();
+        version = child_version;
+    }
+
+    if (leaf.get() == nullptr) {
+        leaf = BufferPool::PageGuard(*buffer_pool, ROOT_PAGE_ID);
+    }
+    return true;
+}
+
+bool BPlusTree::tryInsert(const Entry& entry) {
+    BufferPool::PageGuard parent;
+    uint32_t parent_version = 0;
+    BufferPool::PageGuard node(*buffer_pool, ROOT_PAGE_ID);
+    uint32_t version;
+    if (!readLock(*node, version)) {
+        return false;
+    }
+
+    while (true) {
+        NodeHeader header = readNodeHeader(*node);
+        if (isFull(*node, header.level)) {
+            // Split eagerly, so the parent of any node being split always
+            // has room for the new separator
+            if (parent.get() != nullptr && !upgradeLock(*parent, parent_version)) {
+                return false;
+            }
+            if (!upgradeLock(*node, version)) {
+                if (parent.get() != nullptr) {
+                    writeUnlock(*parent);
+                }
+                return false;
+            }
+
+            if (node.getPageId() == ROOT_PAGE_ID) {
+                splitRoot(*node);
+            } else {
+                Split split = splitNode(*node);
+                InternalEntry cell = {split.separator, split.right_page, 0};
+                insertCell(*parent, lowerBound(*parent, split.separator), &cell, sizeof(InternalEntry));
+                parent.markDirty();
+                writeUnlock(*parent);
+            }
+            node.markDirty();
+            writeUnlock(*node);
+            return false;
+        }
+
+        if (header.level == 0) {
+            break;
+        }
+
+        uint32_t child = findChild(*node, entry);
+        if (!validate(*node, version)) {
+            return false;
+        }
+        BufferPool::PageGuard child_guard(*buffer_pool, child);
+        uint32_t child_version;
+        if (!readLock(*child_guard, child_version) || !validate(*node, version)) {
+            return false;
+        }
+        parent = std::move(node);
+        parent_version = version;
+        node = std::move(child_guard);
+        version = child_version;
+    }
+
+    uint16_t idx = lowerBound(*node, entry);
+    bool exists = idx <= numEntries(*node) && !less(entry, entryAt(*node, idx));
+    if (!upgradeLock(*node, version)) {
+        return false;
+    }
+    if (exists) {
+        writeUnlock(*node);
+        return true; // Already indexed
+    }
+
+    // Fails only if compacting did not free enough room; the retry splits
+    bool inserted = insertCell(*node, idx, &entry, sizeof(Entry));
+    node.markDirty();
+    writeUnlock(*node);
+    return inserted;
+}
+
+uint32_t BPlusTree::allocatePage(SlottedPage::PageType type, NodeHeader node) {
+    uint32_t page_id = static_cast<uint32_t>(num_pages++);
+    SlottedPage* page = buffer_pool->newPage(page_id, type);
+    page->addCell(&node, sizeof(NodeHeader));
+    buffer_pool->unpinPage(page_id, true);
+    return page_id;
+}
+
+bool BPlusTree::insertCell(SlottedPage& page, uint16_t idx, const void* cell, uint16_t cell_size) {
+    std::size_t required = cell_size + sizeof(SlottedPage::CellPointer);
+    if (page.getHeader().total_free < required) {
+        // Space left by deletes is only reusable once compacted
+        page.compact();
+        if (page.getHeader().total_free < required) {
+            return false;
+        }
+    }
+    page.insertCell(idx, cell, cell_size);
+    return true;
+}
+
+BPlusTree::Split BPlusTree::splitNode(SlottedPage& page) {
+    NodeHeader header = readNodeHeader(page);
+    uint16_t size = cellSize(header.level);
+    uint16_t count = numEntries(page);
+
+    std::vector<uint8_t> cells(count * size);
+    for (uint16_t i = 0; i < count; i++) {
+        std::memcpy(cells.data() + i * size, page.getCell(i + 1), size);
+    }
+
+    // Leaves copy the first right entry up as the separator; internal nodes
+    // move the middle separator up and its child becomes the right node's
+    // leftmost child
+    uint16_t mid = count / 2;
+    uint16_t right_first = mid;
+    NodeHeader right_header = {header.link, header.level, {}};
+    Split split;
+    if (header.level == 0) {
+        std::memcpy(&split.separator, cells.data() + mid * size, sizeof(Entry));
+    } else {
+        InternalEntry middle;
+        std::memcpy(&middle, cells.data() + mid * size, sizeof(InternalEntry));
+        split.separator = middle.separator;
+        right_header.link = middle.child;
+        right_first = mid + 1;
+    }
+
+    // The new node is unreachable until the parent is updated, so it can
+    // be filled without locking
+    auto type = header.level == 0 ? SlottedPage::PageType::LEAF : SlottedPage::PageType::INTERNAL;
+    split.right_page = allocatePage(type, right_header);
+    {
+        BufferPool::PageGuard right(*buffer_pool, split.right_page);
+        for (uint16_t i = right_first; i < count; i++) {
+            right->addCell(cells.data() + i * size, size);
+        }
+        right.markDirty();
+    }
+
+    // Rebuild the left half in place, keeping the page's id and type
+    if (header.level == 0) {
+        header.link = split.right_page;
+    }
+    page.reset(page.getHeader().type, page.getHeader().id);
+    page.addCell(&header, sizeof(NodeHeader));
+    for (uint16_t i = 0; i < mid; i++) {
+        page.addCell(cells.data() + i * size, size);
+    }
+    return split;
+}
+
+void BPlusTree::splitRoot(SlottedPage& root_page) {
+    NodeHeader header = readNodeHeader(root_page);
+    uint16_t size = cellSize(header.level);
+
+    // Move the root's contents into a new child and split that instead
+    auto type = header.level == 0 ? SlottedPage::PageType::LEAF : SlottedPage::PageType::INTERNAL;
+    uint32_t left_page = allocatePage(type, header);
+    Split split;
+    {
+        BufferPool::PageGuard left(*buffer_pool, left_page);
+        uint16_t count = numEntries(root_page);
+        for (uint16_t i = 1; i <= count; i++) {
+            left->addCell(root_page.getCell(i), size);
+        }
+        split = splitNode(*left);
+        left.markDirty();
+    }
+
+    NodeHeader root_header = {left_page, static_cast<uint8_t>(header.level + 1), {}};
+    InternalEntry cell = {split.separator, split.right_page, 0};
+    root_page.reset(SlottedPage::PageType::ROOT, ROOT_PAGE_ID);
+    root_page.addCell(&root_header, sizeof(NodeHeader));
+    root_page.addCell(&cell, sizeof(InternalEntry));
+}
@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include "storage/batch_scanner.hpp"
+#include "storage/encoded_page.hpp"
+#include "storage/pax_page.hpp"
+
+namespace {
+
+// Upper bound on the cells of a slotted page
+constexpr std::size_t MAX_SLOTS =
+    (SlottedPage::PAGE_SIZE - sizeof(SlottedPage::PageHeader)) / sizeof(SlottedPage::CellPointer);
+
+} // namespace
+
+BatchScanner::BatchScanner(HeapFile& heap_file, std::vector<Field> fields, std::size_t readahead_pages)
+    : heap_file(heap_file),
+      fields(std::move(fields)),
+      end_page(heap_file.getNumPages()),
+      column_data(this->fields.size()) {
+    for (const Field& field : this->fields) {
+        record_size = std::max(record_size, field.offset + FilterKernels::typeWidth(field.type));
+    }
+
+    if (heap_file.isPax()) {
+        // A field must be exactly one column: records are the columns back to back
+        const auto& widths = heap_file.getColumnWidths();
+        for (const Field& field : this->fields) {
+            std::size_t offset = 0;
+            uint16_t column = 0;
+            while (column < widths.size() && offset < field.offset) {
+                offset += widths[column++];
+            }
+            if (column == widths.size() || offset != field.offset ||
+                widths[column] != FilterKernels::typeWidth(field.type)) {
+                throw std::invalid_argument("No PAX column of the field's width at offset " +
+                                            std::to_string(field.offset));
+            }
+            pax_columns.push_back(column);
+        }
+    } else {
+        for (std::size_t i = 0; i < this->fields.size(); i++) {
+            gathered.push_back(std::make_unique<uint64_t[]>(MAX_SLOTS));
+        }
+        slots.reserve(MAX_SLOTS);
+    }
+
+    if (heap_file.mapping == nullptr) {
+        scanner = std::make_unique<HeapScanner>(heap_file, readahead_pages);
+    }
+}
+
+const uint8_t* BatchScanner::nextPage() {
+    if (scanner) {
+        const uint8_t* page = scanner->nextPage();
+        page_id = scanner->getPageId();
+        return page;
+    }
+    if (next_mapped_page >= end_page) {
+        return nullptr;
+    }
+    page_id = next_mapped_page++;
+    return heap_file.getMappedPage(page_id);
+}
+
+bool BatchScanner::next() {
+    while (const uint8_t* page = nextPage()) {
+        const auto* header = reinterpret_cast<const SlottedPage::PageHeader*>(page);
+        encoded_page = nullptr;
+        if (header->type == SlottedPage::PageType::PAX) {
+            num_rows = loadPax(page);
+        } else if (header->type == SlottedPage::PageType::ENCODED) {
+            num_rows = loadEncoded(page);
+        } else if (header->type == SlottedPage::PageType::LEAF &&
+                   header->free_start >= sizeof(SlottedPage::PageHeader)) {
+            num_rows = gatherSlotted(page);
+        } else {
+            num_rows = 0;
+        }
+        if (num_rows > 0) {
+            return true;
+        }
+    }
+
+    num_rows = 0;
+    return false;
+}
+
+std::size_t BatchScanner::gatherSlotted(const uint8_t* page) {
+    const auto* header = reinterpret_cast<const SlottedPage::PageHeader*>(page);
+    std::size_t num_slots = (header->free_start - sizeof(SlottedPage::PageHeader)) / sizeof(SlottedPage::CellPointer);
+    const auto* pointers = reinterpret_cast<const SlottedPage::CellPointer*>(page + sizeof(SlottedPage::PageHeader));
+
+    slots.clear();
+    for (std::size_t slot = 0; slot < num_slots; slot++) {
+        const SlottedPage::CellPointer& pointer = pointers[slot];
+        if (pointer.cell_location == 0 || pointer.isOverflow()) {
+            continue;
+        }
+        if (pointer.size() < record_size) {
+            throw std::runtime_error("Record " + std::to_string(page_id) + ":" + std::to_string(slot) +
+                                     " is too short for the scanned fields");
+        }
+
+        const uint8_t* record = page + pointer.cell_location;
+        std::size_t row = slots.size();
+        for (std::size_t i = 0; i < fields.size(); i++) {
+            std::size_t width = FilterKernels::typeWidth(fields[i].type);
+            std::memcpy(reinterpret_cast<uint8_t*>(gathered[i].get()) + row * width, record + fields[i].offset, width);
+        }
+        slots.push_back(static_cast<uint16_t>(slot));
+    }
+
+    std::size_t rows = slots.size();
+    for (std::size_t i = 0; i < fields.size(); i++) {
+        column_data[i] = gathered[i].get();
+    }
+    // Every gathered row is live
+    live.assign(FilterKernels::selectionWords(rows), ~uint64_t{0});
+    if (rows % 64 != 0) {
+        live.back() = (uint64_t{1} << (rows % 64)) - 1;
+    }
+    return rows;
+}
+
+std::size_t BatchScanner::loadPax(const uint8_t* page) {
+    PaxPage pax(const_cast<uint8_t*>(page));
+    std::size_t rows = pax.getNumRows();
+    if (pax.getLiveRows() == 0) {
+        return 0;
+    }
+
+    slots.clear();
+    for (std::size_t i = 0; i < fields.size(); i++) {
+        column_data[i] = pax.getColumn(pax_columns[i]);
+    }
+    // Widen the presence bitmap to whole words; bits past num_rows are clear
+    live.assign(FilterKernels::selectionWords(rows), 0);
+    std::memcpy(live.data(), pax.getPresence(), (rows + 7) / 8);
+    if (rows % 8 != 0) {
+        reinterpret_cast<uint8_t*>(live.data())[rows / 8] &= static_cast<uint8_t>((1u << (rows % 8)) - 1);
+    }
+    return rows;
+}
+
+std::size_t BatchScanner::loadEncoded(const uint8_t* page) {
+    EncodedPage encoded(const_cast<uint8_t*>(page));
+    std::size_t rows = encoded.getNumRows();
+    if (encoded.getLiveRows() == 0) {
+        return 0;
+    }
+
+    slots.clear();
+    encoded_page = page;
+    std::fill(column_data.begin(), column_data.end(), nullptr);
+    live.assign(FilterKernels::selectionWords(rows), 0);
+    std::memcpy(live.data(), encoded.getPresence(), (rows + 7) / 8);
+    return rows;
+}
+
+const void* BatchScanner::getColumn(std::size_t i) const {
+    if (column_data[i] == nullptr && encoded_page != nullptr) {
+        EncodedPage encoded(const_cast<uint8_t*>(encoded_page));
+        column_data[i] = encoded.getPlainColumn(pax_columns[i]);
+        if (column_data[i] == nullptr) {
+            decoded.resize(fields.size());
+            decoded[i].resize((num_rows * FilterKernels::typeWidth(fields[i].type) + 7) / 8);
+            encoded.decodeColumn(pax_columns[i], decoded[i].data());
+            column_data[i] = decoded[i].data();
+        }
+    }
+    return column_data[i];
+}
+
+void BatchScanner::compare(std::size_t i, const FilterKernels& kernels, FilterKernels::CompareOp op,
+                           const void* constant, uint64_t* selection) const {
+    if (encoded_page != nullptr && column_data[i] == nullptr) {
+        EncodedPage(const_cast<uint8_t*>(encoded_page))
+            .compare(pax_columns[i], kernels, fields[i].type, op, constant, selection);
+        return;
+    }
+    kernels.compare(fields[i].type, getColumn(i), num_rows, op, constant, selection);
+}
@@ -0,0 +1,700 @@
+#include <unistd.h>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#include "storage/buffer_pool.hpp"
+#include "storage/compressed_page_file.hpp"
+#include "storage/metrics.hpp"
+
+BufferPool::PageGuard::PageGuard(BufferPool& pool, uint32_t page_id, LatchMode mode)
+    : pool(&pool), page_id(page_id), mode(mode) {
+    Frame* frame = pool.fetchFrame(page_id);
+    page = &frame->page;
+    latch = &frame->latch;
+
+    switch (mode) {
+        case LatchMode::SHARED: latch->lock_shared(); break;
+        case LatchMode::EXCLUSIVE: latch->lock(); break;
+        case LatchMode::NONE:
+            // Wait out an in-flight read of the page
+            latch->lock_shared();
+            latch->unlock_shared();
+            break;
+    }
+}
+
+BufferPool::PageGuard::PageGuard(PageGuard&& other) noexcept
+    : pool(other.pool), latch(other.latch), page(other.page), page_id(other.page_id),
+      mode(other.mode), is_dirty(other.is_dirty) {
+    other.pool = nullptr;
+    other.page = nullptr;
+}
+
+BufferPool::PageGuard& BufferPool::PageGuard::operator=(PageGuard&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool = other.pool;
+        latch = other.latch;
+        page = other.page;
+        page_id = other.page_id;
+        mode = other.mode;
+        is_dirty = other.is_dirty;
+        other.pool = nullptr;
+        other.page = nullptr;
+    }
+    return *this;
+}
+
+void BufferPool::PageGuard::release() {
+    if (pool != nullptr && page != nullptr) {
+        if (mode == LatchMode::SHARED) {
+            latch->unlock_shared();
+        } else if (mode == LatchMode::EXCLUSIVE) {
+            latch->unlock();
+        }
+        pool->unpinPage(page_id, is_dirty);
+    }
+    pool = nullptr;
+    page = nullptr;
+    is_dirty = false;
+}
+
+BufferPool::BufferPool(int fd, std::size_t pool_size_mb, LogManager* log_manager, IoBackend* io_backend,
+                       CompressedPageFile* compressed_file)
+    : file_descriptor(fd), log_manager(log_manager), io_backend(io_backend), compressed_file(compressed_file),
+      num_frames(numFrames(pool_size_mb)), arena(num_frames + FLUSH_BATCH_PAGES, SlottedPage::PAGE_SIZE),
+      flush_requests(FLUSH_BATCH_PAGES) {
+    if (this->io_backend == nullptr) {
+        owned_io_backend = std::make_unique<SyncIoBackend>();
+        this->io_backend = owned_io_backend.get();
+    }
+
+    std::size_t num_shards = numShards(num_frames);
+    std::size_t next_frame = 0;
+    for (std::size_t i = 0; i < num_shards; i++) {
+        auto shard = std::make_unique<Shard>();
+        // Spread the remainder over the first shards
+        shard->num_frames = num_frames / num_shards + (i < num_frames % num_shards ? 1 : 0);
+        shard->frames = std::make_unique<Frame[]>(shard->num_frames);
+        for (std::size_t j = 0; j < shard->num_frames; j++) {
+            shard->frames[j].page = SlottedPage(arena.getFrame(next_frame++));
+        }
+        shard->page_table.init(shard->num_frames);
+        shards.push_back(std::move(shard));
+    }
+    writer_frames.reserve(WRITER_ROUND_PAGES + shards.size());
+}
+
+void BufferPool::PageTable::init(std::size_t max_entries) {
+    std::size_t capacity = 1;
+    while (capacity < 2 * max_entries) {
+        capacity <<= 1;
+    }
+    page_ids.assign(capacity, EMPTY);
+    frame_ids.assign(capacity, 0);
+    mask = capacity - 1;
+    num_entries = 0;
+}
+
+std::size_t BufferPool::PageTable::find(uint32_t page_id) const {
+    for (std::size_t slot = home(page_id);; slot = (slot + 1) & mask) {
+        if (page_ids[slot] == page_id) {
+            return frame_ids[slot];
+        }
+        if (page_ids[slot] == EMPTY) {
+            return NOT_FOUND;
+        }
+    }
+}
+
+void BufferPool::PageTable::insert(uint32_t page_id, std::size_t frame_idx) {
+    std::size_t slot = home(page_id);
+    while (page_ids[slot] != EMPTY && page_ids[slot] != page_id) {
+        slot = (slot + 1) & mask;
+    }
+    num_entries += page_ids[slot] == EMPTY ? 1 : 0;
+    page_ids[slot] = page_id;
+    frame_ids[slot] = static_cast<uint32_t>(frame_idx);
+}
+
+void BufferPool::PageTable::erase(uint32_t page_id) {
+    std::size_t slot = home(page_id);
+    while (page_ids[slot] != page_id) {
+        if (page_ids[slot] == EMPTY) {
+            return;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    // Move back each later entry of the run that may sit in the hole: one
+    // whose home is not cyclically within (hole, its slot]
+    std::size_t hole = slot;
+    for (std::size_t next = (slot + 1) & mask; page_ids[next] != EMPTY; next = (next + 1) & mask) {
+        std::size_t want = home(page_ids[next]);
+        if (((next - want) & mask) >= ((next - hole) & mask)) {
+            page_ids[hole] = page_ids[next];
+            frame_ids[hole] = frame_ids[next];
+            hole = next;
+        }
+    }
+    page_ids[hole] = EMPTY;
+    num_entries--;
+}
+
+BufferPool::~BufferPool() {
+    stopBackgroundWriter();
+}
+
+SlottedPage* BufferPool::fetchPage(uint32_t page_id) {
+    Frame* frame = fetchFrame(page_id);
+    frame->latch.lock_shared();
+    frame->latch.unlock_shared();
+    return &frame->page;
+}
+
+BufferPool::Frame* BufferPool::fetchFrame(uint32_t page_id) {
+    Shard& shard = shardFor(page_id);
+    std::unique_lock<std::mutex> lock(shard.latch);
+
+    std::size_t found = shard.page_table.find(page_id);
+    if (found != PageTable::NOT_FOUND) {
+        Frame& frame = shard.frames[found];
+        frame.pin_count++;
+        frame.referenced = true;
+        shard.stats.hits++;
+        TINYDB_COUNT(PAGE_HITS, 1);
+        return &frame;
+    }
+
+    shard.stats.misses++;
+    TINYDB_COUNT(PAGE_MISSES, 1);
+    std::size_t frame_idx = acquireFrame(shard, lock);
+
+    // Another fetcher may have loaded the page while the shard latch was
+    // released to write back a victim; the acquired frame stays free
+    found = shard.page_table.find(page_id);
+    if (found != PageTable::NOT_FOUND) {
+        Frame& frame = shard.frames[found];
+        frame.pin_count++;
+        frame.referenced = true;
+        return &frame;
+    }
+    Frame& frame = shard.frames[frame_idx];
+
+    frame.page_id = page_id;
+    frame.pin_count = 1;
+    frame.is_dirty = false;
+    frame.referenced = true;
+    frame.in_use = true;
+    shard.page_table.insert(page_id, frame_idx);
+
+    // The victim frame had no pins, so nobody holds its latch. Keep it
+    // exclusively latched while reading so concurrent fetchers of the same
+    // page wait for the data without holding up the rest of the shard.
+    frame.latch.lock();
+    lock.unlock();
+
+    try {
+        readFrame(frame, page_id);
+    } catch (...) {
+        lock.lock();
+        shard.page_table.erase(page_id);
+        frame.in_use = false;
+        frame.pin_count = 0;
+        frame.latch.unlock();
+        throw;
+    }
+    frame.latch.unlock();
+    return &frame;
+}
+
+SlottedPage* BufferPool::newPage(uint32_t page_id, SlottedPage::PageType type) {
+    Shard& shard = shardFor(page_id);
+    std::unique_lock<std::mutex> lock(shard.latch);
+
+    if (shard.page_table.find(page_id) != PageTable::NOT_FOUND) {
+        throw std::runtime_error("Page already resident in buffer pool");
+    }
+
+    // Zeroed so the new page's image on disk holds nothing of the frame's
+    // previous page
+    std::size_t frame_idx = acquireFrame(shard, lock);
+    if (shard.page_table.find(page_id) != PageTable::NOT_FOUND) {
+        throw std::runtime_error("Page already resident in buffer pool");
+    }
+    Frame& frame = shard.frames[frame_idx];
+    std::memset(frame.page.getData(), 0, SlottedPage::PAGE_SIZE);
+    frame.page.reset(type, page_id);
+
+    frame.page_id = page_id;
+    frame.pin_count = 1;
+    frame.referenced = true;
+    frame.in_use = true;
+    setDirty(shard, frame, true);
+    shard.page_table.insert(page_id, frame_idx);
+    return &frame.page;
+}
+
+void BufferPool::unpinPage(uint32_t page_id, bool is_dirty) {
+    Shard& shard = shardFor(page_id);
+    std::lock_guard<std::mutex> lock(shard.latch);
+
+    std::size_t found = shard.page_table.find(page_id);
+    if (found == PageTable::NOT_FOUND) {
+        return;
+    }
+
+    Frame& frame = shard.frames[found];
+    if (frame.pin_count > 0) {
+        frame.pin_count--;
+    }
+    if (is_dirty) {
+        setDirty(shard, frame, true);
+    }
+}
+
+void BufferPool::flushPage(uint32_t page_id) {
+    Shard& shard = shardFor(page_id);
+    std::unique_lock<std::mutex> lock(shard.latch);
+
+    std::size_t found = shard.page_table.find(page_id);
+    if (found == PageTable::NOT_FOUND || !shard.frames[found].is_dirty) {
+        return;
+    }
+
+    // Pin so the frame cannot be evicted, then write it under a shared
+    // latch so no writer modifies it mid-write
+    Frame& frame = shard.frames[found];
+    frame.pin_count++;
+    lock.unlock();
+
+    {
+        std::shared_lock<std::shared_mutex> page_latch(frame.latch);
+        try {
+            if (log_manager != nullptr) {
+                log_manager->flush(frame.page.getHeader().lsn);
+            }
+            writePage(frame.page);
+        } catch (...) {
+            lock.lock();
+            frame.pin_count--;
+            throw;
+        }
+
+        lock.lock();
+        setDirty(shard, frame, false);
+        shard.stats.dirty_writes++;
+    }
+    frame.pin_count--;
+}
+
+void BufferPool::flushAllPages() {
+    // Pin every dirty frame so none is evicted (and re-read from disk)
+    // before its write has landed
+    std::vector<DirtyFrame> dirty;
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->latch);
+        for (std::size_t i = 0; i < shard->num_frames; i++) {
+            Frame& frame = shard->frames[i];
+            if (frame.in_use && frame.is_dirty) {
+                frame.pin_count++;
+                dirty.push_back({shard.get(), &frame, frame.page_id, nullptr});
+            }
+        }
+    }
+    writeDirtyFrames(dirty, false);
+}
+
+void BufferPool::flushPages(const uint32_t* page_ids, std::size_t count) {
+    std::vector<DirtyFrame> dirty;
+    for (std::size_t i = 0; i < count; i++) {
+        Shard& shard = shardFor(page_ids[i]);
+        std::lock_guard<std::mutex> lock(shard.latch);
+        std::size_t found = shard.page_table.find(page_ids[i]);
+        if (found != PageTable::NOT_FOUND && shard.frames[found].is_dirty) {
+            Frame& frame = shard.frames[found];
+            frame.pin_count++;
+            dirty.push_back({&shard, &frame, page_ids[i], nullptr});
+        }
+    }
+    writeDirtyFrames(dirty, false);
+}
+
+std::vector<uint32_t> BufferPool::getDirtyPages() {
+    // Batches clear the dirty bit before writing, so wait out the one in
+    // flight; eviction and flushPage() clear it only after writing
+    std::lock_guard<std::mutex> flush_lock(flush_latch);
+
+    std::vector<uint32_t> page_ids;
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->latch);
+        for (std::size_t i = 0; i < shard->num_frames && shard->num_dirty > 0; i++) {
+            const Frame& frame = shard->frames[i];
+            if (frame.in_use && frame.is_dirty) {
+                page_ids.push_back(frame.page_id);
+            }
+        }
+    }
+    std::sort(page_ids.begin(), page_ids.end());
+    return page_ids;
+}
+
+std::size_t BufferPool::writeDirtyFrames(std::vector<DirtyFrame>& dirty, bool background) {
+    std::sort(dirty.begin(), dirty.end(),
+              [](const DirtyFrame& a, const DirtyFrame& b) { return a.page_id < b.page_id; });
+
+    std::lock_guard<std::mutex> flush_lock(flush_latch);
+    uint8_t* staging = arena.getFrame(num_frames);
+    std::vector<IoBackend::Request>& requests = flush_requests;
+    std::size_t written = 0;
+    bool failed = false;
+
+    for (std::size_t first = 0; first < dirty.size(); first += FLUSH_BATCH_PAGES) {
+        std::size_t count = std::min(FLUSH_BATCH_PAGES, dirty.size() - first);
+
+        // Snapshot each page under its shared latch and clear the dirty bit
+        // while still holding it, so a later change marks the page dirty
+        // again. Pages written back since they were picked are skipped.
+        std::size_t queued = 0;
+        uint64_t max_lsn = 0;
+        for (std::size_t i = 0; i < count; i++) {
+            DirtyFrame& entry = dirty[first + i];
+            std::shared_lock<std::shared_mutex> page_latch(entry.frame->latch);
+            {
+                std::lock_guard<std::mutex> lock(entry.shard->latch);
+                if (!entry.frame->is_dirty) {
+                    continue;
+                }
+                setDirty(*entry.shard, *entry.frame, false);
+            }
+
+            uint8_t* dest = staging + queued * SlottedPage::PAGE_SIZE;
+            std::memcpy(dest, entry.frame->page.getData(), SlottedPage::PAGE_SIZE);
+            max_lsn = std::max(max_lsn, entry.frame->page.getHeader().lsn);
+            entry.request = &requests[queued++];
+            *entry.request = {IoBackend::Request::Op::WRITE, file_descriptor, dest, SlottedPage::PAGE_SIZE,
+                              static_cast<off_t>(entry.page_id * SlottedPage::PAGE_SIZE), 0};
+        }
+
+        if (queued > 0) {
+            try {
+                // One log flush covers the whole batch
+                if (log_manager != nullptr) {
+                    log_manager->flush(max_lsn);
+                }
+                TINYDB_TIME(BATCH_WRITE);
+                if (compressed_file != nullptr) {
+                    compressed_file->submit(requests.data(), queued);
+                } else {
+                    io_backend->submit(requests.data(), queued);
+                }
+            } catch (...) {
+                // Nothing of the batch is known to be written: mark its
+                // pages dirty again and unpin every frame not yet released
+                for (std::size_t i = first; i < dirty.size(); i++) {
+                    std::lock_guard<std::mutex> lock(dirty[i].shard->latch);
+                    if (i < first + count && dirty[i].request != nullptr) {
+                        setDirty(*dirty[i].shard, *dirty[i].frame, true);
+                    }
+                    dirty[i].frame->pin_count--;
+                }
+                throw;
+            }
+        }
+
+        for (std::size_t i = 0; i < count; i++) {
+            DirtyFrame& entry = dirty[first + i];
+            std::lock_guard<std::mutex> lock(entry.shard->latch);
+            if (entry.request == nullptr) {
+                // Skipped
+            } else if (entry.request->result != static_cast<ssize_t>(SlottedPage::PAGE_SIZE)) {
+                setDirty(*entry.shard, *entry.frame, true);
+                failed = true;
+            } else {
+                entry.shard->stats.dirty_writes++;
+                TINYDB_COUNT(PAGES_WRITTEN, 1);
+                if (background) {
+                    entry.shard->stats.writer_writes++;
+                }
+                written++;
+            }
+            entry.frame->pin_count--;
+        }
+        if (failed) {
+            // Unpin the frames of the batches not attempted
+            for (std::size_t i = first + count; i < dirty.size(); i++) {
+                std::lock_guard<std::mutex> lock(dirty[i].shard->latch);
+                dirty[i].frame->pin_count--;
+            }
+            throw std::runtime_error("Failed to write the page to the file");
+        }
+    }
+    return written;
+}
+
+void BufferPool::startBackgroundWriter(std::chrono::milliseconds interval) {
+    std::lock_guard<std::mutex> lock(writer_latch);
+    if (writer_thread.joinable()) {
+        return;
+    }
+    writer_stopping = false;
+    writer_running = true;
+    writer_thread = std::thread(&BufferPool::runBackgroundWriter, this, interval);
+}
+
+void BufferPool::stopBackgroundWriter() {
+    {
+        std::lock_guard<std::mutex> lock(writer_latch);
+        if (!writer_thread.joinable()) {
+            return;
+        }
+        writer_stopping = true;
+        writer_running = false;
+    }
+    writer_cv.notify_all();
+    writer_thread.join();
+}
+
+void BufferPool::runBackgroundWriter(std::chrono::milliseconds interval) {
+    auto window_start = std::chrono::steady_clock::now();
+    uint64_t window_pages = 0;
+    std::size_t written = 0;
+
+    while (true) {
+        {
+            // Go straight into the next round while there is a backlog
+            std::unique_lock<std::mutex> lock(writer_latch);
+            if (written < WRITER_ROUND_PAGES) {
+                writer_cv.wait_for(lock, interval, [this] { return writer_stopping || writer_wanted; });
+            }
+            if (writer_stopping) {
+                return;
+            }
+            writer_wanted = false;
+        }
+
+        try {
+            written = cleanAheadOfHand();
+        } catch (const std::exception&) {
+            // The pages stay dirty; the failure surfaces when a foreground
+            // write of them fails too
+            written = 0;
+        }
+        window_pages += written;
+
+        auto now = std::chrono::steady_clock::now();
+        double elapsed = std::chrono::duration<double>(now - window_start).count();
+        if (elapsed >= 1.0) {
+            std::lock_guard<std::mutex> lock(writer_latch);
+            writer_pages_per_sec = window_pages / elapsed;
+            window_start = now;
+            window_pages = 0;
+        }
+    }
+}
+
+std::size_t BufferPool::cleanAheadOfHand() {
+    // Unreferenced dirty frames are the ones the hand will evict next; hot
+    // pages would only be dirtied again and are left to checkpoints. Leave
+    // at least half of each shard unpinned for foreground fetches.
+    std::vector<DirtyFrame>& dirty = writer_frames;
+    dirty.clear();
+    std::size_t quota = std::max<std::size_t>(1, WRITER_ROUND_PAGES / shards.size());
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->latch);
+        std::size_t limit = std::min(quota, shard->num_frames / 2);
+        std::size_t picked = 0;
+        for (std::size_t step = 0; step < shard->num_frames && picked < limit && shard->num_dirty > 0; step++) {
+            Frame& frame = shard->frames[(shard->clock_hand + step) % shard->num_frames];
+            if (frame.in_use && frame.is_dirty && frame.pin_count == 0 && !frame.referenced) {
+                frame.pin_count++;
+                dirty.push_back({shard.get(), &frame, frame.page_id, nullptr});
+                picked++;
+            }
+        }
+    }
+    return writeDirtyFrames(dirty, true);
+}
+
+bool BufferPool::copyPageIfResident(uint32_t page_id, uint8_t* dest) {
+    Shard& shard = shardFor(page_id);
+    std::unique_lock<std::mutex> lock(shard.latch);
+
+    std::size_t found = shard.page_table.find(page_id);
+    if (found == PageTable::NOT_FOUND) {
+        return false;
+    }
+
+    Frame& frame = shard.frames[found];
+    frame.pin_count++;
+    lock.unlock();
+
+    {
+        std::shared_lock<std::shared_mutex> page_latch(frame.latch);
+        std::memcpy(dest, frame.page.getData(), SlottedPage::PAGE_SIZE);
+    }
+
+    lock.lock();
+    frame.pin_count--;
+    return true;
+}
+
+BufferPool::Stats BufferPool::getStats() const {
+    Stats total = {};
+    for (const auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard->latch);
+        total.hits += shard->stats.hits;
+        total.misses += shard->stats.misses;
+        total.evictions += shard->stats.evictions;
+        total.dirty_writes += shard->stats.dirty_writes;
+        total.eviction_writes += shard->stats.eviction_writes;
+        total.writer_writes += shard->stats.writer_writes;
+        total.dirty_pages += shard->num_dirty;
+    }
+    std::lock_guard<std::mutex> lock(writer_latch);
+    total.writer_pages_per_sec = writer_pages_per_sec;
+    return total;
+}
+
+std::size_t BufferPool::acquireFrame(Shard& shard, std::unique_lock<std::mutex>& lock) {
+    while (true) {
+        // Prefer a frame that has never been used
+        if (shard.page_table.size() < shard.num_frames) {
+            for (std::size_t i = 0; i < shard.num_frames; i++) {
+                if (!shard.frames[i].in_use) {
+                    return i;
+                }
+            }
+        }
+
+        // CLOCK sweep: two full passes clear every reference bit, so if
+        // nothing is found by then every frame in the shard is pinned. With
+        // the background writer running, dirty victims are passed over so
+        // the caller does not wait on a write; the first one is the fallback.
+        bool skip_dirty = writer_running;
+        std::size_t dirty_victim = shard.num_frames;
+        for (std::size_t step = 0; step < 2 * shard.num_frames; step++) {
+            std::size_t idx = shard.clock_hand;
+            shard.clock_hand = (shard.clock_hand + 1) % shard.num_frames;
+
+            Frame& frame = shard.frames[idx];
+            if (frame.pin_count > 0) {
+                continue;
+            }
+            if (frame.referenced) {
+                frame.referenced = false;
+                continue;
+            }
+
+            if (frame.is_dirty) {
+                dirty_victim = dirty_victim == shard.num_frames ? idx : dirty_victim;
+                if (skip_dirty) {
+                    continue;
+                }
+                break;
+            }
+
+            evictFrame(shard, frame);
+            return idx;
+        }
+
+        if (dirty_victim == shard.num_frames) {
+            throw std::runtime_error("Buffer pool exhausted: all frames in shard are pinned");
+        }
+        if (writer_running) {
+            // Let the writer catch up before the next eviction
+            {
+                std::lock_guard<std::mutex> writer_lock(writer_latch);
+                writer_wanted = true;
+            }
+            writer_cv.notify_one();
+        }
+
+        // Take the victim only if nobody fetched or dirtied it again while
+        // it was written; otherwise sweep again
+        Frame& frame = shard.frames[dirty_victim];
+        writeFrame(shard, frame, lock);
+        if (frame.pin_count == 0 && !frame.referenced && !frame.is_dirty) {
+            evictFrame(shard, frame);
+            return dirty_victim;
+        }
+    }
+}
+
+void BufferPool::evictFrame(Shard& shard, Frame& frame) {
+    shard.page_table.erase(frame.page_id);
+    frame.in_use = false;
+    shard.stats.evictions++;
+}
+
+void BufferPool::setDirty(Shard& shard, Frame& frame, bool is_dirty) {
+    if (frame.is_dirty != is_dirty) {
+        frame.is_dirty = is_dirty;
+        if (is_dirty) {
+            shard.num_dirty++;
+        } else {
+            shard.num_dirty--;
+        }
+    }
+}
+
+void BufferPool::writeFrame(Shard& shard, Frame& frame, std::unique_lock<std::mutex>& lock) {
+    // An unpinned frame's latch is free, so this does not wait. Pinned and
+    // shared-latched, the page neither goes away nor changes under a
+    // latching caller while the shard latch is released for the log flush
+    // and the write.
+    frame.pin_count++;
+    frame.latch.lock_shared();
+    lock.unlock();
+
+    try {
+        if (log_manager != nullptr) {
+            log_manager->flush(frame.page.getHeader().lsn);
+        }
+        writePage(frame.page);
+    } catch (...) {
+        lock.lock();
+        frame.latch.unlock_shared();
+        frame.pin_count--;
+        throw;
+    }
+
+    // Cleared before the page latch is released, so a change made after
+    // the write marks the page dirty again. The B+-tree changes pages
+    // under their version word without the frame latch, so a page fetched
+    // during the write stays dirty; the pin kept sweeps from clearing the
+    // reference bit that fetch set.
+    lock.lock();
+    if (!frame.referenced) {
+        setDirty(shard, frame, false);
+    }
+    frame.latch.unlock_shared();
+    frame.pin_count--;
+    shard.stats.dirty_writes++;
+    shard.stats.eviction_writes++;
+    TINYDB_COUNT(EVICTION_WRITES, 1);
+}
+
+void BufferPool::readFrame(Frame& frame, uint32_t page_id) {
+    TINYDB_TIME(PAGE_READ);
+    TINYDB_COUNT(PAGES_READ, 1);
+    off_t offset = static_cast<off_t>(page_id) * SlottedPage::PAGE_SIZE;
+    ssize_t bytes = compressed_file != nullptr
+                        ? compressed_file->read(frame.page.getData(), SlottedPage::PAGE_SIZE, offset)
+                        : IoBackend::read(file_descriptor, frame.page.getData(), SlottedPage::PAGE_SIZE, offset);
+    if (bytes != SlottedPage::PAGE_SIZE) {
+        throw std::runtime_error("Failed to read the page from the file");
+    }
+}
+
+void BufferPool::writePage(const SlottedPage& page) {
+    TINYDB_TIME(PAGE_WRITE);
+    TINYDB_COUNT(PAGES_WRITTEN, 1);
+    off_t offset = static_cast<off_t>(page.getHeader().id) * SlottedPage::PAGE_SIZE;
+    ssize_t bytes = compressed_file != nullptr
+                        ? compressed_file->write(page.getData(), SlottedPage::PAGE_SIZE, offset)
+                        : IoBackend::write(file_descriptor, page.getData(), SlottedPage::PAGE_SIZE, offset);
+    if (bytes != SlottedPage::PAGE_SIZE) {
+        throw std::runtime_error("Failed to write the page to the file");
+    }
+}
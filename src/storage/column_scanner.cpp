@@ -0,0 +1,82 @@
+#include <stdexcept>
+#include "storage/column_scanner.hpp"
+
+ColumnScanner::ColumnScanner(HeapFile& heap_file, std::vector<uint16_t> columns, std::size_t readahead_pages)
+    : heap_file(heap_file),
+      columns(std::move(columns)),
+      end_page(heap_file.getNumPages()),
+      column_data(this->columns.size()) {
+    if (!heap_file.isPax()) {
+        throw std::invalid_argument("Column scans need a heap file with the PAX layout");
+    }
+    for (uint16_t column : this->columns) {
+        if (column >= heap_file.getColumnWidths().size()) {
+            throw std::invalid_argument("Column " + std::to_string(column) + " is not in the schema");
+        }
+    }
+    if (heap_file.mapping == nullptr) {
+        scanner = std::make_unique<HeapScanner>(heap_file, readahead_pages);
+    }
+}
+
+const uint8_t* ColumnScanner::nextPage() {
+    if (scanner) {
+        const uint8_t* page = scanner->nextPage();
+        page_id = scanner->getPageId();
+        return page;
+    }
+    if (next_mapped_page >= end_page) {
+        return nullptr;
+    }
+    page_id = next_mapped_page++;
+    return heap_file.getMappedPage(page_id);
+}
+
+bool ColumnScanner::next() {
+    while (const uint8_t* page = nextPage()) {
+        const auto* header = reinterpret_cast<const SlottedPage::PageHeader*>(page);
+        if (header->type == SlottedPage::PageType::ENCODED) {
+            if (loadEncoded(page)) {
+                return true;
+            }
+            continue;
+        }
+        if (header->type != SlottedPage::PageType::PAX) {
+            continue;
+        }
+        PaxPage pax(const_cast<uint8_t*>(page));
+        if (pax.getNumRows() == 0) {
+            continue;
+        }
+
+        num_rows = pax.getNumRows();
+        presence = pax.getPresence();
+        for (std::size_t i = 0; i < columns.size(); i++) {
+            column_data[i] = pax.getColumn(columns[i]);
+        }
+        return true;
+    }
+
+    num_rows = 0;
+    return false;
+}
+
+bool ColumnScanner::loadEncoded(const uint8_t* page) {
+    EncodedPage encoded(const_cast<uint8_t*>(page));
+    if (encoded.getNumRows() == 0) {
+        return false;
+    }
+
+    num_rows = encoded.getNumRows();
+    presence = encoded.getPresence();
+    decoded.resize(columns.size());
+    for (std::size_t i = 0; i < columns.size(); i++) {
+        column_data[i] = encoded.getPlainColumn(columns[i]);
+        if (column_data[i] == nullptr) {
+            decoded[i].resize(num_rows * encoded.getColumnWidth(columns[i]));
+            encoded.decodeColumn(columns[i], decoded[i].data());
+            column_data[i] = decoded[i].data();
+        }
+    }
+    return true;
+}
@@ -0,0 +1,469 @@
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include "storage/compressed_page_file.hpp"
+#include "storage/lz_codec.hpp"
+
+namespace {
+
+constexpr std::size_t PAGE_SIZE = SlottedPage::PAGE_SIZE;
+constexpr uint32_t TABLE_MAGIC = 0x54504454; // "TDPT"
+
+struct TableHeader {
+    uint32_t magic;
+    uint32_t page_size;
+    uint64_t num_pages;
+    uint32_t checksum; // FNV-1a over the entries
+    uint32_t reserved;
+};
+
+uint32_t checksum(const uint8_t* data, std::size_t size) {
+    uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
+
+// Per-thread buffer for stored extents, grown on demand. Only the stored
+// bytes of each extent are ever used, so it is not cleared between calls.
+uint8_t* stagingBuffer(std::size_t size) {
+    thread_local AlignedBuffer buffer;
+    thread_local std::size_t capacity = 0;
+    if (capacity < size) {
+        buffer = allocateAligned(size);
+        capacity = size;
+    }
+    return buffer.get();
+}
+
+} // namespace
+
+bool CompressedPageFile::isCompressed(int fd) {
+    // A whole aligned block, so this also works on O_DIRECT descriptors
+    AlignedBuffer block = allocateAligned(IO_ALIGNMENT);
+    return pread(fd, block.get(), IO_ALIGNMENT, 0) >= static_cast<ssize_t>(sizeof(SlottedPage::PageHeader)) &&
+           reinterpret_cast<const SlottedPage::PageHeader*>(block.get())->id == MAGIC;
+}
+
+CompressedPageFile::CompressedPageFile(int fd, const std::string& filename, IoBackend* io_backend)
+    : file_descriptor(fd), table_filename(filename + ".ptt"), io_backend(io_backend) {
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        throw std::runtime_error("Failed to stat heap file: " + filename);
+    }
+
+    if (st.st_size == 0) {
+        AlignedBuffer block = allocateAligned(IO_ALIGNMENT);
+        auto* header = reinterpret_cast<SlottedPage::PageHeader*>(block.get());
+        header->id = MAGIC;
+        header->page_size = PAGE_SIZE;
+        if (IoBackend::write(fd, block.get(), IO_ALIGNMENT, 0) != static_cast<ssize_t>(IO_ALIGNMENT)) {
+            throw std::runtime_error("Failed to write the superblock of " + filename);
+        }
+        file_end = IO_ALIGNMENT;
+        // Replaces any table left behind by an earlier file of this name
+        sync();
+        return;
+    }
+
+    file_end = alignedSize(static_cast<uint64_t>(st.st_size));
+    loadTable();
+}
+
+void CompressedPageFile::loadTable() {
+    int fd = open(table_filename.c_str(), O_RDONLY);
+    if (fd == -1 && file_end == IO_ALIGNMENT) {
+        sync(); // Created up to the superblock
+        return;
+    }
+    if (fd == -1) {
+        throw std::runtime_error("Missing page table: " + table_filename);
+    }
+    struct stat st;
+    TableHeader header;
+    bool ok = fstat(fd, &st) == 0 && pread(fd, &header, sizeof(header), 0) == sizeof(header) &&
+              header.magic == TABLE_MAGIC && header.page_size == PAGE_SIZE &&
+              static_cast<uint64_t>(st.st_size) == sizeof(header) + header.num_pages * sizeof(Extent);
+    if (ok) {
+        table.resize(header.num_pages);
+        std::size_t bytes = table.size() * sizeof(Extent);
+        ok = pread(fd, table.data(), bytes, sizeof(header)) == static_cast<ssize_t>(bytes) &&
+             checksum(reinterpret_cast<const uint8_t*>(table.data()), bytes) == header.checksum;
+    }
+    ::close(fd);
+    if (!ok) {
+        throw std::runtime_error("Corrupt page table: " + table_filename);
+    }
+
+    // Everything between the extents in use is free
+    std::vector<std::pair<uint64_t, uint64_t>> used;
+    for (const Extent& extent : table) {
+        if (extent.size == 0) {
+            continue;
+        }
+        if (extent.offset < IO_ALIGNMENT || extent.offset % EXTENT_ALIGNMENT != 0 || extent.size > PAGE_SIZE ||
+            extent.offset + alignedSize(extent.size) > file_end) {
+            throw std::runtime_error("Corrupt page table: " + table_filename);
+        }
+        used.emplace_back(extent.offset, alignedSize(extent.size));
+        stats.pages++;
+        stats.stored_bytes += extent.size;
+    }
+    std::sort(used.begin(), used.end());
+    uint64_t position = IO_ALIGNMENT;
+    for (const auto& [offset, size] : used) {
+        if (offset < position) {
+            throw std::runtime_error("Corrupt page table: " + table_filename);
+        }
+        if (offset > position) {
+            releaseExtent(position, offset - position);
+        }
+        position = offset + size;
+    }
+    if (file_end > position) {
+        releaseExtent(position, file_end - position);
+    }
+    trimFile();
+}
+
+std::size_t CompressedPageFile::getNumPages() {
+    std::lock_guard<std::mutex> lock(latch);
+    return table.size();
+}
+
+uint64_t CompressedPageFile::allocateExtent(uint64_t size) {
+    // Best fit, splitting off the rest; otherwise grow the file
+    auto it = free_by_size.lower_bound(size);
+    if (it == free_by_size.end()) {
+        uint64_t offset = file_end;
+        file_end += size;
+        return offset;
+    }
+    uint64_t offset = it->second;
+    uint64_t rest = it->first - size;
+    removeFreeExtent(free_by_offset.find(offset));
+    if (rest > 0) {
+        free_by_size.emplace(rest, offset + size);
+        free_by_offset.emplace(offset + size, rest);
+    }
+    return offset;
+}
+
+void CompressedPageFile::releaseExtent(uint64_t offset, uint64_t size) {
+    auto next = free_by_offset.lower_bound(offset);
+    if (next != free_by_offset.end() && next->first == offset + size) {
+        size += next->second;
+        next = std::next(next);
+        removeFreeExtent(std::prev(next));
+    }
+    if (next != free_by_offset.begin()) {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == offset) {
+            offset = prev->first;
+            size += prev->second;
+            removeFreeExtent(prev);
+        }
+    }
+    free_by_size.emplace(size, offset);
+    free_by_offset.emplace(offset, size);
+}
+
+void CompressedPageFile::removeFreeExtent(std::map<uint64_t, uint64_t>::iterator it) {
+    auto [first, last] = free_by_size.equal_range(it->second);
+    for (auto entry = first; entry != last; ++entry) {
+        if (entry->second == it->first) {
+            free_by_size.erase(entry);
+            break;
+        }
+    }
+    free_by_offset.erase(it);
+}
+
+void CompressedPageFile::releaseRetired() {
+    // Retired extents are in epoch order
+    uint64_t oldest = active_reads.empty() ? read_epoch : active_reads.begin()->first;
+    auto it = retired.begin();
+    for (; it != retired.end() && it->first < oldest; ++it) {
+        releaseExtent(it->second.offset, alignedSize(it->second.size));
+    }
+    retired.erase(retired.begin(), it);
+    trimFile();
+}
+
+void CompressedPageFile::endRead(uint64_t epoch) {
+    std::lock_guard<std::mutex> lock(latch);
+    auto it = active_reads.find(epoch);
+    if (--it->second == 0) {
+        active_reads.erase(it);
+        releaseRetired();
+    }
+}
+
+void CompressedPageFile::trimFile() {
+    if (free_by_offset.empty()) {
+        return;
+    }
+    auto last = std::prev(free_by_offset.end());
+    if (last->first + last->second != file_end || ftruncate(file_descriptor, last->first) == -1) {
+        return;
+    }
+    file_end = last->first;
+    removeFreeExtent(last);
+}
+
+void CompressedPageFile::submit(IoBackend::Request* requests, std::size_t count) {
+    std::vector<IoBackend::Request*> writes;
+    for (std::size_t i = 0; i < count; i++) {
+        if (requests[i].op == IoBackend::Request::Op::READ) {
+            readPages(requests[i]);
+        } else {
+            writes.push_back(&requests[i]);
+        }
+    }
+    if (!writes.empty()) {
+        writePages(writes);
+    }
+}
+
+ssize_t CompressedPageFile::read(void* buffer, std::size_t length, off_t offset) {
+    IoBackend::Request request = {IoBackend::Request::Op::READ, file_descriptor, buffer, length, offset, 0};
+    readPages(request);
+    return request.result < 0 ? -1 : request.result;
+}
+
+ssize_t CompressedPageFile::write(const void* buffer, std::size_t length, off_t offset) {
+    IoBackend::Request request = {IoBackend::Request::Op::WRITE, file_descriptor, const_cast<void*>(buffer),
+                                  length, offset, 0};
+    writePages({&request});
+    return request.result < 0 ? -1 : request.result;
+}
+
+void CompressedPageFile::readPages(IoBackend::Request& request) {
+    uint32_t first_page = static_cast<uint32_t>(request.offset / PAGE_SIZE);
+    std::vector<Extent> extents;
+    uint64_t epoch;
+    {
+        // Registered so the extents looked up stay allocated, and are not
+        // handed to another page, until the read has finished
+        std::lock_guard<std::mutex> lock(latch);
+        if (first_page < table.size()) {
+            std::size_t count = std::min(request.length / PAGE_SIZE, table.size() - first_page);
+            extents.assign(table.begin() + first_page, table.begin() + first_page + count);
+        }
+        epoch = read_epoch;
+        active_reads[epoch]++;
+    }
+
+    try {
+        readExtents(request, first_page, extents);
+    } catch (...) {
+        endRead(epoch);
+        throw;
+    }
+    endRead(epoch);
+}
+
+void CompressedPageFile::readExtents(IoBackend::Request& request, uint32_t first_page,
+                                     const std::vector<Extent>& extents) {
+    // Extents adjacent in the file are read with one request, as
+    // bulk-loaded and sequentially written pages usually are
+    uint8_t* staging = stagingBuffer(std::max<std::size_t>(extents.size(), 1) * PAGE_SIZE);
+    std::vector<IoBackend::Request> physical;
+    std::vector<uint64_t> staged_at(extents.size());
+    uint64_t staged = 0;
+    for (std::size_t i = 0; i < extents.size(); i++) {
+        if (extents[i].size == 0) {
+            continue;
+        }
+        uint64_t size = alignedSize(extents[i].size);
+        staged_at[i] = staged;
+        IoBackend::Request* last = physical.empty() ? nullptr : &physical.back();
+        if (last != nullptr && static_cast<uint64_t>(last->offset) + last->length == extents[i].offset &&
+            static_cast<uint8_t*>(last->buffer) + last->length == staging + staged) {
+            last->length += size;
+        } else {
+            physical.push_back({IoBackend::Request::Op::READ, file_descriptor, staging + staged, size,
+                                static_cast<off_t>(extents[i].offset), 0});
+        }
+        staged += size;
+    }
+
+    io_backend->submit(physical.data(), physical.size());
+    for (const auto& read : physical) {
+        if (read.result != static_cast<ssize_t>(read.length)) {
+            request.result = read.result < 0 ? read.result : -EIO;
+            return;
+        }
+    }
+
+    auto* output = static_cast<uint8_t*>(request.buffer);
+    for (std::size_t i = 0; i < extents.size(); i++) {
+        uint8_t* page = output + i * PAGE_SIZE;
+        const uint8_t* stored = staging + staged_at[i];
+        if (extents[i].size == 0) {
+            std::memset(page, 0, PAGE_SIZE);
+        } else if (extents[i].flags & RAW) {
+            std::memcpy(page, stored, PAGE_SIZE);
+        } else if (LzCodec::decompress(stored, extents[i].size, page, PAGE_SIZE) != PAGE_SIZE) {
+            throw std::runtime_error("Corrupt compressed page " + std::to_string(first_page + i));
+        }
+    }
+    request.result = static_cast<ssize_t>(extents.size() * PAGE_SIZE);
+
+    std::lock_guard<std::mutex> lock(latch);
+    stats.pages_read += extents.size();
+}
+
+void CompressedPageFile::writePages(const std::vector<IoBackend::Request*>& requests) {
+    struct PageWrite {
+        IoBackend::Request* request;
+        uint32_t page_id;
+        Extent extent;
+        uint64_t staged_at;
+    };
+    std::vector<PageWrite> pages;
+    for (IoBackend::Request* request : requests) {
+        for (std::size_t i = 0; i < request->length / PAGE_SIZE; i++) {
+            pages.push_back({request, static_cast<uint32_t>(request->offset / PAGE_SIZE + i), {}, 0});
+        }
+        request->result = static_cast<ssize_t>(request->length);
+    }
+
+    // Compress outside the latch; a page must save at least one alignment
+    // unit, or it is stored as is
+    uint8_t* staging = stagingBuffer(std::max<std::size_t>(pages.size(), 1) * PAGE_SIZE);
+    uint64_t staged = 0;
+    for (PageWrite& page : pages) {
+        const uint8_t* input = static_cast<const uint8_t*>(page.request->buffer) +
+                               (page.page_id - page.request->offset / PAGE_SIZE) * PAGE_SIZE;
+        uint8_t* output = staging + staged;
+        std::size_t size = LzCodec::compress(input, PAGE_SIZE, output, PAGE_SIZE - EXTENT_ALIGNMENT);
+        if (size == 0) {
+            std::memcpy(output, input, PAGE_SIZE);
+            page.extent.size = PAGE_SIZE;
+            page.extent.flags = RAW;
+        } else {
+            page.extent.size = static_cast<uint32_t>(size);
+        }
+        page.staged_at = staged;
+        staged += alignedSize(page.extent.size);
+    }
+
+    std::vector<IoBackend::Request> physical;
+    std::vector<std::size_t> physical_of(pages.size());
+    {
+        std::lock_guard<std::mutex> lock(latch);
+        for (std::size_t i = 0; i < pages.size(); i++) {
+            uint64_t size = alignedSize(pages[i].extent.size);
+            pages[i].extent.offset = allocateExtent(size);
+            IoBackend::Request* last = physical.empty() ? nullptr : &physical.back();
+            if (last != nullptr && static_cast<uint64_t>(last->offset) + last->length == pages[i].extent.offset &&
+                static_cast<uint8_t*>(last->buffer) + last->length == staging + pages[i].staged_at) {
+                last->length += size;
+            } else {
+                physical.push_back({IoBackend::Request::Op::WRITE, file_descriptor,
+                                    staging + pages[i].staged_at, size,
+                                    static_cast<off_t>(pages[i].extent.offset), 0});
+            }
+            physical_of[i] = physical.size() - 1;
+        }
+    }
+
+    io_backend->submit(physical.data(), physical.size());
+
+    // Only pages whose extent reached the file are installed in the table
+    std::lock_guard<std::mutex> lock(latch);
+    for (std::size_t i = 0; i < pages.size(); i++) {
+        const IoBackend::Request& write = physical[physical_of[i]];
+        PageWrite& page = pages[i];
+        if (write.result != static_cast<ssize_t>(write.length)) {
+            page.request->result = write.result < 0 ? write.result : -EIO;
+            releaseExtent(page.extent.offset, alignedSize(page.extent.size));
+            continue;
+        }
+        if (page.page_id >= table.size()) {
+            table.resize(page.page_id + 1);
+        }
+        Extent& entry = table[page.page_id];
+        if (entry.size != 0) {
+            pending_free.push_back(entry);
+            stats.pages--;
+            stats.stored_bytes -= entry.size;
+        }
+        entry = page.extent;
+        stats.pages++;
+        stats.stored_bytes += entry.size;
+        stats.pages_written++;
+    }
+}
+
+void CompressedPageFile::sync() {
+    std::lock_guard<std::mutex> sync_lock(sync_latch);
+
+    // Snapshot before syncing, so every extent the persisted table refers
+    // to is durable; pages written meanwhile wait for the next sync
+    std::vector<Extent> snapshot;
+    std::vector<Extent> releasable;
+    {
+        std::lock_guard<std::mutex> lock(latch);
+        snapshot = table;
+        releasable.swap(pending_free);
+    }
+    try {
+        if (fdatasync(file_descriptor) == -1) {
+            throw std::runtime_error("Failed to sync compressed pages");
+        }
+        persistTable(snapshot);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(latch);
+        pending_free.insert(pending_free.end(), releasable.begin(), releasable.end());
+        throw;
+    }
+
+    // The persisted table no longer refers to the replaced extents; reads
+    // that began before this may still do
+    std::lock_guard<std::mutex> lock(latch);
+    for (const Extent& extent : releasable) {
+        retired.emplace_back(read_epoch, extent);
+    }
+    read_epoch++;
+    releaseRetired();
+}
+
+void CompressedPageFile::persistTable(const std::vector<Extent>& snapshot) {
+    std::size_t bytes = snapshot.size() * sizeof(Extent);
+    TableHeader header = {TABLE_MAGIC, static_cast<uint32_t>(PAGE_SIZE), snapshot.size(),
+                          checksum(reinterpret_cast<const uint8_t*>(snapshot.data()), bytes), 0};
+
+    // Written aside and swapped in atomically, like a log truncation
+    std::string temp_name = table_filename + ".tmp";
+    int fd = open(temp_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1) {
+        throw std::runtime_error("Failed to open page table: " + temp_name);
+    }
+    bool ok = pwrite(fd, &header, sizeof(header), 0) == sizeof(header) &&
+              pwrite(fd, snapshot.data(), bytes, sizeof(header)) == static_cast<ssize_t>(bytes) &&
+              fdatasync(fd) == 0 &&
+              rename(temp_name.c_str(), table_filename.c_str()) == 0;
+    ::close(fd);
+    if (!ok) {
+        unlink(temp_name.c_str());
+        throw std::runtime_error("Failed to write page table: " + table_filename);
+    }
+    // Until the directory is synced a crash may bring back the old table
+    if (!IoBackend::syncDirectory(table_filename)) {
+        throw std::runtime_error("Failed to sync the directory of " + table_filename);
+    }
+}
+
+CompressedPageFile::Stats CompressedPageFile::getStats() {
+    std::lock_guard<std::mutex> lock(latch);
+    Stats result = stats;
+    result.file_bytes = file_end;
+    return result;
+}
@@ -0,0 +1,714 @@
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include "storage/encoded_page.hpp"
+#include "storage/pax_page.hpp"
+
+namespace {
+
+constexpr std::size_t DICTIONARY_SLOTS = 2 * EncodedPage::MAX_DICTIONARY;
+// Packed values are read with one 64-bit load, shifted by up to 7 bits
+constexpr uint8_t MAX_PACKED_BITS = 56;
+
+std::size_t alignUp(std::size_t offset) {
+    return (offset + EncodedPage::SEGMENT_ALIGNMENT - 1) & ~(EncodedPage::SEGMENT_ALIGNMENT - 1);
+}
+
+bool isIntegerWidth(std::size_t width) {
+    return width == 1 || width == 2 || width == 4 || width == 8;
+}
+
+uint8_t bitWidth(uint64_t value) {
+    return value == 0 ? 0 : static_cast<uint8_t>(64 - __builtin_clzll(value));
+}
+
+// Bytes for count packed values, with slack so the last one can be read
+// with a full 64-bit load
+std::size_t packedSize(std::size_t count, uint8_t bits) {
+    return bits == 0 ? 0 : (count * bits + 7) / 8 + 7;
+}
+
+uint64_t load64(const uint8_t* p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+// Fixed-size copies for the integer widths, which compile to single loads
+template <typename T>
+uint64_t loadAs(const uint8_t* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint64_t loadUnsigned(const uint8_t* p, std::size_t width) {
+    switch (width) {
+        case 1:
+            return *p;
+        case 2:
+            return loadAs<uint16_t>(p);
+        case 4:
+            return loadAs<uint32_t>(p);
+        case 8:
+            return loadAs<uint64_t>(p);
+        default: {
+            uint64_t value = 0;
+            std::memcpy(&value, p, std::min<std::size_t>(width, sizeof(value)));
+            return value;
+        }
+    }
+}
+
+bool sameValue(const uint8_t* a, const uint8_t* b, std::size_t width) {
+    if (isIntegerWidth(width)) {
+        return loadUnsigned(a, width) == loadUnsigned(b, width);
+    }
+    return std::memcmp(a, b, width) == 0;
+}
+
+int64_t signExtend(uint64_t value, std::size_t width) {
+    unsigned shift = 64 - 8 * static_cast<unsigned>(width);
+    return static_cast<int64_t>(value << shift) >> shift;
+}
+
+uint64_t unpack(const uint8_t* packed, std::size_t index, uint8_t bits) {
+    if (bits == 0) {
+        return 0;
+    }
+    std::size_t bit = index * bits;
+    return (load64(packed + bit / 8) >> (bit % 8)) & ((uint64_t{1} << bits) - 1);
+}
+
+// Unpack count consecutive values from index first on; the position
+// advances by addition, so the loop unrolls
+void unpackBlock(const uint8_t* packed, std::size_t first, std::size_t count, uint8_t bits, uint64_t* out) {
+    if (bits == 0) {
+        std::fill(out, out + count, 0);
+        return;
+    }
+    const uint64_t mask = (uint64_t{1} << bits) - 1;
+    std::size_t bit = first * bits;
+    for (std::size_t i = 0; i < count; i++, bit += bits) {
+        out[i] = (load64(packed + bit / 8) >> (bit % 8)) & mask;
+    }
+}
+
+// Decoding works through blocks of this many packed values
+constexpr std::size_t UNPACK_BLOCK = 64;
+
+// Frame-of-reference values of an integer column of type T
+template <typename T>
+void decodeFrame(const uint8_t* packed, std::size_t num_rows, uint8_t bits, uint64_t base, uint8_t* output) {
+    uint64_t block[UNPACK_BLOCK];
+    for (std::size_t first = 0; first < num_rows; first += UNPACK_BLOCK) {
+        std::size_t count = std::min(UNPACK_BLOCK, num_rows - first);
+        unpackBlock(packed, first, count, bits, block);
+        for (std::size_t i = 0; i < count; i++) {
+            T value = static_cast<T>(base + block[i]);
+            std::memcpy(output + (first + i) * sizeof(T), &value, sizeof(T));
+        }
+    }
+}
+
+// Dictionary entries of Width bytes looked up by packed code; Width 0
+// stands for any width, passed at run time
+template <std::size_t Width>
+void decodeDictionary(const uint8_t* entries, const uint8_t* codes, std::size_t num_rows, uint8_t bits,
+                      std::size_t width, uint8_t* output) {
+    if (Width != 0) {
+        width = Width;
+    }
+    uint64_t block[UNPACK_BLOCK];
+    for (std::size_t first = 0; first < num_rows; first += UNPACK_BLOCK) {
+        std::size_t count = std::min(UNPACK_BLOCK, num_rows - first);
+        unpackBlock(codes, first, count, bits, block);
+        for (std::size_t i = 0; i < count; i++) {
+            std::memcpy(output + (first + i) * width, entries + block[i] * width, Width != 0 ? Width : width);
+        }
+    }
+}
+
+// The target bytes start zeroed
+void pack(uint8_t* packed, std::size_t index, uint8_t bits, uint64_t value) {
+    std::size_t bit = index * bits;
+    uint64_t word = load64(packed + bit / 8) | value << (bit % 8);
+    std::memcpy(packed + bit / 8, &word, sizeof(word));
+}
+
+// Home slot of a value in a dictionary hash table
+std::size_t hashValue(const uint8_t* p, std::size_t size) {
+    uint64_t hash;
+    if (size <= sizeof(uint64_t)) {
+        hash = loadUnsigned(p, size) * 0x9e3779b97f4a7c15ull;
+    } else {
+        hash = 0xcbf29ce484222325ull;
+        for (std::size_t i = 0; i < size; i++) {
+            hash = (hash ^ p[i]) * 0x100000001b3ull;
+        }
+        hash *= 0x9e3779b97f4a7c15ull;
+    }
+    return static_cast<std::size_t>(hash >> 32) % DICTIONARY_SLOTS;
+}
+
+void clearTail(uint64_t* selection, std::size_t count) {
+    if (count % 64 != 0) {
+        selection[count / 64] &= (uint64_t{1} << (count % 64)) - 1;
+    }
+}
+
+void setRange(uint64_t* selection, std::size_t begin, std::size_t end) {
+    while (begin < end) {
+        std::size_t bit = begin % 64;
+        std::size_t n = std::min<std::size_t>(64 - bit, end - begin);
+        uint64_t mask = n == 64 ? ~uint64_t{0} : ((uint64_t{1} << n) - 1) << bit;
+        selection[begin / 64] |= mask;
+        begin += n;
+    }
+}
+
+// Chosen layout of one column for a given number of rows
+struct ColumnPlan {
+    EncodedPage::Encoding encoding;
+    std::size_t size;
+    uint8_t bits;
+    uint8_t domain;
+};
+
+} // namespace
+
+std::size_t EncodedPage::presenceOffset(std::size_t num_columns) {
+    return sizeof(SlottedPage::PageHeader) + sizeof(EncodedHeader) + num_columns * sizeof(ColumnInfo);
+}
+
+EncodedPage::Builder::Builder(const std::vector<uint16_t>& column_widths) : column_widths(column_widths) {
+    if (column_widths.empty() || column_widths.size() > PaxPage::MAX_COLUMNS) {
+        throw std::invalid_argument("PAX schema needs between 1 and " + std::to_string(PaxPage::MAX_COLUMNS) +
+                                    " columns");
+    }
+    // One row stored plain is the most a page ever needs for it
+    std::size_t end = presenceOffset(column_widths.size()) + 1;
+    for (uint16_t width : column_widths) {
+        if (width == 0) {
+            throw std::invalid_argument("PAX columns must be at least one byte wide");
+        }
+        end = alignUp(end) + width;
+        row_size += width;
+    }
+    if (end > SlottedPage::PAGE_SIZE - 1) {
+        throw std::invalid_argument("PAX record does not fit in an encoded page");
+    }
+
+    stats.resize(column_widths.size());
+    reset();
+}
+
+void EncodedPage::Builder::reset() {
+    num_rows = 0;
+    rows.clear();
+    for (std::size_t c = 0; c < stats.size(); c++) {
+        ColumnStats& column = stats[c];
+        column.width = column_widths[c];
+        column.runs = 0;
+        column.dictionary = true;
+        column.entries.clear();
+        column.num_entries = 0;
+        column.slots.assign(DICTIONARY_SLOTS, 0);
+        column.integer = isIntegerWidth(column.width);
+        column.unsigned_min = UINT64_MAX;
+        column.unsigned_max = 0;
+        column.signed_min = INT64_MAX;
+        column.signed_max = INT64_MIN;
+    }
+}
+
+namespace {
+
+// Size of each encoding of a column with the given statistics; the
+// smallest wins, PLAIN on ties
+template <typename Stats>
+ColumnPlan planColumn(const Stats& column, std::size_t num_rows, std::size_t runs, std::size_t entries,
+                      bool dictionary, uint64_t unsigned_min, uint64_t unsigned_max, int64_t signed_min,
+                      int64_t signed_max) {
+    ColumnPlan best{EncodedPage::Encoding::PLAIN, num_rows * column.width, 0, 0};
+
+    std::size_t rle = alignUp(runs * sizeof(uint16_t)) + runs * column.width;
+    if (rle < best.size) {
+        best = {EncodedPage::Encoding::RLE, rle, 0, 0};
+    }
+
+    if (dictionary) {
+        uint8_t bits = entries <= 1 ? 0 : bitWidth(entries - 1);
+        std::size_t size = alignUp(entries * column.width) + packedSize(num_rows, bits);
+        if (size < best.size) {
+            best = {EncodedPage::Encoding::DICTIONARY, size, bits, 0};
+        }
+    }
+
+    if (column.integer && num_rows > 0) {
+        uint64_t top = uint64_t{1} << (8 * column.width - 1);
+        uint64_t range = unsigned_max - unsigned_min;
+        uint8_t domain = EncodedPage::ANY;
+        if (!(unsigned_min & top) && (unsigned_max & top)) {
+            // Mixed signs: offsets follow whichever order spans less
+            uint64_t signed_range = static_cast<uint64_t>(signed_max) - static_cast<uint64_t>(signed_min);
+            domain = signed_range < range ? EncodedPage::SIGNED : EncodedPage::UNSIGNED;
+            range = std::min(range, signed_range);
+        }
+        uint8_t bits = bitWidth(range);
+        std::size_t size = sizeof(uint64_t) + packedSize(num_rows, bits);
+        if (bits <= MAX_PACKED_BITS && size < best.size) {
+            best = {EncodedPage::Encoding::FRAME_OF_REFERENCE, size, bits, domain};
+        }
+    }
+    return best;
+}
+
+} // namespace
+
+bool EncodedPage::Builder::add(const void* record) {
+    if (num_rows == MAX_ROWS) {
+        return false;
+    }
+
+    // Statistics of each column with the row, committed only if it fits
+    struct Pending {
+        std::size_t runs;
+        std::size_t entries;
+        bool dictionary;
+        uint16_t new_slot; // Dictionary slot of a new entry + 1, else 0
+        uint64_t unsigned_min, unsigned_max;
+        int64_t signed_min, signed_max;
+    };
+    Pending pending[PaxPage::MAX_COLUMNS];
+
+    const auto* input = static_cast<const uint8_t*>(record);
+    const uint8_t* previous = num_rows == 0 ? nullptr : rows.data() + (num_rows - 1) * row_size;
+    std::size_t rows_after = num_rows + 1;
+    std::size_t end = presenceOffset(column_widths.size()) + (rows_after + 7) / 8;
+
+    std::size_t field_offset = 0;
+    for (std::size_t c = 0; c < stats.size(); c++) {
+        const ColumnStats& column = stats[c];
+        const uint8_t* value = input + field_offset;
+        Pending& next = pending[c];
+        next = {column.runs, column.num_entries, column.dictionary, 0, column.unsigned_min, column.unsigned_max,
+                column.signed_min, column.signed_max};
+
+        if (previous == nullptr || !sameValue(previous + field_offset, value, column.width)) {
+            next.runs++;
+        }
+        if (next.dictionary) {
+            std::size_t slot = hashValue(value, column.width);
+            while (column.slots[slot] != 0 &&
+                   !sameValue(column.entries.data() + (column.slots[slot] - 1) * column.width, value, column.width)) {
+                slot = (slot + 1) % DICTIONARY_SLOTS;
+            }
+            if (column.slots[slot] == 0) {
+                next.entries++;
+                next.dictionary = next.entries <= MAX_DICTIONARY;
+                next.new_slot = static_cast<uint16_t>(slot + 1);
+            }
+        }
+        if (column.integer) {
+            uint64_t v = loadUnsigned(value, column.width);
+            int64_t s = signExtend(v, column.width);
+            next.unsigned_min = std::min(next.unsigned_min, v);
+            next.unsigned_max = std::max(next.unsigned_max, v);
+            next.signed_min = std::min(next.signed_min, s);
+            next.signed_max = std::max(next.signed_max, s);
+        }
+
+        ColumnPlan plan = planColumn(column, rows_after, next.runs, next.entries, next.dictionary,
+                                     next.unsigned_min, next.unsigned_max, next.signed_min, next.signed_max);
+        end = alignUp(end) + plan.size;
+        if (end > SlottedPage::PAGE_SIZE - 1) {
+            return false;
+        }
+        field_offset += column.width;
+    }
+
+    // The row fits: fold it into the statistics
+    field_offset = 0;
+    for (std::size_t c = 0; c < stats.size(); c++) {
+        ColumnStats& column = stats[c];
+        const Pending& next = pending[c];
+        column.runs = next.runs;
+        column.dictionary = next.dictionary;
+        if (next.dictionary && next.new_slot != 0) {
+            column.slots[next.new_slot - 1] = static_cast<uint16_t>(next.entries);
+            column.entries.insert(column.entries.end(), input + field_offset, input + field_offset + column.width);
+            column.num_entries = next.entries;
+        }
+        column.unsigned_min = next.unsigned_min;
+        column.unsigned_max = next.unsigned_max;
+        column.signed_min = next.signed_min;
+        column.signed_max = next.signed_max;
+        field_offset += column.width;
+    }
+    rows.insert(rows.end(), input, input + row_size);
+    num_rows++;
+    return true;
+}
+
+void EncodedPage::Builder::build(uint8_t* data) {
+    auto* header = reinterpret_cast<EncodedHeader*>(data + sizeof(SlottedPage::PageHeader));
+    header->num_columns = static_cast<uint16_t>(column_widths.size());
+    header->num_rows = static_cast<uint16_t>(num_rows);
+    header->live_rows = static_cast<uint16_t>(num_rows);
+    header->reserved = 0;
+
+    // Every row starts live; segments start zeroed for packing
+    std::size_t offset = presenceOffset(column_widths.size());
+    std::memset(data + offset, 0, SlottedPage::PAGE_SIZE - offset);
+    std::memset(data + offset, 0xff, num_rows / 8);
+    if (num_rows % 8 != 0) {
+        data[offset + num_rows / 8] = static_cast<uint8_t>((1u << (num_rows % 8)) - 1);
+    }
+    offset += (num_rows + 7) / 8;
+
+    auto* info = reinterpret_cast<ColumnInfo*>(header + 1);
+    std::size_t field_offset = 0;
+    for (std::size_t c = 0; c < stats.size(); c++) {
+        const ColumnStats& column = stats[c];
+        const std::size_t width = column.width;
+        ColumnPlan plan = planColumn(column, num_rows, column.runs, column.num_entries,
+                                     column.dictionary, column.unsigned_min, column.unsigned_max,
+                                     column.signed_min, column.signed_max);
+        offset = alignUp(offset);
+        uint8_t* segment = data + offset;
+        const uint8_t* field = rows.data() + field_offset;
+
+        ColumnInfo& out = info[c];
+        out = {static_cast<uint16_t>(offset), static_cast<uint16_t>(plan.size), column.width, 0, plan.encoding,
+               plan.bits, plan.domain, 0};
+
+        switch (plan.encoding) {
+            case Encoding::PLAIN:
+                for (std::size_t row = 0; row < num_rows; row++) {
+                    std::memcpy(segment + row * width, field + row * row_size, width);
+                }
+                break;
+            case Encoding::RLE: {
+                auto* ends = reinterpret_cast<uint16_t*>(segment);
+                uint8_t* values = segment + alignUp(column.runs * sizeof(uint16_t));
+                std::size_t run = 0;
+                for (std::size_t row = 0; row < num_rows; row++) {
+                    const uint8_t* value = field + row * row_size;
+                    if (row > 0 && std::memcmp(value, field + (row - 1) * row_size, width) != 0) {
+                        run++;
+                    }
+                    if (row == 0 || ends[run] == 0) {
+                        std::memcpy(values + run * width, value, width);
+                    }
+                    ends[run] = static_cast<uint16_t>(row + 1);
+                }
+                out.count = static_cast<uint16_t>(column.runs);
+                break;
+            }
+            case Encoding::DICTIONARY: {
+                std::size_t entries = column.num_entries;
+                std::memcpy(segment, column.entries.data(), column.entries.size());
+                uint8_t* codes = segment + alignUp(column.entries.size());
+                for (std::size_t row = 0; row < num_rows && plan.bits > 0; row++) {
+                    const uint8_t* value = field + row * row_size;
+                    std::size_t slot = hashValue(value, width);
+                    while (std::memcmp(column.entries.data() + (column.slots[slot] - 1) * width, value, width) != 0) {
+                        slot = (slot + 1) % DICTIONARY_SLOTS;
+                    }
+                    pack(codes, row, plan.bits, column.slots[slot] - 1u);
+                }
+                out.count = static_cast<uint16_t>(entries);
+                break;
+            }
+            case Encoding::FRAME_OF_REFERENCE: {
+                uint64_t base = plan.domain == SIGNED ? static_cast<uint64_t>(column.signed_min) : column.unsigned_min;
+                std::memcpy(segment, &base, sizeof(base));
+                uint8_t* offsets = segment + sizeof(base);
+                for (std::size_t row = 0; row < num_rows && plan.bits > 0; row++) {
+                    uint64_t v = loadUnsigned(field + row * row_size, width);
+                    if (plan.domain == SIGNED) {
+                        v = static_cast<uint64_t>(signExtend(v, width));
+                    }
+                    pack(offsets, row, plan.bits, v - base);
+                }
+                break;
+            }
+        }
+        offset += plan.size;
+        field_offset += width;
+    }
+    reset();
+}
+
+std::vector<uint16_t> EncodedPage::readColumnWidths(const uint8_t* data) {
+    EncodedPage page(const_cast<uint8_t*>(data));
+    std::vector<uint16_t> widths(page.getNumColumns());
+    for (std::size_t c = 0; c < widths.size(); c++) {
+        widths[c] = page.getColumnWidth(static_cast<uint16_t>(c));
+    }
+    return widths;
+}
+
+uint16_t EncodedPage::getRowSize() const {
+    uint16_t row_size = 0;
+    for (uint16_t c = 0; c < header()->num_columns; c++) {
+        row_size += columns()[c].width;
+    }
+    return row_size;
+}
+
+void EncodedPage::removeRow(uint16_t row) {
+    if (!isLive(row)) {
+        return;
+    }
+    presence()[row / 8] &= static_cast<uint8_t>(~(1u << (row % 8)));
+    header()->live_rows--;
+}
+
+void EncodedPage::readValue(const ColumnInfo& column, uint16_t row, uint8_t* out, std::size_t length) const {
+    const uint8_t* segment = data + column.offset;
+    switch (column.encoding) {
+        case Encoding::PLAIN:
+            std::memcpy(out, segment + static_cast<std::size_t>(row) * column.width, length);
+            break;
+        case Encoding::RLE: {
+            const auto* ends = reinterpret_cast<const uint16_t*>(segment);
+            std::size_t run = std::upper_bound(ends, ends + column.count, row) - ends;
+            const uint8_t* values = segment + alignUp(column.count * sizeof(uint16_t));
+            std::memcpy(out, values + run * column.width, length);
+            break;
+        }
+        case Encoding::DICTIONARY: {
+            uint64_t code = unpack(segment + alignUp(column.count * column.width), row, column.bits);
+            std::memcpy(out, segment + code * column.width, length);
+            break;
+        }
+        case Encoding::FRAME_OF_REFERENCE: {
+            uint64_t value = load64(segment) + unpack(segment + sizeof(uint64_t), row, column.bits);
+            std::memcpy(out, &value, length);
+            break;
+        }
+    }
+}
+
+uint16_t EncodedPage::readRow(uint16_t row, void* buffer, uint16_t size) const {
+    auto* output = static_cast<uint8_t*>(buffer);
+    uint16_t copied = 0;
+    for (uint16_t c = 0; c < header()->num_columns && copied < size; c++) {
+        const ColumnInfo& column = columns()[c];
+        uint16_t n = std::min<uint16_t>(column.width, size - copied);
+        readValue(column, row, output + copied, n);
+        copied += n;
+    }
+    return copied;
+}
+
+const uint8_t* EncodedPage::getPlainColumn(uint16_t column) const {
+    const ColumnInfo& info = columns()[column];
+    return info.encoding == Encoding::PLAIN ? data + info.offset : nullptr;
+}
+
+void EncodedPage::decodeColumn(uint16_t column, void* out) const {
+    const ColumnInfo& info = columns()[column];
+    const uint8_t* segment = data + info.offset;
+    const std::size_t width = info.width;
+    const std::size_t num_rows = header()->num_rows;
+    auto* output = static_cast<uint8_t*>(out);
+
+    switch (info.encoding) {
+        case Encoding::PLAIN:
+            std::memcpy(output, segment, num_rows * width);
+            break;
+        case Encoding::RLE: {
+            const auto* ends = reinterpret_cast<const uint16_t*>(segment);
+            const uint8_t* values = segment + alignUp(info.count * sizeof(uint16_t));
+            std::size_t row = 0;
+            for (std::size_t run = 0; run < info.count; run++) {
+                for (; row < ends[run]; row++) {
+                    std::memcpy(output + row * width, values + run * width, width);
+                }
+            }
+            break;
+        }
+        case Encoding::DICTIONARY: {
+            const uint8_t* codes = segment + alignUp(info.count * width);
+            switch (width) {
+                case 4:
+                    decodeDictionary<4>(segment, codes, num_rows, info.bits, width, output);
+                    break;
+                case 8:
+                    decodeDictionary<8>(segment, codes, num_rows, info.bits, width, output);
+                    break;
+                default:
+                    decodeDictionary<0>(segment, codes, num_rows, info.bits, width, output);
+                    break;
+            }
+            break;
+        }
+        case Encoding::FRAME_OF_REFERENCE: {
+            // Only integer widths are stored this way
+            uint64_t base = load64(segment);
+            const uint8_t* offsets = segment + sizeof(uint64_t);
+            switch (width) {
+                case 1:
+                    decodeFrame<uint8_t>(offsets, num_rows, info.bits, base, output);
+                    break;
+                case 2:
+                    decodeFrame<uint16_t>(offsets, num_rows, info.bits, base, output);
+                    break;
+                case 4:
+                    decodeFrame<uint32_t>(offsets, num_rows, info.bits, base, output);
+                    break;
+                default:
+                    decodeFrame<uint64_t>(offsets, num_rows, info.bits, base, output);
+                    break;
+            }
+            break;
+        }
+    }
+}
+
+void EncodedPage::compare(uint16_t column, const FilterKernels& kernels, FilterKernels::ColumnType type,
+                          FilterKernels::CompareOp op, const void* constant, uint64_t* selection) const {
+    const ColumnInfo& info = columns()[column];
+    if (FilterKernels::typeWidth(type) != info.width) {
+        throw std::invalid_argument("Column " + std::to_string(column) + " is not as wide as the compared type");
+    }
+    const uint8_t* segment = data + info.offset;
+    const std::size_t num_rows = header()->num_rows;
+    const std::size_t words = FilterKernels::selectionWords(num_rows);
+
+    switch (info.encoding) {
+        case Encoding::PLAIN:
+            kernels.compare(type, segment, num_rows, op, constant, selection);
+            break;
+        case Encoding::RLE: {
+            // One comparison per run, then whole runs of rows at once
+            uint64_t matches[FilterKernels::selectionWords(MAX_ROWS)];
+            kernels.compare(type, segment + alignUp(info.count * sizeof(uint16_t)), info.count, op, constant,
+                            matches);
+            const auto* ends = reinterpret_cast<const uint16_t*>(segment);
+            std::fill(selection, selection + words, 0);
+            for (std::size_t run = 0; run < info.count; run++) {
+                if (matches[run / 64] >> (run % 64) & 1) {
+                    setRange(selection, run == 0 ? 0 : ends[run - 1], ends[run]);
+                }
+            }
+            break;
+        }
+        case Encoding::DICTIONARY: {
+            // One comparison per entry, then a lookup per code
+            uint64_t matches[FilterKernels::selectionWords(MAX_DICTIONARY)];
+            kernels.compare(type, segment, info.count, op, constant, matches);
+            const uint8_t* codes = segment + alignUp(info.count * info.width);
+            uint64_t block[UNPACK_BLOCK];
+            for (std::size_t word = 0; word < words; word++) {
+                std::size_t count = std::min<std::size_t>(64, num_rows - word * 64);
+                unpackBlock(codes, word * 64, count, info.bits, block);
+                uint64_t bits = 0;
+                for (std::size_t i = 0; i < count; i++) {
+                    bits |= (matches[block[i] / 64] >> (block[i] % 64) & 1) << i;
+                }
+                selection[word] = bits;
+            }
+            break;
+        }
+        case Encoding::FRAME_OF_REFERENCE:
+            compareFrameOfReference(info, kernels, type, op, constant, selection);
+            break;
+    }
+}
+
+void EncodedPage::compareFrameOfReference(const ColumnInfo& column, const FilterKernels& kernels,
+                                          FilterKernels::ColumnType type, FilterKernels::CompareOp op,
+                                          const void* constant, uint64_t* selection) const {
+    using ColumnType = FilterKernels::ColumnType;
+    using CompareOp = FilterKernels::CompareOp;
+    const uint8_t* segment = data + column.offset;
+    const std::size_t num_rows = header()->num_rows;
+    const std::size_t words = FilterKernels::selectionWords(num_rows);
+
+    bool is_signed = type == ColumnType::INT32 || type == ColumnType::INT64;
+    if (type == ColumnType::FLOAT || type == ColumnType::DOUBLE ||
+        (column.domain == SIGNED && !is_signed) || (column.domain == UNSIGNED && is_signed)) {
+        // Offsets do not follow the order of the type: compare decoded values
+        std::vector<uint64_t> values(num_rows);
+        decodeColumn(static_cast<uint16_t>(&column - columns()), values.data());
+        kernels.compare(type, values.data(), num_rows, op, constant, selection);
+        return;
+    }
+
+    // value op constant is offset op (constant - base) with offsets in
+    // [0, 2^bits), so every predicate but NE selects one range of offsets
+    __int128 base;
+    __int128 target;
+    uint64_t raw_base = load64(segment);
+    if (is_signed) {
+        base = signExtend(raw_base, column.width);
+        if (type == ColumnType::INT32) {
+            int32_t c;
+            std::memcpy(&c, constant, sizeof(c));
+            target = c;
+        } else {
+            int64_t c;
+            std::memcpy(&c, constant, sizeof(c));
+            target = c;
+        }
+    } else {
+        base = raw_base;
+        uint32_t c;
+        std::memcpy(&c, constant, sizeof(c));
+        target = c;
+    }
+    __int128 k = target - base;
+    __int128 max_offset = (__int128{1} << column.bits) - 1;
+    __int128 lo = 0;
+    __int128 hi = max_offset;
+    switch (op) {
+        case CompareOp::EQ:
+        case CompareOp::NE:
+            lo = hi = k;
+            break;
+        case CompareOp::LT:
+            hi = k - 1;
+            break;
+        case CompareOp::LE:
+            hi = k;
+            break;
+        case CompareOp::GT:
+            lo = k + 1;
+            break;
+        case CompareOp::GE:
+            lo = k;
+            break;
+    }
+    lo = std::max<__int128>(lo, 0);
+    hi = std::min(hi, max_offset);
+
+    if (lo > hi) {
+        std::fill(selection, selection + words, 0);
+    } else if (lo == 0 && hi == max_offset) {
+        std::fill(selection, selection + words, ~uint64_t{0});
+    } else {
+        const uint8_t* offsets = segment + sizeof(uint64_t);
+        uint64_t low = static_cast<uint64_t>(lo);
+        uint64_t span = static_cast<uint64_t>(hi - lo);
+        uint64_t block[UNPACK_BLOCK];
+        for (std::size_t word = 0; word < words; word++) {
+            std::size_t count = std::min<std::size_t>(64, num_rows - word * 64);
+            unpackBlock(offsets, word * 64, count, column.bits, block);
+            uint64_t bits = 0;
+            for (std::size_t i = 0; i < count; i++) {
+                bits |= static_cast<uint64_t>(block[i] - low <= span) << i;
+            }
+            selection[word] = bits;
+        }
+    }
+    if (op == CompareOp::NE) {
+        for (std::size_t word = 0; word < words; word++) {
+            selection[word] = ~selection[word];
+        }
+    }
+    clearTail(selection, num_rows);
+}
@@ -0,0 +1,893 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+#include "storage/filter_kernels.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FILTER_KERNELS_X86 1
+// Vector code is compiled per function, so the rest of the binary keeps
+// the baseline instruction set and runs on any CPU
+#define TARGET_AVX2 __attribute__((target("avx2,popcnt")))
+#define TARGET_SSE42 __attribute__((target("sse4.2,popcnt")))
+#endif
+
+namespace {
+
+using ColumnType = FilterKernels::ColumnType;
+using CompareOp = FilterKernels::CompareOp;
+using Aggregate = FilterKernels::Aggregate;
+
+constexpr std::size_t WORD_ROWS = 64;
+
+template <CompareOp OP, typename T>
+bool test(T value, T constant) {
+    if constexpr (OP == CompareOp::EQ) {
+        return value == constant;
+    } else if constexpr (OP == CompareOp::NE) {
+        return value != constant;
+    } else if constexpr (OP == CompareOp::LT) {
+        return value < constant;
+    } else if constexpr (OP == CompareOp::LE) {
+        return value <= constant;
+    } else if constexpr (OP == CompareOp::GT) {
+        return value > constant;
+    } else {
+        return value >= constant;
+    }
+}
+
+template <typename T>
+void foldValue(Aggregate& result, T value) {
+    if constexpr (std::is_integral_v<T>) {
+        result.int_sum += static_cast<int64_t>(value);
+        result.int_min = std::min(result.int_min, static_cast<int64_t>(value));
+        result.int_max = std::max(result.int_max, static_cast<int64_t>(value));
+    } else {
+        result.fp_sum += value;
+        // NaNs take no part in MIN and MAX
+        if (value < result.fp_min) {
+            result.fp_min = value;
+        }
+        if (value > result.fp_max) {
+            result.fp_max = value;
+        }
+    }
+}
+
+// Scalar code for rows [first, count). Also finishes the rows behind the
+// vector kernels, whose bits of a shared word are already set.
+template <typename T, CompareOp OP>
+void compareRows(const T* values, std::size_t first, std::size_t count, T constant, uint64_t* selection) {
+    std::size_t row = first;
+    while (row < count) {
+        std::size_t word = row / WORD_ROWS;
+        std::size_t end = std::min(count, (word + 1) * WORD_ROWS);
+        uint64_t bits = row % WORD_ROWS != 0 ? selection[word] : 0;
+        for (; row < end; row++) {
+            bits |= static_cast<uint64_t>(test<OP>(values[row], constant)) << (row % WORD_ROWS);
+        }
+        selection[word] = bits;
+    }
+}
+
+template <typename T>
+void aggregateRows(const T* values, std::size_t first, std::size_t count, const uint64_t* selection,
+                   Aggregate& result) {
+    for (std::size_t word = first / WORD_ROWS; word * WORD_ROWS < count; word++) {
+        std::size_t base = word * WORD_ROWS;
+        uint64_t bits = selection[word];
+        if (count - base < WORD_ROWS) {
+            bits &= (uint64_t{1} << (count - base)) - 1;
+        }
+        if (first > base) {
+            bits &= ~uint64_t{0} << (first - base);
+        }
+        result.count += __builtin_popcountll(bits);
+        while (bits != 0) {
+            foldValue(result, values[base + __builtin_ctzll(bits)]);
+            bits &= bits - 1;
+        }
+    }
+}
+
+template <typename T, CompareOp OP>
+struct ScalarCompare {
+    static void run(const T* values, std::size_t count, T constant, uint64_t* selection) {
+        compareRows<T, OP>(values, 0, count, constant, selection);
+    }
+};
+
+template <typename T>
+struct ScalarAggregate {
+    static void run(const T* values, std::size_t count, const uint64_t* selection, Aggregate& result) {
+        aggregateRows(values, 0, count, selection, result);
+    }
+};
+
+#ifdef FILTER_KERNELS_X86
+
+// Per-type lane operations. Each ISA gets its own set so that no function
+// compiled for a wider ISA is ever reached from a narrower one.
+//
+//   splat, load       broadcast a constant, load LANES values
+//   eq, gt            lane comparisons as a LANES-bit mask (integer types)
+//   cmp<OP>           the same for any operator (floating-point types)
+//   mask              lanes whose bit is set, as a vector mask
+//   start, add, finish  running SUM, MIN and MAX of masked lanes
+
+template <typename T>
+struct Avx2Lanes;
+
+template <>
+struct Avx2Lanes<int32_t> {
+    using Vec = __m256i;
+    static constexpr std::size_t LANES = 8;
+    struct Acc {
+        __m256i sum_low, sum_high, min, max;
+    };
+
+    TARGET_AVX2 static Vec splat(int32_t value) { return _mm256_set1_epi32(value); }
+    TARGET_AVX2 static Vec load(const int32_t* values) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values));
+    }
+    TARGET_AVX2 static unsigned eq(Vec a, Vec b) {
+        return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)));
+    }
+    TARGET_AVX2 static unsigned gt(Vec a, Vec b) {
+        return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(a, b)));
+    }
+    TARGET_AVX2 static Vec mask(unsigned bits) {
+        const __m256i lane_bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+        return _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(static_cast<int>(bits)), lane_bits), lane_bits);
+    }
+    TARGET_AVX2 static Acc start() {
+        return {_mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_set1_epi32(INT32_MAX),
+                _mm256_set1_epi32(INT32_MIN)};
+    }
+    TARGET_AVX2 static void add(Acc& acc, Vec values, Vec mask) {
+        __m256i selected = _mm256_and_si256(values, mask);
+        acc.sum_low = _mm256_add_epi64(acc.sum_low, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(selected)));
+        acc.sum_high = _mm256_add_epi64(acc.sum_high, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(selected, 1)));
+        acc.min = _mm256_min_epi32(acc.min, _mm256_blendv_epi8(_mm256_set1_epi32(INT32_MAX), values, mask));
+        acc.max = _mm256_max_epi32(acc.max, _mm256_blendv_epi8(_mm256_set1_epi32(INT32_MIN), values, mask));
+    }
+    TARGET_AVX2 static void finish(const Acc& acc, Aggregate& result) {
+        alignas(32) int64_t sums[4];
+        alignas(32) int32_t mins[8], maxs[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(sums), _mm256_add_epi64(acc.sum_low, acc.sum_high));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(mins), acc.min);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(maxs), acc.max);
+        for (std::size_t i = 0; i < 4; i++) {
+            result.int_sum += sums[i];
+        }
+        for (std::size_t i = 0; i < 8; i++) {
+            result.int_min = std::min<int64_t>(result.int_min, mins[i]);
+            result.int_max = std::max<int64_t>(result.int_max, maxs[i]);
+        }
+    }
+};
+
+template <>
+struct Avx2Lanes<uint32_t> {
+    using Vec = __m256i;
+    static constexpr std::size_t LANES = 8;
+    struct Acc {
+        __m256i sum_low, sum_high, min, max;
+    };
+
+    TARGET_AVX2 static Vec splat(uint32_t value) { return _mm256_set1_epi32(static_cast<int>(value)); }
+    TARGET_AVX2 static Vec load(const uint32_t* values) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values));
+    }
+    TARGET_AVX2 static unsigned eq(Vec a, Vec b) {
+        return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b)));
+    }
+    TARGET_AVX2 static unsigned gt(Vec a, Vec b) {
+        // Flipping the sign bit turns an unsigned order into a signed one
+        const __m256i sign = _mm256_set1_epi32(INT32_MIN);
+        return _mm256_movemask_ps(_mm256_castsi256_ps(
+            _mm256_cmpgt_epi32(_mm256_xor_si256(a, sign), _mm256_xor_si256(b, sign))));
+    }
+    TARGET_AVX2 static Vec mask(unsigned bits) { return Avx2Lanes<int32_t>::mask(bits); }
+    TARGET_AVX2 static Acc start() {
+        return {_mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_set1_epi32(-1), _mm256_setzero_si256()};
+    }
+    TARGET_AVX2 static void add(Acc& acc, Vec values, Vec mask) {
+        __m256i selected = _mm256_and_si256(values, mask);
+        acc.sum_low = _mm256_add_epi64(acc.sum_low, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(selected)));
+        acc.sum_high = _mm256_add_epi64(acc.sum_high, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(selected, 1)));
+        acc.min = _mm256_min_epu32(acc.min, _mm256_or_si256(selected, _mm256_andnot_si256(mask, _mm256_set1_epi32(-1))));
+        acc.max = _mm256_max_epu32(acc.max, selected);
+    }
+    TARGET_AVX2 static void finish(const Acc& acc, Aggregate& result) {
+        alignas(32) int64_t sums[4];
+        alignas(32) uint32_t mins[8], maxs[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(sums), _mm256_add_epi64(acc.sum_low, acc.sum_high));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(mins), acc.min);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(maxs), acc.max);
+        for (std::size_t i = 0; i < 4; i++) {
+            result.int_sum += sums[i];
+        }
+        for (std::size_t i = 0; i < 8; i++) {
+            result.int_min = std::min<int64_t>(result.int_min, mins[i]);
+            result.int_max = std::max<int64_t>(result.int_max, maxs[i]);
+        }
+    }
+};
+
+template <>
+struct Avx2Lanes<int64_t> {
+    using Vec = __m256i;
+    static constexpr std::size_t LANES = 4;
+    struct Acc {
+        __m256i sum, min, max;
+    };
+
+    TARGET_AVX2 static Vec splat(int64_t value) { return _mm256_set1_epi64x(value); }
+    TARGET_AVX2 static Vec load(const int64_t* values) {
+        return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values));
+    }
+    TARGET_AVX2 static unsigned eq(Vec a, Vec b) {
+        return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(a, b)));
+    }
+    TARGET_AVX2 static unsigned gt(Vec a, Vec b) {
+        return _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(a, b)));
+    }
+    TARGET_AVX2 static Vec mask(unsigned bits) {
+        const __m256i lane_bits = _mm256_setr_epi64x(1, 2, 4, 8);
+        return _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(bits), lane_bits), lane_bits);
+    }
+    TARGET_AVX2 static Acc start() {
+        return {_mm256_setzero_si256(), _mm256_set1_epi64x(INT64_MAX), _mm256_set1_epi64x(INT64_MIN)};
+    }
+    TARGET_AVX2 static void add(Acc& acc, Vec values, Vec mask) {
+        // AVX2 has no 64-bit min or max, so compare and blend
+        acc.sum = _mm256_add_epi64(acc.sum, _mm256_and_si256(values, mask));
+        __m256i low = _mm256_blendv_epi8(_mm256_set1_epi64x(INT64_MAX), values, mask);
+        __m256i high = _mm256_blendv_epi8(_mm256_set1_epi64x(INT64_MIN), values, mask);
+        acc.min = _mm256_blendv_epi8(acc.min, low, _mm256_cmpgt_epi64(acc.min, low));
+        acc.max = _mm256_blendv_epi8(acc.max, high, _mm256_cmpgt_epi64(high, acc.max));
+    }
+    TARGET_AVX2 static void finish(const Acc& acc, Aggregate& result) {
+        alignas(32) int64_t sums[4], mins[4], maxs[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(sums), acc.sum);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(mins), acc.min);
+        _mm256_store_si256(reinterpret_cast<__m256i*>(maxs), acc.max);
+        for (std::size_t i = 0; i < 4; i++) {
+            result.int_sum += sums[i];
+            result.int_min = std::min(result.int_min, mins[i]);
+            result.int_max = std::max(result.int_max, maxs[i]);
+        }
+    }
+};
+
+template <CompareOp OP>
+constexpr int floatPredicate() {
+    // Ordered predicates are false for NaN; NE is unordered, true for NaN
+    switch (OP) {
+        case CompareOp::EQ: return _CMP_EQ_OQ;
+        case CompareOp::NE: return _CMP_NEQ_UQ;
+        case CompareOp::LT: return _CMP_LT_OQ;
+        case CompareOp::LE: return _CMP_LE_OQ;
+        case CompareOp::GT: return _CMP_GT_OQ;
+        case CompareOp::GE: return _CMP_GE_OQ;
+    }
+    return _CMP_EQ_OQ;
+}
+
+template <>
+struct Avx2Lanes<float> {
+    using Vec = __m256;
+    static constexpr std::size_t LANES = 8;
+    struct Acc {
+        __m256d sum_low, sum_high;
+        __m256 min, max;
+    };
+
+    TARGET_AVX2 static Vec splat(float value) { return _mm256_set1_ps(value); }
+    TARGET_AVX2 static Vec load(const float* values) { return _mm256_loadu_ps(values); }
+    template <CompareOp OP>
+    TARGET_AVX2 static unsigned cmp(Vec a, Vec b) {
+        constexpr int PREDICATE = floatPredicate<OP>();
+        return _mm256_movemask_ps(_mm256_cmp_ps(a, b, PREDICATE));
+    }
+    TARGET_AVX2 static Vec mask(unsigned bits) { return _mm256_castsi256_ps(Avx2Lanes<int32_t>::mask(bits)); }
+    TARGET_AVX2 static Acc start() {
+        return {_mm256_setzero_pd(), _mm256_setzero_pd(), _mm256_set1_ps(INFINITY), _mm256_set1_ps(-INFINITY)};
+    }
+    TARGET_AVX2 static void add(Acc& acc, Vec values, Vec mask) {
+        // Sums are kept in double precision, as the scalar code does
+        __m256 selected = _mm256_and_ps(values, mask);
+        acc.sum_low = _mm256_add_pd(acc.sum_low, _mm256_cvtps_pd(_mm256_castps256_ps128(selected)));
+        acc.sum_high = _mm256_add_pd(acc.sum_high, _mm256_cvtps_pd(_mm256_extractf128_ps(selected, 1)));
+        // minps returns its second operand when either is NaN, which keeps NaNs out
+        acc.min = _mm256_min_ps(_mm256_blendv_ps(_mm256_set1_ps(INFINITY), values, mask), acc.min);
+        acc.max = _mm256_max_ps(_mm256_blendv_ps(_mm256_set1_ps(-INFINITY), values, mask), acc.max);
+    }
+    TARGET_AVX2 static void finish(const Acc& acc, Aggregate& result) {
+        alignas(32) double sums[4];
+        alignas(32) float mins[8], maxs[8];
+        _mm256_store_pd(sums, _mm256_add_pd(acc.sum_low, acc.sum_high));
+        _mm256_store_ps(mins, acc.min);
+        _mm256_store_ps(maxs, acc.max);
+        result.fp_sum += (sums[0] + sums[1]) + (sums[2] + sums[3]);
+        for (std::size_t i = 0; i < 8; i++) {
+            result.fp_min = std::min<double>(result.fp_min, mins[i]);
+            result.fp_max = std::max<double>(result.fp_max, maxs[i]);
+        }
+    }
+};
+
+template <>
+struct Avx2Lanes<double> {
+    using Vec = __m256d;
+    static constexpr std::size_t LANES = 4;
+    struct Acc {
+        __m256d sum, min, max;
+    };
+
+    TARGET_AVX2 static Vec splat(double value) { return _mm256_set1_pd(value); }
+    TARGET_AVX2 static Vec load(const double* values) { return _mm256_loadu_pd(values); }
+    template <CompareOp OP>
+    TARGET_AVX2 static unsigned cmp(Vec a, Vec b) {
+        constexpr int PREDICATE = floatPredicate<OP>();
+        return _mm256_movemask_pd(_mm256_cmp_pd(a, b, PREDICATE));
+    }
+    TARGET_AVX2 static Vec mask(unsigned bits) { return _mm256_castsi256_pd(Avx2Lanes<int64_t>::mask(bits)); }
+    TARGET_AVX2 static Acc start() {
+        return {_mm256_setzero_pd(), _mm256_set1_pd(INFINITY), _mm256_set1_pd(-INFINITY)};
+    }
+    TARGET_AVX2 static void add(Acc& acc, Vec values, Vec mask) {
+        acc.sum = _mm256_add_pd(acc.sum, _mm256_and_pd(values, mask));
+        acc.min = _mm256_min_pd(_mm256_blendv_pd(_mm256_set1_pd(INFINITY), values, mask), acc.min);
+        acc.max = _mm256_max_pd(_mm256_blendv_pd(_mm256_set1_pd(-INFINITY), values, mask), acc.max);
+    }
+    TARGET_AVX2 static void finish(const Acc& acc, Aggregate& result) {
+        alignas(32) double sums[4], mins[4], maxs[4];
+        _mm256_store_pd(sums, acc.sum);
+        _mm256_store_pd(mins, acc.min);
+        _mm256_store_pd(maxs, acc.max);
+        result.fp_sum += (sums[0] + sums[1]) + (sums[2] + sums[3]);
+        for (std::size_t i = 0; i < 4; i++) {
+            result.fp_min = std::min(result.fp_min, mins[i]);
+            result.fp_max = std::max(result.fp_max, maxs[i]);
+        }
+    }
+};
+
+template <typename T, CompareOp OP>
+struct Avx2Compare {
+    using Lanes = Avx2Lanes<T>;
+
+    TARGET_AVX2 static unsigned compareLanes(typename Lanes::Vec a, typename Lanes::Vec b) {
+        constexpr unsigned ALL = (1u << Lanes::LANES) - 1;
+        if constexpr (std::is_floating_point_v<T>) {
+            return Lanes::template cmp<OP>(a, b);
+        } else if constexpr (OP == CompareOp::EQ) {
+            return Lanes::eq(a, b);
+        } else if constexpr (OP == CompareOp::NE) {
+            return ~Lanes::eq(a, b) & ALL;
+        } else if constexpr (OP == CompareOp::LT) {
+            return Lanes::gt(b, a);
+        } else if constexpr (OP == CompareOp::LE) {
+            return ~Lanes::gt(a, b) & ALL;
+        } else if constexpr (OP == CompareOp::GT) {
+            return Lanes::gt(a, b);
+        } else {
+            return ~Lanes::gt(b, a) & ALL;
+        }
+    }
+
+    TARGET_AVX2 static void run(const T* values, std::size_t count, T constant, uint64_t* selection) {
+        // Whole vectors as far as they go, including into a partial last
+        // word; pages often hold fewer than 64 rows
+        auto splat = Lanes::splat(constant);
+        std::size_t vector_rows = count - count % Lanes::LANES;
+        for (std::size_t base = 0; base < vector_rows; base += WORD_ROWS) {
+            std::size_t rows = std::min(WORD_ROWS, vector_rows - base);
+            uint64_t bits = 0;
+            for (std::size_t i = 0; i < rows; i += Lanes::LANES) {
+                bits |= static_cast<uint64_t>(compareLanes(Lanes::load(values + base + i), splat)) << i;
+            }
+            selection[base / WORD_ROWS] = bits;
+        }
+        compareRows<T, OP>(values, vector_rows, count, constant, selection);
+    }
+};
+
+template <typename T>
+struct Avx2Aggregate {
+    using Lanes = Avx2Lanes<T>;
+
+    TARGET_AVX2 static void run(const T* values, std::size_t count, const uint64_t* selection, Aggregate& result) {
+        constexpr unsigned ALL = (1u << Lanes::LANES) - 1;
+        typename Lanes::Acc acc = Lanes::start();
+        std::size_t vector_rows = count - count % Lanes::LANES;
+        uint64_t selected = 0;
+        for (std::size_t base = 0; base < vector_rows; base += WORD_ROWS) {
+            std::size_t rows = std::min(WORD_ROWS, vector_rows - base);
+            uint64_t bits = selection[base / WORD_ROWS];
+            if (rows < WORD_ROWS) {
+                bits &= (uint64_t{1} << rows) - 1;
+            }
+            if (bits == 0) {
+                continue;
+            }
+            selected += __builtin_popcountll(bits);
+            for (std::size_t i = 0; i < rows; i += Lanes::LANES) {
+                unsigned lane_bits = static_cast<unsigned>(bits >> i) & ALL;
+                if (lane_bits != 0) {
+                    Lanes::add(acc, Lanes::load(values + base + i), Lanes::mask(lane_bits));
+                }
+            }
+        }
+        if (selected > 0) {
+            Lanes::finish(acc, result);
+            result.count += selected;
+        }
+        aggregateRows(values, vector_rows, count, selection, result);
+    }
+};
+
+template <typename T>
+struct Sse42Lanes;
+
+template <>
+struct Sse42Lanes<int32_t> {
+    using Vec = __m128i;
+    static constexpr std::size_t LANES = 4;
+    struct Acc {
+        __m128i sum_low, sum_high, min, max;
+    };
+
+    TARGET_SSE42 static Vec splat(int32_t value) { return _mm_set1_epi32(value); }
+    TARGET_SSE42 static Vec load(const int32_t* values) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+    }
+    TARGET_SSE42 static unsigned eq(Vec a, Vec b) {
+        return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, b)));
+    }
+    TARGET_SSE42 static unsigned gt(Vec a, Vec b) {
+        return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(a, b)));
+    }
+    TARGET_SSE42 static Vec mask(unsigned bits) {
+        const __m128i lane_bits = _mm_setr_epi32(1, 2, 4, 8);
+        return _mm_cmpeq_epi32(_mm_and_si128(_mm_set1_epi32(static_cast<int>(bits)), lane_bits), lane_bits);
+    }
+    TARGET_SSE42 static Acc start() {
+        return {_mm_setzero_si128(), _mm_setzero_si128(), _mm_set1_epi32(INT32_MAX), _mm_set1_epi32(INT32_MIN)};
+    }
+    TARGET_SSE42 static void add(Acc& acc, Vec values, Vec mask) {
+        __m128i selected = _mm_and_si128(values, mask);
+        acc.sum_low = _mm_add_epi64(acc.sum_low, _mm_cvtepi32_epi64(selected));
+        acc.sum_high = _mm_add_epi64(acc.sum_high, _mm_cvtepi32_epi64(_mm_srli_si128(selected, 8)));
+        acc.min = _mm_min_epi32(acc.min, _mm_blendv_epi8(_mm_set1_epi32(INT32_MAX), values, mask));
+        acc.max = _mm_max_epi32(acc.max, _mm_blendv_epi8(_mm_set1_epi32(INT32_MIN), values, mask));
+    }
+    TARGET_SSE42 static void finish(const Acc& acc, Aggregate& result) {
+        alignas(16) int64_t sums[2];
+        alignas(16) int32_t mins[4], maxs[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(sums), _mm_add_epi64(acc.sum_low, acc.sum_high));
+        _mm_store_si128(reinterpret_cast<__m128i*>(mins), acc.min);
+        _mm_store_si128(reinterpret_cast<__m128i*>(maxs), acc.max);
+        result.int_sum += sums[0] + sums[1];
+        for (std::size_t i = 0; i < 4; i++) {
+            result.int_min = std::min<int64_t>(result.int_min, mins[i]);
+            result.int_max = std::max<int64_t>(result.int_max, maxs[i]);
+        }
+    }
+};
+
+template <>
+struct Sse42Lanes<uint32_t> {
+    using Vec = __m128i;
+    static constexpr std::size_t LANES = 4;
+    struct Acc {
+        __m128i sum_low, sum_high, min, max;
+    };
+
+    TARGET_SSE42 static Vec splat(uint32_t value) { return _mm_set1_epi32(static_cast<int>(value)); }
+    TARGET_SSE42 static Vec load(const uint32_t* values) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+    }
+    TARGET_SSE42 static unsigned eq(Vec a, Vec b) {
+        return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, b)));
+    }
+    TARGET_SSE42 static unsigned gt(Vec a, Vec b) {
+        const __m128i sign = _mm_set1_epi32(INT32_MIN);
+        return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(_mm_xor_si128(a, sign), _mm_xor_si128(b, sign))));
+    }
+    TARGET_SSE42 static Vec mask(unsigned bits) { return Sse42Lanes<int32_t>::mask(bits); }
+    TARGET_SSE42 static Acc start() {
+        return {_mm_setzero_si128(), _mm_setzero_si128(), _mm_set1_epi32(-1), _mm_setzero_si128()};
+    }
+    TARGET_SSE42 static void add(Acc& acc, Vec values, Vec mask) {
+        __m128i selected = _mm_and_si128(values, mask);
+        acc.sum_low = _mm_add_epi64(acc.sum_low, _mm_cvtepu32_epi64(selected));
+        acc.sum_high = _mm_add_epi64(acc.sum_high, _mm_cvtepu32_epi64(_mm_srli_si128(selected, 8)));
+        acc.min = _mm_min_epu32(acc.min, _mm_or_si128(selected, _mm_andnot_si128(mask, _mm_set1_epi32(-1))));
+        acc.max = _mm_max_epu32(acc.max, selected);
+    }
+    TARGET_SSE42 static void finish(const Acc& acc, Aggregate& result) {
+        alignas(16) int64_t sums[2];
+        alignas(16) uint32_t mins[4], maxs[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(sums), _mm_add_epi64(acc.sum_low, acc.sum_high));
+        _mm_store_si128(reinterpret_cast<__m128i*>(mins), acc.min);
+        _mm_store_si128(reinterpret_cast<__m128i*>(maxs), acc.max);
+        result.int_sum += sums[0] + sums[1];
+        for (std::size_t i = 0; i < 4; i++) {
+            result.int_min = std::min<int64_t>(result.int_min, mins[i]);
+            result.int_max = std::max<int64_t>(result.int_max, maxs[i]);
+        }
+    }
+};
+
+template <>
+struct Sse42Lanes<int64_t> {
+    using Vec = __m128i;
+    static constexpr std::size_t LANES = 2;
+    struct Acc {
+        __m128i sum, min, max;
+    };
+
+    TARGET_SSE42 static Vec splat(int64_t value) { return _mm_set1_epi64x(value); }
+    TARGET_SSE42 static Vec load(const int64_t* values) {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+    }
+    TARGET_SSE42 static unsigned eq(Vec a, Vec b) {
+        return _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(a, b)));
+    }
+    TARGET_SSE42 static unsigned gt(Vec a, Vec b) {
+        return _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(a, b)));
+    }
+    TARGET_SSE42 static Vec mask(unsigned bits) {
+        const __m128i lane_bits = _mm_set_epi64x(2, 1);
+        return _mm_cmpeq_epi64(_mm_and_si128(_mm_set1_epi64x(bits), lane_bits), lane_bits);
+    }
+    TARGET_SSE42 static Acc start() {
+        return {_mm_setzero_si128(), _mm_set1_epi64x(INT64_MAX), _mm_set1_epi64x(INT64_MIN)};
+    }
+    TARGET_SSE42 static void add(Acc& acc, Vec values, Vec mask) {
+        acc.sum = _mm_add_epi64(acc.sum, _mm_and_si128(values, mask));
+        __m128i low = _mm_blendv_epi8(_mm_set1_epi64x(INT64_MAX), values, mask);
+        __m128i high = _mm_blendv_epi8(_mm_set1_epi64x(INT64_MIN), values, mask);
+        acc.min = _mm_blendv_epi8(acc.min, low, _mm_cmpgt_epi64(acc.min, low));
+        acc.max = _mm_blendv_epi8(acc.max, high, _mm_cmpgt_epi64(high, acc.max));
+    }
+    TARGET_SSE42 static void finish(const Acc& acc, Aggregate& result) {
+        alignas(16) int64_t sums[2], mins[2], maxs[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(sums), acc.sum);
+        _mm_store_si128(reinterpret_cast<__m128i*>(mins), acc.min);
+        _mm_store_si128(reinterpret_cast<__m128i*>(maxs), acc.max);
+        for (std::size_t i = 0; i < 2; i++) {
+            result.int_sum += sums[i];
+            result.int_min = std::min(result.int_min, mins[i]);
+            result.int_max = std::max(result.int_max, maxs[i]);
+        }
+    }
+};
+
+template <>
+struct Sse42Lanes<float> {
+    using Vec = __m128;
+    static constexpr std::size_t LANES = 4;
+    struct Acc {
+        __m128d sum_low, sum_high;
+        __m128 min, max;
+    };
+
+    TARGET_SSE42 static Vec splat(float value) { return _mm_set1_ps(value); }
+    TARGET_SSE42 static Vec load(const float* values) { return _mm_loadu_ps(values); }
+    template <CompareOp OP>
+    TARGET_SSE42 static unsigned cmp(Vec a, Vec b) {
+        // cmpneq is unordered and the rest ordered, as with AVX
+        if constexpr (OP == CompareOp::EQ) {
+            return _mm_movemask_ps(_mm_cmpeq_ps(a, b));
+        } else if constexpr (OP == CompareOp::NE) {
+            return _mm_movemask_ps(_mm_cmpneq_ps(a, b));
+        } else if constexpr (OP == CompareOp::LT) {
+            return _mm_movemask_ps(_mm_cmplt_ps(a, b));
+        } else if constexpr (OP == CompareOp::LE) {
+            return _mm_movemask_ps(_mm_cmple_ps(a, b));
+        } else if constexpr (OP == CompareOp::GT) {
+            return _mm_movemask_ps(_mm_cmpgt_ps(a, b));
+        } else {
+            return _mm_movemask_ps(_mm_cmpge_ps(a, b));
+        }
+    }
+    TARGET_SSE42 static Vec mask(unsigned bits) { return _mm_castsi128_ps(Sse42Lanes<int32_t>::mask(bits)); }
+    TARGET_SSE42 static Acc start() {
+        return {_mm_setzero_pd(), _mm_setzero_pd(), _mm_set1_ps(INFINITY), _mm_set1_ps(-INFINITY)};
+    }
+    TARGET_SSE42 static void add(Acc& acc, Vec values, Vec mask) {
+        __m128 selected = _mm_and_ps(values, mask);
+        acc.sum_low = _mm_add_pd(acc.sum_low, _mm_cvtps_pd(selected));
+        acc.sum_high = _mm_add_pd(acc.sum_high, _mm_cvtps_pd(_mm_movehl_ps(selected, selected)));
+        acc.min = _mm_min_ps(_mm_blendv_ps(_mm_set1_ps(INFINITY), values, mask), acc.min);
+        acc.max = _mm_max_ps(_mm_blendv_ps(_mm_set1_ps(-INFINITY), values, mask), acc.max);
+    }
+    TARGET_SSE42 static void finish(const Acc& acc, Aggregate& result) {
+        alignas(16) double sums[2];
+        alignas(16) float mins[4], maxs[4];
+        _mm_store_pd(sums, _mm_add_pd(acc.sum_low, acc.sum_high));
+        _mm_store_ps(mins, acc.min);
+        _mm_store_ps(maxs, acc.max);
+        result.fp_sum += sums[0] + sums[1];
+        for (std::size_t i = 0; i < 4; i++) {
+            result.fp_min = std::min<double>(result.fp_min, mins[i]);
+            result.fp_max = std::max<double>(result.fp_max, maxs[i]);
+        }
+    }
+};
+
+template <>
+struct Sse42Lanes<double> {
+    using Vec = __m128d;
+    static constexpr std::size_t LANES = 2;
+    struct Acc {
+        __m128d sum, min, max;
+    };
+
+    TARGET_SSE42 static Vec splat(double value) { return _mm_set1_pd(value); }
+    TARGET_SSE42 static Vec load(const double* values) { return _mm_loadu_pd(values); }
+    template <CompareOp OP>
+    TARGET_SSE42 static unsigned cmp(Vec a, Vec b) {
+        if constexpr (OP == CompareOp::EQ) {
+            return _mm_movemask_pd(_mm_cmpeq_pd(a, b));
+        } else if constexpr (OP == CompareOp::NE) {
+            return _mm_movemask_pd(_mm_cmpneq_pd(a, b));
+        } else if constexpr (OP == CompareOp::LT) {
+            return _mm_movemask_pd(_mm_cmplt_pd(a, b));
+        } else if constexpr (OP == CompareOp::LE) {
+            return _mm_movemask_pd(_mm_cmple_pd(a, b));
+        } else if constexpr (OP == CompareOp::GT) {
+            return _mm_movemask_pd(_mm_cmpgt_pd(a, b));
+        } else {
+            return _mm_movemask_pd(_mm_cmpge_pd(a, b));
+        }
+    }
+    TARGET_SSE42 static Vec mask(unsigned bits) { return _mm_castsi128_pd(Sse42Lanes<int64_t>::mask(bits)); }
+    TARGET_SSE42 static Acc start() { return {_mm_setzero_pd(), _mm_set1_pd(INFINITY), _mm_set1_pd(-INFINITY)}; }
+    TARGET_SSE42 static void add(Acc& acc, Vec values, Vec mask) {
+        acc.sum = _mm_add_pd(acc.sum, _mm_and_pd(values, mask));
+        acc.min = _mm_min_pd(_mm_blendv_pd(_mm_set1_pd(INFINITY), values, mask), acc.min);
+        acc.max = _mm_max_pd(_mm_blendv_pd(_mm_set1_pd(-INFINITY), values, mask), acc.max);
+    }
+    TARGET_SSE42 static void finish(const Acc& acc, Aggregate& result) {
+        alignas(16) double sums[2], mins[2], maxs[2];
+        _mm_store_pd(sums, acc.sum);
+        _mm_store_pd(mins, acc.min);
+        _mm_store_pd(maxs, acc.max);
+        result.fp_sum += sums[0] + sums[1];
+        for (std::size_t i = 0; i < 2; i++) {
+            result.fp_min = std::min(result.fp_min, mins[i]);
+            result.fp_max = std::max(result.fp_max, maxs[i]);
+        }
+    }
+};
+
+// Same drivers as the AVX2 ones, compiled for SSE4.2
+template <typename T, CompareOp OP>
+struct Sse42Compare {
+    using Lanes = Sse42Lanes<T>;
+
+    TARGET_SSE42 static unsigned compareLanes(typename Lanes::Vec a, typename Lanes::Vec b) {
+        constexpr unsigned ALL = (1u << Lanes::LANES) - 1;
+        if constexpr (std::is_floating_point_v<T>) {
+            return Lanes::template cmp<OP>(a, b);
+        } else if constexpr (OP == CompareOp::EQ) {
+            return Lanes::eq(a, b);
+        } else if constexpr (OP == CompareOp::NE) {
+            return ~Lanes::eq(a, b) & ALL;
+        } else if constexpr (OP == CompareOp::LT) {
+            return Lanes::gt(b, a);
+        } else if constexpr (OP == CompareOp::LE) {
+            return ~Lanes::gt(a, b) & ALL;
+        } else if constexpr (OP == CompareOp::GT) {
+            return Lanes::gt(a, b);
+        } else {
+            return ~Lanes::gt(b, a) & ALL;
+        }
+    }
+
+    TARGET_SSE42 static void run(const T* values, std::size_t count, T constant, uint64_t* selection) {
+        // Whole vectors as far as they go, including into a partial last
+        // word; pages often hold fewer than 64 rows
+        auto splat = Lanes::splat(constant);
+        std::size_t vector_rows = count - count % Lanes::LANES;
+        for (std::size_t base = 0; base < vector_rows; base += WORD_ROWS) {
+            std::size_t rows = std::min(WORD_ROWS, vector_rows - base);
+            uint64_t bits = 0;
+            for (std::size_t i = 0; i < rows; i += Lanes::LANES) {
+                bits |= static_cast<uint64_t>(compareLanes(Lanes::load(values + base + i), splat)) << i;
+            }
+            selection[base / WORD_ROWS] = bits;
+        }
+        compareRows<T, OP>(values, vector_rows, count, constant, selection);
+    }
+};
+
+template <typename T>
+struct Sse42Aggregate {
+    using Lanes = Sse42Lanes<T>;
+
+    TARGET_SSE42 static void run(const T* values, std::size_t count, const uint64_t* selection, Aggregate& result) {
+        constexpr unsigned ALL = (1u << Lanes::LANES) - 1;
+        typename Lanes::Acc acc = Lanes::start();
+        std::size_t vector_rows = count - count % Lanes::LANES;
+        uint64_t selected = 0;
+        for (std::size_t base = 0; base < vector_rows; base += WORD_ROWS) {
+            std::size_t rows = std::min(WORD_ROWS, vector_rows - base);
+            uint64_t bits = selection[base / WORD_ROWS];
+            if (rows < WORD_ROWS) {
+                bits &= (uint64_t{1} << rows) - 1;
+            }
+            if (bits == 0) {
+                continue;
+            }
+            selected += __builtin_popcountll(bits);
+            for (std::size_t i = 0; i < rows; i += Lanes::LANES) {
+                unsigned lane_bits = static_cast<unsigned>(bits >> i) & ALL;
+                if (lane_bits != 0) {
+                    Lanes::add(acc, Lanes::load(values + base + i), Lanes::mask(lane_bits));
+                }
+            }
+        }
+        if (selected > 0) {
+            Lanes::finish(acc, result);
+            result.count += selected;
+        }
+        aggregateRows(values, vector_rows, count, selection, result);
+    }
+};
+
+#endif // FILTER_KERNELS_X86
+
+template <typename T>
+T loadConstant(const void* constant) {
+    T value;
+    std::memcpy(&value, constant, sizeof(value));
+    return value;
+}
+
+template <template <typename, CompareOp> class Compare, typename T>
+void compareTyped(const void* values, std::size_t count, CompareOp op, const void* constant, uint64_t* selection) {
+    const auto* typed = static_cast<const T*>(values);
+    T value = loadConstant<T>(constant);
+    switch (op) {
+        case CompareOp::EQ: Compare<T, CompareOp::EQ>::run(typed, count, value, selection); break;
+        case CompareOp::NE: Compare<T, CompareOp::NE>::run(typed, count, value, selection); break;
+        case CompareOp::LT: Compare<T, CompareOp::LT>::run(typed, count, value, selection); break;
+        case CompareOp::LE: Compare<T, CompareOp::LE>::run(typed, count, value, selection); break;
+        case CompareOp::GT: Compare<T, CompareOp::GT>::run(typed, count, value, selection); break;
+        case CompareOp::GE: Compare<T, CompareOp::GE>::run(typed, count, value, selection); break;
+    }
+}
+
+// One implementation of the interface per instruction set; the kernels are
+// stateless, so each is a single static instance
+template <template <typename, CompareOp> class Compare, template <typename> class Fold>
+class KernelSet : public FilterKernels {
+public:
+    explicit KernelSet(const char* name) : name(name) {}
+
+    void compare(ColumnType type, const void* values, std::size_t count, CompareOp op, const void* constant,
+                 uint64_t* selection) const override {
+        switch (type) {
+            case ColumnType::INT32: compareTyped<Compare, int32_t>(values, count, op, constant, selection); break;
+            case ColumnType::UINT32: compareTyped<Compare, uint32_t>(values, count, op, constant, selection); break;
+            case ColumnType::INT64: compareTyped<Compare, int64_t>(values, count, op, constant, selection); break;
+            case ColumnType::FLOAT: compareTyped<Compare, float>(values, count, op, constant, selection); break;
+            case ColumnType::DOUBLE: compareTyped<Compare, double>(values, count, op, constant, selection); break;
+        }
+    }
+
+    void aggregate(ColumnType type, const void* values, std::size_t count, const uint64_t* selection,
+                   Aggregate& result) const override {
+        switch (type) {
+            case ColumnType::INT32:
+                Fold<int32_t>::run(static_cast<const int32_t*>(values), count, selection, result);
+                break;
+            case ColumnType::UINT32:
+                Fold<uint32_t>::run(static_cast<const uint32_t*>(values), count, selection, result);
+                break;
+            case ColumnType::INT64:
+                Fold<int64_t>::run(static_cast<const int64_t*>(values), count, selection, result);
+                break;
+            case ColumnType::FLOAT:
+                Fold<float>::run(static_cast<const float*>(values), count, selection, result);
+                break;
+            case ColumnType::DOUBLE:
+                Fold<double>::run(static_cast<const double*>(values), count, selection, result);
+                break;
+        }
+    }
+
+    const char* getName() const override { return name; }
+
+private:
+    const char* name;
+};
+
+} // namespace
+
+bool FilterKernels::isSupported(Kind kind) {
+    switch (kind) {
+        case Kind::SCALAR:
+        case Kind::AUTO:
+            return true;
+#ifdef FILTER_KERNELS_X86
+        case Kind::SSE42:
+            return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+        case Kind::AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+#else
+        case Kind::SSE42:
+        case Kind::AVX2:
+            return false;
+#endif
+    }
+    return false;
+}
+
+const FilterKernels& FilterKernels::get(Kind kind) {
+    static const KernelSet<ScalarCompare, ScalarAggregate> scalar("scalar");
+    if (kind == Kind::AUTO) {
+        kind = isSupported(Kind::AVX2) ? Kind::AVX2 : isSupported(Kind::SSE42) ? Kind::SSE42 : Kind::SCALAR;
+    }
+    if (!isSupported(kind)) {
+        throw std::runtime_error(std::string(kind == Kind::AVX2 ? "AVX2" : "SSE4.2") +
+                                 " kernels are not supported by this CPU");
+    }
+
+    switch (kind) {
+#ifdef FILTER_KERNELS_X86
+        case Kind::SSE42: {
+            static const KernelSet<Sse42Compare, Sse42Aggregate> sse42("sse4.2");
+            return sse42;
+        }
+        case Kind::AVX2: {
+            static const KernelSet<Avx2Compare, Avx2Aggregate> avx2("avx2");
+            return avx2;
+        }
+#endif
+        default:
+            return scalar;
+    }
+}
+
+void FilterKernels::intersect(uint64_t* selection, const uint64_t* other, std::size_t count) {
+    for (std::size_t word = 0; word < selectionWords(count); word++) {
+        selection[word] &= other[word];
+    }
+}
+
+void FilterKernels::unite(uint64_t* selection, const uint64_t* other, std::size_t count) {
+    for (std::size_t word = 0; word < selectionWords(count); word++) {
+        selection[word] |= other[word];
+    }
+}
+
+std::size_t FilterKernels::countSelected(const uint64_t* selection, std::size_t count) {
+    std::size_t selected = 0;
+    for (std::size_t word = 0; word < selectionWords(count); word++) {
+        selected += __builtin_popcountll(selection[word]);
+    }
+    return selected;
+}
+
+std::size_t FilterKernels::typeWidth(ColumnType type) {
+    switch (type) {
+        case ColumnType::INT32:
+        case ColumnType::UINT32:
+        case ColumnType::FLOAT:
+            return 4;
+        case ColumnType::INT64:
+        case ColumnType::DOUBLE:
+            return 8;
+    }
+    return 0;
+}
@@ -0,0 +1,204 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <stdexcept>
+#include "storage/free_space_map.hpp"
+
+FreeSpaceMap::FreeSpaceMap(const std::string& fname, std::size_t fanout)
+    : filename(fname), fanout(std::max<std::size_t>(fanout, 2)) {
+    file_descriptor = open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+    if (file_descriptor == -1) {
+        throw std::runtime_error("Failed to open free space map: " + filename);
+    }
+    levels.emplace_back();
+}
+
+FreeSpaceMap::~FreeSpaceMap() {
+    ::close(file_descriptor);
+}
+
+bool FreeSpaceMap::load(std::size_t num_pages) {
+    std::lock_guard<std::mutex> lock(latch);
+
+    levels.assign(1, std::vector<uint8_t>(num_pages, 0));
+    std::size_t num_fsm_pages = (num_pages + SlottedPage::PAGE_SIZE - 1) / SlottedPage::PAGE_SIZE;
+    dirty_fsm_pages.assign(num_fsm_pages, false);
+
+    off_t file_size = lseek(file_descriptor, 0, SEEK_END);
+    bool complete = file_size >= static_cast<off_t>(num_pages);
+    if (complete && num_pages > 0 &&
+        pread(file_descriptor, levels[0].data(), num_pages, 0) != static_cast<ssize_t>(num_pages)) {
+        complete = false;
+    }
+
+    growLevels();
+    return complete;
+}
+
+void FreeSpaceMap::sync() {
+    std::lock_guard<std::mutex> lock(latch);
+
+    const auto& leaves = levels[0];
+    for (std::size_t fsm_page = 0; fsm_page < dirty_fsm_pages.size(); fsm_page++) {
+        if (!dirty_fsm_pages[fsm_page]) {
+            continue;
+        }
+
+        std::size_t first = fsm_page * SlottedPage::PAGE_SIZE;
+        std::size_t count = std::min(SlottedPage::PAGE_SIZE, leaves.size() - first);
+        if (pwrite(file_descriptor, leaves.data() + first, count, first) != static_cast<ssize_t>(count)) {
+            throw std::runtime_error("Failed to write free space map page");
+        }
+        dirty_fsm_pages[fsm_page] = false;
+    }
+    if (fdatasync(file_descriptor) == -1) {
+        throw std::runtime_error("Failed to sync free space map");
+    }
+}
+
+void FreeSpaceMap::addPage(uint32_t page_id, uint16_t free_bytes) {
+    std::lock_guard<std::mutex> lock(latch);
+
+    if (page_id >= levels[0].size()) {
+        levels[0].resize(page_id + 1, 0);
+        dirty_fsm_pages.resize(page_id / SlottedPage::PAGE_SIZE + 1, false);
+        growLevels();
+    }
+    setLeaf(page_id, toCategory(free_bytes));
+}
+
+void FreeSpaceMap::update(uint32_t page_id, uint16_t free_bytes) {
+    std::lock_guard<std::mutex> lock(latch);
+
+    if (page_id < levels[0].size()) {
+        setLeaf(page_id, toCategory(free_bytes));
+    }
+}
+
+uint32_t FreeSpaceMap::findPage(uint16_t required_bytes) {
+    std::lock_guard<std::mutex> lock(latch);
+
+    uint32_t needed = requiredCategory(required_bytes);
+    if (levels[0].empty() || needed > UINT8_MAX || levels.back()[0] < needed) {
+        return NO_PAGE;
+    }
+
+    // Append-heavy workloads keep filling the same page
+    if (last_page_hint < levels[0].size() && levels[0][last_page_hint] >= needed) {
+        return last_page_hint;
+    }
+
+    // Descend from the root, taking the first child with enough room
+    std::size_t idx = 0;
+    for (std::size_t level = levels.size() - 1; level > 0; level--) {
+        const auto& children = levels[level - 1];
+        std::size_t first = idx * fanout;
+        std::size_t last = std::min(first + fanout, children.size());
+
+        std::size_t child = first;
+        while (child < last && children[child] < needed) {
+            child++;
+        }
+        if (child == last) {
+            return NO_PAGE; // Internal node out of sync; should not happen
+        }
+        idx = child;
+    }
+
+    last_page_hint = static_cast<uint32_t>(idx);
+    return last_page_hint;
+}
+
+uint16_t FreeSpaceMap::getFreeSpace(uint32_t page_id) const {
+    std::lock_guard<std::mutex> lock(latch);
+    if (page_id >= levels[0].size()) {
+        return 0;
+    }
+    return levels[0][page_id] * BYTES_PER_CATEGORY;
+}
+
+std::size_t FreeSpaceMap::getNumPages() const {
+    std::lock_guard<std::mutex> lock(latch);
+    return levels[0].size();
+}
+
+void FreeSpaceMap::print(std::ostream& os) const {
+    std::lock_guard<std::mutex> lock(latch);
+
+    os << "Free Space Map (fanout " << fanout << ", " << levels.size() << " levels):\n";
+    for (std::size_t i = 0; i < levels[0].size(); i++) {
+        os << "Block " << i << ": " << levels[0][i] * BYTES_PER_CATEGORY << " bytes free\n";
+    }
+
+    for (std::size_t level = 1; level < levels.size(); level++) {
+        os << "\nLevel " << level << ":\n";
+        for (std::size_t i = 0; i < levels[level].size(); i++) {
+            os << "Entry " << i << ": max " << levels[level][i] * BYTES_PER_CATEGORY << " bytes free\n";
+        }
+    }
+}
+
+uint8_t FreeSpaceMap::toCategory(uint16_t free_bytes) {
+    return static_cast<uint8_t>(std::min<std::size_t>(free_bytes / BYTES_PER_CATEGORY, UINT8_MAX));
+}
+
+uint32_t FreeSpaceMap::requiredCategory(uint16_t required_bytes) {
+    // Round up so any page in the category is guaranteed to fit the request
+    return (static_cast<uint32_t>(required_bytes) + BYTES_PER_CATEGORY - 1) / BYTES_PER_CATEGORY;
+}
+
+void FreeSpaceMap::setLeaf(uint32_t page_id, uint8_t category) {
+    if (levels[0][page_id] == category) {
+        return;
+    }
+    levels[0][page_id] = category;
+    dirty_fsm_pages[page_id / SlottedPage::PAGE_SIZE] = true;
+    propagate(page_id);
+}
+
+void FreeSpaceMap::growLevels() {
+    // Size every internal level for the current leaf count, adding a new
+    // root level whenever the top no longer fits in a single node
+    std::size_t level = 1;
+    std::size_t below = levels[0].size();
+    while (below > 1 || level == 1) {
+        std::size_t size = std::max<std::size_t>((below + fanout - 1) / fanout, 1);
+        if (level == levels.size()) {
+            levels.emplace_back();
+        }
+
+        // New nodes, and the last old one whose child range may have grown,
+        // are recomputed from the level below
+        std::size_t old_size = levels[level].size();
+        levels[level].resize(size, 0);
+        for (std::size_t i = old_size > 0 ? old_size - 1 : 0; i < size; i++) {
+            levels[level][i] = maxOfChildren(level, i);
+        }
+
+        below = size;
+        level++;
+    }
+    levels.resize(level);
+}
+
+uint8_t FreeSpaceMap::maxOfChildren(std::size_t level, std::size_t idx) const {
+    std::size_t first = idx * fanout;
+    std::size_t last = std::min(first + fanout, levels[level - 1].size());
+    if (first >= last) {
+        return 0;
+    }
+    return *std::max_element(levels[level - 1].begin() + first, levels[level - 1].begin() + last);
+}
+
+void FreeSpaceMap::propagate(std::size_t leaf_idx) {
+    std::size_t idx = leaf_idx;
+    for (std::size_t level = 1; level < levels.size(); level++) {
+        std::size_t parent = idx / fanout;
+        uint8_t max_category = maxOfChildren(level, parent);
+        if (levels[level][parent] == max_category) {
+            break; // Ancestors already reflect this subtree
+        }
+        levels[level][parent] = max_category;
+        idx = parent;
+    }
+}
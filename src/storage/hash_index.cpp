@@ -0,0 +1,435 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include "storage/hash_index.hpp"
+#include "storage/heap_scanner.hpp"
+
+HashIndex::HashIndex(const std::string& fname, KeyExtractor extractor, std::size_t buffer_pool_mb)
+    : filename(fname), key_extractor(std::move(extractor)) {
+    file_descriptor = open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+    if (file_descriptor == -1) {
+        throw std::runtime_error("Failed to open index file: " + filename);
+    }
+    try {
+        SlottedPage::checkPageSize(file_descriptor, filename);
+    } catch (...) {
+        ::close(file_descriptor);
+        throw;
+    }
+
+    buffer_pool = std::make_unique<BufferPool>(file_descriptor, buffer_pool_mb);
+    off_t file_size = lseek(file_descriptor, 0, SEEK_END);
+    num_pages = file_size / SlottedPage::PAGE_SIZE;
+
+    if (num_pages > 0) {
+        try {
+            loadDirectory();
+        } catch (...) {
+            ::close(file_descriptor);
+            throw;
+        }
+        return;
+    }
+
+    // An empty index is a single bucket of depth 0
+    allocatePage(SlottedPage::PageType::ROOT);
+    {
+        BufferPool::PageGuard meta(*buffer_pool, META_PAGE_ID);
+        MetaHeader header = {MAGIC, 0, {}, 1};
+        meta->addCell(&header, sizeof(MetaHeader));
+        meta.markDirty();
+    }
+    uint32_t bucket_page = allocatePage(SlottedPage::PageType::LEAF);
+    BufferPool::PageGuard bucket(*buffer_pool, bucket_page);
+    writeChain(bucket, 0, {});
+    directory.assign(1, bucket_page);
+    num_buckets = 1;
+}
+
+void HashIndex::insert(Key key, RecordId rid) {
+    Entry entry = makeEntry(key, rid);
+    uint64_t hash = hashKey(key);
+    while (true) {
+        {
+            std::shared_lock<std::shared_mutex> lock(directory_latch);
+            if (tryInsert(bucketFor(hash), entry)) {
+                return;
+            }
+        }
+
+        // The bucket is full: grow it unless another writer already did
+        std::unique_lock<std::shared_mutex> lock(directory_latch);
+        uint32_t bucket_page = bucketFor(hash);
+        if (tryInsert(bucket_page, entry)) {
+            return;
+        }
+        growBucket(bucket_page, hash);
+    }
+}
+
+bool HashIndex::remove(Key key, RecordId rid) {
+    Entry target = makeEntry(key, rid);
+    std::shared_lock<std::shared_mutex> lock(directory_latch);
+    BufferPool::PageGuard head(*buffer_pool, bucketFor(hashKey(key)), BufferPool::LatchMode::EXCLUSIVE);
+
+    // The first page's latch covers the rest of the chain
+    BufferPool::PageGuard chained;
+    BufferPool::PageGuard* page = &head;
+    while (true) {
+        uint16_t idx = lowerBound(**page, target);
+        if (idx <= numEntries(**page) && !less(target, entryAt(**page, idx))) {
+            (*page)->eraseCell(idx);
+            page->markDirty();
+            return true;
+        }
+        uint32_t next = (*page)->getHeader().next_page;
+        if (next == NO_PAGE) {
+            return false;
+        }
+        chained = BufferPool::PageGuard(*buffer_pool, next);
+        page = &chained;
+    }
+}
+
+std::vector<HashIndex::RecordId> HashIndex::find(Key key) {
+    std::vector<RecordId> rids;
+    Entry target = makeEntry(key, {0, 0});
+    std::shared_lock<std::shared_mutex> lock(directory_latch);
+    BufferPool::PageGuard head(*buffer_pool, bucketFor(hashKey(key)), BufferPool::LatchMode::SHARED);
+
+    BufferPool::PageGuard chained;
+    SlottedPage* page = head.get();
+    bool chain = false;
+    while (true) {
+        uint16_t count = numEntries(*page);
+        for (uint16_t idx = lowerBound(*page, target); idx <= count; idx++) {
+            Entry entry = entryAt(*page, idx);
+            if (entry.key != key) {
+                break;
+            }
+            rids.push_back({entry.page_id, entry.slot_id});
+        }
+        uint32_t next = page->getHeader().next_page;
+        if (next == NO_PAGE) {
+            break;
+        }
+        chained = BufferPool::PageGuard(*buffer_pool, next);
+        page = chained.get();
+        chain = true;
+    }
+
+    // Each page is sorted, the chain as a whole is not
+    if (chain) {
+        std::sort(rids.begin(), rids.end(), [](const RecordId& a, const RecordId& b) {
+            return a.page_id != b.page_id ? a.page_id < b.page_id : a.slot_id < b.slot_id;
+        });
+    }
+    return rids;
+}
+
+void HashIndex::build(HeapFile& heap_file) {
+    HeapScanner scanner(heap_file);
+    while (scanner.next()) {
+        insertRecord(scanner.getRecord(), scanner.getRecordSize(), scanner.getRecordId());
+    }
+}
+
+void HashIndex::sync() {
+    std::unique_lock<std::shared_mutex> lock(directory_latch);
+    saveDirectory();
+    buffer_pool->flushAllPages();
+    if (fdatasync(file_descriptor) == -1) {
+        throw std::runtime_error("Failed to sync index file: " + filename);
+    }
+}
+
+void HashIndex::close() {
+    sync();
+    ::close(file_descriptor);
+}
+
+uint8_t HashIndex::getGlobalDepth() {
+    std::shared_lock<std::shared_mutex> lock(directory_latch);
+    return global_depth;
+}
+
+std::size_t HashIndex::getNumBuckets() {
+    std::shared_lock<std::shared_mutex> lock(directory_latch);
+    return num_buckets;
+}
+
+HashIndex::Entry HashIndex::makeEntry(Key key, RecordId rid) {
+    return {key, rid.page_id, rid.slot_id, 0};
+}
+
+bool HashIndex::less(const Entry& a, const Entry& b) {
+    if (a.key != b.key) {
+        return a.key < b.key;
+    }
+    if (a.page_id != b.page_id) {
+        return a.page_id < b.page_id;
+    }
+    return a.slot_id < b.slot_id;
+}
+
+uint16_t HashIndex::numEntries(SlottedPage& page) {
+    std::size_t cells = page.getPointerList().size;
+    return static_cast<uint16_t>(cells == 0 ? 0 : cells - 1);
+}
+
+HashIndex::Entry HashIndex::entryAt(SlottedPage& page, uint16_t idx) {
+    // Cells are not aligned, so copy rather than cast
+    Entry entry;
+    std::memcpy(&entry, page.getCell(idx), sizeof(Entry));
+    return entry;
+}
+
+uint16_t HashIndex::lowerBound(SlottedPage& page, const Entry& target) {
+    // First entry >= target; entries occupy cells 1..numEntries
+    uint16_t low = 1;
+    uint16_t high = numEntries(page) + 1;
+    while (low < high) {
+        uint16_t mid = low + (high - low) / 2;
+        if (less(entryAt(page, mid), target)) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+bool HashIndex::makeRoom(SlottedPage& page) {
+    constexpr std::size_t required = sizeof(Entry) + sizeof(SlottedPage::CellPointer);
+    if (page.getHeader().total_free >= required) {
+        return true;
+    }
+    // Space left by removes is only reusable once compacted
+    if (!(page.getHeader().flags & SlottedPage::CAN_COMPACT)) {
+        return false;
+    }
+    page.compact();
+    return page.getHeader().total_free >= required;
+}
+
+bool HashIndex::tryInsert(uint32_t bucket_page, const Entry& entry) {
+    // Writers of a bucket serialise on its first page, which also keeps
+    // readers out of the rest of the chain
+    BufferPool::PageGuard head(*buffer_pool, bucket_page, BufferPool::LatchMode::EXCLUSIVE);
+
+    // Look for the entry along the whole chain, noting the first page
+    // with room on the way
+    BufferPool::PageGuard chained;
+    BufferPool::PageGuard* page = &head;
+    uint32_t room_page = NO_PAGE;
+    uint16_t room_idx = 0;
+    while (true) {
+        uint16_t idx = lowerBound(**page, entry);
+        if (idx <= numEntries(**page) && !less(entry, entryAt(**page, idx))) {
+            return true; // Already indexed
+        }
+        if (room_page == NO_PAGE && makeRoom(**page)) {
+            page->markDirty(); // May have been compacted
+            room_page = page->getPageId();
+            room_idx = idx;
+        }
+        uint32_t next = (*page)->getHeader().next_page;
+        if (next == NO_PAGE) {
+            break;
+        }
+        chained = BufferPool::PageGuard(*buffer_pool, next);
+        page = &chained;
+    }
+
+    if (room_page == NO_PAGE) {
+        return false;
+    }
+    if (room_page != bucket_page) {
+        chained = BufferPool::PageGuard(*buffer_pool, room_page);
+        page = &chained;
+    } else {
+        page = &head;
+    }
+    (*page)->insertCell(room_idx, &entry, sizeof(Entry));
+    page->markDirty();
+    return true;
+}
+
+void HashIndex::growBucket(uint32_t bucket_page, uint64_t hash) {
+    BufferPool::PageGuard head(*buffer_pool, bucket_page, BufferPool::LatchMode::EXCLUSIVE);
+    BucketHeader header;
+    std::memcpy(&header, head->getCell(0), sizeof(BucketHeader));
+
+    // Gather the chain's entries; they share the low local-depth hash bits
+    const uint8_t depth = header.local_depth;
+    const uint64_t bit = uint64_t(1) << depth;
+    std::vector<Entry> entries;
+    std::size_t num_set = (hash & bit) != 0 ? 1 : 0;
+    uint32_t last_page = bucket_page;
+    {
+        BufferPool::PageGuard chained;
+        SlottedPage* page = head.get();
+        while (true) {
+            uint16_t count = numEntries(*page);
+            for (uint16_t idx = 1; idx <= count; idx++) {
+                entries.push_back(entryAt(*page, idx));
+                num_set += (hashKey(entries.back().key) & bit) != 0 ? 1 : 0;
+            }
+            uint32_t next = page->getHeader().next_page;
+            if (next == NO_PAGE) {
+                break;
+            }
+            chained = BufferPool::PageGuard(*buffer_pool, next);
+            page = chained.get();
+            last_page = next;
+        }
+    }
+
+    // A split that would leave one half nearly empty, as with a run of
+    // duplicates of one key, mostly grows the directory: chain another page
+    std::size_t total = entries.size() + 1;
+    if (std::min(num_set, total - num_set) * MIN_SPLIT_DIVISOR < total || depth >= MAX_GLOBAL_DEPTH) {
+        uint32_t overflow_page = allocatePage(SlottedPage::PageType::LEAF);
+        {
+            BufferPool::PageGuard overflow(*buffer_pool, overflow_page);
+            writeChain(overflow, depth, {});
+        }
+        if (last_page == bucket_page) {
+            head->setNextPage(overflow_page);
+            head.markDirty();
+        } else {
+            BufferPool::PageGuard last(*buffer_pool, last_page);
+            last->setNextPage(overflow_page);
+            last.markDirty();
+        }
+        return;
+    }
+
+    if (depth == global_depth) {
+        doubleDirectory();
+    }
+
+    // Entries with the next hash bit set move to a new bucket
+    std::sort(entries.begin(), entries.end(), less);
+    std::vector<Entry> moved;
+    auto stay_end = std::stable_partition(entries.begin(), entries.end(), [bit](const Entry& entry) {
+        return (hashKey(entry.key) & bit) == 0;
+    });
+    moved.assign(stay_end, entries.end());
+    entries.erase(stay_end, entries.end());
+
+    uint32_t new_bucket = allocatePage(SlottedPage::PageType::LEAF);
+    {
+        BufferPool::PageGuard bucket(*buffer_pool, new_bucket);
+        writeChain(bucket, depth + 1, moved);
+    }
+    writeChain(head, depth + 1, entries);
+    num_buckets++;
+
+    // The bucket owned every slot ending in its depth bits; those with the
+    // next bit set now belong to the new one
+    for (std::size_t slot = (hash & (bit - 1)) | bit; slot < directory.size(); slot += bit << 1) {
+        directory[slot] = new_bucket;
+    }
+}
+
+void HashIndex::doubleDirectory() {
+    // With the low bits as the slot, the new upper half is a copy of the
+    // lower one
+    std::size_t size = directory.size();
+    directory.resize(size * 2);
+    std::copy(directory.begin(), directory.begin() + size, directory.begin() + size);
+    global_depth++;
+}
+
+void HashIndex::writeChain(BufferPool::PageGuard& first, uint8_t local_depth, const std::vector<Entry>& entries) {
+    BucketHeader header = {local_depth, {}};
+    BufferPool::PageGuard chained;
+    BufferPool::PageGuard* page = &first;
+    std::size_t next = 0;
+    while (true) {
+        // Pages left over at the end of the chain are emptied, not unlinked
+        uint32_t link = (*page)->getHeader().next_page;
+        (*page)->reset(SlottedPage::PageType::LEAF, page->getPageId());
+        (*page)->addCell(&header, sizeof(BucketHeader));
+        while (next < entries.size() &&
+               (*page)->getHeader().total_free >= sizeof(Entry) + sizeof(SlottedPage::CellPointer)) {
+            (*page)->addCell(&entries[next++], sizeof(Entry));
+        }
+        if (link == NO_PAGE && next < entries.size()) {
+            link = allocatePage(SlottedPage::PageType::LEAF);
+        }
+        (*page)->setNextPage(link);
+        page->markDirty();
+        if (link == NO_PAGE) {
+            return;
+        }
+        chained = BufferPool::PageGuard(*buffer_pool, link);
+        page = &chained;
+    }
+}
+
+uint32_t HashIndex::allocatePage(SlottedPage::PageType type) {
+    uint32_t page_id = static_cast<uint32_t>(num_pages++);
+    buffer_pool->newPage(page_id, type);
+    buffer_pool->unpinPage(page_id, true);
+    return page_id;
+}
+
+void HashIndex::loadDirectory() {
+    BufferPool::PageGuard meta(*buffer_pool, META_PAGE_ID);
+    MetaHeader header;
+    if (meta->getHeader().type != SlottedPage::PageType::ROOT || meta->getPointerList().size == 0) {
+        throw std::runtime_error(filename + " is not a hash index");
+    }
+    std::memcpy(&header, meta->getCell(0), sizeof(MetaHeader));
+    if (header.magic != MAGIC || header.global_depth > MAX_GLOBAL_DEPTH) {
+        throw std::runtime_error(filename + " is not a hash index");
+    }
+    global_depth = header.global_depth;
+    num_buckets = header.num_buckets;
+
+    directory.resize(std::size_t(1) << global_depth);
+    std::size_t loaded = 0;
+    uint32_t page_id = meta->getHeader().next_page;
+    while (loaded < directory.size()) {
+        if (page_id == NO_PAGE || page_id >= num_pages) {
+            throw std::runtime_error("Hash index directory is truncated: " + filename);
+        }
+        BufferPool::PageGuard page(*buffer_pool, page_id);
+        std::size_t count = std::min(DIRECTORY_ENTRIES_PER_PAGE, directory.size() - loaded);
+        std::memcpy(directory.data() + loaded, page->getData() + sizeof(SlottedPage::PageHeader),
+                    count * sizeof(uint32_t));
+        loaded += count;
+        page_id = page->getHeader().next_page;
+    }
+}
+
+void HashIndex::saveDirectory() {
+    BufferPool::PageGuard previous(*buffer_pool, META_PAGE_ID);
+    MetaHeader header = {MAGIC, global_depth, {}, num_buckets};
+    std::memcpy(previous->getCell(0), &header, sizeof(MetaHeader));
+    previous.markDirty();
+
+    // Directory pages hold raw slot arrays after the header; the chain only
+    // grows, so a directory once written never needs new pages below its size
+    std::size_t saved = 0;
+    while (saved < directory.size()) {
+        uint32_t page_id = previous->getHeader().next_page;
+        if (page_id == NO_PAGE) {
+            page_id = allocatePage(SlottedPage::PageType::OVERFLOW);
+            previous->setNextPage(page_id);
+            previous.markDirty();
+        }
+        BufferPool::PageGuard page(*buffer_pool, page_id);
+        std::size_t count = std::min(DIRECTORY_ENTRIES_PER_PAGE, directory.size() - saved);
+        std::memcpy(page->getData() + sizeof(SlottedPage::PageHeader), directory.data() + saved,
+                    count * sizeof(uint32_t));
+        page.markDirty();
+        saved += count;
+        previous = std::move(page);
+    }
+}
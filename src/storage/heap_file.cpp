@@ -1,230 +1,1194 @@
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <stdexcept>
 #include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <exception>
 #include <iostream>
 #include "storage/heap_file.hpp"
+#include "storage/tuple.hpp"
+
+namespace {
+
+// Schema stored in cell 0 of a catalog page; false if the cell is missing
+bool readCatalog(const uint8_t* page, Schema& schema) {
+    const auto* header = reinterpret_cast<const SlottedPage::PageHeader*>(page);
+    if (header->free_start < sizeof(SlottedPage::PageHeader) + sizeof(SlottedPage::CellPointer)) {
+        return false;
+    }
+    const auto* pointer = reinterpret_cast<const SlottedPage::CellPointer*>(page + sizeof(SlottedPage::PageHeader));
+    if (pointer->cell_location == 0) {
+        return false;
+    }
+    if (pointer->cell_location + pointer->size() > SlottedPage::PAGE_SIZE) {
+        throw std::runtime_error("Corrupt catalog page");
+    }
+    schema = Schema::decode(page + pointer->cell_location, pointer->size());
+    return true;
+}
+
+} // namespace
+
+HeapFile::HeapFile(const std::string& fname, const HeapFileOptions& options)
+    : filename(fname), access_mode(options.access_mode) {
+    if (access_mode == HeapFileOptions::AccessMode::MMAP_READ_ONLY) {
+        openMapped(options);
+        return;
+    }
 
-HeapFile::HeapFile(const std::string& fname) : filename(fname) {
     // Open or create the file
-    file_descriptor = open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+    int flags = O_RDWR | O_CREAT | (options.direct_io ? O_DIRECT : 0);
+    file_descriptor = open(filename.c_str(), flags, 0644);
     if (file_descriptor == -1) {
         throw std::runtime_error("Failed to open heap file: " + filename);
     }
+    bool compressed;
+    try {
+        SlottedPage::checkPageSize(file_descriptor, filename);
+        off_t file_size = lseek(file_descriptor, 0, SEEK_END);
+        compressed = CompressedPageFile::isCompressed(file_descriptor) ||
+                     (file_size == 0 && options.compression == HeapFileOptions::Compression::LZ);
+        if (compressed && options.direct_io) {
+            throw std::invalid_argument("Compressed heap files do not support direct I/O");
+        }
+        if (!compressed && options.compression == HeapFileOptions::Compression::LZ) {
+            throw std::runtime_error(filename + " is not compressed");
+        }
+    } catch (...) {
+        ::close(file_descriptor);
+        throw;
+    }
+    if (options.compaction_threshold > 0) {
+        compaction_threshold_bytes = static_cast<uint16_t>(
+            std::max(1.0f, std::min(options.compaction_threshold, 1.0f) * (SlottedPage::PAGE_SIZE - 1)));
+    }
+    log_manager = std::make_unique<LogManager>(filename + ".wal");
+    io_backend_kind = options.io_backend;
+    io_backend = IoBackend::create(io_backend_kind);
+    if (compressed) {
+        try {
+            compressed_file = std::make_unique<CompressedPageFile>(file_descriptor, filename, io_backend.get());
+        } catch (...) {
+            ::close(file_descriptor);
+            throw;
+        }
+    }
+    buffer_pool = std::make_unique<BufferPool>(file_descriptor, options.buffer_pool_mb, log_manager.get(),
+                                               io_backend.get(), compressed_file.get());
+    free_space_map = std::make_unique<FreeSpaceMap>(filename + ".fsm", options.fsm_fanout);
 
     // Get file size and calculate number of pages
-    off_t file_size = lseek(file_descriptor, 0, SEEK_END);
-    num_pages = file_size / SlottedPage::PAGE_SIZE;
-    
-    // Initialize maps
-    initializeMaps();
+    if (compressed_file) {
+        num_pages = compressed_file->getNumPages();
+    } else {
+        off_t file_size = lseek(file_descriptor, 0, SEEK_END);
+        num_pages = file_size / SlottedPage::PAGE_SIZE;
+    }
     
-    // Read existing free space map if file exists
-    if (file_size > 0) {
-        readFreeSpaceMapFromDisk();
+    // Read existing free space map, rebuilding it if the fork is missing or short
+    if (!free_space_map->load(num_pages)) {
+        recomputeFreeSpaceMap();
+    }
+
+    // Redo any changes that were logged but not checkpointed
+    recover();
+    try {
+        resolveLayout(options);
+    } catch (...) {
+        ::close(file_descriptor);
+        throw;
+    }
+
+    if (options.writer_interval_ms > 0) {
+        buffer_pool->startBackgroundWriter(std::chrono::milliseconds(options.writer_interval_ms));
+    }
+    if (options.checkpoint_interval_ms > 0) {
+        checkpoint_thread = std::thread(&HeapFile::runCheckpointer, this,
+                                        std::chrono::milliseconds(options.checkpoint_interval_ms));
     }
 }
 
-void HeapFile::initializeMaps() {
-    free_space_map.resize(num_pages, {MAX_FREE_FRACTION});
-    second_level_map.resize((num_pages + ENTRIES_PER_SECOND_LEVEL - 1) / ENTRIES_PER_SECOND_LEVEL, {MAX_FREE_FRACTION});
+HeapFile::~HeapFile() {
+    stopBackgroundWork();
 }
 
-uint32_t HeapFile::insertRecord(const void* record, uint16_t record_size) {
-    // Find a page with enough space
-    uint32_t page_id = findPageWithSpace(record_size);
-    if (page_id == num_pages) {
-        // No existing page has enough space, allocate new page
-        page_id = allocateNewPage();
+void HeapFile::stopBackgroundWork() {
+    if (checkpoint_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(checkpointer_latch);
+            checkpointer_stopping = true;
+        }
+        checkpointer_cv.notify_all();
+        checkpoint_thread.join();
     }
+    if (buffer_pool) {
+        buffer_pool->stopBackgroundWriter();
+    }
+}
 
-    auto page = getPage(page_id);
-    uint16_t slot_id = page->addCell(record, record_size);
-    
-    // Mark page as dirty
-    auto cache_it = std::find_if(page_cache.begin(), page_cache.end(),
-        [page_id](const CachedPage& cached) { return cached.page_id == page_id; });
-    if (cache_it != page_cache.end()) {
-        cache_it->is_dirty = true;
+void HeapFile::runCheckpointer(std::chrono::milliseconds interval) {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(checkpointer_latch);
+            if (checkpointer_cv.wait_for(lock, interval, [this] { return checkpointer_stopping; })) {
+                return;
+            }
+        }
+        try {
+            checkpoint(static_cast<uint32_t>(interval.count() / 2));
+        } catch (const std::exception&) {
+            // Nothing was lost: the log still covers every page. Retry on
+            // the next interval.
+        }
     }
-    
-    // Update free space map
-    updateFreeSpaceMap(page_id);
-    
-    return page_id;
 }
 
-uint32_t HeapFile::findPageWithSpace(uint16_t required_space) {
-    float required_fraction = static_cast<float>(required_space) / SlottedPage::PAGE_SIZE;
-    
-    // First check second level map
-    for (size_t i = 0; i < second_level_map.size(); i++) {
-        if (second_level_map[i].getFraction() >= required_fraction) {
-            // Check corresponding entries in main map
-            size_t start_idx = i * ENTRIES_PER_SECOND_LEVEL;
-            size_t end_idx = std::min(start_idx + ENTRIES_PER_SECOND_LEVEL, free_space_map.size());
-            
-            for (size_t j = start_idx; j < end_idx; j++) {
-                if (free_space_map[j].getFraction() >= required_fraction) {
-                    auto page = getPage(j);
-                    if (calculatePageFreeSpace(*page) >= required_fraction) {
-                        return j;
-                    }
-                    // If actual free space is less, update maps
-                    updateFreeSpaceMap(j);
+void HeapFile::openMapped(const HeapFileOptions& options) {
+    file_descriptor = open(filename.c_str(), O_RDONLY);
+    if (file_descriptor == -1) {
+        throw std::runtime_error("Failed to open heap file: " + filename);
+    }
+    try {
+        SlottedPage::checkPageSize(file_descriptor, filename);
+        if (CompressedPageFile::isCompressed(file_descriptor)) {
+            throw std::runtime_error(filename + " is compressed and cannot be mapped");
+        }
+    } catch (...) {
+        ::close(file_descriptor);
+        throw;
+    }
+
+    // No log or free-space map: nothing is ever written. The pool stays
+    // empty but keeps scanners working unchanged.
+    io_backend = std::make_unique<SyncIoBackend>();
+    buffer_pool = std::make_unique<BufferPool>(file_descriptor, 0, nullptr, io_backend.get());
+    num_pages = 0;
+    try {
+        refreshMapping();
+        resolveLayout(options);
+    } catch (...) {
+        unmapFile();
+        ::close(file_descriptor);
+        throw;
+    }
+}
+
+void HeapFile::resolveLayout(const HeapFileOptions& options) {
+    const std::vector<uint16_t>& requested_widths = options.pax_column_widths;
+    if (!requested_widths.empty() && !options.schema.empty()) {
+        throw std::invalid_argument("Typed tuples use the row layout, not PAX");
+    }
+
+    std::vector<uint16_t> widths = requested_widths;
+    if (num_pages > 0) {
+        // Page 0 is a heap page or the catalog, so it tells which layout the
+        // file has
+        std::vector<uint16_t> found;
+        auto readWidths = [&found](const uint8_t* page) {
+            auto type = reinterpret_cast<const SlottedPage::PageHeader*>(page)->type;
+            if (type == SlottedPage::PageType::PAX) {
+                found = PaxPage::readColumnWidths(page);
+            } else if (type == SlottedPage::PageType::ENCODED) {
+                found = EncodedPage::readColumnWidths(page);
+            }
+        };
+        if (mapping != nullptr) {
+            readWidths(getMappedPage(0));
+        } else {
+            auto page = getPage(0, BufferPool::LatchMode::SHARED);
+            readWidths(page->getData());
+        }
+        if (!requested_widths.empty() && found != requested_widths) {
+            throw std::runtime_error(filename + (found.empty() ? " uses the row layout"
+                                                               : " uses a different PAX schema"));
+        }
+        widths = found;
+    }
+
+    if (!widths.empty()) {
+        PaxPage::capacityFor(widths); // Rejects schemas that do not fit a page
+        pax_record_size = 0;
+        for (uint16_t width : widths) {
+            pax_record_size += width;
+        }
+        if (pax_record_size > MAX_RECORD_SIZE) {
+            throw std::invalid_argument("PAX record does not fit in a page");
+        }
+    }
+    pax_column_widths = widths;
+    encode_bulk_loads = options.encode_bulk_loads && isPax();
+    if (encode_bulk_loads) {
+        EncodedPage::Builder check(widths); // Rejects schemas too wide to encode
+    }
+    resolveSchema(options.schema);
+}
+
+void HeapFile::resolveSchema(const Schema& requested) {
+    if (num_pages == 0) {
+        if (!requested.empty()) {
+            if (mapping != nullptr) {
+                throw std::runtime_error(filename + " is empty and has no schema");
+            }
+            writeCatalog(requested, true);
+            schema = requested;
+        }
+        return;
+    }
+
+    bool is_catalog;
+    bool has_schema;
+    Schema found;
+    if (mapping != nullptr) {
+        const uint8_t* page = getMappedPage(0);
+        is_catalog = reinterpret_cast<const SlottedPage::PageHeader*>(page)->type == SlottedPage::PageType::CATALOG;
+        has_schema = is_catalog && readCatalog(page, found);
+    } else {
+        auto page = getPage(0, BufferPool::LatchMode::SHARED);
+        is_catalog = page->getHeader().type == SlottedPage::PageType::CATALOG;
+        has_schema = is_catalog && readCatalog(page->getData(), found);
+    }
+
+    if (!is_catalog) {
+        if (!requested.empty()) {
+            throw std::runtime_error(filename + " holds untyped records");
+        }
+        return;
+    }
+    if (!has_schema) {
+        // Created by a crash between logging the catalog page and its cell
+        if (requested.empty() || mapping != nullptr) {
+            throw std::runtime_error(filename + " has an incomplete catalog");
+        }
+        writeCatalog(requested, false);
+        found = requested;
+    }
+    if (!requested.empty() && found != requested) {
+        throw std::runtime_error(filename + " has a different schema");
+    }
+    schema = found;
+}
+
+void HeapFile::writeCatalog(const Schema& requested, bool new_page) {
+    std::vector<uint8_t> encoded;
+    requested.encode(encoded);
+    if (encoded.size() > MAX_RECORD_SIZE) {
+        throw std::invalid_argument("Schema does not fit in the catalog page");
+    }
+
+    // Both changes go through the log like any other, so recovery rebuilds
+    // a catalog page that never reached the data file
+    const auto type = SlottedPage::PageType::CATALOG;
+    if (new_page) {
+        uint8_t payload = static_cast<uint8_t>(type);
+        uint64_t lsn = log_manager->append(LogManager::RecordType::NEW_PAGE, 0, 0, &payload, sizeof(payload));
+        auto* page = buffer_pool->newPage(0, type);
+        page->setLsn(lsn);
+        buffer_pool->unpinPage(0, true);
+        num_pages = 1;
+        free_space_map->addPage(0, 0);
+    }
+    {
+        auto page = getPage(0, BufferPool::LatchMode::EXCLUSIVE);
+        uint16_t slot_id = page->addCell(encoded.data(), static_cast<uint16_t>(encoded.size()));
+        page->setLsn(log_manager->append(LogManager::RecordType::ADD_CELL, 0, slot_id, encoded.data(),
+                                         encoded.size()));
+        page.markDirty();
+    }
+    log_manager->flushAll();
+}
+
+void HeapFile::checkTuple(const void* record, uint16_t record_size) const {
+    if (!schema.empty() && !TupleView::isValid(schema, record, record_size)) {
+        throw std::invalid_argument("Record is not a valid tuple of the schema");
+    }
+}
+
+SlottedPage::PageType HeapFile::heapPageType() const {
+    return isPax() ? SlottedPage::PageType::PAX : SlottedPage::PageType::LEAF;
+}
+
+void HeapFile::formatHeapPage(SlottedPage& page) const {
+    if (isPax()) {
+        PaxPage::format(page.getData(), pax_column_widths);
+    }
+}
+
+void HeapFile::refreshMapping() {
+    std::lock_guard<std::mutex> lock(mapping_latch);
+
+    struct stat st;
+    if (fstat(file_descriptor, &st) == -1) {
+        throw std::runtime_error("Failed to stat heap file: " + filename);
+    }
+    size_t file_size = static_cast<size_t>(st.st_size);
+
+    // The mapping reserves address space beyond the end of the file, so
+    // appended pages become visible without remapping; only outgrowing
+    // the reservation moves it. The old mapping stays in place for
+    // readers still using it, and the new one is published before the
+    // pages that need it.
+    if (file_size > mapping_size) {
+        size_t reserve = std::max(MMAP_MIN_RESERVATION, file_size * 2);
+        void* addr = mmap(nullptr, reserve, PROT_READ, MAP_SHARED, file_descriptor, 0);
+        if (addr == MAP_FAILED) {
+            throw std::runtime_error("Failed to mmap heap file: " + filename);
+        }
+        madvise(addr, reserve, MADV_RANDOM);
+        if (mapping != nullptr) {
+            old_mappings.emplace_back(mapping.load(), mapping_size);
+        }
+        mapping = static_cast<const uint8_t*>(addr);
+        mapping_size = reserve;
+    }
+
+    num_pages = file_size / SlottedPage::PAGE_SIZE;
+}
+
+void HeapFile::unmapFile() {
+    std::lock_guard<std::mutex> lock(mapping_latch);
+    if (mapping != nullptr) {
+        munmap(const_cast<uint8_t*>(mapping.load()), mapping_size);
+        mapping = nullptr;
+        mapping_size = 0;
+    }
+    for (const auto& [addr, size] : old_mappings) {
+        munmap(const_cast<uint8_t*>(addr), size);
+    }
+    old_mappings.clear();
+}
+
+const uint8_t* HeapFile::getMappedPage(uint32_t page_id) {
+    if (page_id >= num_pages) {
+        // The file may have grown since the mapping was last checked
+        refreshMapping();
+        if (page_id >= num_pages) {
+            return nullptr;
+        }
+    }
+    return mapping + static_cast<size_t>(page_id) * SlottedPage::PAGE_SIZE;
+}
+
+const SlottedPage::CellPointer* HeapFile::getMappedCell(uint32_t page_id, uint16_t slot_id) {
+    const uint8_t* page = getMappedPage(page_id);
+    if (page == nullptr) {
+        return nullptr;
+    }
+
+    const auto* header = reinterpret_cast<const SlottedPage::PageHeader*>(page);
+    if (header->type != SlottedPage::PageType::LEAF || header->free_start < sizeof(SlottedPage::PageHeader) ||
+        slot_id >= (header->free_start - sizeof(SlottedPage::PageHeader)) / sizeof(SlottedPage::CellPointer)) {
+        return nullptr;
+    }
+
+    const auto* pointer = reinterpret_cast<const SlottedPage::CellPointer*>(
+        page + sizeof(SlottedPage::PageHeader)) + slot_id;
+    return pointer->cell_location == 0 ? nullptr : pointer;
+}
+
+void HeapFile::requireWritable() const {
+    if (access_mode != HeapFileOptions::AccessMode::READ_WRITE) {
+        throw std::logic_error("Heap file is open read-only: " + filename);
+    }
+}
+
+void HeapFile::redoNewPage(uint32_t page_id, SlottedPage::PageType type, uint64_t lsn,
+                           const std::vector<uint16_t>& column_widths) {
+    if (page_id >= num_pages) {
+        // The page never reached the data file
+        num_pages = page_id + 1;
+        auto* page = buffer_pool->newPage(page_id, type);
+        if (type == SlottedPage::PageType::PAX) {
+            PaxPage::format(page->getData(), column_widths);
+        }
+        page->setLsn(lsn);
+        free_space_map->addPage(page_id, usableSpace(*page));
+        buffer_pool->unpinPage(page_id, true);
+        return;
+    }
+
+    auto page = getPage(page_id, BufferPool::LatchMode::EXCLUSIVE);
+    if (page->getHeader().lsn < lsn) {
+        page->reset(type, page_id);
+        if (type == SlottedPage::PageType::PAX) {
+            PaxPage::format(page->getData(), column_widths);
+        }
+        page->setLsn(lsn);
+        page.markDirty();
+    }
+}
+
+void HeapFile::recover() {
+    bool replayed = false;
+
+    log_manager->forEachRecord([this, &replayed](const LogManager::LogRecord& record) {
+        const auto& rec = *record.header;
+        replayed = true;
+
+        if (rec.type == LogManager::RecordType::NEW_PAGE) {
+            auto type = static_cast<SlottedPage::PageType>(record.payload[0]);
+            std::vector<uint16_t> column_widths;
+            if (type == SlottedPage::PageType::PAX) {
+                column_widths = PaxPage::decodeSchema(record.payload + 1, record.payload_size - 1);
+            }
+            redoNewPage(rec.page_id, type, rec.lsn, column_widths);
+            return;
+        }
+
+        if (rec.type == LogManager::RecordType::NEW_PAGE_RANGE) {
+            // Bulk-loaded pages: intact ones carry this LSN, torn ones are reset
+            auto type = static_cast<SlottedPage::PageType>(record.payload[0]);
+            uint32_t count;
+            std::memcpy(&count, record.payload + 1, sizeof(count));
+            std::vector<uint16_t> column_widths;
+            if (type == SlottedPage::PageType::PAX) {
+                column_widths = PaxPage::decodeSchema(record.payload + 1 + sizeof(count),
+                                                      record.payload_size - 1 - sizeof(count));
+            }
+            for (uint32_t i = 0; i < count; i++) {
+                redoNewPage(rec.page_id + i, type, rec.lsn, column_widths);
+            }
+            return;
+        }
+
+        auto page = getPage(rec.page_id, BufferPool::LatchMode::EXCLUSIVE);
+        if (page->getHeader().lsn >= rec.lsn) {
+            return; // Change already on disk
+        }
+
+        if (page->getHeader().type == SlottedPage::PageType::PAX) {
+            // Row changes on a PAX page use the cell record types
+            PaxPage pax(page->getData());
+            if (rec.type == LogManager::RecordType::ADD_CELL) {
+                if (pax.addRow(record.payload) != rec.slot_id) {
+                    throw std::runtime_error("Log replay diverged on page " + std::to_string(rec.page_id));
                 }
+            } else if (rec.type == LogManager::RecordType::REMOVE_CELL) {
+                pax.removeRow(rec.slot_id);
+            } else {
+                throw std::runtime_error("Unexpected log record for PAX page " + std::to_string(rec.page_id));
             }
+            page->setLsn(rec.lsn);
+            page.markDirty();
+            return;
         }
+
+        if (page->getHeader().type == SlottedPage::PageType::ENCODED) {
+            // Sealed pages only ever lose rows
+            if (rec.type != LogManager::RecordType::REMOVE_CELL) {
+                throw std::runtime_error("Unexpected log record for encoded page " + std::to_string(rec.page_id));
+            }
+            EncodedPage(page->getData()).removeRow(rec.slot_id);
+            page->setLsn(rec.lsn);
+            page.markDirty();
+            return;
+        }
+
+        switch (rec.type) {
+            case LogManager::RecordType::ADD_CELL:
+            case LogManager::RecordType::ADD_OVERFLOW_CELL:
+                if (page->addCell(record.payload, record.payload_size,
+                                  rec.type == LogManager::RecordType::ADD_OVERFLOW_CELL) != rec.slot_id) {
+                    throw std::runtime_error("Log replay diverged on page " + std::to_string(rec.page_id));
+                }
+                break;
+            case LogManager::RecordType::REMOVE_CELL:
+                page->removeCell(rec.slot_id);
+                break;
+            case LogManager::RecordType::COMPACT:
+                page->compact();
+                break;
+            case LogManager::RecordType::UPDATE_CELL: {
+                uint16_t offset;
+                std::memcpy(&offset, record.payload, sizeof(offset));
+                auto plist = page->getPointerList();
+                uint16_t length = record.payload_size - sizeof(offset);
+                if (rec.slot_id >= plist.size || plist.start[rec.slot_id].cell_location == 0 ||
+                    offset + length > plist.start[rec.slot_id].size()) {
+                    throw std::runtime_error("Log replay diverged on page " + std::to_string(rec.page_id));
+                }
+                std::memcpy(static_cast<uint8_t*>(page->getCell(rec.slot_id)) + offset, record.payload + sizeof(offset),
+                            length);
+                break;
+            }
+            default:
+                throw std::runtime_error("Unknown log record type");
+        }
+        page->setLsn(rec.lsn);
+        page.markDirty();
+    });
+
+    if (replayed) {
+        for (size_t i = 0; i < num_pages; i++) {
+            updateFreeSpaceMap(i);
+        }
+        sync();
     }
-    
-    return num_pages; // Indicates no suitable page found
 }
 
-void HeapFile::updateFreeSpaceMap(uint32_t page_id) {
-    if (page_id >= free_space_map.size()) {
+HeapFile::RecordId HeapFile::insertRecord(const void* record, uint16_t record_size) {
+    requireWritable();
+    if (record_size > MAX_RECORD_SIZE) {
+        throw std::length_error("Record does not fit in a page");
+    }
+    if (isPax() && record_size != pax_record_size) {
+        throw std::invalid_argument("Record size does not match the PAX schema");
+    }
+    checkTuple(record, record_size);
+    return insertCell(record, record_size, false);
+}
+
+HeapFile::RecordId HeapFile::insertCell(const void* cell, uint16_t cell_size, bool is_overflow) {
+    std::shared_lock<std::shared_mutex> checkpoint_guard(checkpoint_latch);
+    // PAX rows need no pointer: a free row is exactly one record wide
+    uint16_t required_space = isPax() ? cell_size : cell_size + sizeof(SlottedPage::CellPointer);
+    auto record_type = is_overflow ? LogManager::RecordType::ADD_OVERFLOW_CELL : LogManager::RecordType::ADD_CELL;
+
+    while (true) {
+        // Find a page with enough space
+        TINYDB_COUNT(FSM_PROBES, 1);
+        uint32_t page_id = free_space_map->findPage(required_space);
+        if (page_id == FreeSpaceMap::NO_PAGE) {
+            // No existing page has enough space, allocate new page
+            page_id = allocateNewPage();
+        }
+
+        auto page = getPage(page_id, BufferPool::LatchMode::EXCLUSIVE);
+        if (usableSpace(*page) < required_space) {
+            // Another writer filled the page since the map was read
+            setFreeSpace(page_id, *page);
+            continue;
+        }
+
+        uint16_t slot_id = page->getHeader().type == SlottedPage::PageType::PAX
+                               ? PaxPage(page->getData()).addRow(cell)
+                               : page->addCell(cell, cell_size, is_overflow);
+        page->setLsn(log_manager->append(record_type, page_id, slot_id, cell, cell_size));
+        page.markDirty();
+        
+        // Update free space map
+        setFreeSpace(page_id, *page);
+        
+        return {page_id, slot_id};
+    }
+}
+
+std::vector<HeapFile::RecordId> HeapFile::insertRecords(const void* records, uint16_t record_size, size_t count,
+                                                       size_t num_threads) {
+    requireWritable();
+    if (record_size > MAX_RECORD_SIZE) {
+        throw std::length_error("Record does not fit in a page");
+    }
+    if (isPax() && record_size != pax_record_size) {
+        throw std::invalid_argument("Record size does not match the PAX schema");
+    }
+
+    const auto* input = static_cast<const uint8_t*>(records);
+    for (size_t i = 0; i < count && hasSchema(); i++) {
+        checkTuple(input + i * record_size, record_size);
+    }
+
+    std::vector<RecordId> record_ids;
+    record_ids.reserve(count);
+    if (count == 0) {
+        return record_ids;
+    }
+
+    std::shared_lock<std::shared_mutex> checkpoint_guard(checkpoint_latch);
+    std::vector<std::pair<uint32_t, uint16_t>> loaded_pages;
+
+    // Slices of whole batches, so that only the last page of each can be
+    // partly filled
+    const size_t records_per_batch = BULK_LOAD_BATCH_PAGES * (isPax() ? PaxPage::capacityFor(pax_column_widths)
+        : (SlottedPage::PAGE_SIZE - 1 - sizeof(SlottedPage::PageHeader)) /
+          (record_size + sizeof(SlottedPage::CellPointer)));
+    size_t num_slices = std::max<size_t>(1, std::min(num_threads, (count + records_per_batch - 1) / records_per_batch));
+    if (num_slices == 1) {
+        loadRecords(input, record_size, count, record_ids, loaded_pages);
+    } else {
+        size_t slice_records = (count + num_slices - 1) / num_slices;
+        slice_records = (slice_records + records_per_batch - 1) / records_per_batch * records_per_batch;
+        num_slices = (count + slice_records - 1) / slice_records;
+
+        // The calling thread loads the first slice; the checkpoint latch it
+        // holds covers the workers, which are joined before it is released
+        std::vector<std::vector<RecordId>> slice_ids(num_slices);
+        std::vector<std::vector<std::pair<uint32_t, uint16_t>>> slice_pages(num_slices);
+        std::vector<std::exception_ptr> errors(num_slices);
+        auto load_slice = [&](size_t slice) {
+            try {
+                size_t first = slice * slice_records;
+                slice_ids[slice].reserve(std::min(slice_records, count - first));
+                loadRecords(input + first * record_size, record_size, std::min(slice_records, count - first),
+                            slice_ids[slice], slice_pages[slice]);
+            } catch (...) {
+                errors[slice] = std::current_exception();
+            }
+        };
+        std::vector<std::thread> workers;
+        for (size_t slice = 1; slice < num_slices; slice++) {
+            workers.emplace_back(load_slice, slice);
+        }
+        load_slice(0);
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        for (const auto& error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+        for (size_t slice = 0; slice < num_slices; slice++) {
+            record_ids.insert(record_ids.end(), slice_ids[slice].begin(), slice_ids[slice].end());
+            loaded_pages.insert(loaded_pages.end(), slice_pages[slice].begin(), slice_pages[slice].end());
+        }
+    }
+
+    // Make the pages durable before other inserts can land on them, since
+    // later log records for these pages assume they are on disk
+    syncPages();
+    for (const auto& [page_id, free_bytes] : loaded_pages) {
+        free_space_map->addPage(page_id, free_bytes);
+    }
+
+    return record_ids;
+}
+
+void HeapFile::loadRecords(const uint8_t* input, uint16_t record_size, size_t count,
+                           std::vector<RecordId>& record_ids,
+                           std::vector<std::pair<uint32_t, uint16_t>>& loaded_pages) {
+    const auto type = heapPageType();
+    const size_t records_per_page = isPax() ? PaxPage::capacityFor(pax_column_widths)
+        : (SlottedPage::PAGE_SIZE - 1 - sizeof(SlottedPage::PageHeader)) /
+          (record_size + sizeof(SlottedPage::CellPointer));
+    std::unique_ptr<EncodedPage::Builder> encoder;
+    if (encode_bulk_loads) {
+        encoder = std::make_unique<EncodedPage::Builder>(pax_column_widths);
+    }
+
+    // Pages are filled in memory, bypassing the buffer pool and free-space
+    // search, and each batch is submitted to the I/O backend at once
+    std::vector<SlottedPage> batch;
+    batch.reserve(BULK_LOAD_BATCH_PAGES);
+    std::vector<IoBackend::Request> requests(BULK_LOAD_BATCH_PAGES);
+    std::vector<uint8_t> payload;
+
+    size_t next = 0;
+    while (next < count) {
+        // Fill the batch first and claim its pages after, since sealed
+        // pages only show how many they take once built; the ids recorded
+        // meanwhile are offsets into the batch
+        size_t batch_first_id = record_ids.size();
+        size_t batch_pages = 0;
+        for (; batch_pages < BULK_LOAD_BATCH_PAGES && next < count; batch_pages++) {
+            if (batch.size() == batch_pages) {
+                batch.emplace_back(type, 0);
+            }
+            SlottedPage& page = batch[batch_pages];
+            uint32_t page_offset = static_cast<uint32_t>(batch_pages);
+
+            if (encoder) {
+                // Sealed pages take rows until the encoded columns fill them
+                while (next < count && encoder->add(input + next * record_size)) {
+                    next++;
+                }
+                for (size_t row = 0; row < encoder->getNumRows(); row++) {
+                    record_ids.push_back({page_offset, static_cast<uint16_t>(row)});
+                }
+                page.reset(SlottedPage::PageType::ENCODED, 0);
+                encoder->build(page.getData());
+                continue;
+            }
+
+            page.reset(type, 0);
+            formatHeapPage(page);
+            for (size_t r = 0; r < records_per_page && next < count; r++, next++) {
+                const uint8_t* record = input + next * record_size;
+                uint16_t slot_id = isPax() ? PaxPage(page.getData()).addRow(record)
+                                           : page.addCell(record, record_size);
+                record_ids.push_back({page_offset, slot_id});
+            }
+        }
+
+        uint32_t first_page = static_cast<uint32_t>(num_pages.fetch_add(batch_pages));
+        for (size_t i = batch_first_id; i < record_ids.size(); i++) {
+            record_ids[i].page_id += first_page;
+        }
+
+        // Log the allocation before writing so recovery can reset torn
+        // pages; those of sealed pages come back as empty PAX pages
+        uint32_t page_count = static_cast<uint32_t>(batch_pages);
+        payload.assign(1 + sizeof(uint32_t), 0);
+        payload[0] = static_cast<uint8_t>(type);
+        std::memcpy(payload.data() + 1, &page_count, sizeof(page_count));
+        if (isPax()) {
+            PaxPage::encodeSchema(pax_column_widths, payload);
+        }
+        uint64_t lsn = log_manager->append(LogManager::RecordType::NEW_PAGE_RANGE, first_page, 0,
+                                           payload.data(), payload.size());
+        log_manager->flush(lsn);
+
+        for (size_t i = 0; i < batch_pages; i++) {
+            SlottedPage& page = batch[i];
+            uint32_t page_id = first_page + i;
+            page.setId(page_id);
+            page.setLsn(lsn);
+            requests[i] = {IoBackend::Request::Op::WRITE, file_descriptor, page.getData(), SlottedPage::PAGE_SIZE,
+                           static_cast<off_t>(page_id * SlottedPage::PAGE_SIZE), 0};
+            loaded_pages.emplace_back(page_id, usableSpace(page));
+        }
+
+        submitPageIo(requests.data(), batch_pages);
+        for (size_t i = 0; i < batch_pages; i++) {
+            if (requests[i].result != static_cast<ssize_t>(SlottedPage::PAGE_SIZE)) {
+                throw std::runtime_error("Failed to write bulk-loaded pages");
+            }
+        }
+    }
+}
+
+bool HeapFile::deleteRecord(uint32_t page_id, uint16_t slot_id) {
+    requireWritable();
+    if (page_id >= num_pages) {
+        return false;
+    }
+
+    std::shared_lock<std::shared_mutex> checkpoint_guard(checkpoint_latch);
+    OverflowStub stub{0, SlottedPage::NO_PAGE, 0};
+    {
+        auto page = getPage(page_id, BufferPool::LatchMode::EXCLUSIVE);
+        if (page->getHeader().type == SlottedPage::PageType::PAX) {
+            // A freed row is reusable at once; nothing to compact
+            PaxPage pax(page->getData());
+            if (!pax.isLive(slot_id)) {
+                return false;
+            }
+            pax.removeRow(slot_id);
+            page->setLsn(log_manager->append(LogManager::RecordType::REMOVE_CELL, page_id, slot_id));
+            page.markDirty();
+            setFreeSpace(page_id, *page);
+            return true;
+        }
+        if (page->getHeader().type == SlottedPage::PageType::ENCODED) {
+            // The row's values stay encoded; sealed pages never take new rows
+            EncodedPage encoded(page->getData());
+            if (!encoded.isLive(slot_id)) {
+                return false;
+            }
+            encoded.removeRow(slot_id);
+            page->setLsn(log_manager->append(LogManager::RecordType::REMOVE_CELL, page_id, slot_id));
+            page.markDirty();
+            return true;
+        }
+
+        auto plist = page->getPointerList();
+        if (page->getHeader().type != SlottedPage::PageType::LEAF || slot_id >= plist.size ||
+            plist.start[slot_id].cell_location == 0) {
+            return false;
+        }
+        if (plist.start[slot_id].isOverflow()) {
+            std::memcpy(&stub, page->getCell(slot_id), sizeof(stub));
+        }
+
+        page->removeCell(slot_id);
+        page->setLsn(log_manager->append(LogManager::RecordType::REMOVE_CELL, page_id, slot_id));
+        page.markDirty();
+
+        // Compacting keeps slot numbers, so it can run as soon as enough
+        // space is stranded rather than waiting for compactPage()
+        if (compaction_threshold_bytes > 0 && page->getFragmentedBytes() >= compaction_threshold_bytes) {
+            page->compact();
+            page->setLsn(log_manager->append(LogManager::RecordType::COMPACT, page_id, 0));
+            setFreeSpace(page_id, *page);
+            TINYDB_COUNT(COMPACTIONS, 1);
+        }
+    }
+
+    // With the stub gone nothing reaches the chain; a crash part way
+    // through only leaks the rest of it
+    uint32_t overflow_page = stub.first_page;
+    for (uint32_t i = 0; i < stub.num_pages && overflow_page < num_pages; i++) {
+        overflow_page = freeOverflowPage(overflow_page);
+    }
+    return true;
+}
+
+bool HeapFile::updateRecord(uint32_t page_id, uint16_t slot_id,
+                            const std::function<bool(void* record, uint16_t record_size)>& update) {
+    requireWritable();
+    if (page_id >= num_pages) {
+        return false;
+    }
+
+    std::shared_lock<std::shared_mutex> checkpoint_guard(checkpoint_latch);
+    auto page = getPage(page_id, BufferPool::LatchMode::EXCLUSIVE);
+    auto plist = page->getPointerList();
+    if (page->getHeader().type != SlottedPage::PageType::LEAF || slot_id >= plist.size ||
+        plist.start[slot_id].cell_location == 0 || plist.start[slot_id].isOverflow()) {
+        return false;
+    }
+
+    // Edit in place, keeping the old bytes to restore a declined update
+    // and to find the range that changed
+    uint16_t size = plist.start[slot_id].size();
+    auto* cell = static_cast<uint8_t*>(page->getCell(slot_id));
+    thread_local std::vector<uint8_t> before;
+    before.assign(cell, cell + size);
+    if (!update(cell, size)) {
+        std::memcpy(cell, before.data(), size);
+        return false;
+    }
+    uint16_t first = 0;
+    while (first < size && cell[first] == before[first]) {
+        first++;
+    }
+    if (first == size) {
+        return true;
+    }
+    uint16_t end = size;
+    while (cell[end - 1] == before[end - 1]) {
+        end--;
+    }
+
+    thread_local std::vector<uint8_t> payload;
+    payload.resize(sizeof(first) + end - first);
+    std::memcpy(payload.data(), &first, sizeof(first));
+    std::memcpy(payload.data() + sizeof(first), cell + first, end - first);
+    page->setLsn(log_manager->append(LogManager::RecordType::UPDATE_CELL, page_id, slot_id, payload.data(),
+                                     static_cast<uint16_t>(payload.size())));
+    page.markDirty();
+    return true;
+}
+
+uint32_t HeapFile::freeOverflowPage(uint32_t page_id) {
+    const auto type = SlottedPage::PageType::LEAF;
+    auto page = getPage(page_id, BufferPool::LatchMode::EXCLUSIVE);
+    if (page->getHeader().type != SlottedPage::PageType::OVERFLOW) {
+        return SlottedPage::NO_PAGE;
+    }
+
+    uint32_t next_page = page->getHeader().next_page;
+    uint8_t payload = static_cast<uint8_t>(type);
+    page->reset(type, page_id);
+    page->setLsn(log_manager->append(LogManager::RecordType::NEW_PAGE, page_id, 0, &payload, sizeof(payload)));
+    page.markDirty();
+    setFreeSpace(page_id, *page);
+    return next_page;
+}
+
+uint32_t HeapFile::allocateOverflowPages(uint32_t count, uint64_t& lsn) {
+    const auto type = SlottedPage::PageType::OVERFLOW;
+    uint32_t first_page = static_cast<uint32_t>(num_pages.fetch_add(count));
+
+    // As for bulk loads, the durable allocation lets recovery reset pages
+    // that were torn or never written
+    uint8_t payload[1 + sizeof(uint32_t)];
+    payload[0] = static_cast<uint8_t>(type);
+    std::memcpy(payload + 1, &count, sizeof(count));
+    lsn = log_manager->append(LogManager::RecordType::NEW_PAGE_RANGE, first_page, 0, payload, sizeof(payload));
+    log_manager->flush(lsn);
+    return first_page;
+}
+
+void HeapFile::compactPage(uint32_t page_id) {
+    requireWritable();
+    std::shared_lock<std::shared_mutex> checkpoint_guard(checkpoint_latch);
+    auto page = getPage(page_id, BufferPool::LatchMode::EXCLUSIVE);
+    if (page->getHeader().type != SlottedPage::PageType::LEAF || !(page->getHeader().flags & SlottedPage::CAN_COMPACT)) {
         return;
     }
 
-    auto page = getPage(page_id);
-    float free_fraction = calculatePageFreeSpace(*page);
-    
-    // Update main map
-    free_space_map[page_id].free_fraction = 
-        std::min(static_cast<uint8_t>(free_fraction * MAX_FREE_FRACTION), MAX_FREE_FRACTION);
-    
-    // Update second level map
-    updateSecondLevelMap(page_id / ENTRIES_PER_SECOND_LEVEL);
+    page->compact();
+    page->setLsn(log_manager->append(LogManager::RecordType::COMPACT, page_id, 0));
+    page.markDirty();
+    setFreeSpace(page_id, *page);
+    TINYDB_COUNT(COMPACTIONS, 1);
 }
 
-void HeapFile::updateSecondLevelMap(size_t start_idx) {
-    size_t start = start_idx * ENTRIES_PER_SECOND_LEVEL;
-    size_t end = std::min(start + ENTRIES_PER_SECOND_LEVEL, free_space_map.size());
-    
-    uint8_t max_fraction = 0;
-    for (size_t i = start; i < end; i++) {
-        max_fraction = std::max(max_fraction, free_space_map[i].free_fraction);
+void HeapFile::commit() {
+    requireWritable();
+    // Concurrent committers share a single log fsync
+    log_manager->flushAll();
+}
+
+void* HeapFile::getRecord(uint32_t page_id, uint16_t slot_id) {
+    if (mapping != nullptr) {
+        // Zero-copy: point straight into the read-only mapping
+        const auto* pointer = getMappedCell(page_id, slot_id);
+        if (pointer == nullptr) {
+            return nullptr;
+        }
+        return const_cast<uint8_t*>(getMappedPage(page_id) + pointer->cell_location);
     }
-    
-    second_level_map[start_idx].free_fraction = max_fraction;
+
+    if (page_id >= num_pages) {
+        return nullptr;
+    }
+
+    // The returned pointer refers to the buffered page and stays valid until
+    // the page is evicted or modified by a later operation
+    auto page = getPage(page_id, BufferPool::LatchMode::SHARED);
+    auto plist = page->getPointerList();
+    if (page->getHeader().type != SlottedPage::PageType::LEAF || slot_id >= plist.size) {
+        return nullptr;
+    }
+    return page->getCell(slot_id);
+}
+
+bool HeapFile::isLargeRecord(uint32_t page_id, uint16_t slot_id) {
+    if (mapping != nullptr) {
+        const auto* pointer = getMappedCell(page_id, slot_id);
+        return pointer != nullptr && pointer->isOverflow();
+    }
+
+    if (page_id >= num_pages) {
+        return false;
+    }
+
+    auto page = getPage(page_id, BufferPool::LatchMode::SHARED);
+    auto plist = page->getPointerList();
+    return page->getHeader().type == SlottedPage::PageType::LEAF && slot_id < plist.size &&
+           plist.start[slot_id].cell_location != 0 && plist.start[slot_id].isOverflow();
+}
+
+uint16_t HeapFile::readRecord(uint32_t page_id, uint16_t slot_id, void* buffer, uint16_t buffer_size) {
+    if (mapping != nullptr) {
+        const uint8_t* page = getMappedPage(page_id);
+        auto type = page != nullptr ? reinterpret_cast<const SlottedPage::PageHeader*>(page)->type
+                                    : SlottedPage::PageType::LEAF;
+        if (type == SlottedPage::PageType::PAX) {
+            PaxPage pax(const_cast<uint8_t*>(page));
+            return pax.isLive(slot_id) ? pax.readRow(slot_id, buffer, buffer_size) : 0;
+        }
+        if (type == SlottedPage::PageType::ENCODED) {
+            EncodedPage encoded(const_cast<uint8_t*>(page));
+            return encoded.isLive(slot_id) ? encoded.readRow(slot_id, buffer, buffer_size) : 0;
+        }
+
+        const auto* pointer = getMappedCell(page_id, slot_id);
+        if (pointer == nullptr) {
+            return 0;
+        }
+        uint16_t size = std::min(pointer->size(), buffer_size);
+        std::memcpy(buffer, getMappedPage(page_id) + pointer->cell_location, size);
+        return size;
+    }
+
+    if (page_id >= num_pages) {
+        return 0;
+    }
+
+    auto page = getPage(page_id, BufferPool::LatchMode::SHARED);
+    if (page->getHeader().type == SlottedPage::PageType::PAX) {
+        PaxPage pax(page->getData());
+        return pax.isLive(slot_id) ? pax.readRow(slot_id, buffer, buffer_size) : 0;
+    }
+    if (page->getHeader().type == SlottedPage::PageType::ENCODED) {
+        EncodedPage encoded(page->getData());
+        return encoded.isLive(slot_id) ? encoded.readRow(slot_id, buffer, buffer_size) : 0;
+    }
+
+    auto plist = page->getPointerList();
+    if (page->getHeader().type != SlottedPage::PageType::LEAF || slot_id >= plist.size ||
+        plist.start[slot_id].cell_location == 0) {
+        return 0;
+    }
+
+    uint16_t size = std::min(plist.start[slot_id].size(), buffer_size);
+    std::memcpy(buffer, page->getCell(slot_id), size);
+    return size;
+}
+
+uint32_t HeapFile::findPageWithSpace(uint16_t required_space) {
+    requireWritable();
+    // Candidates are only a hint: the caller re-checks the page under its
+    // latch and corrects the map if it is stale
+    uint32_t page_id = free_space_map->findPage(required_space + sizeof(SlottedPage::CellPointer));
+    return page_id == FreeSpaceMap::NO_PAGE ? static_cast<uint32_t>(num_pages) : page_id;
+}
+
+void HeapFile::updateFreeSpaceMap(uint32_t page_id) {
+    requireWritable();
+    if (page_id >= num_pages) {
+        return;
+    }
+
+    auto page = getPage(page_id, BufferPool::LatchMode::SHARED);
+    setFreeSpace(page_id, *page);
+}
+
+void HeapFile::setFreeSpace(uint32_t page_id, const SlottedPage& page) {
+    free_space_map->update(page_id, usableSpace(page));
 }
 
-float HeapFile::calculatePageFreeSpace(const SlottedPage& page) {
-    const auto& header = page.getHeader();
-    return static_cast<float>(header.total_free) / SlottedPage::PAGE_SIZE;
+uint16_t HeapFile::usableSpace(const SlottedPage& page) {
+    // Only heap pages take records; overflow and sealed pages always look full
+    switch (page.getHeader().type) {
+        case SlottedPage::PageType::LEAF:
+            return page.getHeader().total_free;
+        case SlottedPage::PageType::PAX: {
+            PaxPage pax(const_cast<uint8_t*>(page.getData()));
+            return static_cast<uint16_t>(std::min<size_t>(UINT16_MAX, size_t(pax.getFreeRows()) * pax.getRowSize()));
+        }
+        default:
+            return 0;
+    }
 }
 
 void HeapFile::recomputeFreeSpaceMap() {
+    requireWritable();
     for (size_t i = 0; i < num_pages; i++) {
-        updateFreeSpaceMap(i);
+        auto page = getPage(i, BufferPool::LatchMode::SHARED);
+        free_space_map->addPage(i, usableSpace(*page));
     }
-    writeFreeSpaceMapToDisk();
+    free_space_map->sync();
 }
 
 uint32_t HeapFile::allocateNewPage() {
-    uint32_t new_page_id = num_pages++;
-    auto new_page = std::make_unique<SlottedPage>(SlottedPage::PageType::LEAF, new_page_id);
+    uint32_t new_page_id = static_cast<uint32_t>(num_pages.fetch_add(1));
+    auto type = heapPageType();
     
-    // Extend free space maps
-    free_space_map.push_back({MAX_FREE_FRACTION});
-    if (new_page_id % ENTRIES_PER_SECOND_LEVEL == 0) {
-        second_level_map.push_back({MAX_FREE_FRACTION});
+    // The page reaches disk through the buffer pool once its log record is
+    // durable; PAX pages carry the schema so recovery can lay them out.
+    // The payload reuses a per-thread buffer.
+    thread_local std::vector<uint8_t> payload;
+    payload.assign(1, static_cast<uint8_t>(type));
+    if (isPax()) {
+        PaxPage::encodeSchema(pax_column_widths, payload);
     }
-    
-    // Save the new page
-    new_page->savePage(file_descriptor);
+    uint64_t lsn = log_manager->append(LogManager::RecordType::NEW_PAGE, new_page_id, 0,
+                                       payload.data(), payload.size());
+    auto* page = buffer_pool->newPage(new_page_id, type);
+    formatHeapPage(*page);
+    page->setLsn(lsn);
+    uint16_t free_bytes = usableSpace(*page);
+    buffer_pool->unpinPage(new_page_id, true);
+
+    // Only publish the page in the map once it is resident
+    free_space_map->addPage(new_page_id, free_bytes);
     
     return new_page_id;
 }
 
-std::shared_ptr<SlottedPage> HeapFile::getPage(uint32_t page_id) {
-    // Check cache first
-    auto cache_it = std::find_if(page_cache.begin(), page_cache.end(),
-        [page_id](const CachedPage& cached) { return cached.page_id == page_id; });
-    
-    if (cache_it != page_cache.end()) {
-        return cache_it->page;
+void HeapFile::submitPageIo(IoBackend::Request* requests, std::size_t count, IoBackend* backend) {
+#if TINYDB_METRICS
+    auto start = std::chrono::steady_clock::now();
+#endif
+    if (compressed_file) {
+        compressed_file->submit(requests, count);
+    } else {
+        (backend != nullptr ? backend : io_backend.get())->submit(requests, count);
     }
-    
-    // Create new page
-    auto page = std::make_shared<SlottedPage>(SlottedPage::PageType::LEAF, page_id);
-    
-    // Load data if page exists
-    if (page_id < num_pages) {
-        // Load existing page data
-        lseek(file_descriptor, page_id * SlottedPage::PAGE_SIZE, SEEK_SET);
-        read(file_descriptor, page->getData(), SlottedPage::PAGE_SIZE);
+#if TINYDB_METRICS
+    std::size_t writes = std::count_if(requests, requests + count, [](const IoBackend::Request& request) {
+        return request.op == IoBackend::Request::Op::WRITE;
+    });
+    if (writes > 0) {
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        Metrics::record(Metrics::Latency::BATCH_WRITE,
+                        static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
     }
-    
-    // Cache management
-    if (page_cache.size() >= PAGE_CACHE_SIZE) {
-        if (page_cache.front().is_dirty) {
-            flushPage(page_cache.front().page_id);
+    direct_page_writes += writes;
+    TINYDB_COUNT(PAGES_WRITTEN, writes);
+    TINYDB_COUNT(PAGES_READ, count - writes);
+#endif
+}
+
+void HeapFile::syncPages() {
+    {
+        TINYDB_TIME(DATA_SYNC);
+        if (compressed_file) {
+            compressed_file->sync();
+        } else if (fdatasync(file_descriptor) == -1) {
+            throw std::runtime_error("Failed to sync heap file: " + filename);
         }
-        page_cache.erase(page_cache.begin());
     }
-    
-    page_cache.push_back({page_id, page, false});
-    return page;
+#if TINYDB_METRICS
+    // Page bytes this sync made durable: everything written since the
+    // last one, by the buffer pool or directly
+    uint64_t page_writes = buffer_pool->getStats().dirty_writes + direct_page_writes;
+    uint64_t previous = synced_page_writes.load();
+    while (page_writes > previous && !synced_page_writes.compare_exchange_weak(previous, page_writes)) {
+    }
+    TINYDB_COUNT(FSYNCS, 1);
+    TINYDB_COUNT(BYTES_FSYNCED, page_writes > previous ? (page_writes - previous) * SlottedPage::PAGE_SIZE : 0);
+#endif
 }
 
-void HeapFile::flushPage(uint32_t page_id) {
-    auto cache_it = std::find_if(page_cache.begin(), page_cache.end(),
-        [page_id](const CachedPage& cached) { return cached.page_id == page_id; });
-    
-    if (cache_it != page_cache.end() && cache_it->is_dirty) {
-        cache_it->page->savePage(file_descriptor);
-        cache_it->is_dirty = false;
+BufferPool::PageGuard HeapFile::getPage(uint32_t page_id, BufferPool::LatchMode mode) {
+    if (page_id >= num_pages) {
+        throw std::out_of_range("Page id beyond end of heap file");
     }
+    return BufferPool::PageGuard(*buffer_pool, page_id, mode);
 }
 
 void HeapFile::sync() {
+    requireWritable();
+    TINYDB_TIME(CHECKPOINT);
+    // Quiesce writers so no change slips in between the page flush and the
+    // log truncation
+    std::unique_lock<std::shared_mutex> checkpoint_guard(checkpoint_latch);
+
     // Flush all dirty pages
-    for (auto& cached : page_cache) {
-        if (cached.is_dirty) {
-            flushPage(cached.page_id);
-        }
-    }
+    log_manager->flushAll();
+    buffer_pool->flushAllPages();
     
     // Write free space map
-    writeFreeSpaceMapToDisk();
+    free_space_map->sync();
     
-    // Sync file to disk
-    fsync(file_descriptor);
+    // Sync file to disk; every logged change is now in the data file
+    syncPages();
+    log_manager->truncate();
 }
 
-void HeapFile::close() {
-    sync();
-    ::close(file_descriptor);
-}
+void HeapFile::checkpoint(uint32_t spread_ms) {
+    requireWritable();
+    TINYDB_TIME(CHECKPOINT);
 
-void HeapFile::writeFreeSpaceMapToDisk() {
-    // Write maps at the end of the file
-    off_t maps_offset = num_pages * SlottedPage::PAGE_SIZE;
-    lseek(file_descriptor, maps_offset, SEEK_SET);
-    
-    write(file_descriptor, free_space_map.data(), free_space_map.size() * sizeof(FreeSpaceEntry));
-    write(file_descriptor, second_level_map.data(), second_level_map.size() * sizeof(FreeSpaceEntry));
+    uint64_t begin_lsn;
+    std::vector<uint32_t> dirty;
+    {
+        // With writers drained, every change logged up to begin_lsn is in
+        // its page, and that page is either listed or already written
+        std::unique_lock<std::shared_mutex> checkpoint_guard(checkpoint_latch);
+        begin_lsn = log_manager->getLastLsn();
+        dirty = buffer_pool->getDirtyPages();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (size_t first = 0; first < dirty.size(); first += BufferPool::FLUSH_BATCH_PAGES) {
+        size_t count = std::min(BufferPool::FLUSH_BATCH_PAGES, dirty.size() - first);
+        buffer_pool->flushPages(dirty.data() + first, count);
+
+        // Pace the batches evenly over the spread; shutting down finishes
+        // the rest at full speed
+        if (spread_ms > 0) {
+            auto due = start + std::chrono::milliseconds(spread_ms) * (first + count) / dirty.size();
+            std::unique_lock<std::mutex> lock(checkpointer_latch);
+            if (checkpointer_cv.wait_until(lock, due, [this] { return checkpointer_stopping; })) {
+                spread_ms = 0;
+            }
+        }
+    }
+
+    free_space_map->sync();
+    syncPages();
+    log_manager->truncateBefore(begin_lsn + 1);
 }
 
-void HeapFile::readFreeSpaceMapFromDisk() {
-    off_t maps_offset = num_pages * SlottedPage::PAGE_SIZE;
-    lseek(file_descriptor, maps_offset, SEEK_SET);
-    
-    read(file_descriptor, free_space_map.data(), free_space_map.size() * sizeof(FreeSpaceEntry));
-    read(file_descriptor, second_level_map.data(), second_level_map.size() * sizeof(FreeSpaceEntry));
+void HeapFile::close() {
+    stopBackgroundWork();
+    if (access_mode == HeapFileOptions::AccessMode::READ_WRITE) {
+        sync();
+    }
+    unmapFile();
+    ::close(file_descriptor);
 }
 
 void HeapFile::printFreeSpaceMap() const {
-    std::cout << "Main Free Space Map:\n";
-    for (size_t i = 0; i < free_space_map.size(); i++) {
-        std::cout << "Block " << i << ": " << static_cast<int>(free_space_map[i].free_fraction) 
-                 << "/" << static_cast<int>(MAX_FREE_FRACTION) << "\n";
-    }
-    
-    std::cout << "\nSecond Level Map:\n";
-    for (size_t i = 0; i < second_level_map.size(); i++) {
-        std::cout << "Entry " << i << ": " << static_cast<int>(second_level_map[i].free_fraction)
-                 << "/" << static_cast<int>(MAX_FREE_FRACTION) << "\n";
+    if (free_space_map) {
+        free_space_map->print(std::cout);
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,173 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "storage/heap_scanner.hpp"
+
+HeapScanner::HeapScanner(HeapFile& heap_file, std::size_t readahead_pages)
+    : HeapScanner(heap_file, 0, heap_file.getNumPages(), readahead_pages) {}
+
+HeapScanner::HeapScanner(HeapFile& heap_file, uint32_t first_page, std::size_t end_page,
+                         std::size_t readahead_pages, IoBackend* io_backend)
+    : heap_file(heap_file),
+      io_backend(io_backend),
+      readahead_pages(std::max<std::size_t>(readahead_pages, 1)),
+      chunk(allocateAligned(this->readahead_pages * SlottedPage::PAGE_SIZE)) {
+    setRange(first_page, end_page);
+}
+
+void HeapScanner::setRange(uint32_t first_page, std::size_t end_page) {
+    this->end_page = end_page;
+    chunk_pages = 0;
+    page_started = false;
+    if (first_page < end_page) {
+        posix_fadvise(heap_file.getFileDescriptor(), static_cast<off_t>(first_page) * SlottedPage::PAGE_SIZE,
+                      static_cast<off_t>(end_page - first_page) * SlottedPage::PAGE_SIZE, POSIX_FADV_SEQUENTIAL);
+        loadChunk(first_page);
+    }
+}
+
+bool HeapScanner::next() {
+    while (chunk_pages > 0) {
+        if (advanceInPage()) {
+            return true;
+        }
+
+        // Current page exhausted
+        page_in_chunk++;
+        slot_started = false;
+        if (page_in_chunk == chunk_pages && !loadChunk(chunk_first_page + chunk_pages)) {
+            chunk_pages = 0;
+        }
+    }
+
+    record = nullptr;
+    record_size = 0;
+    return false;
+}
+
+const uint8_t* HeapScanner::nextPage() {
+    if (page_started && chunk_pages > 0) {
+        page_in_chunk++;
+        if (page_in_chunk == chunk_pages && !loadChunk(chunk_first_page + chunk_pages)) {
+            chunk_pages = 0;
+        }
+    }
+    page_started = true;
+    return chunk_pages > 0 ? chunk.get() + page_in_chunk * SlottedPage::PAGE_SIZE : nullptr;
+}
+
+bool HeapScanner::advanceInPage() {
+    uint8_t* page = chunk.get() + page_in_chunk * SlottedPage::PAGE_SIZE;
+    const auto* header = reinterpret_cast<const SlottedPage::PageHeader*>(page);
+
+    if (header->type == SlottedPage::PageType::PAX) {
+        PaxPage pax(page);
+        for (std::size_t row = slot_started ? slot_id + 1u : 0; row < pax.getNumRows(); row++) {
+            if (pax.isLive(row)) {
+                slot_id = static_cast<uint16_t>(row);
+                slot_started = true;
+                row_buffer.resize(pax.getRowSize());
+                record_size = pax.readRow(slot_id, row_buffer.data(), pax.getRowSize());
+                record = row_buffer.data();
+                large_record = false;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    if (header->type == SlottedPage::PageType::ENCODED) {
+        EncodedPage encoded(page);
+        for (std::size_t row = slot_started ? slot_id + 1u : 0; row < encoded.getNumRows(); row++) {
+            if (encoded.isLive(row)) {
+                slot_id = static_cast<uint16_t>(row);
+                slot_started = true;
+                row_buffer.resize(encoded.getRowSize());
+                record_size = encoded.readRow(slot_id, row_buffer.data(), encoded.getRowSize());
+                record = row_buffer.data();
+                large_record = false;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Unwritten space past the end of the file reads back as zeroes;
+    // overflow pages hold no cells of their own
+    if (header->type != SlottedPage::PageType::LEAF || header->free_start < sizeof(SlottedPage::PageHeader)) {
+        return false;
+    }
+
+    std::size_t num_slots = (header->free_start - sizeof(SlottedPage::PageHeader)) / sizeof(SlottedPage::CellPointer);
+    const auto* pointers = reinterpret_cast<const SlottedPage::CellPointer*>(page + sizeof(SlottedPage::PageHeader));
+
+    std::size_t slot = slot_started ? slot_id + 1u : 0;
+    for (; slot < num_slots; slot++) {
+        if (pointers[slot].cell_location != 0) {
+            slot_id = static_cast<uint16_t>(slot);
+            slot_started = true;
+            record = page + pointers[slot].cell_location;
+            record_size = pointers[slot].size();
+            large_record = pointers[slot].isOverflow();
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HeapScanner::loadChunk(uint32_t first_page) {
+    if (first_page >= end_page) {
+        return false;
+    }
+
+    int fd = heap_file.getFileDescriptor();
+    std::size_t count = std::min(readahead_pages, end_page - first_page);
+    chunk_first_page = first_page;
+    chunk_pages = count;
+    page_in_chunk = 0;
+    slot_started = false;
+
+    // Take pages the buffer pool holds first (they may be newer than disk),
+    // then read each run of remaining pages as one request of a batch
+    std::vector<bool> resident(count);
+    for (std::size_t i = 0; i < count; i++) {
+        resident[i] = heap_file.getBufferPool().copyPageIfResident(
+            first_page + i, chunk.get() + i * SlottedPage::PAGE_SIZE);
+    }
+
+    requests.clear();
+    std::size_t i = 0;
+    while (i < count) {
+        if (resident[i]) {
+            i++;
+            continue;
+        }
+        std::size_t run_end = i;
+        while (run_end < count && !resident[run_end]) {
+            run_end++;
+        }
+        requests.push_back({IoBackend::Request::Op::READ, fd, chunk.get() + i * SlottedPage::PAGE_SIZE,
+                            (run_end - i) * SlottedPage::PAGE_SIZE,
+                            static_cast<off_t>((first_page + i) * SlottedPage::PAGE_SIZE), 0});
+        i = run_end;
+    }
+
+    heap_file.submitPageIo(requests.data(), requests.size(), io_backend);
+    for (const auto& request : requests) {
+        if (request.result < 0) {
+            throw std::runtime_error("Failed to read pages during scan");
+        }
+        std::memset(static_cast<uint8_t*>(request.buffer) + request.result, 0, request.length - request.result);
+    }
+
+    // Ask the kernel to start reading the following chunk while this one is processed
+    std::size_t next_first = first_page + count;
+    if (next_first < end_page && !heap_file.isCompressed()) {
+        std::size_t next_count = std::min(readahead_pages, end_page - next_first);
+        posix_fadvise(fd, static_cast<off_t>(next_first) * SlottedPage::PAGE_SIZE,
+                      static_cast<off_t>(next_count) * SlottedPage::PAGE_SIZE, POSIX_FADV_WILLNEED);
+    }
+    return true;
+}
@@ -0,0 +1,242 @@
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+#include <vector>
+#include "storage/io_backend.hpp"
+
+namespace {
+
+unsigned* ringField(void* ring, uint32_t offset) {
+    return reinterpret_cast<unsigned*>(static_cast<uint8_t*>(ring) + offset);
+}
+
+unsigned loadAcquire(const unsigned* field) {
+    return __atomic_load_n(field, __ATOMIC_ACQUIRE);
+}
+
+void storeRelease(unsigned* field, unsigned value) {
+    __atomic_store_n(field, value, __ATOMIC_RELEASE);
+}
+
+} // namespace
+
+std::unique_ptr<IoBackend> IoBackend::create(Kind kind) {
+    switch (kind) {
+        case Kind::SYNC:
+            return std::make_unique<SyncIoBackend>();
+        case Kind::IO_URING:
+            return std::make_unique<IoUringBackend>();
+        case Kind::AUTO:
+            try {
+                return std::make_unique<IoUringBackend>();
+            } catch (const std::runtime_error&) {
+                // Old kernel, or io_uring disabled by policy
+                return std::make_unique<SyncIoBackend>();
+            }
+    }
+    return std::make_unique<SyncIoBackend>();
+}
+
+bool IoBackend::syncDirectory(const std::string& path) {
+    std::size_t slash = path.rfind('/');
+    std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+    int fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (fd == -1) {
+        return false;
+    }
+    bool ok = fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+ssize_t IoBackend::read(int fd, void* buffer, std::size_t length, off_t offset) {
+    std::size_t done = 0;
+    while (done < length) {
+        ssize_t bytes = pread(fd, static_cast<uint8_t*>(buffer) + done, length - done, offset + done);
+        if (bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes < 0) {
+            return -1;
+        }
+        if (bytes == 0) {
+            break; // End of file
+        }
+        done += bytes;
+    }
+    return static_cast<ssize_t>(done);
+}
+
+ssize_t IoBackend::write(int fd, const void* buffer, std::size_t length, off_t offset) {
+    std::size_t done = 0;
+    while (done < length) {
+        ssize_t bytes = pwrite(fd, static_cast<const uint8_t*>(buffer) + done, length - done, offset + done);
+        if (bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes <= 0) {
+            return -1;
+        }
+        done += bytes;
+    }
+    return static_cast<ssize_t>(done);
+}
+
+void SyncIoBackend::submit(Request* requests, std::size_t count) {
+    for (std::size_t i = 0; i < count; i++) {
+        Request& request = requests[i];
+        ssize_t bytes = request.op == Request::Op::READ
+            ? read(request.fd, request.buffer, request.length, request.offset)
+            : write(request.fd, request.buffer, request.length, request.offset);
+        request.result = bytes < 0 ? -errno : bytes;
+    }
+}
+
+IoUringBackend::IoUringBackend(unsigned queue_depth) {
+    struct io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, queue_depth, &params));
+    if (ring_fd < 0) {
+        throw std::runtime_error("io_uring is not available");
+    }
+
+    sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single_mmap) {
+        sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+    }
+
+    sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                   ring_fd, IORING_OFF_SQ_RING);
+    if (sq_ring == MAP_FAILED) {
+        sq_ring = nullptr;
+        ::close(ring_fd);
+        throw std::runtime_error("Failed to map io_uring submission ring");
+    }
+    cq_ring = single_mmap ? sq_ring
+                          : mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                                 ring_fd, IORING_OFF_CQ_RING);
+    sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes_map = cq_ring == MAP_FAILED ? MAP_FAILED
+                   : mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                          ring_fd, IORING_OFF_SQES);
+    if (cq_ring == MAP_FAILED || sqes_map == MAP_FAILED) {
+        if (cq_ring == MAP_FAILED) {
+            cq_ring = nullptr;
+        }
+        unmapRings();
+        ::close(ring_fd);
+        throw std::runtime_error("Failed to map io_uring rings");
+    }
+    sqes = static_cast<struct io_uring_sqe*>(sqes_map);
+
+    sq_head = ringField(sq_ring, params.sq_off.head);
+    sq_tail = ringField(sq_ring, params.sq_off.tail);
+    sq_mask = ringField(sq_ring, params.sq_off.ring_mask);
+    sq_array = ringField(sq_ring, params.sq_off.array);
+    sq_entries = params.sq_entries;
+    cq_head = ringField(cq_ring, params.cq_off.head);
+    cq_tail = ringField(cq_ring, params.cq_off.tail);
+    cq_mask = ringField(cq_ring, params.cq_off.ring_mask);
+    cqes = reinterpret_cast<struct io_uring_cqe*>(static_cast<uint8_t*>(cq_ring) + params.cq_off.cqes);
+}
+
+IoUringBackend::~IoUringBackend() {
+    unmapRings();
+    ::close(ring_fd);
+}
+
+void IoUringBackend::unmapRings() {
+    if (sqes != nullptr) {
+        munmap(sqes, sqes_size);
+    }
+    if (cq_ring != nullptr && cq_ring != sq_ring) {
+        munmap(cq_ring, cq_ring_size);
+    }
+    if (sq_ring != nullptr) {
+        munmap(sq_ring, sq_ring_size);
+    }
+    sqes = nullptr;
+    cq_ring = sq_ring = nullptr;
+}
+
+void IoUringBackend::submit(Request* requests, std::size_t count) {
+    std::lock_guard<std::mutex> lock(latch);
+
+    // Requests still to be queued; short transfers are queued again for
+    // their remainder
+    pending.clear();
+    transferred.assign(count, 0);
+    for (std::size_t i = count; i > 0; i--) {
+        pending.push_back(i - 1);
+    }
+
+    std::size_t in_flight = 0;
+    std::size_t completed = 0;
+    unsigned to_submit = 0; // Queued entries the kernel has not consumed yet
+    while (completed < count) {
+        // Fill the submission queue
+        unsigned tail = *sq_tail;
+        while (!pending.empty() && in_flight < sq_entries) {
+            std::size_t idx = pending.back();
+            pending.pop_back();
+            const Request& request = requests[idx];
+
+            unsigned slot = tail & *sq_mask;
+            struct io_uring_sqe* sqe = &sqes[slot];
+            std::memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = request.op == Request::Op::READ ? IORING_OP_READ : IORING_OP_WRITE;
+            sqe->fd = request.fd;
+            sqe->addr = reinterpret_cast<uint64_t>(static_cast<uint8_t*>(request.buffer) + transferred[idx]);
+            sqe->len = static_cast<uint32_t>(request.length - transferred[idx]);
+            sqe->off = static_cast<uint64_t>(request.offset) + transferred[idx];
+            sqe->user_data = idx;
+            sq_array[slot] = slot;
+
+            tail++;
+            to_submit++;
+            in_flight++;
+        }
+        storeRelease(sq_tail, tail);
+
+        // Submit and wait for at least one completion
+        int ret;
+        do {
+            ret = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, 1,
+                                           IORING_ENTER_GETEVENTS, nullptr, 0));
+        } while (ret < 0 && errno == EINTR);
+        if (ret < 0) {
+            throw std::runtime_error("io_uring_enter failed");
+        }
+        to_submit -= static_cast<unsigned>(ret);
+
+        // Reap completions
+        unsigned head = *cq_head;
+        unsigned cq_end = loadAcquire(cq_tail);
+        for (; head != cq_end; head++) {
+            const struct io_uring_cqe& cqe = cqes[head & *cq_mask];
+            std::size_t idx = static_cast<std::size_t>(cqe.user_data);
+            in_flight--;
+
+            if (cqe.res < 0) {
+                requests[idx].result = cqe.res;
+                completed++;
+                continue;
+            }
+            transferred[idx] += cqe.res;
+            if (cqe.res == 0 || transferred[idx] == requests[idx].length) {
+                requests[idx].result = static_cast<ssize_t>(transferred[idx]);
+                completed++;
+            } else {
+                pending.push_back(idx);
+            }
+        }
+        storeRelease(cq_head, head);
+    }
+}
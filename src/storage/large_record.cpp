@@ -0,0 +1,246 @@
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "storage/large_record.hpp"
+
+namespace {
+
+constexpr std::size_t PAGE_SIZE = SlottedPage::PAGE_SIZE;
+constexpr std::size_t HEADER_SIZE = sizeof(SlottedPage::PageHeader);
+
+// Overflow pages keep their bytes between the header and free_start
+void formatOverflowPage(uint8_t* page, uint32_t page_id, std::size_t data_size, uint32_t next_page, uint64_t lsn) {
+    auto* header = reinterpret_cast<SlottedPage::PageHeader*>(page);
+    std::memset(header, 0, HEADER_SIZE);
+    header->id = page_id;
+    header->type = SlottedPage::PageType::OVERFLOW;
+    header->free_start = static_cast<uint16_t>(HEADER_SIZE + data_size);
+    header->free_end = PAGE_SIZE - 1;
+    header->total_free = header->free_end - header->free_start;
+    header->lsn = lsn;
+    header->page_size = PAGE_SIZE;
+    header->next_page = next_page;
+}
+
+} // namespace
+
+LargeRecordWriter::LargeRecordWriter(HeapFile& heap_file, std::size_t batch_pages)
+    : heap_file(heap_file),
+      batch_pages(std::max<std::size_t>(batch_pages, 1)),
+      batch(allocateAligned(this->batch_pages * PAGE_SIZE)),
+      held(allocateAligned(PAGE_SIZE)) {
+    heap_file.requireWritable();
+    if (heap_file.isPax()) {
+        throw std::logic_error("Large records need a heap file with the row layout");
+    }
+}
+
+LargeRecordWriter::~LargeRecordWriter() {
+    if (finished || allocated.empty()) {
+        return;
+    }
+
+    try {
+        std::shared_lock<std::shared_mutex> checkpoint_guard(heap_file.checkpoint_latch);
+        if (held_page != SlottedPage::NO_PAGE) {
+            reinterpret_cast<SlottedPage::PageHeader*>(held.get())->next_page = SlottedPage::NO_PAGE;
+            IoBackend::Request request = {IoBackend::Request::Op::WRITE, heap_file.file_descriptor, held.get(),
+                                          PAGE_SIZE, static_cast<off_t>(held_page * PAGE_SIZE), 0};
+            heap_file.submitPageIo(&request, 1);
+        }
+        for (const auto& [first, count] : allocated) {
+            for (uint32_t i = 0; i < count; i++) {
+                heap_file.freeOverflowPage(first + i);
+            }
+        }
+    } catch (const std::exception&) {
+        // The pages stay allocated but unreachable
+    }
+}
+
+void LargeRecordWriter::write(const void* data, std::size_t size) {
+    if (finished) {
+        throw std::logic_error("Large record already finished");
+    }
+
+    const auto* input = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        // A full batch is only flushed once more data arrives, so finish()
+        // always has the final pages in hand
+        if (batch_bytes == batch_pages * DATA_PER_PAGE) {
+            flushBatch(false);
+        }
+
+        std::size_t page = batch_bytes / DATA_PER_PAGE;
+        std::size_t offset = batch_bytes % DATA_PER_PAGE;
+        std::size_t n = std::min(size, DATA_PER_PAGE - offset);
+        std::memcpy(batch.get() + page * PAGE_SIZE + HEADER_SIZE + offset, input, n);
+        input += n;
+        size -= n;
+        batch_bytes += n;
+        length += n;
+    }
+}
+
+void LargeRecordWriter::flushBatch(bool last) {
+    uint32_t count = static_cast<uint32_t>((batch_bytes + DATA_PER_PAGE - 1) / DATA_PER_PAGE);
+    std::shared_lock<std::shared_mutex> checkpoint_guard(heap_file.checkpoint_latch);
+
+    uint32_t first = SlottedPage::NO_PAGE;
+    if (count > 0) {
+        uint64_t lsn;
+        first = heap_file.allocateOverflowPages(count, lsn);
+        allocated.emplace_back(first, count);
+        if (first_page == SlottedPage::NO_PAGE) {
+            first_page = first;
+        }
+        num_pages += count;
+
+        for (uint32_t i = 0; i < count; i++) {
+            bool tail = i + 1 == count;
+            std::size_t data_size = tail ? batch_bytes - i * DATA_PER_PAGE : DATA_PER_PAGE;
+            formatOverflowPage(batch.get() + i * PAGE_SIZE, first + i, data_size,
+                               tail ? SlottedPage::NO_PAGE : first + i + 1, lsn);
+        }
+    }
+
+    IoBackend::Request requests[2];
+    std::size_t num_requests = 0;
+    int fd = heap_file.file_descriptor;
+    if (held_page != SlottedPage::NO_PAGE) {
+        reinterpret_cast<SlottedPage::PageHeader*>(held.get())->next_page = first;
+        requests[num_requests++] = {IoBackend::Request::Op::WRITE, fd, held.get(), PAGE_SIZE,
+                                    static_cast<off_t>(held_page * PAGE_SIZE), 0};
+        held_page = SlottedPage::NO_PAGE;
+    }
+
+    // The batch's pages are consecutive, so all but a held-back last page
+    // go out as one request
+    uint32_t write_pages = last ? count : count - 1;
+    if (write_pages > 0) {
+        requests[num_requests++] = {IoBackend::Request::Op::WRITE, fd, batch.get(), write_pages * PAGE_SIZE,
+                                    static_cast<off_t>(first * PAGE_SIZE), 0};
+    }
+
+    heap_file.submitPageIo(requests, num_requests);
+    for (std::size_t i = 0; i < num_requests; i++) {
+        if (requests[i].result != static_cast<ssize_t>(requests[i].length)) {
+            throw std::runtime_error("Failed to write overflow pages");
+        }
+    }
+
+    if (!last) {
+        std::memcpy(held.get(), batch.get() + (count - 1) * PAGE_SIZE, PAGE_SIZE);
+        held_page = first + count - 1;
+    }
+    batch_bytes = 0;
+}
+
+HeapFile::RecordId LargeRecordWriter::finish() {
+    if (finished) {
+        throw std::logic_error("Large record already finished");
+    }
+
+    if (batch_bytes > 0 || held_page != SlottedPage::NO_PAGE) {
+        flushBatch(true);
+    }
+
+    // The chain must be on disk before the stub that makes it reachable is logged
+    if (num_pages > 0) {
+        heap_file.syncPages();
+    }
+
+    HeapFile::OverflowStub stub{length, first_page, num_pages};
+    HeapFile::RecordId rid = heap_file.insertCell(&stub, sizeof(stub), true);
+    finished = true;
+    return rid;
+}
+
+LargeRecordReader::LargeRecordReader(HeapFile& heap_file, HeapFile::RecordId rid, std::size_t readahead_pages)
+    : LargeRecordReader(heap_file, readStub(heap_file, rid), readahead_pages) {}
+
+LargeRecordReader::LargeRecordReader(HeapFile& heap_file, const HeapFile::OverflowStub& stub,
+                                     std::size_t readahead_pages)
+    : heap_file(heap_file),
+      stub(stub),
+      readahead_pages(std::max<std::size_t>(readahead_pages, 1)),
+      chunk(allocateAligned(this->readahead_pages * PAGE_SIZE)),
+      next_page(stub.first_page),
+      pages_left(stub.num_pages) {}
+
+HeapFile::OverflowStub LargeRecordReader::readStub(HeapFile& heap_file, HeapFile::RecordId rid) {
+    HeapFile::OverflowStub stub;
+    if (heap_file.mapping != nullptr) {
+        const auto* pointer = heap_file.getMappedCell(rid.page_id, rid.slot_id);
+        if (pointer == nullptr || !pointer->isOverflow()) {
+            throw std::invalid_argument("Record is not a large record");
+        }
+        std::memcpy(&stub, heap_file.getMappedPage(rid.page_id) + pointer->cell_location, sizeof(stub));
+        return stub;
+    }
+
+    if (rid.page_id >= heap_file.num_pages) {
+        throw std::invalid_argument("Record is not a large record");
+    }
+    auto page = heap_file.getPage(rid.page_id, BufferPool::LatchMode::SHARED);
+    auto plist = page->getPointerList();
+    if (page->getHeader().type != SlottedPage::PageType::LEAF || rid.slot_id >= plist.size ||
+        plist.start[rid.slot_id].cell_location == 0 || !plist.start[rid.slot_id].isOverflow()) {
+        throw std::invalid_argument("Record is not a large record");
+    }
+    std::memcpy(&stub, page->getCell(rid.slot_id), sizeof(stub));
+    return stub;
+}
+
+std::size_t LargeRecordReader::read(void* buffer, std::size_t size) {
+    auto* output = static_cast<uint8_t*>(buffer);
+    std::size_t copied = 0;
+    while (copied < size && position < stub.length) {
+        if (data_offset == data_size) {
+            loadNextPage();
+        }
+        std::size_t n = std::min(size - copied, data_size - data_offset);
+        std::memcpy(output + copied, data + data_offset, n);
+        copied += n;
+        data_offset += n;
+        position += n;
+    }
+    return copied;
+}
+
+void LargeRecordReader::loadNextPage() {
+    uint32_t page_id = next_page;
+    if (pages_left == 0 || page_id == SlottedPage::NO_PAGE || page_id >= heap_file.getNumPages()) {
+        throw std::runtime_error("Overflow chain ends before the record");
+    }
+
+    if (page_id < chunk_first_page || page_id >= chunk_first_page + chunk_pages) {
+        // Chains are laid out in runs of consecutive pages, so read the
+        // rest of the record from here as far as the chunk allows
+        std::size_t count = std::min<std::size_t>({readahead_pages, pages_left,
+                                                   heap_file.getNumPages() - page_id});
+        IoBackend::Request request = {IoBackend::Request::Op::READ, heap_file.file_descriptor, chunk.get(),
+                                      count * PAGE_SIZE, static_cast<off_t>(page_id * PAGE_SIZE), 0};
+        heap_file.submitPageIo(&request, 1);
+        ssize_t bytes = request.result;
+        if (bytes < static_cast<ssize_t>(PAGE_SIZE)) {
+            throw std::runtime_error("Failed to read overflow pages");
+        }
+        chunk_first_page = page_id;
+        chunk_pages = static_cast<std::size_t>(bytes) / PAGE_SIZE;
+    }
+
+    const uint8_t* page = chunk.get() + (page_id - chunk_first_page) * PAGE_SIZE;
+    const auto* header = reinterpret_cast<const SlottedPage::PageHeader*>(page);
+    if (header->type != SlottedPage::PageType::OVERFLOW || header->id != page_id ||
+        header->free_start < HEADER_SIZE) {
+        throw std::runtime_error("Overflow page " + std::to_string(page_id) + " is not part of the record");
+    }
+
+    data = page + HEADER_SIZE;
+    data_size = header->free_start - HEADER_SIZE;
+    data_offset = 0;
+    next_page = header->next_page;
+    pages_left--;
+}
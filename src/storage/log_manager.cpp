@@ -0,0 +1,263 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include "storage/io_backend.hpp"
+#include "storage/log_manager.hpp"
+#include "storage/metrics.hpp"
+
+LogManager::LogManager(const std::string& fname) : filename(fname) {
+    file_descriptor = open(filename.c_str(), O_RDWR | O_CREAT, 0644);
+    if (file_descriptor == -1) {
+        throw std::runtime_error("Failed to open log file: " + filename);
+    }
+
+    FileHeader file_header;
+    if (pread(file_descriptor, &file_header, sizeof(FileHeader), 0) != sizeof(FileHeader) ||
+        file_header.magic != LOG_MAGIC) {
+        writeFileHeader(1);
+        file_header.base_lsn = 1;
+    }
+    base_lsn = file_header.base_lsn;
+    log_buffer.reserve(INITIAL_BUFFER_SIZE);
+    spare_buffer.reserve(INITIAL_BUFFER_SIZE);
+
+    // Find the end of the intact records; anything after it is a torn write
+    next_lsn = base_lsn;
+    write_offset = sizeof(FileHeader);
+    forEachRecord([this](const LogRecord& record) {
+        next_lsn = record.header->lsn + 1;
+        write_offset += record.header->size;
+    });
+    if (ftruncate(file_descriptor, write_offset) == -1) {
+        throw std::runtime_error("Failed to truncate torn log tail");
+    }
+    durable_lsn = next_lsn - 1;
+}
+
+LogManager::~LogManager() {
+    ::close(file_descriptor);
+}
+
+uint64_t LogManager::append(RecordType type, uint32_t page_id, uint16_t slot_id,
+                            const void* payload, uint16_t payload_size) {
+    std::lock_guard<std::mutex> lock(latch);
+
+    RecordHeader header;
+    header.size = sizeof(RecordHeader) + payload_size;
+    header.checksum = 0;
+    header.lsn = next_lsn++;
+    header.page_id = page_id;
+    header.slot_id = slot_id;
+    header.type = type;
+    header.reserved = 0;
+
+    size_t offset = log_buffer.size();
+    log_buffer.resize(offset + header.size);
+    std::memcpy(log_buffer.data() + offset, &header, sizeof(RecordHeader));
+    if (payload_size > 0) {
+        std::memcpy(log_buffer.data() + offset + sizeof(RecordHeader), payload, payload_size);
+    }
+
+    uint32_t sum = checksum(log_buffer.data() + offset, header.size);
+    std::memcpy(log_buffer.data() + offset + offsetof(RecordHeader, checksum), &sum, sizeof(sum));
+
+    stats.records_appended++;
+    return header.lsn;
+}
+
+void LogManager::flush(uint64_t lsn) {
+    std::unique_lock<std::mutex> lock(latch);
+    stats.flush_requests++;
+    lsn = std::min(lsn, next_lsn - 1);
+
+    while (durable_lsn < lsn) {
+        if (flush_in_progress) {
+            // Another thread is the group leader; our records either ride
+            // along with its fsync or we lead the next group
+            flushed_cv.wait(lock);
+            continue;
+        }
+
+        flush_in_progress = true;
+        std::vector<uint8_t> group;
+        group.swap(log_buffer);
+        log_buffer.swap(spare_buffer);
+        uint64_t group_lsn = next_lsn - 1;
+        off_t offset = write_offset;
+        lock.unlock();
+
+        bool ok;
+        {
+            TINYDB_TIME(LOG_FLUSH);
+            ok = pwrite(file_descriptor, group.data(), group.size(), offset) == static_cast<ssize_t>(group.size()) &&
+                 fdatasync(file_descriptor) == 0;
+        }
+        TINYDB_COUNT(FSYNCS, 1);
+        TINYDB_COUNT(BYTES_FSYNCED, group.size());
+
+        lock.lock();
+        flush_in_progress = false;
+        if (!ok) {
+            // Put the group back in front of the records appended since, so
+            // the next leader retries it at the same offset and no waiter
+            // counts as durable past a hole in the log
+            group.insert(group.end(), log_buffer.begin(), log_buffer.end());
+            log_buffer.swap(group);
+            flushed_cv.notify_all();
+            throw std::runtime_error("Failed to write the log to disk");
+        }
+        write_offset += group.size();
+        durable_lsn = group_lsn;
+        stats.bytes_written += group.size();
+        stats.fsyncs++;
+        group.clear();
+        spare_buffer.swap(group);
+        flushed_cv.notify_all();
+    }
+}
+
+void LogManager::forEachRecord(const std::function<void(const LogRecord&)>& visitor) {
+    off_t file_size = lseek(file_descriptor, 0, SEEK_END);
+    if (file_size <= static_cast<off_t>(sizeof(FileHeader))) {
+        return;
+    }
+
+    std::vector<uint8_t> contents(file_size - sizeof(FileHeader));
+    if (pread(file_descriptor, contents.data(), contents.size(), sizeof(FileHeader)) !=
+        static_cast<ssize_t>(contents.size())) {
+        throw std::runtime_error("Failed to read the log file");
+    }
+
+    size_t offset = 0;
+    uint64_t expected_lsn = base_lsn;
+    while (offset + sizeof(RecordHeader) <= contents.size()) {
+        RecordHeader header;
+        std::memcpy(&header, contents.data() + offset, sizeof(RecordHeader));
+        if (header.size < sizeof(RecordHeader) || offset + header.size > contents.size() ||
+            header.lsn != expected_lsn) {
+            break;
+        }
+
+        uint32_t stored = header.checksum;
+        std::memset(contents.data() + offset + offsetof(RecordHeader, checksum), 0, sizeof(uint32_t));
+        if (checksum(contents.data() + offset, header.size) != stored) {
+            break;
+        }
+
+        LogRecord record;
+        record.header = &header;
+        record.payload = contents.data() + offset + sizeof(RecordHeader);
+        record.payload_size = header.size - sizeof(RecordHeader);
+        visitor(record);
+
+        offset += header.size;
+        expected_lsn++;
+    }
+}
+
+void LogManager::truncate() {
+    std::unique_lock<std::mutex> lock(latch);
+    flushed_cv.wait(lock, [this] { return !flush_in_progress; });
+
+    // Records still buffered belong to pages that may not be flushed yet
+    if (!log_buffer.empty()) {
+        return;
+    }
+
+    base_lsn = next_lsn;
+    writeFileHeader(base_lsn);
+    if (ftruncate(file_descriptor, sizeof(FileHeader)) == -1 || fdatasync(file_descriptor) == -1) {
+        throw std::runtime_error("Failed to truncate the log file");
+    }
+    write_offset = sizeof(FileHeader);
+}
+
+void LogManager::truncateBefore(uint64_t lsn) {
+    std::unique_lock<std::mutex> lock(latch);
+    flushed_cv.wait(lock, [this] { return !flush_in_progress; });
+
+    lsn = std::min(lsn, durable_lsn + 1);
+    if (lsn <= base_lsn) {
+        return;
+    }
+
+    std::vector<uint8_t> contents(write_offset - sizeof(FileHeader));
+    if (pread(file_descriptor, contents.data(), contents.size(), sizeof(FileHeader)) !=
+        static_cast<ssize_t>(contents.size())) {
+        throw std::runtime_error("Failed to read the log file");
+    }
+
+    // Records on disk are intact and consecutive up to write_offset
+    size_t dead_bytes = 0;
+    for (uint64_t record_lsn = base_lsn; record_lsn < lsn; record_lsn++) {
+        RecordHeader header;
+        std::memcpy(&header, contents.data() + dead_bytes, sizeof(RecordHeader));
+        dead_bytes += header.size;
+    }
+    size_t live_bytes = contents.size() - dead_bytes;
+    if (dead_bytes < live_bytes) {
+        return;
+    }
+
+    // Write the surviving records to a new file and swap it in atomically
+    std::string temp_name = filename + ".tmp";
+    int temp_fd = open(temp_name.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (temp_fd == -1) {
+        throw std::runtime_error("Failed to open log file: " + temp_name);
+    }
+    FileHeader file_header = {LOG_MAGIC, 0, lsn};
+    bool ok = pwrite(temp_fd, &file_header, sizeof(FileHeader), 0) == sizeof(FileHeader) &&
+              pwrite(temp_fd, contents.data() + dead_bytes, live_bytes, sizeof(FileHeader)) ==
+                  static_cast<ssize_t>(live_bytes) &&
+              fdatasync(temp_fd) == 0 &&
+              rename(temp_name.c_str(), filename.c_str()) == 0;
+    if (!ok) {
+        ::close(temp_fd);
+        unlink(temp_name.c_str());
+        throw std::runtime_error("Failed to truncate the log file");
+    }
+
+    ::close(file_descriptor);
+    file_descriptor = temp_fd;
+    base_lsn = lsn;
+    write_offset = sizeof(FileHeader) + live_bytes;
+
+    // Until the directory is synced a crash may bring back the old log
+    if (!IoBackend::syncDirectory(filename)) {
+        throw std::runtime_error("Failed to sync the directory of " + filename);
+    }
+}
+
+uint64_t LogManager::getLastLsn() {
+    std::lock_guard<std::mutex> lock(latch);
+    return next_lsn - 1;
+}
+
+uint64_t LogManager::getDurableLsn() {
+    std::lock_guard<std::mutex> lock(latch);
+    return durable_lsn;
+}
+
+LogManager::Stats LogManager::getStats() {
+    std::lock_guard<std::mutex> lock(latch);
+    return stats;
+}
+
+void LogManager::writeFileHeader(uint64_t first_lsn) {
+    FileHeader file_header = {LOG_MAGIC, 0, first_lsn};
+    if (pwrite(file_descriptor, &file_header, sizeof(FileHeader), 0) != sizeof(FileHeader)) {
+        throw std::runtime_error("Failed to write log file header");
+    }
+}
+
+uint32_t LogManager::checksum(const uint8_t* data, std::size_t size) {
+    uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < size; i++) {
+        hash = (hash ^ data[i]) * 16777619u;
+    }
+    return hash;
+}
@@ -0,0 +1,195 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "storage/lz_codec.hpp"
+
+namespace {
+
+constexpr std::size_t MIN_MATCH = 4;
+// The format ends with literals: the last match stops this far from the
+// end and starts no later than MATCH_START_LIMIT before it
+constexpr std::size_t LAST_LITERALS = 5;
+constexpr std::size_t MATCH_START_LIMIT = 12;
+constexpr std::size_t MAX_OFFSET = 65535;
+constexpr int HASH_BITS = 12;
+// Misses before the search starts skipping ahead over incompressible data
+constexpr int SKIP_TRIGGER = 6;
+
+uint32_t read32(const uint8_t* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+uint32_t hashPrefix(uint32_t value) {
+    return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// Length of the common prefix of a and b, stopping at limit (for a)
+std::size_t matchLength(const uint8_t* a, const uint8_t* b, const uint8_t* limit) {
+    const uint8_t* start = a;
+    while (a + sizeof(uint64_t) <= limit) {
+        uint64_t x;
+        uint64_t y;
+        std::memcpy(&x, a, sizeof(x));
+        std::memcpy(&y, b, sizeof(y));
+        if (x != y) {
+            return static_cast<std::size_t>(a - start) + __builtin_ctzll(x ^ y) / 8;
+        }
+        a += sizeof(uint64_t);
+        b += sizeof(uint64_t);
+    }
+    while (a < limit && *a == *b) {
+        a++;
+        b++;
+    }
+    return static_cast<std::size_t>(a - start);
+}
+
+// Bytes needed for a length of at least 15 beyond the token's nibble
+std::size_t extraLengthBytes(std::size_t length) {
+    return length >= 15 ? (length - 15) / 255 + 1 : 0;
+}
+
+uint8_t* writeExtraLength(uint8_t* out, std::size_t length) {
+    if (length < 15) {
+        return out;
+    }
+    length -= 15;
+    while (length >= 255) {
+        *out++ = 255;
+        length -= 255;
+    }
+    *out++ = static_cast<uint8_t>(length);
+    return out;
+}
+
+std::size_t readExtraLength(const uint8_t*& in, const uint8_t* end) {
+    std::size_t length = 0;
+    uint8_t byte;
+    do {
+        if (in == end) {
+            throw std::runtime_error("Corrupt compressed data");
+        }
+        byte = *in++;
+        length += byte;
+    } while (byte == 255);
+    return length;
+}
+
+} // namespace
+
+std::size_t LzCodec::compress(const uint8_t* src, std::size_t size, uint8_t* dst, std::size_t capacity) {
+    const uint8_t* const end = src + size;
+    const uint8_t* anchor = src; // First literal not yet emitted
+    uint8_t* out = dst;
+    uint8_t* const out_end = dst + capacity;
+
+    if (size > MATCH_START_LIMIT) {
+        uint32_t table[1 << HASH_BITS] = {}; // Last position of each prefix hash
+        const uint8_t* const match_end_limit = end - LAST_LITERALS;
+        const uint8_t* const match_start_limit = end - MATCH_START_LIMIT;
+        const uint8_t* ip = src + 1;
+        uint32_t misses = 0;
+
+        while (ip < match_start_limit) {
+            uint32_t hash = hashPrefix(read32(ip));
+            const uint8_t* ref = src + table[hash];
+            table[hash] = static_cast<uint32_t>(ip - src);
+            if (ref >= ip || static_cast<std::size_t>(ip - ref) > MAX_OFFSET || read32(ref) != read32(ip)) {
+                ip += 1 + (misses++ >> SKIP_TRIGGER);
+                continue;
+            }
+            misses = 0;
+
+            while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+            std::size_t match_length = matchLength(ip + MIN_MATCH, ref + MIN_MATCH, match_end_limit) + MIN_MATCH;
+
+            std::size_t literals = static_cast<std::size_t>(ip - anchor);
+            std::size_t needed = 1 + extraLengthBytes(literals) + literals + 2 +
+                                 extraLengthBytes(match_length - MIN_MATCH);
+            if (needed > static_cast<std::size_t>(out_end - out)) {
+                return 0;
+            }
+            uint8_t* token = out++;
+            *token = static_cast<uint8_t>(std::min<std::size_t>(literals, 15) << 4 |
+                                          std::min<std::size_t>(match_length - MIN_MATCH, 15));
+            out = writeExtraLength(out, literals);
+            std::memcpy(out, anchor, literals);
+            out += literals;
+            uint16_t offset = static_cast<uint16_t>(ip - ref);
+            *out++ = static_cast<uint8_t>(offset);
+            *out++ = static_cast<uint8_t>(offset >> 8);
+            out = writeExtraLength(out, match_length - MIN_MATCH);
+
+            ip += match_length;
+            anchor = ip;
+            if (ip - 2 > src) {
+                table[hashPrefix(read32(ip - 2))] = static_cast<uint32_t>(ip - 2 - src);
+            }
+        }
+    }
+
+    std::size_t literals = static_cast<std::size_t>(end - anchor);
+    if (1 + extraLengthBytes(literals) + literals > static_cast<std::size_t>(out_end - out)) {
+        return 0;
+    }
+    *out++ = static_cast<uint8_t>(std::min<std::size_t>(literals, 15) << 4);
+    out = writeExtraLength(out, literals);
+    std::memcpy(out, anchor, literals);
+    out += literals;
+    return static_cast<std::size_t>(out - dst);
+}
+
+std::size_t LzCodec::decompress(const uint8_t* src, std::size_t size, uint8_t* dst, std::size_t capacity) {
+    const uint8_t* in = src;
+    const uint8_t* const end = src + size;
+    uint8_t* out = dst;
+    uint8_t* const out_end = dst + capacity;
+
+    while (in < end) {
+        uint8_t token = *in++;
+        std::size_t literals = token >> 4;
+        if (literals == 15) {
+            literals += readExtraLength(in, end);
+        }
+        if (literals > static_cast<std::size_t>(end - in) || literals > static_cast<std::size_t>(out_end - out)) {
+            throw std::runtime_error("Corrupt compressed data");
+        }
+        std::memcpy(out, in, literals);
+        in += literals;
+        out += literals;
+        if (in == end) {
+            break; // The last sequence has no match
+        }
+
+        if (end - in < 2) {
+            throw std::runtime_error("Corrupt compressed data");
+        }
+        std::size_t offset = in[0] | static_cast<std::size_t>(in[1]) << 8;
+        in += 2;
+        std::size_t match_length = token & 15;
+        if (match_length == 15) {
+            match_length += readExtraLength(in, end);
+        }
+        match_length += MIN_MATCH;
+        if (offset == 0 || offset > static_cast<std::size_t>(out - dst) ||
+            match_length > static_cast<std::size_t>(out_end - out)) {
+            throw std::runtime_error("Corrupt compressed data");
+        }
+
+        // An overlapping match repeats its first offset bytes; each copy
+        // doubles the pattern already written, so runs take few copies
+        const uint8_t* ref = out - offset;
+        uint8_t* match_end = out + match_length;
+        while (out < match_end) {
+            std::size_t n = std::min<std::size_t>(out - ref, match_end - out);
+            std::memcpy(out, ref, n);
+            out += n;
+        }
+    }
+    return static_cast<std::size_t>(out - dst);
+}
@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <sstream>
+#include <unordered_set>
+#include "storage/metrics.hpp"
+
+namespace {
+
+// Slots of the live threads and the totals of those that have exited
+struct Registry {
+    std::mutex latch;
+    std::unordered_set<const void*> threads;
+    Metrics::Snapshot retired;
+};
+
+Registry& registry() {
+    // Never destroyed: threads may still exit during static destruction
+    static Registry* instance = new Registry;
+    return *instance;
+}
+
+constexpr double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+} // namespace
+
+uint64_t Histogram::bucketLimit(std::size_t bucket) {
+    constexpr std::size_t sub_buckets = std::size_t(1) << SUB_BUCKET_BITS;
+    if (bucket < sub_buckets) {
+        return bucket;
+    }
+    unsigned shift = static_cast<unsigned>(bucket >> SUB_BUCKET_BITS) - 1;
+    uint64_t sub_bucket = (bucket & (sub_buckets - 1)) + sub_buckets;
+    return ((sub_bucket + 1) << shift) - 1;
+}
+
+void Histogram::add(std::size_t bucket, uint64_t bucket_count, uint64_t bucket_sum, uint64_t bucket_max) {
+    buckets[bucket] += bucket_count;
+    count += bucket_count;
+    sum += bucket_sum;
+    max = std::max(max, bucket_max);
+}
+
+void Histogram::merge(const Histogram& other) {
+    for (std::size_t i = 0; i < NUM_BUCKETS; i++) {
+        buckets[i] += other.buckets[i];
+    }
+    count += other.count;
+    sum += other.sum;
+    max = std::max(max, other.max);
+}
+
+uint64_t Histogram::getPercentile(double quantile) const {
+    if (count == 0) {
+        return 0;
+    }
+    uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(quantile * count)));
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < NUM_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return std::min(bucketLimit(i), max);
+        }
+    }
+    return max;
+}
+
+Metrics::Registration::Registration() : metrics(new ThreadMetrics()) {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.latch);
+    reg.threads.insert(metrics.get());
+}
+
+Metrics::Registration::~Registration() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.latch);
+    collect(*metrics, reg.retired);
+    reg.threads.erase(metrics.get());
+}
+
+void Metrics::collect(const ThreadMetrics& metrics, Snapshot& snapshot) {
+    for (std::size_t i = 0; i < NUM_COUNTERS; i++) {
+        snapshot.counters[i] += metrics.counters[i].load(std::memory_order_relaxed);
+    }
+    for (std::size_t i = 0; i < NUM_LATENCIES; i++) {
+        const ThreadHistogram& from = metrics.latencies[i];
+        Histogram& to = snapshot.latencies[i];
+        // The sum and maximum go in with the first non-empty bucket
+        uint64_t sum = from.sum.load(std::memory_order_relaxed);
+        uint64_t max = from.max.load(std::memory_order_relaxed);
+        for (std::size_t bucket = 0; bucket < Histogram::NUM_BUCKETS; bucket++) {
+            uint64_t count = from.buckets[bucket].load(std::memory_order_relaxed);
+            if (count > 0) {
+                to.add(bucket, count, sum, max);
+                sum = 0;
+            }
+        }
+    }
+}
+
+Metrics::Snapshot Metrics::snapshot() {
+    Registry& reg = registry();
+    std::lock_guard<std::mutex> lock(reg.latch);
+    Snapshot snapshot = reg.retired;
+    for (const void* thread : reg.threads) {
+        collect(*static_cast<const ThreadMetrics*>(thread), snapshot);
+    }
+    return snapshot;
+}
+
+const char* Metrics::getName(Counter counter) {
+    switch (counter) {
+        case Counter::PAGE_HITS: return "page_hits";
+        case Counter::PAGE_MISSES: return "page_misses";
+        case Counter::PAGES_READ: return "pages_read";
+        case Counter::PAGES_WRITTEN: return "pages_written";
+        case Counter::EVICTION_WRITES: return "eviction_writes";
+        case Counter::FSM_PROBES: return "fsm_probes";
+        case Counter::COMPACTIONS: return "compactions";
+        case Counter::VERSIONS_VACUUMED: return "versions_vacuumed";
+        case Counter::FSYNCS: return "fsyncs";
+        case Counter::BYTES_FSYNCED: return "bytes_fsynced";
+        default: return "unknown";
+    }
+}
+
+const char* Metrics::getName(Latency latency) {
+    switch (latency) {
+        case Latency::PAGE_READ: return "page_read";
+        case Latency::PAGE_WRITE: return "page_write";
+        case Latency::BATCH_WRITE: return "batch_write";
+        case Latency::LOG_FLUSH: return "log_flush";
+        case Latency::DATA_SYNC: return "data_sync";
+        case Latency::CHECKPOINT: return "checkpoint";
+        default: return "unknown";
+    }
+}
+
+double Metrics::Snapshot::getHitRate() const {
+    double hits = static_cast<double>(get(Counter::PAGE_HITS));
+    double misses = static_cast<double>(get(Counter::PAGE_MISSES));
+    return hits + misses > 0 ? hits / (hits + misses) : 0;
+}
+
+std::string Metrics::Snapshot::toJson() const {
+    std::ostringstream out;
+    out << "{\"enabled\":" << (ENABLED ? "true" : "false") << ",\"counters\":{";
+    for (std::size_t i = 0; i < NUM_COUNTERS; i++) {
+        out << (i > 0 ? "," : "") << "\"" << getName(static_cast<Counter>(i)) << "\":" << counters[i];
+    }
+    out << "},\"latencies_ns\":{";
+    for (std::size_t i = 0; i < NUM_LATENCIES; i++) {
+        const Histogram& histogram = latencies[i];
+        out << (i > 0 ? "," : "") << "\"" << getName(static_cast<Latency>(i)) << "\":{\"count\":"
+            << histogram.getCount() << ",\"sum\":" << histogram.getSum() << ",\"max\":" << histogram.getMax()
+            << ",\"p50\":" << histogram.getPercentile(0.5) << ",\"p90\":" << histogram.getPercentile(0.9)
+            << ",\"p99\":" << histogram.getPercentile(0.99) << ",\"p999\":" << histogram.getPercentile(0.999)
+            << "}";
+    }
+    out << "}}";
+    return out.str();
+}
+
+std::string Metrics::Snapshot::toPrometheus() const {
+    std::ostringstream out;
+    for (std::size_t i = 0; i < NUM_COUNTERS; i++) {
+        std::string name = std::string("tinydb_") + getName(static_cast<Counter>(i)) + "_total";
+        out << "# TYPE " << name << " counter\n" << name << " " << counters[i] << "\n";
+    }
+    for (std::size_t i = 0; i < NUM_LATENCIES; i++) {
+        const Histogram& histogram = latencies[i];
+        std::string name = std::string("tinydb_") + getName(static_cast<Latency>(i)) + "_seconds";
+        out << "# TYPE " << name << " summary\n";
+        for (double quantile : QUANTILES) {
+            out << name << "{quantile=\"" << quantile << "\"} " << histogram.getPercentile(quantile) * 1e-9 << "\n";
+        }
+        out << name << "_sum " << histogram.getSum() * 1e-9 << "\n" << name << "_count " << histogram.getCount() << "\n";
+    }
+    return out.str();
+}
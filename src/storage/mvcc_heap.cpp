@@ -0,0 +1,462 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "storage/metrics.hpp"
+#include "storage/mvcc_heap.hpp"
+
+namespace {
+
+// Edit the header of the version at rid in place under its page latch;
+// edit returns false to leave it unchanged
+template <typename Edit>
+bool editVersion(HeapFile& heap_file, HeapFile::RecordId rid, Edit edit) {
+    return heap_file.updateRecord(rid.page_id, rid.slot_id, [&edit](void* cell, uint16_t cell_size) {
+        MvccHeap::VersionHeader version;
+        if (cell_size < sizeof(version)) {
+            return false;
+        }
+        std::memcpy(&version, cell, sizeof(version));
+        if (!edit(version)) {
+            return false;
+        }
+        std::memcpy(cell, &version, sizeof(version));
+        return true;
+    });
+}
+
+bool recordIdLess(const HeapFile::RecordId& a, const HeapFile::RecordId& b) {
+    return a.page_id != b.page_id ? a.page_id < b.page_id : a.slot_id < b.slot_id;
+}
+
+} // namespace
+
+MvccHeap::Snapshot::Snapshot(MvccHeap* heap, std::multiset<Timestamp>::iterator registration)
+    : heap(heap), registration(registration), timestamp(*registration) {}
+
+MvccHeap::Snapshot::Snapshot(Snapshot&& other) noexcept
+    : heap(other.heap), registration(other.registration), timestamp(other.timestamp) {
+    other.heap = nullptr;
+}
+
+MvccHeap::Snapshot::~Snapshot() {
+    if (heap != nullptr) {
+        std::lock_guard<std::mutex> lock(heap->timestamp_latch);
+        heap->snapshots.erase(registration);
+    }
+}
+
+MvccHeap::Scanner::Scanner(MvccHeap& heap, const Snapshot& snapshot, std::size_t readahead_pages)
+    : snapshot(snapshot), scanner(heap.getHeapFile(), readahead_pages), version() {}
+
+bool MvccHeap::Scanner::next() {
+    while (scanner.next()) {
+        if (scanner.isLargeRecord() || scanner.getRecordSize() < sizeof(VersionHeader)) {
+            continue;
+        }
+        std::memcpy(&version, scanner.getRecord(), sizeof(version));
+        if (snapshot.isVisible(version)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+MvccHeap::MvccHeap(const std::string& filename, const HeapFileOptions& options, uint32_t vacuum_interval_ms)
+    : state_filename(filename + ".mvcc") {
+    if (options.access_mode != HeapFileOptions::AccessMode::READ_WRITE) {
+        throw std::invalid_argument("MVCC heaps need read-write access");
+    }
+    if (!options.pax_column_widths.empty() || !options.schema.empty()) {
+        throw std::invalid_argument("MVCC heaps store untyped slotted rows");
+    }
+    heap_file = std::make_unique<HeapFile>(filename, options);
+    if (heap_file->isPax() || heap_file->hasSchema()) {
+        throw std::invalid_argument("MVCC heaps store untyped slotted rows");
+    }
+
+    state_descriptor = open(state_filename.c_str(), O_RDWR | O_CREAT, 0644);
+    if (state_descriptor == -1) {
+        throw std::runtime_error("Failed to open MVCC state: " + state_filename);
+    }
+    try {
+        State state = {};
+        ssize_t bytes = pread(state_descriptor, &state, sizeof(state), 0);
+        if (bytes == 0 && heap_file->getNumPages() > 0) {
+            throw std::runtime_error(filename + " holds unversioned records");
+        }
+        if (bytes != 0 && (bytes != sizeof(state) || state.magic != STATE_MAGIC)) {
+            throw std::runtime_error("Corrupt MVCC state: " + state_filename);
+        }
+        if (bytes != 0 && state.clean) {
+            next_timestamp = state.next_timestamp;
+        } else {
+            recoverVersions();
+        }
+        // Until close() the stored timestamp may fall behind
+        writeState(false);
+    } catch (...) {
+        ::close(state_descriptor);
+        throw;
+    }
+
+    if (vacuum_interval_ms > 0) {
+        vacuum_thread = std::thread(&MvccHeap::runVacuum, this, std::chrono::milliseconds(vacuum_interval_ms));
+    }
+}
+
+MvccHeap::~MvccHeap() {
+    stopVacuum();
+    if (state_descriptor != -1) {
+        ::close(state_descriptor);
+    }
+}
+
+MvccHeap::RecordId MvccHeap::insert(const void* record, uint16_t record_size) {
+    if (record_size > MAX_RECORD_SIZE) {
+        throw std::length_error("Record does not fit in a page");
+    }
+    Timestamp timestamp = beginWrite();
+    RecordId rid;
+    try {
+        rid = insertVersion({timestamp, INFINITE_TS, SlottedPage::NO_PAGE, SlottedPage::NO_PAGE, 0, 0, 0, 0}, record,
+                            record_size);
+    } catch (...) {
+        endWrite(timestamp);
+        throw;
+    }
+    endWrite(timestamp);
+    return rid;
+}
+
+bool MvccHeap::update(RecordId& rid, const void* record, uint16_t record_size) {
+    if (record_size > MAX_RECORD_SIZE) {
+        throw std::length_error("Record does not fit in a page");
+    }
+
+    // Claim the current version. Taking the timestamp under its page latch
+    // orders this write after the one that created it.
+    Timestamp timestamp = 0;
+    RecordId old_rid = rid;
+    try {
+        bool claimed = editVersion(*heap_file, old_rid, [this, &timestamp](VersionHeader& version) {
+            if (version.end_ts != INFINITE_TS) {
+                return false;
+            }
+            timestamp = beginWrite();
+            version.end_ts = timestamp;
+            version.flags |= UPDATE_PENDING;
+            return true;
+        });
+        if (!claimed) {
+            return false;
+        }
+        rid = insertVersion({timestamp, INFINITE_TS, old_rid.page_id, SlottedPage::NO_PAGE, old_rid.slot_id, 0, 0, 0},
+                            record, record_size);
+    } catch (...) {
+        if (timestamp != 0) {
+            editVersion(*heap_file, old_rid, [](VersionHeader& version) {
+                version.end_ts = INFINITE_TS;
+                version.flags &= ~UPDATE_PENDING;
+                return true;
+            });
+            endWrite(timestamp);
+        }
+        throw;
+    }
+
+    RecordId new_rid = rid;
+    editVersion(*heap_file, old_rid, [new_rid](VersionHeader& version) {
+        version.next_page = new_rid.page_id;
+        version.next_slot = new_rid.slot_id;
+        version.flags &= ~UPDATE_PENDING;
+        return true;
+    });
+    endWrite(timestamp, old_rid.page_id);
+    return true;
+}
+
+bool MvccHeap::remove(RecordId rid) {
+    Timestamp timestamp = 0;
+    try {
+        bool removed = editVersion(*heap_file, rid, [this, &timestamp](VersionHeader& version) {
+            if (version.end_ts != INFINITE_TS) {
+                return false;
+            }
+            timestamp = beginWrite();
+            version.end_ts = timestamp;
+            return true;
+        });
+        if (removed) {
+            endWrite(timestamp, rid.page_id);
+        }
+        return removed;
+    } catch (...) {
+        if (timestamp != 0) {
+            endWrite(timestamp);
+        }
+        throw;
+    }
+}
+
+uint16_t MvccHeap::read(const Snapshot& snapshot, RecordId rid, void* buffer, uint16_t buffer_size) {
+    thread_local std::vector<uint8_t> cell;
+    VersionHeader version;
+    if (!readVersion(rid, cell, version)) {
+        return 0;
+    }
+
+    // Walk back to older versions or forward to newer ones. Each link is
+    // checked against the timestamp it must carry, since the slot it names
+    // may have been vacuumed and reused.
+    while (!snapshot.isVisible(version)) {
+        bool backward = version.begin_ts > snapshot.getTimestamp();
+        RecordId link = backward ? RecordId{version.prev_page, version.prev_slot}
+                                 : RecordId{version.next_page, version.next_slot};
+        Timestamp expected = backward ? version.begin_ts : version.end_ts;
+        if (link.page_id == SlottedPage::NO_PAGE || !readVersion(link, cell, version) ||
+            (backward ? version.end_ts : version.begin_ts) != expected) {
+            return 0;
+        }
+    }
+
+    uint16_t size = std::min<std::size_t>(cell.size() - sizeof(VersionHeader), buffer_size);
+    std::memcpy(buffer, cell.data() + sizeof(VersionHeader), size);
+    return size;
+}
+
+MvccHeap::Snapshot MvccHeap::beginSnapshot() {
+    std::lock_guard<std::mutex> lock(timestamp_latch);
+    return Snapshot(this, snapshots.insert(stableTimestamp()));
+}
+
+MvccHeap::Timestamp MvccHeap::getVacuumHorizon() {
+    std::lock_guard<std::mutex> lock(timestamp_latch);
+    // Snapshots never run ahead of the stable timestamp
+    return snapshots.empty() ? stableTimestamp() : *snapshots.begin();
+}
+
+std::size_t MvccHeap::vacuum() {
+    std::lock_guard<std::mutex> vacuum_guard(vacuum_latch);
+    Timestamp horizon = getVacuumHorizon();
+    std::set<uint32_t> pages;
+    bool everything;
+    {
+        std::lock_guard<std::mutex> lock(timestamp_latch);
+        pages.swap(ended_pages);
+        everything = vacuum_everything;
+        vacuum_everything = false;
+    }
+
+    // The first pass after opening covers the whole file; later ones only
+    // the pages where versions have ended since
+    std::size_t reclaimed = 0;
+    HeapScanner scanner(*heap_file, 0, 0);
+    if (everything) {
+        reclaimed = vacuumPages(scanner, 0, heap_file->getNumPages(), horizon);
+    } else {
+        for (uint32_t page_id : pages) {
+            reclaimed += vacuumPages(scanner, page_id, page_id + 1, horizon);
+        }
+    }
+    TINYDB_COUNT(VERSIONS_VACUUMED, reclaimed);
+    return reclaimed;
+}
+
+void MvccHeap::close() {
+    stopVacuum();
+    heap_file->close();
+    writeState(true);
+    ::close(state_descriptor);
+    state_descriptor = -1;
+}
+
+MvccHeap::Timestamp MvccHeap::beginWrite() {
+    std::lock_guard<std::mutex> lock(timestamp_latch);
+    Timestamp timestamp = next_timestamp++;
+    in_flight.insert(timestamp);
+    return timestamp;
+}
+
+void MvccHeap::endWrite(Timestamp timestamp, uint32_t ended_page) {
+    std::lock_guard<std::mutex> lock(timestamp_latch);
+    in_flight.erase(timestamp);
+    // Each page is listed once, so the set stays within the file's size
+    // however long vacuum is left to the caller
+    if (ended_page != SlottedPage::NO_PAGE && !vacuum_everything) {
+        ended_pages.insert(ended_page);
+    }
+}
+
+MvccHeap::Timestamp MvccHeap::stableTimestamp() const {
+    return in_flight.empty() ? next_timestamp - 1 : *in_flight.begin() - 1;
+}
+
+MvccHeap::RecordId MvccHeap::insertVersion(const VersionHeader& header, const void* record, uint16_t record_size) {
+    thread_local std::vector<uint8_t> cell;
+    cell.resize(sizeof(header) + record_size);
+    std::memcpy(cell.data(), &header, sizeof(header));
+    std::memcpy(cell.data() + sizeof(header), record, record_size);
+    return heap_file->insertRecord(cell.data(), static_cast<uint16_t>(cell.size()));
+}
+
+bool MvccHeap::readVersion(RecordId rid, std::vector<uint8_t>& buffer, VersionHeader& header) {
+    buffer.resize(HeapFile::MAX_RECORD_SIZE);
+    uint16_t size = heap_file->readRecord(rid.page_id, rid.slot_id, buffer.data(), HeapFile::MAX_RECORD_SIZE);
+    if (size < sizeof(header) || heap_file->isLargeRecord(rid.page_id, rid.slot_id)) {
+        return false;
+    }
+    buffer.resize(size);
+    std::memcpy(&header, buffer.data(), sizeof(header));
+    return true;
+}
+
+std::size_t MvccHeap::vacuumPages(HeapScanner& scanner, uint32_t first_page, std::size_t end_page,
+                                  Timestamp horizon) {
+    std::size_t reclaimed = 0;
+    std::vector<uint16_t> dead;
+    uint32_t page_id = SlottedPage::NO_PAGE;
+    bool keep = false;
+
+    // Delete the dead versions of a page, then hand its space back. Pages
+    // that still hold ended versions are looked at again next time.
+    auto finishPage = [&]() {
+        if (page_id == SlottedPage::NO_PAGE) {
+            return;
+        }
+        for (uint16_t slot_id : dead) {
+            reclaimed += heap_file->deleteRecord(page_id, slot_id);
+        }
+        if (!dead.empty()) {
+            heap_file->compactPage(page_id);
+            heap_file->updateFreeSpaceMap(page_id);
+        }
+        if (keep) {
+            std::lock_guard<std::mutex> lock(timestamp_latch);
+            ended_pages.insert(page_id);
+        }
+        dead.clear();
+        keep = false;
+    };
+
+    // Dead versions never come back and only vacuum deletes versions, so
+    // the copy the scanner read is still accurate about them
+    scanner.setRange(first_page, end_page);
+    VersionHeader version;
+    while (scanner.next()) {
+        if (scanner.getPageId() != page_id) {
+            finishPage();
+            page_id = scanner.getPageId();
+        }
+        if (scanner.isLargeRecord() || scanner.getRecordSize() < sizeof(VersionHeader)) {
+            continue;
+        }
+        std::memcpy(&version, scanner.getRecord(), sizeof(version));
+        if (version.end_ts <= horizon && !(version.flags & UPDATE_PENDING)) {
+            dead.push_back(scanner.getRecordId().slot_id);
+        } else if (version.end_ts != INFINITE_TS) {
+            keep = true;
+        }
+    }
+    finishPage();
+    return reclaimed;
+}
+
+void MvccHeap::writeState(bool clean) {
+    State state = {STATE_MAGIC, clean ? 1u : 0u, 0};
+    {
+        std::lock_guard<std::mutex> lock(timestamp_latch);
+        state.next_timestamp = next_timestamp;
+    }
+    if (pwrite(state_descriptor, &state, sizeof(state), 0) != sizeof(state) || fdatasync(state_descriptor) == -1) {
+        throw std::runtime_error("Failed to write MVCC state: " + state_filename);
+    }
+}
+
+void MvccHeap::recoverVersions() {
+    // Every timestamp on disk came from the counter, and updates cut short
+    // by the crash are the versions still marked pending
+    Timestamp newest = 0;
+    std::vector<RecordId> pending;
+    std::vector<Timestamp> pending_ends;
+    HeapScanner scanner(*heap_file);
+    VersionHeader version;
+    while (scanner.next()) {
+        if (scanner.isLargeRecord() || scanner.getRecordSize() < sizeof(VersionHeader)) {
+            continue;
+        }
+        std::memcpy(&version, scanner.getRecord(), sizeof(version));
+        newest = std::max(newest, version.begin_ts);
+        if (version.end_ts != INFINITE_TS) {
+            newest = std::max(newest, version.end_ts);
+        }
+        if (version.flags & UPDATE_PENDING) {
+            pending.push_back(scanner.getRecordId());
+            pending_ends.push_back(version.end_ts);
+        }
+    }
+    next_timestamp = newest + 1;
+    if (pending.empty()) {
+        return;
+    }
+
+    // Find each one's new version, if it was logged. The scan returned
+    // them in page order, so they are sorted for the lookup.
+    std::vector<RecordId> successors(pending.size(), {SlottedPage::NO_PAGE, 0});
+    scanner.setRange(0, heap_file->getNumPages());
+    while (scanner.next()) {
+        if (scanner.isLargeRecord() || scanner.getRecordSize() < sizeof(VersionHeader)) {
+            continue;
+        }
+        std::memcpy(&version, scanner.getRecord(), sizeof(version));
+        RecordId prev = {version.prev_page, version.prev_slot};
+        auto it = std::lower_bound(pending.begin(), pending.end(), prev, recordIdLess);
+        // Only the successor carries the claiming timestamp
+        if (version.prev_page != SlottedPage::NO_PAGE && it != pending.end() && !recordIdLess(prev, *it) &&
+            pending_ends[it - pending.begin()] == version.begin_ts) {
+            successors[it - pending.begin()] = scanner.getRecordId();
+        }
+    }
+
+    for (std::size_t i = 0; i < pending.size(); i++) {
+        RecordId successor = successors[i];
+        editVersion(*heap_file, pending[i], [successor](VersionHeader& old_version) {
+            if (successor.page_id != SlottedPage::NO_PAGE) {
+                old_version.next_page = successor.page_id;
+                old_version.next_slot = successor.slot_id;
+            } else {
+                old_version.end_ts = INFINITE_TS;
+            }
+            old_version.flags &= ~UPDATE_PENDING;
+            return true;
+        });
+    }
+}
+
+void MvccHeap::runVacuum(std::chrono::milliseconds interval) {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(vacuumer_latch);
+            if (vacuumer_cv.wait_for(lock, interval, [this] { return vacuumer_stopping; })) {
+                return;
+            }
+        }
+        try {
+            vacuum();
+        } catch (const std::exception&) {
+            // Dead versions stay until a later pass reclaims them
+        }
+    }
+}
+
+void MvccHeap::stopVacuum() {
+    if (vacuum_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(vacuumer_latch);
+            vacuumer_stopping = true;
+        }
+        vacuumer_cv.notify_all();
+        vacuum_thread.join();
+    }
+}
@@ -0,0 +1,37 @@
+#include <sys/mman.h>
+#include <stdexcept>
+#include "storage/page_arena.hpp"
+
+PageArena::PageArena(std::size_t num_frames, std::size_t frame_size)
+    : num_frames(num_frames), frame_size(frame_size) {
+    size = (num_frames * frame_size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+
+    void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (addr != MAP_FAILED) {
+        base = static_cast<uint8_t*>(addr);
+        reserved_huge_pages = true;
+        return;
+    }
+
+    // No reserved huge pages: over-map by one huge page and trim both ends
+    // so the arena starts on a boundary transparent huge pages can use
+    std::size_t reserve = size + HUGE_PAGE_SIZE;
+    addr = mmap(nullptr, reserve, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) {
+        throw std::runtime_error("Failed to map the page arena");
+    }
+    auto start = reinterpret_cast<uintptr_t>(addr);
+    uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) & ~(uintptr_t(HUGE_PAGE_SIZE) - 1);
+    if (aligned > start) {
+        munmap(addr, aligned - start);
+    }
+    if (aligned + size < start + reserve) {
+        munmap(reinterpret_cast<void*>(aligned + size), start + reserve - aligned - size);
+    }
+    base = reinterpret_cast<uint8_t*>(aligned);
+    madvise(base, size, MADV_HUGEPAGE);
+}
+
+PageArena::~PageArena() {
+    munmap(base, size);
+}
@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <thread>
+#include "storage/parallel_scan.hpp"
+
+ParallelScan::ParallelScan(HeapFile& heap_file, std::size_t num_threads, std::size_t morsel_pages,
+                           std::size_t readahead_pages)
+    : heap_file(heap_file),
+      num_threads(std::max<std::size_t>(num_threads, 1)),
+      morsel_pages(std::max<std::size_t>(morsel_pages, 1)),
+      readahead_pages(std::max<std::size_t>(readahead_pages, 1)),
+      runs(this->num_threads) {}
+
+void ParallelScan::run(const std::function<void(std::size_t worker, HeapScanner& scanner)>& scan_morsel) {
+    // Pages allocated later are not part of this scan
+    end_page = heap_file.getNumPages();
+    num_morsels = (end_page + morsel_pages - 1) / morsel_pages;
+    for (std::size_t worker = 0; worker < num_threads; worker++) {
+        runs[worker].next.store(num_morsels * worker / num_threads, std::memory_order_relaxed);
+        runs[worker].end = num_morsels * (worker + 1) / num_threads;
+    }
+
+    std::atomic<bool> failed{false};
+    std::vector<std::exception_ptr> errors(num_threads);
+    auto work = [&](std::size_t worker) {
+        try {
+            runWorker(worker, scan_morsel, failed);
+        } catch (...) {
+            errors[worker] = std::current_exception();
+            failed = true;
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(num_threads - 1);
+    for (std::size_t worker = 1; worker < num_threads; worker++) {
+        workers.emplace_back(work, worker);
+    }
+    work(0);
+    for (auto& thread : workers) {
+        thread.join();
+    }
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+void ParallelScan::runWorker(std::size_t worker, const std::function<void(std::size_t, HeapScanner&)>& scan_morsel,
+                             std::atomic<bool>& failed) {
+    std::unique_ptr<IoBackend> io_backend;
+    std::unique_ptr<HeapScanner> scanner;
+
+    // Own run first, in page order, then the others' starting with the next
+    // worker's, so thieves spread out instead of all hitting one run
+    for (std::size_t i = 0; i < num_threads && !failed; i++) {
+        Run& victim = runs[(worker + i) % num_threads];
+        while (!failed) {
+            std::size_t morsel = victim.next.fetch_add(1, std::memory_order_relaxed);
+            if (morsel >= victim.end) {
+                break;
+            }
+            auto first_page = static_cast<uint32_t>(morsel * morsel_pages);
+            std::size_t last_page = std::min(end_page, first_page + morsel_pages);
+            if (!scanner) {
+                io_backend = heap_file.createIoBackend();
+                scanner = std::make_unique<HeapScanner>(heap_file, first_page, last_page, readahead_pages,
+                                                        io_backend.get());
+            } else {
+                scanner->setRange(first_page, last_page);
+            }
+            scan_morsel(worker, *scanner);
+        }
+    }
+}
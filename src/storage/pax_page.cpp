@@ -0,0 +1,171 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include "storage/pax_page.hpp"
+
+namespace {
+
+std::size_t alignUp(std::size_t offset) {
+    return (offset + PaxPage::MINIPAGE_ALIGNMENT - 1) & ~(PaxPage::MINIPAGE_ALIGNMENT - 1);
+}
+
+} // namespace
+
+std::size_t PaxPage::presenceOffset(std::size_t num_columns) {
+    return sizeof(SlottedPage::PageHeader) + sizeof(PaxHeader) + num_columns * sizeof(ColumnInfo);
+}
+
+std::size_t PaxPage::layoutSize(const std::vector<uint16_t>& column_widths, std::size_t capacity) {
+    std::size_t end = presenceOffset(column_widths.size()) + (capacity + 7) / 8;
+    for (uint16_t width : column_widths) {
+        end = alignUp(end) + capacity * width;
+    }
+    // Offsets are 16-bit and the last byte of a page is never used
+    return end <= SlottedPage::PAGE_SIZE - 1 ? end : 0;
+}
+
+uint16_t PaxPage::capacityFor(const std::vector<uint16_t>& column_widths) {
+    if (column_widths.empty() || column_widths.size() > MAX_COLUMNS) {
+        throw std::invalid_argument("PAX schema needs between 1 and " + std::to_string(MAX_COLUMNS) + " columns");
+    }
+    std::size_t row_size = 0;
+    for (uint16_t width : column_widths) {
+        if (width == 0) {
+            throw std::invalid_argument("PAX columns must be at least one byte wide");
+        }
+        row_size += width;
+    }
+
+    // Start from the estimate that ignores alignment and step down to a fit
+    std::size_t usable = SlottedPage::PAGE_SIZE - 1 - presenceOffset(column_widths.size());
+    std::size_t capacity = usable * 8 / (row_size * 8 + 1);
+    while (capacity > 0 && layoutSize(column_widths, capacity) == 0) {
+        capacity--;
+    }
+    if (capacity == 0) {
+        throw std::invalid_argument("PAX record does not fit in a page");
+    }
+    return static_cast<uint16_t>(capacity);
+}
+
+void PaxPage::format(uint8_t* data, const std::vector<uint16_t>& column_widths) {
+    uint16_t capacity = capacityFor(column_widths);
+    auto* pax = reinterpret_cast<PaxHeader*>(data + sizeof(SlottedPage::PageHeader));
+    pax->num_columns = static_cast<uint16_t>(column_widths.size());
+    pax->capacity = capacity;
+    pax->num_rows = 0;
+    pax->live_rows = 0;
+
+    std::size_t offset = presenceOffset(column_widths.size());
+    std::memset(data + offset, 0, (capacity + 7) / 8);
+    offset += (capacity + 7) / 8;
+
+    auto* info = reinterpret_cast<ColumnInfo*>(pax + 1);
+    for (std::size_t c = 0; c < column_widths.size(); c++) {
+        offset = alignUp(offset);
+        info[c] = {static_cast<uint16_t>(offset), column_widths[c]};
+        offset += static_cast<std::size_t>(capacity) * column_widths[c];
+    }
+}
+
+std::vector<uint16_t> PaxPage::readColumnWidths(const uint8_t* data) {
+    const auto* pax = reinterpret_cast<const PaxHeader*>(data + sizeof(SlottedPage::PageHeader));
+    const auto* info = reinterpret_cast<const ColumnInfo*>(pax + 1);
+    std::vector<uint16_t> widths(pax->num_columns);
+    for (std::size_t c = 0; c < widths.size(); c++) {
+        widths[c] = info[c].width;
+    }
+    return widths;
+}
+
+void PaxPage::encodeSchema(const std::vector<uint16_t>& column_widths, std::vector<uint8_t>& out) {
+    uint16_t count = static_cast<uint16_t>(column_widths.size());
+    std::size_t start = out.size();
+    out.resize(start + sizeof(count) + count * sizeof(uint16_t));
+    std::memcpy(out.data() + start, &count, sizeof(count));
+    std::memcpy(out.data() + start + sizeof(count), column_widths.data(), count * sizeof(uint16_t));
+}
+
+std::vector<uint16_t> PaxPage::decodeSchema(const uint8_t* payload, std::size_t size) {
+    uint16_t count;
+    if (size < sizeof(count)) {
+        throw std::runtime_error("PAX schema missing from log record");
+    }
+    std::memcpy(&count, payload, sizeof(count));
+    if (size < sizeof(count) + count * sizeof(uint16_t)) {
+        throw std::runtime_error("PAX schema truncated in log record");
+    }
+    std::vector<uint16_t> widths(count);
+    std::memcpy(widths.data(), payload + sizeof(count), count * sizeof(uint16_t));
+    return widths;
+}
+
+uint16_t PaxPage::getRowSize() const {
+    uint16_t row_size = 0;
+    for (uint16_t c = 0; c < header()->num_columns; c++) {
+        row_size += columns()[c].width;
+    }
+    return row_size;
+}
+
+uint16_t PaxPage::addRow(const void* record) {
+    auto* pax = header();
+    if (pax->live_rows == pax->capacity) {
+        throw std::runtime_error("PAX page is full");
+    }
+
+    // Reuse the first freed row, else extend the used range
+    uint16_t row = pax->num_rows;
+    if (pax->live_rows < pax->num_rows) {
+        const uint8_t* bits = presence();
+        for (uint16_t byte = 0; byte * 8 < pax->num_rows; byte++) {
+            if (bits[byte] != 0xff) {
+                row = byte * 8;
+                while (bits[byte] >> (row % 8) & 1) {
+                    row++;
+                }
+                break;
+            }
+        }
+    }
+
+    const auto* input = static_cast<const uint8_t*>(record);
+    for (uint16_t c = 0; c < pax->num_columns; c++) {
+        const ColumnInfo& column = columns()[c];
+        std::memcpy(data + column.offset + static_cast<std::size_t>(row) * column.width, input, column.width);
+        input += column.width;
+    }
+
+    presence()[row / 8] |= static_cast<uint8_t>(1u << (row % 8));
+    pax->live_rows++;
+    if (row == pax->num_rows) {
+        pax->num_rows++;
+    }
+    return row;
+}
+
+void PaxPage::removeRow(uint16_t row) {
+    if (!isLive(row)) {
+        return;
+    }
+    auto* pax = header();
+    presence()[row / 8] &= static_cast<uint8_t>(~(1u << (row % 8)));
+    pax->live_rows--;
+    // Trailing free rows go back to the unused range
+    while (pax->num_rows > 0 && !isLive(pax->num_rows - 1)) {
+        pax->num_rows--;
+    }
+}
+
+uint16_t PaxPage::readRow(uint16_t row, void* buffer, uint16_t size) const {
+    auto* output = static_cast<uint8_t*>(buffer);
+    uint16_t copied = 0;
+    for (uint16_t c = 0; c < header()->num_columns && copied < size; c++) {
+        const ColumnInfo& column = columns()[c];
+        uint16_t n = std::min<uint16_t>(column.width, size - copied);
+        std::memcpy(output + copied, data + column.offset + static_cast<std::size_t>(row) * column.width, n);
+        copied += n;
+    }
+    return copied;
+}
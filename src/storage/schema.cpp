@@ -0,0 +1,100 @@
+#include <cstring>
+#include <stdexcept>
+#include <unordered_set>
+#include "storage/schema.hpp"
+
+namespace {
+
+constexpr uint8_t FORMAT_VERSION = 1;
+constexpr uint8_t NULLABLE = 0x1;
+
+} // namespace
+
+Schema::Schema(std::vector<Column> columns) : columns(std::move(columns)) {
+    if (this->columns.size() > MAX_COLUMNS) {
+        throw std::invalid_argument("A schema holds at most " + std::to_string(MAX_COLUMNS) + " columns");
+    }
+
+    std::unordered_set<std::string> names;
+    std::size_t offset = getNullBitmapSize();
+    for (const Column& column : this->columns) {
+        if (column.name.empty() || column.name.size() > MAX_NAME_LENGTH) {
+            throw std::invalid_argument("Column names must be 1 to " + std::to_string(MAX_NAME_LENGTH) +
+                                        " characters");
+        }
+        if (static_cast<uint8_t>(column.type) > static_cast<uint8_t>(Type::VARCHAR)) {
+            throw std::invalid_argument("Unknown type for column " + column.name);
+        }
+        if (!names.insert(column.name).second) {
+            throw std::invalid_argument("Duplicate column " + column.name);
+        }
+        offsets.push_back(static_cast<uint16_t>(offset));
+        offset += slotWidth(column.type);
+    }
+    fixed_size = static_cast<uint16_t>(offset);
+}
+
+std::size_t Schema::getColumnIndex(const std::string& name) const {
+    for (std::size_t i = 0; i < columns.size(); i++) {
+        if (columns[i].name == name) {
+            return i;
+        }
+    }
+    throw std::invalid_argument("No column named " + name);
+}
+
+uint16_t Schema::slotWidth(Type type) {
+    switch (type) {
+        case Type::INT32:
+        case Type::UINT32:
+        case Type::FLOAT:
+            return 4;
+        case Type::INT64:
+        case Type::DOUBLE:
+            return 8;
+        case Type::VARCHAR:
+            return sizeof(uint16_t);
+    }
+    return 0;
+}
+
+void Schema::encode(std::vector<uint8_t>& out) const {
+    out.push_back(FORMAT_VERSION);
+    uint16_t count = static_cast<uint16_t>(columns.size());
+    out.insert(out.end(), reinterpret_cast<const uint8_t*>(&count),
+               reinterpret_cast<const uint8_t*>(&count) + sizeof(count));
+    for (const Column& column : columns) {
+        out.push_back(static_cast<uint8_t>(column.type));
+        out.push_back(column.nullable ? NULLABLE : 0);
+        out.push_back(static_cast<uint8_t>(column.name.size()));
+        out.insert(out.end(), column.name.begin(), column.name.end());
+    }
+}
+
+Schema Schema::decode(const uint8_t* data, std::size_t size) {
+    uint16_t count;
+    if (size < 1 + sizeof(count) || data[0] != FORMAT_VERSION) {
+        throw std::runtime_error("Unrecognised schema in catalog");
+    }
+    std::memcpy(&count, data + 1, sizeof(count));
+
+    std::vector<Column> columns;
+    std::size_t pos = 1 + sizeof(count);
+    for (uint16_t i = 0; i < count; i++) {
+        if (pos + 3 > size || pos + 3 + data[pos + 2] > size) {
+            throw std::runtime_error("Schema truncated in catalog");
+        }
+        Column column;
+        column.type = static_cast<Type>(data[pos]);
+        column.nullable = (data[pos + 1] & NULLABLE) != 0;
+        column.name.assign(reinterpret_cast<const char*>(data + pos + 3), data[pos + 2]);
+        pos += 3 + data[pos + 2];
+        columns.push_back(std::move(column));
+    }
+
+    try {
+        return Schema(std::move(columns));
+    } catch (const std::invalid_argument& e) {
+        throw std::runtime_error(std::string("Invalid schema in catalog: ") + e.what());
+    }
+}
@@ -1,12 +1,22 @@
+#include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
 #include <sys/mman.h>
 #include "storage/slotted_page.hpp"
-#include <unistd.h> // Include for lseek, write, fsync, read
+#include <unistd.h> // Include for pread, pwrite, fsync
 #include <fcntl.h>  // Include for open
 
-SlottedPage::SlottedPage(PageType type, uint32_t id) 
-    : page_data(std::make_unique<uint8_t[]>(PAGE_SIZE)) {
+template <std::size_t PageSize>
+BasicSlottedPage<PageSize>::BasicSlottedPage(PageType type, uint32_t id)
+    : owned_data(allocateAligned(PAGE_SIZE)), page_data(owned_data.get()) {
+    reset(type, id);
+}
+
+template <std::size_t PageSize>
+void BasicSlottedPage<PageSize>::reset(PageType type, uint32_t id) {
     auto* hdr = header();
     hdr->id = id;
     hdr->type = type;
@@ -14,22 +24,51 @@ SlottedPage::SlottedPage(PageType type, uint32_t id)
     hdr->free_end = PAGE_SIZE - 1;
     hdr->total_free = hdr->free_end - hdr->free_start;
     hdr->flags = 0;
+    hdr->lsn = 0;
+    hdr->page_size = PAGE_SIZE;
+    hdr->next_page = NO_PAGE;
 }
 
-uint16_t SlottedPage::addCell(const void* cell, uint16_t cell_size) {
+template <std::size_t PageSize>
+uint16_t BasicSlottedPage<PageSize>::addCell(const void* cell, uint16_t cell_size, bool is_overflow) {
+    auto* hdr = header();
+    uint16_t cell_flags = is_overflow ? OVERFLOW_CELL : 0;
+    assert(cell_size <= MAX_CELL_SIZE);
+
+    if (hdr->flags & HAS_FREE_SLOT) {
+        auto* pointers = reinterpret_cast<CellPointer*>(page_data + sizeof(PageHeader));
+        uint16_t count = cellPointerOffsetToIdx(hdr->free_start);
+        for (uint16_t idx = 0; idx < count; idx++) {
+            if (pointers[idx].cell_location == 0) {
+                assert(hdr->total_free >= cell_size);
+                hdr->free_end -= cell_size;
+                hdr->total_free = hdr->free_end - hdr->free_start;
+                std::memcpy(page_data + hdr->free_end, cell, cell_size);
+                pointers[idx] = {hdr->free_end, static_cast<uint16_t>(cell_size | cell_flags)};
+                return idx;
+            }
+        }
+        hdr->flags &= ~HAS_FREE_SLOT;
+    }
+
+    return appendCell(cell, cell_size, cell_flags);
+}
+
+template <std::size_t PageSize>
+uint16_t BasicSlottedPage<PageSize>::appendCell(const void* cell, uint16_t cell_size, uint16_t cell_flags) {
     auto* hdr = header();
     assert(hdr->total_free >= cell_size + sizeof(CellPointer));
 
     CellPointer cell_pointer;
     cell_pointer.cell_location = hdr->free_end - cell_size;
-    cell_pointer.cell_size = cell_size;
+    cell_pointer.cell_size = cell_size | cell_flags;
 
     // Add the cell to the page
-    std::memcpy(page_data.get() + cell_pointer.cell_location, cell, cell_size);
+    std::memcpy(page_data + cell_pointer.cell_location, cell, cell_size);
 
     // Add cell pointer to the page
     uint16_t pointer_offset = hdr->free_start;
-    std::memcpy(page_data.get() + pointer_offset, &cell_pointer, sizeof(CellPointer));
+    std::memcpy(page_data + pointer_offset, &cell_pointer, sizeof(CellPointer));
 
     // Update the header
     hdr->free_end -= cell_size;
@@ -39,52 +78,110 @@ uint16_t SlottedPage::addCell(const void* cell, uint16_t cell_size) {
     return cellPointerOffsetToIdx(pointer_offset);
 }
 
-void SlottedPage::removeCell(uint16_t idx) {
+template <std::size_t PageSize>
+void BasicSlottedPage<PageSize>::removeCell(uint16_t idx) {
     uint16_t pointer_offset = cellPointerIdxToOffset(idx);
     auto* hdr = header();
-    hdr->flags |= CAN_COMPACT;
-    reinterpret_cast<CellPointer*>(page_data.get() + pointer_offset)->cell_location = 0;
+    hdr->flags |= CAN_COMPACT | HAS_FREE_SLOT;
+    *reinterpret_cast<CellPointer*>(page_data + pointer_offset) = {0, 0};
 }
 
-void* SlottedPage::getCell(uint16_t idx) {
+template <std::size_t PageSize>
+void* BasicSlottedPage<PageSize>::getCell(uint16_t idx) {
     uint16_t pointer_offset = cellPointerIdxToOffset(idx);
-    uint16_t cell_location = reinterpret_cast<CellPointer*>(page_data.get() + pointer_offset)->cell_location;
+    uint16_t cell_location = reinterpret_cast<CellPointer*>(page_data + pointer_offset)->cell_location;
 
     if (cell_location == 0) {
         return nullptr;
     }
 
-    return page_data.get() + cell_location;
+    return page_data + cell_location;
 }
 
-void SlottedPage::compact() {
+template <std::size_t PageSize>
+void BasicSlottedPage<PageSize>::insertCell(uint16_t idx, const void* cell, uint16_t cell_size) {
+    // Never fills a tombstone: that would break the pointer order
+    uint16_t last = appendCell(cell, cell_size, 0);
+    if (idx >= last) {
+        return;
+    }
+
+    auto* pointers = reinterpret_cast<CellPointer*>(page_data + sizeof(PageHeader));
+    CellPointer added = pointers[last];
+    std::memmove(pointers + idx + 1, pointers + idx, (last - idx) * sizeof(CellPointer));
+    pointers[idx] = added;
+}
+
+template <std::size_t PageSize>
+void BasicSlottedPage<PageSize>::eraseCell(uint16_t idx) {
     auto* hdr = header();
-    PointerList plist = getPointerList();
+    auto* pointers = reinterpret_cast<CellPointer*>(page_data + sizeof(PageHeader));
+    uint16_t count = cellPointerOffsetToIdx(hdr->free_start);
+
+    // The cell bytes stay behind until compact() reclaims them
+    std::memmove(pointers + idx, pointers + idx + 1, (count - idx - 1) * sizeof(CellPointer));
+    hdr->free_start -= sizeof(CellPointer);
+    hdr->total_free = hdr->free_end - hdr->free_start;
+    hdr->flags |= CAN_COMPACT;
+}
 
+template <std::size_t PageSize>
+void BasicSlottedPage<PageSize>::compact() {
+    auto* hdr = header();
     if (!(hdr->flags & CAN_COMPACT))
         return;
 
-    auto temp_page = std::make_unique<SlottedPage>(PageType::ROOT, 0);
-    CellPointer* cur_pointer;
-    
-    for (size_t i = 0; i < plist.size; i++) {
-        cur_pointer = plist.start + i;
-        if (cur_pointer->cell_location != 0) {
-            temp_page->addCell(page_data.get() + cur_pointer->cell_location, cur_pointer->cell_size);
+    // Tombstones at the end of the array can go without renumbering anything
+    auto* pointers = reinterpret_cast<CellPointer*>(page_data + sizeof(PageHeader));
+    uint16_t count = cellPointerOffsetToIdx(hdr->free_start);
+    while (count > 0 && pointers[count - 1].cell_location == 0) {
+        count--;
+    }
+
+    // Move cell bodies toward the end of the page, highest first: each one
+    // only moves up, over space already freed, so this works in place. The
+    // slot order is kept in a per-thread scratch array.
+    thread_local std::vector<uint16_t> order;
+    order.clear();
+    for (uint16_t idx = 0; idx < count; idx++) {
+        if (pointers[idx].cell_location != 0) {
+            order.push_back(idx);
         }
     }
+    std::sort(order.begin(), order.end(), [pointers](uint16_t a, uint16_t b) {
+        return pointers[a].cell_location > pointers[b].cell_location;
+    });
 
-    // Copy the compacted data back
-    const auto* temp_hdr = temp_page->header();
-    hdr->free_start = temp_hdr->free_start;
-    hdr->free_end = temp_hdr->free_end;
-    hdr->total_free = temp_hdr->total_free;
-    hdr->flags &= ~CAN_COMPACT;
-    std::memcpy(
-        page_data.get() + sizeof(PageHeader),
-        temp_page->getData() + sizeof(PageHeader),
-        PAGE_SIZE - sizeof(PageHeader)
-    );
+    uint16_t free_end = PAGE_SIZE - 1;
+    for (uint16_t idx : order) {
+        CellPointer& pointer = pointers[idx];
+        free_end -= pointer.size();
+        if (pointer.cell_location != free_end) {
+            std::memmove(page_data + free_end, page_data + pointer.cell_location, pointer.size());
+            pointer.cell_location = free_end;
+        }
+    }
+
+    hdr->free_start = cellPointerIdxToOffset(count);
+    hdr->free_end = free_end;
+    hdr->total_free = hdr->free_end - hdr->free_start;
+    hdr->flags &= ~(CAN_COMPACT | HAS_FREE_SLOT);
+    if (order.size() < count) {
+        hdr->flags |= HAS_FREE_SLOT;
+    }
+}
+
+template <std::size_t PageSize>
+uint16_t BasicSlottedPage<PageSize>::getFragmentedBytes() {
+    const auto* hdr = header();
+    PointerList plist = getPointerList();
+    std::size_t live = 0;
+    for (std::size_t i = 0; i < plist.size; i++) {
+        if (plist.start[i].cell_location != 0) {
+            live += plist.start[i].size();
+        }
+    }
+    return static_cast<uint16_t>(PAGE_SIZE - 1 - hdr->free_end - live);
 }
 /*
 void SlottedPage::savePage(int fd) const {
@@ -93,7 +190,7 @@ void SlottedPage::savePage(int fd) const {
         throw std::runtime_error("Failed to mmap file for writing");
     }
 
-    std::memcpy(mapped, page_data.get(), PAGE_SIZE);
+    std::memcpy(mapped, page_data, PAGE_SIZE);
 
     if (munmap(mapped, PAGE_SIZE) == -1) {
         throw std::runtime_error("Failed to unmap file after writing");
@@ -115,37 +212,62 @@ std::unique_ptr<SlottedPage> SlottedPage::loadPage(int fd, uint32_t page_id) {
 
     return page;
 }*/
-void SlottedPage::savePage(int fd) const {
-    const auto* header = reinterpret_cast<const PageHeader*>(page_data.get());
-    off_t offset = header->id * PAGE_SIZE;
+template <std::size_t PageSize>
+void BasicSlottedPage<PageSize>::savePage(int fd) const {
+    const auto* header = reinterpret_cast<const PageHeader*>(page_data);
+    off_t offset = static_cast<off_t>(header->id) * PAGE_SIZE;
 
-    if (lseek(fd, offset, SEEK_SET) == -1) {
-        throw std::runtime_error("Failed to seek to the correct position in the file");
-    }
-
-    if (write(fd, page_data.get(), PAGE_SIZE) != PAGE_SIZE) {
+    // Positional I/O leaves the shared file offset alone, so concurrent
+    // writers of different pages do not race on it
+    if (pwrite(fd, page_data, PAGE_SIZE, offset) != PAGE_SIZE) {
         throw std::runtime_error("Failed to write the page to the file");
     }
 }
 
-std::unique_ptr<SlottedPage> SlottedPage::loadPage(int fd, uint32_t page_id) {
-    auto page = std::make_unique<SlottedPage>(PageType::ROOT, page_id);
-    off_t offset = page_id * PAGE_SIZE;
-
-    if (lseek(fd, offset, SEEK_SET) == -1) {
-        throw std::runtime_error("Failed to seek to the correct position in the file");
-    }
+template <std::size_t PageSize>
+std::unique_ptr<BasicSlottedPage<PageSize>> BasicSlottedPage<PageSize>::loadPage(int fd, uint32_t page_id) {
+    auto page = std::make_unique<BasicSlottedPage>(PageType::ROOT, page_id);
+    off_t offset = static_cast<off_t>(page_id) * PAGE_SIZE;
 
-    if (read(fd, page->getData(), PAGE_SIZE) != PAGE_SIZE) {
+    if (pread(fd, page->getData(), PAGE_SIZE, offset) != PAGE_SIZE) {
         throw std::runtime_error("Failed to read the page from the file");
     }
 
     return page;
 }
 
-SlottedPage::PointerList SlottedPage::getPointerList() {
+template <std::size_t PageSize>
+typename BasicSlottedPage<PageSize>::PointerList BasicSlottedPage<PageSize>::getPointerList() {
     PointerList list;
-    list.start = reinterpret_cast<CellPointer*>(page_data.get() + sizeof(PageHeader));
+    list.start = reinterpret_cast<CellPointer*>(page_data + sizeof(PageHeader));
     list.size = (header()->free_start - sizeof(PageHeader)) / sizeof(CellPointer);
     return list;
-}
\ No newline at end of file
+}
+
+template <std::size_t PageSize>
+void BasicSlottedPage<PageSize>::checkPageSize(int fd, const std::string& filename) {
+    std::size_t file_page_size = readPageSize(fd);
+    if (file_page_size != 0 && file_page_size != PAGE_SIZE) {
+        throw std::runtime_error(filename + " uses " + std::to_string(file_page_size) +
+                                 "-byte pages but this build uses " + std::to_string(PAGE_SIZE));
+    }
+}
+
+std::size_t SlottedPageBase::readPageSize(int fd) {
+    // A whole aligned block, so this also works on O_DIRECT descriptors
+    AlignedBuffer block = allocateAligned(IO_ALIGNMENT);
+    ssize_t bytes = pread(fd, block.get(), IO_ALIGNMENT, 0);
+    if (bytes == 0) {
+        return 0;
+    }
+    if (bytes < static_cast<ssize_t>(sizeof(PageHeader))) {
+        throw std::runtime_error("Failed to read the first page header");
+    }
+    return reinterpret_cast<const PageHeader*>(block.get())->page_size;
+}
+
+template class BasicSlottedPage<4096>;
+template class BasicSlottedPage<8192>;
+template class BasicSlottedPage<16384>;
+template class BasicSlottedPage<32768>;
+template class BasicSlottedPage<65536>;
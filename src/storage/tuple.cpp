@@ -0,0 +1,201 @@
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include "storage/tuple.hpp"
+
+namespace {
+
+using Type = Schema::Type;
+
+void checkType(const Schema& schema, std::size_t column, Type type) {
+    if (column >= schema.getNumColumns()) {
+        throw std::invalid_argument("Column " + std::to_string(column) + " out of range");
+    }
+    if (schema.getColumn(column).type != type) {
+        throw std::invalid_argument("Column " + schema.getColumn(column).name + " has another type");
+    }
+}
+
+} // namespace
+
+TupleBuilder::TupleBuilder(const Schema& schema)
+    : schema(schema), strings(schema.getNumColumns()), assigned(schema.getNumColumns()) {
+    clear();
+}
+
+TupleBuilder& TupleBuilder::setInt32(std::size_t column, int32_t value) {
+    setFixed(column, Type::INT32, &value);
+    return *this;
+}
+
+TupleBuilder& TupleBuilder::setUInt32(std::size_t column, uint32_t value) {
+    setFixed(column, Type::UINT32, &value);
+    return *this;
+}
+
+TupleBuilder& TupleBuilder::setInt64(std::size_t column, int64_t value) {
+    setFixed(column, Type::INT64, &value);
+    return *this;
+}
+
+TupleBuilder& TupleBuilder::setFloat(std::size_t column, float value) {
+    setFixed(column, Type::FLOAT, &value);
+    return *this;
+}
+
+TupleBuilder& TupleBuilder::setDouble(std::size_t column, double value) {
+    setFixed(column, Type::DOUBLE, &value);
+    return *this;
+}
+
+TupleBuilder& TupleBuilder::setString(std::size_t column, std::string_view value) {
+    checkType(schema, column, Type::VARCHAR);
+    strings[column].assign(value.data(), value.size());
+    markNull(column, false);
+    return *this;
+}
+
+TupleBuilder& TupleBuilder::setNull(std::size_t column) {
+    if (column >= schema.getNumColumns() || !schema.getColumn(column).nullable) {
+        throw std::invalid_argument("Column " + std::to_string(column) + " is not nullable");
+    }
+    if (schema.getColumn(column).type == Type::VARCHAR) {
+        strings[column].clear();
+    } else {
+        std::memset(fixed.data() + schema.getOffset(column), 0, Schema::slotWidth(schema.getColumn(column).type));
+    }
+    markNull(column, true);
+    return *this;
+}
+
+void TupleBuilder::setFixed(std::size_t column, Type type, const void* value) {
+    checkType(schema, column, type);
+    std::memcpy(fixed.data() + schema.getOffset(column), value, Schema::slotWidth(type));
+    markNull(column, false);
+}
+
+void TupleBuilder::markNull(std::size_t column, bool is_null) {
+    uint8_t bit = static_cast<uint8_t>(1u << (column % 8));
+    fixed[column / 8] = is_null ? (fixed[column / 8] | bit) : (fixed[column / 8] & ~bit);
+    assigned[column] = true;
+}
+
+const std::vector<uint8_t>& TupleBuilder::build() {
+    tuple.assign(fixed.begin(), fixed.end());
+    for (std::size_t i = 0; i < schema.getNumColumns(); i++) {
+        if (!assigned[i] && !schema.getColumn(i).nullable) {
+            throw std::invalid_argument("Column " + schema.getColumn(i).name + " was not set");
+        }
+        if (!assigned[i]) {
+            tuple[i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+        }
+        if (schema.getColumn(i).type != Type::VARCHAR) {
+            continue;
+        }
+        if (assigned[i]) {
+            tuple.insert(tuple.end(), strings[i].begin(), strings[i].end());
+        }
+        if (tuple.size() > std::numeric_limits<uint16_t>::max()) {
+            throw std::length_error("Tuple longer than 64 KiB");
+        }
+        uint16_t end = static_cast<uint16_t>(tuple.size());
+        std::memcpy(tuple.data() + schema.getOffset(i), &end, sizeof(end));
+    }
+    return tuple;
+}
+
+void TupleBuilder::clear() {
+    fixed.assign(schema.getFixedSize(), 0);
+    for (std::size_t i = 0; i < schema.getNumColumns(); i++) {
+        strings[i].clear();
+        assigned[i] = false;
+    }
+}
+
+template <typename T>
+T TupleView::getFixed(std::size_t column, Type type) const {
+    checkType(schema, column, type);
+    T value;
+    std::memcpy(&value, data + schema.getOffset(column), sizeof(T));
+    return value;
+}
+
+int32_t TupleView::getInt32(std::size_t column) const {
+    return getFixed<int32_t>(column, Type::INT32);
+}
+
+uint32_t TupleView::getUInt32(std::size_t column) const {
+    return getFixed<uint32_t>(column, Type::UINT32);
+}
+
+int64_t TupleView::getInt64(std::size_t column) const {
+    return getFixed<int64_t>(column, Type::INT64);
+}
+
+float TupleView::getFloat(std::size_t column) const {
+    return getFixed<float>(column, Type::FLOAT);
+}
+
+double TupleView::getDouble(std::size_t column) const {
+    return getFixed<double>(column, Type::DOUBLE);
+}
+
+std::string_view TupleView::getString(std::size_t column) const {
+    checkType(schema, column, Type::VARCHAR);
+    uint16_t start = varStart(column);
+    return {reinterpret_cast<const char*>(data + start), static_cast<std::size_t>(varEnd(column) - start)};
+}
+
+uint16_t TupleView::varEnd(std::size_t column) const {
+    uint16_t end;
+    std::memcpy(&end, data + schema.getOffset(column), sizeof(end));
+    return end;
+}
+
+// A string starts where the previous VARCHAR column ends
+uint16_t TupleView::varStart(std::size_t column) const {
+    while (column-- > 0) {
+        if (schema.getColumn(column).type == Type::VARCHAR) {
+            return varEnd(column);
+        }
+    }
+    return schema.getFixedSize();
+}
+
+uint16_t TupleView::size() const {
+    for (std::size_t column = schema.getNumColumns(); column-- > 0;) {
+        if (schema.getColumn(column).type == Type::VARCHAR) {
+            return varEnd(column);
+        }
+    }
+    return schema.getFixedSize();
+}
+
+bool TupleView::isValid(const Schema& schema, const void* data, std::size_t size) {
+    if (size < schema.getFixedSize()) {
+        return false;
+    }
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    TupleView view(schema, data);
+    std::size_t start = schema.getFixedSize();
+    for (std::size_t i = 0; i < schema.getNumColumns(); i++) {
+        bool is_null = view.isNull(i);
+        if (is_null && !schema.getColumn(i).nullable) {
+            return false;
+        }
+        if (schema.getColumn(i).type != Type::VARCHAR) {
+            continue;
+        }
+        uint16_t end = view.varEnd(i);
+        if (end < start || end > size || (is_null && end != start)) {
+            return false;
+        }
+        start = end;
+    }
+    // Bits past the last column must be clear
+    std::size_t columns = schema.getNumColumns();
+    if (columns % 8 != 0 && (bytes[columns / 8] >> (columns % 8)) != 0) {
+        return false;
+    }
+    return start == size;
+}
@@ -0,0 +1,247 @@
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "storage/b_plus_tree.hpp"
+#include "storage/hash_index.hpp"
+#include "test_util.hpp"
+
+// Index lookups racing with the inserts that split B+-tree nodes and hash
+// buckets and double the hash directory. Writers publish how far they got;
+// readers check that every key published before a lookup started is found,
+// once and with its own record id, whatever splits are under way.
+
+namespace {
+
+constexpr std::size_t NUM_WRITERS = 4;
+constexpr uint64_t KEYS_PER_WRITER = 1 << 16;
+constexpr uint64_t KEY_STRIDE = 40503; // Odd, so i -> i * KEY_STRIDE is a permutation
+
+// Writer w's i-th key; writers own disjoint keys and each fills its share
+// in scattered order, so splits happen all over the key range
+uint64_t keyOf(std::size_t writer, uint64_t i) {
+    return ((i * KEY_STRIDE) % KEYS_PER_WRITER) * NUM_WRITERS + writer;
+}
+
+uint64_t strideInverse() {
+    uint64_t inverse = KEY_STRIDE; // Newton's iteration, each step doubles the correct bits
+    for (int step = 0; step < 4; step++) {
+        inverse *= 2 - KEY_STRIDE * inverse;
+    }
+    return inverse % KEYS_PER_WRITER;
+}
+
+// Position of key in its writer's order
+uint64_t indexOf(uint64_t key) {
+    static const uint64_t inverse = strideInverse();
+    return ((key / NUM_WRITERS) * inverse) % KEYS_PER_WRITER;
+}
+
+HeapFile::RecordId ridOf(uint64_t key) {
+    return {static_cast<uint32_t>(key), static_cast<uint16_t>(key % 1000)};
+}
+
+bool isRidOf(uint64_t key, const HeapFile::RecordId& rid) {
+    HeapFile::RecordId expected = ridOf(key);
+    return rid.page_id == expected.page_id && rid.slot_id == expected.slot_id;
+}
+
+uint64_t recordKey(const void* record, uint16_t) {
+    return *static_cast<const uint64_t*>(record);
+}
+
+struct Progress {
+    std::atomic<uint64_t> inserted[NUM_WRITERS] = {};
+    std::atomic<bool> done{false};
+
+    bool isPublished(uint64_t key) const {
+        return indexOf(key) < inserted[key % NUM_WRITERS].load(std::memory_order_acquire);
+    }
+};
+
+template <typename Index>
+void runWriters(Index& index, Progress& progress, std::vector<std::thread>& threads) {
+    for (std::size_t writer = 0; writer < NUM_WRITERS; writer++) {
+        threads.emplace_back([&, writer] {
+            for (uint64_t i = 0; i < KEYS_PER_WRITER; i++) {
+                uint64_t key = keyOf(writer, i);
+                index.insert(key, ridOf(key));
+                progress.inserted[writer].store(i + 1, std::memory_order_release);
+            }
+        });
+    }
+}
+
+// Point lookups of published keys and of keys never inserted
+template <typename Index>
+void runFinder(Index& index, Progress& progress, std::vector<std::thread>& threads) {
+    threads.emplace_back([&] {
+        std::mt19937_64 rng(1);
+        std::size_t lookups = 0;
+        while (!progress.done.load(std::memory_order_acquire) || lookups == 0) {
+            std::size_t writer = rng() % NUM_WRITERS;
+            uint64_t published = progress.inserted[writer].load(std::memory_order_acquire);
+            if (published == 0) {
+                continue;
+            }
+            uint64_t key = keyOf(writer, rng() % published);
+            std::vector<HeapFile::RecordId> rids = index.find(key);
+            CHECK(rids.size() == 1 && isRidOf(key, rids[0]));
+            CHECK(index.find(NUM_WRITERS * KEYS_PER_WRITER + rng() % 1000).empty());
+            lookups++;
+        }
+    });
+}
+
+template <typename Index>
+void checkAllKeys(Index& index) {
+    for (std::size_t writer = 0; writer < NUM_WRITERS; writer++) {
+        for (uint64_t i = 0; i < KEYS_PER_WRITER; i++) {
+            uint64_t key = keyOf(writer, i);
+            std::vector<HeapFile::RecordId> rids = index.find(key);
+            CHECK(rids.size() == 1 && isRidOf(key, rids[0]));
+        }
+    }
+}
+
+void testBPlusTree(const std::string& path) {
+    unlink(path.c_str());
+    {
+        BPlusTree tree(path, recordKey, 1);
+        Progress progress;
+        std::vector<std::thread> threads;
+        runWriters(tree, progress, threads);
+        runFinder(tree, progress, threads);
+
+        // Range scans come back in key order, each key once, and hold every
+        // key in range that was published before the scan started
+        threads.emplace_back([&] {
+            std::mt19937_64 rng(2);
+            std::size_t scans = 0;
+            while (!progress.done.load(std::memory_order_acquire) || scans == 0) {
+                uint64_t low = rng() % (NUM_WRITERS * KEYS_PER_WRITER);
+                uint64_t high = low + 2000;
+                std::vector<uint64_t> expected;
+                for (uint64_t key = low; key <= high && key < NUM_WRITERS * KEYS_PER_WRITER; key++) {
+                    if (progress.isPublished(key)) {
+                        expected.push_back(key);
+                    }
+                }
+                std::vector<uint64_t> seen;
+                tree.scan(low, high, [&](uint64_t key, HeapFile::RecordId rid) {
+                    CHECK(key >= low && key <= high && isRidOf(key, rid));
+                    CHECK(seen.empty() || seen.back() < key);
+                    seen.push_back(key);
+                    return true;
+                });
+                CHECK(std::includes(seen.begin(), seen.end(), expected.begin(), expected.end()));
+                scans++;
+            }
+        });
+
+        for (std::size_t writer = 0; writer < NUM_WRITERS; writer++) {
+            threads[writer].join();
+        }
+        progress.done.store(true, std::memory_order_release);
+        for (std::size_t i = NUM_WRITERS; i < threads.size(); i++) {
+            threads[i].join();
+        }
+        CHECK(tree.getHeight() >= 3);
+        checkAllKeys(tree);
+        tree.close();
+    }
+    BPlusTree tree(path, recordKey, 1);
+    checkAllKeys(tree);
+    std::size_t count = 0;
+    tree.scan(0, UINT64_MAX, [&](uint64_t key, HeapFile::RecordId rid) {
+        CHECK(key == count && isRidOf(key, rid));
+        count++;
+        return true;
+    });
+    CHECK(count == NUM_WRITERS * KEYS_PER_WRITER);
+    tree.close();
+    unlink(path.c_str());
+}
+
+void testHashIndex(const std::string& path) {
+    unlink(path.c_str());
+    // Every writer also piles record ids onto one hot key, whose bucket
+    // can only grow an overflow chain
+    const uint64_t hot_key = UINT64_MAX;
+    const uint64_t hot_every = 256;
+    auto hotRid = [](std::size_t writer, uint64_t i) {
+        return HeapFile::RecordId{static_cast<uint32_t>(writer), static_cast<uint16_t>(i / hot_every)};
+    };
+    {
+        HashIndex index(path, recordKey, 1);
+        uint8_t initial_depth = index.getGlobalDepth();
+        Progress progress;
+        std::atomic<uint64_t> hot_inserted[NUM_WRITERS] = {};
+        std::vector<std::thread> threads;
+        for (std::size_t writer = 0; writer < NUM_WRITERS; writer++) {
+            threads.emplace_back([&, writer] {
+                for (uint64_t i = 0; i < KEYS_PER_WRITER; i++) {
+                    uint64_t key = keyOf(writer, i);
+                    index.insert(key, ridOf(key));
+                    progress.inserted[writer].store(i + 1, std::memory_order_release);
+                    if (i % hot_every == 0) {
+                        index.insert(hot_key, hotRid(writer, i));
+                        hot_inserted[writer].fetch_add(1, std::memory_order_release);
+                    }
+                }
+            });
+        }
+        runFinder(index, progress, threads);
+        threads.emplace_back([&] {
+            while (!progress.done.load(std::memory_order_acquire)) {
+                uint64_t published = 0;
+                for (const std::atomic<uint64_t>& inserted : hot_inserted) {
+                    published += inserted.load(std::memory_order_acquire);
+                }
+                CHECK(index.find(hot_key).size() >= published);
+                // Paced: walking the chain on every turn starves the writers
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+
+        for (std::size_t writer = 0; writer < NUM_WRITERS; writer++) {
+            threads[writer].join();
+        }
+        progress.done.store(true, std::memory_order_release);
+        for (std::size_t i = NUM_WRITERS; i < threads.size(); i++) {
+            threads[i].join();
+        }
+        CHECK(index.getGlobalDepth() > initial_depth + 2);
+        checkAllKeys(index);
+        index.close();
+    }
+    HashIndex index(path, recordKey, 1);
+    checkAllKeys(index);
+    std::vector<HeapFile::RecordId> hot = index.find(hot_key);
+    CHECK(hot.size() == NUM_WRITERS * KEYS_PER_WRITER / hot_every);
+    for (std::size_t writer = 0; writer < NUM_WRITERS; writer++) {
+        for (uint64_t i = 0; i < KEYS_PER_WRITER; i += hot_every) {
+            HeapFile::RecordId rid = hotRid(writer, i);
+            CHECK(std::count_if(hot.begin(), hot.end(), [&](const HeapFile::RecordId& found) {
+                      return found.page_id == rid.page_id && found.slot_id == rid.slot_id;
+                  }) == 1);
+        }
+    }
+    index.close();
+    unlink(path.c_str());
+}
+
+} // namespace
+
+int main() {
+    testBPlusTree("index_concurrency_test.bpt");
+    std::cout << "b+-tree lookups during splits: ok\n";
+    testHashIndex("index_concurrency_test.idx");
+    std::cout << "hash lookups during splits and doubling: ok\n";
+    return 0;
+}
@@ -0,0 +1,45 @@
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// Shared helpers for the storage tests. Each test is a plain executable that
+// exits non-zero at the first failed check, which is all CTest looks at.
+
+#define CHECK(condition)                                                                       \
+    do {                                                                                       \
+        if (!(condition)) {                                                                    \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition "\n";  \
+            std::abort();                                                                      \
+        }                                                                                      \
+    } while (0)
+
+// A heap file and every fork it may have
+inline void removeHeapFile(const std::string& path) {
+    for (const char* suffix : {"", ".wal", ".fsm", ".ptt", ".ptt.tmp", ".wal.tmp", ".mvcc"}) {
+        unlink((path + suffix).c_str());
+    }
+}
+
+// Run body in a child process that exits straight after, closing nothing,
+// as a crash would; fails unless the child got that far. Call with no
+// threads running, since only the calling thread survives the fork.
+template <typename Body>
+void runAndCrash(Body body) {
+    std::cout.flush();
+    pid_t pid = fork();
+    CHECK(pid != -1);
+    if (pid == 0) {
+        body();
+        _exit(0);
+    }
+    int status;
+    CHECK(waitpid(pid, &status, 0) == pid);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+#endif // TEST_UTIL_H